@@ -0,0 +1,228 @@
+#include "filter.h"
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+uint64_t hashNormalizedKey(const string &normalizedKey)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char byte : normalizedKey)
+    {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    }
+    // FNV-1a alone leaves the keys of a short range with much the same high bits, and so in few
+    // blocks; the finalizer of MurmurHash3 spreads them
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+IndexFilter::IndexFilter(const string &indexFileName, unsigned size)
+{
+    fileName = indexFileName + ".filter";
+    pageSize = size;
+    isOpen = false;
+    probes = 0;
+    negatives = 0;
+    falsePositives = 0;
+    header.blocksNumber = 0;
+    header.keysNumber = 0;
+    header.capacity = 0;
+    headerChanged = false;
+}
+
+IndexFilter::~IndexFilter()
+{
+    if (isOpen)
+        PagedFileManager::instance()->closeFile(fileHandle);
+}
+
+uint64_t IndexFilter::getKeyHash(const Attribute &attr, const void *key)
+{
+    int32_t length = INT_SIZE;
+    if (attr.type == TypeVarChar)
+        memcpy(&length, key, VARCHAR_LENGTH_SIZE);
+    // At worst every byte of a varchar is followed by another, and then two more end it
+    string normalizedKey(2 * length + 2, 0);
+    normalizedKey.resize(IndexManager::normalizeKey(attr, key, &normalizedKey[0]));
+    return hashNormalizedKey(normalizedKey);
+}
+
+// The high half of the hash picks the block, and the low half the bits h1 + i * h2 in it
+uint32_t IndexFilter::getBlock(uint64_t hash) const
+{
+    return (uint32_t)(hash >> 32) % header.blocksNumber;
+}
+
+uint32_t IndexFilter::getBit(uint64_t hash, unsigned i)
+{
+    uint32_t h1 = (uint32_t)hash;
+    uint32_t h2 = (h1 >> 16 | h1 << 16) | 1;
+    return (h1 + i * h2) % FILTER_BLOCK_BITS;
+}
+
+RC IndexFilter::create(unsigned capacity, const vector<uint64_t> &hashes)
+{
+    lock_guard<mutex> guard(lock);
+    PagedFileManager *pfm = PagedFileManager::instance();
+    if (isOpen)
+    {
+        pfm->closeFile(fileHandle);
+        isOpen = false;
+    }
+    pfm->destroyFile(fileName);
+    if (pfm->createFile(fileName, false, pageSize) || pfm->openFile(fileName, fileHandle))
+        return IX_CREATE_FAILED;
+    isOpen = true;
+
+    header.capacity = max(capacity, (unsigned)FILTER_MIN_KEYS);
+    header.blocksNumber = (header.capacity * FILTER_BITS_PER_KEY + FILTER_BLOCK_BITS - 1) / FILTER_BLOCK_BITS;
+    header.keysNumber = hashes.size();
+    blocks.assign(header.blocksNumber * FILTER_BLOCK_BITS / CHAR_BIT, 0);
+    for (uint64_t hash : hashes)
+    {
+        unsigned char *block = &blocks[getBlock(hash) * FILTER_BLOCK_BITS / CHAR_BIT];
+        for (unsigned i = 0; i < FILTER_HASHES; i++)
+            block[getBit(hash, i) / CHAR_BIT] |= 1 << (getBit(hash, i) % CHAR_BIT);
+    }
+
+    void *page = calloc(pageSize, 1);
+    if (page == NULL)
+        return IX_MALLOC_FAILED;
+    memcpy(page, &header, sizeof(FilterHeader));
+    RC rc = fileHandle.appendPage(page) ? IX_APPEND_FAILED : SUCCESS;
+    for (size_t offset = 0; offset < blocks.size() && rc == SUCCESS; offset += pageSize)
+    {
+        memset(page, 0, pageSize);
+        memcpy(page, blocks.data() + offset, min((size_t)pageSize, blocks.size() - offset));
+        if (fileHandle.appendPage(page))
+            rc = IX_APPEND_FAILED;
+    }
+    free(page);
+    headerChanged = false;
+    return rc;
+}
+
+RC IndexFilter::open()
+{
+    lock_guard<mutex> guard(lock);
+    if (PagedFileManager::instance()->openFile(fileName, fileHandle))
+        return IX_OPEN_FAILED;
+    isOpen = true;
+    void *page = malloc(pageSize);
+    if (page == NULL)
+        return IX_MALLOC_FAILED;
+    RC rc = fileHandle.readPage(0, page) ? IX_READ_FAILED : SUCCESS;
+    memcpy(&header, page, sizeof(FilterHeader));
+    if (rc == SUCCESS)
+        blocks.resize(header.blocksNumber * FILTER_BLOCK_BITS / CHAR_BIT);
+    for (PageNum pageNum = 1; rc == SUCCESS && (pageNum - 1) * pageSize < blocks.size(); pageNum++)
+    {
+        size_t offset = (pageNum - 1) * pageSize;
+        if (fileHandle.readPage(pageNum, page))
+            rc = IX_READ_FAILED;
+        else
+            memcpy(blocks.data() + offset, page, min((size_t)pageSize, blocks.size() - offset));
+    }
+    free(page);
+    return rc;
+}
+
+RC IndexFilter::destroy()
+{
+    lock_guard<mutex> guard(lock);
+    PagedFileManager *pfm = PagedFileManager::instance();
+    if (isOpen)
+        pfm->closeFile(fileHandle);
+    isOpen = false;
+    if (pfm->destroyFile(fileName))
+        return IX_DESTROY_FAILED;
+    return SUCCESS;
+}
+
+RC IndexFilter::add(uint64_t hash)
+{
+    lock_guard<mutex> guard(lock);
+    size_t blockOffset = getBlock(hash) * FILTER_BLOCK_BITS / CHAR_BIT;
+    bool changed = false;
+    for (unsigned i = 0; i < FILTER_HASHES; i++)
+    {
+        unsigned char &byte = blocks[blockOffset + getBit(hash, i) / CHAR_BIT];
+        unsigned char bit = 1 << (getBit(hash, i) % CHAR_BIT);
+        changed = changed || !(byte & bit);
+        byte |= bit;
+    }
+    header.keysNumber++;
+    headerChanged = true;
+    if (!changed)
+        return SUCCESS;
+
+    // The page the block is on, whole
+    size_t offset = blockOffset / pageSize * pageSize;
+    void *page = calloc(pageSize, 1);
+    if (page == NULL)
+        return IX_MALLOC_FAILED;
+    memcpy(page, blocks.data() + offset, min((size_t)pageSize, blocks.size() - offset));
+    RC rc = fileHandle.writePage(1 + offset / pageSize, page) ? IX_WRITE_FAILED : SUCCESS;
+    free(page);
+    return rc;
+}
+
+bool IndexFilter::mayContain(uint64_t hash) const
+{
+    lock_guard<mutex> guard(lock);
+    const unsigned char *block = &blocks[getBlock(hash) * FILTER_BLOCK_BITS / CHAR_BIT];
+    for (unsigned i = 0; i < FILTER_HASHES; i++)
+    {
+        if (!(block[getBit(hash, i) / CHAR_BIT] & (1 << (getBit(hash, i) % CHAR_BIT))))
+            return false;
+    }
+    return true;
+}
+
+bool IndexFilter::isFull() const
+{
+    lock_guard<mutex> guard(lock);
+    return header.keysNumber > header.capacity;
+}
+
+RC IndexFilter::writeHeader()
+{
+    lock_guard<mutex> guard(lock);
+    if (!headerChanged)
+        return SUCCESS;
+    void *page = calloc(pageSize, 1);
+    if (page == NULL)
+        return IX_MALLOC_FAILED;
+    memcpy(page, &header, sizeof(FilterHeader));
+    RC rc = fileHandle.writePage(0, page) ? IX_WRITE_FAILED : SUCCESS;
+    free(page);
+    headerChanged = rc != SUCCESS;
+    return rc;
+}
+
+void IndexFilter::getStats(FilterStats &stats) const
+{
+    lock_guard<mutex> guard(lock);
+    stats.keys = header.keysNumber;
+    stats.capacity = header.capacity;
+    stats.memoryBytes = blocks.size();
+    // (1 - e^(-kn/m))^k, the rate of a Bloom filter of as many bits, which a blocked one
+    // comes close to
+    double bits = (double)header.blocksNumber * FILTER_BLOCK_BITS;
+    stats.expectedFalsePositiveRate = pow(1 - exp(-FILTER_HASHES * (double)header.keysNumber / bits), FILTER_HASHES);
+    stats.probes = probes;
+    stats.negatives = negatives;
+    stats.falsePositives = falsePositives;
+    // Of the probes for keys that were not there (absent or deleted), those let through
+    unsigned negatives = this->negatives;
+    unsigned falsePositives = this->falsePositives;
+    stats.falsePositiveRate = falsePositives + negatives == 0 ? 0 : (double)falsePositives / (falsePositives + negatives);
+    stats.pageReads = fileHandle.readPageCounter;
+    stats.pageWrites = fileHandle.writePageCounter + fileHandle.appendPageCounter;
+}
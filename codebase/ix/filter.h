@@ -0,0 +1,86 @@
+#ifndef _filter_h_
+#define _filter_h_
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+#include "ix.h"
+
+// The Bloom filter of an index, over the keys of its entries, which an equality scan consults
+// before it reads any page. It is blocked: the FILTER_HASHES bits of a key are all in one block
+// of FILTER_BLOCK_BITS bits, so that adding a key changes one page of the filter, which is
+// written at once. A filter cannot forget keys, and is built again, twice as large as the
+// index's entries need, when more keys than it was sized for have been added.
+//
+// The filter of an index named F is the file F.filter: a header page, then the pages of the
+// blocks. Its pages are read and written through its own FileHandle, and counted in its
+// stats rather than in the handles of the index.
+//
+// The handles of an index on different threads share its filter: its bits and file are only
+// touched with its lock held, and its counters are atomic.
+#define FILTER_BITS_PER_KEY 10
+#define FILTER_HASHES 7
+#define FILTER_BLOCK_BITS 512
+#define FILTER_MIN_KEYS 1024   // The fewest keys a filter is sized for
+
+typedef struct FilterHeader
+{
+    uint32_t blocksNumber;
+    uint32_t keysNumber;    // Keys added since it was built
+    uint32_t capacity;      // Keys it was sized for
+} FilterHeader;
+
+// The hash of a key that the Bloom filters of indexes and of LSM runs take their bits from:
+// FNV-1a of the normalized key, finalized
+uint64_t hashNormalizedKey(const string &normalizedKey);
+
+class IndexFilter
+{
+public:
+    IndexFilter(const string &indexFileName, unsigned pageSize);
+    ~IndexFilter();
+
+    static uint64_t getKeyHash(const Attribute &attr, const void *key);
+
+    // Writes the filter for capacity keys, with the keys of hashes, replacing any filter the
+    // index had
+    RC create(unsigned capacity, const vector<uint64_t> &hashes);
+    RC open();
+    // Removes the file of the filter
+    RC destroy();
+
+    // Sets the bits of a key, writing the page of its block if they change
+    RC add(uint64_t hash);
+    bool mayContain(uint64_t hash) const;
+    // Whether more keys were added than it was sized for
+    bool isFull() const;
+    // Writes the number of keys added, if it changed
+    RC writeHeader();
+
+    void getStats(FilterStats &stats) const;
+
+    // Equality scans since the filter was opened: all that consulted it, those it ruled out,
+    // and those it let through that found nothing
+    atomic<unsigned> probes;
+    atomic<unsigned> negatives;
+    atomic<unsigned> falsePositives;
+
+private:
+    mutable mutex lock;
+    string fileName;
+    unsigned pageSize;
+    FileHandle fileHandle;
+    bool isOpen;
+
+    FilterHeader header;
+    bool headerChanged;
+    vector<unsigned char> blocks;
+
+    // The block of a hash, and the bits in it
+    uint32_t getBlock(uint64_t hash) const;
+    static uint32_t getBit(uint64_t hash, unsigned i);
+};
+
+#endif
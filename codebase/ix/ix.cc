@@ -1,9 +1,12 @@
 
 #include "ix.h"
+#include "lsm.h"
+#include "filter.h"
 
 #include "../rbf/pfm.h"
 #include "../rbf/rbfm.h"
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <cstring>
@@ -11,6 +14,16 @@
 
 IndexManager *IndexManager::_index_manager = 0;
 
+// The size of a key, or of a value of attr in a tuple
+static unsigned getKeySize(const Attribute &attr, const void *key)
+{
+    if (attr.type != TypeVarChar)
+        return INT_SIZE;
+    int32_t length;
+    memcpy(&length, key, VARCHAR_LENGTH_SIZE);
+    return VARCHAR_LENGTH_SIZE + length;
+}
+
 IndexManager *IndexManager::instance()
 {
     if (!_index_manager)
@@ -25,14 +38,28 @@ IndexManager::IndexManager()
 
 IndexManager::~IndexManager()
 {
+    for (auto &tree : lsmTrees)
+        delete tree.second;
+    while (!pinnedTrees.empty())
+        unpinTree(pinnedTrees.begin()->first);
+    for (auto &filter : filters)
+        delete filter.second;
 }
 
-RC IndexManager::createFile(const string &fileName)
+RC IndexManager::createFile(const string &fileName, unsigned pageSize)
+{
+    return createFile(fileName, BTREE_INDEX, pageSize);
+}
+
+RC IndexManager::createFile(const string &fileName, IndexKind kind, unsigned pageSize)
 {
     PagedFileManager *pfm = PagedFileManager::instance();
 
-    if (pfm->createFile(fileName.c_str()))
+    if (pfm->createFile(fileName.c_str(), false, pageSize))
         return IX_CREATE_FAILED;
+    // Pages pinned for an index of the same name that was destroyed are gone, and so is its filter
+    unpinTree(fileName);
+    dropFilter(fileName);
 
     // Open the file we just created
     IXFileHandle handle;
@@ -40,14 +67,18 @@ RC IndexManager::createFile(const string &fileName)
     if (rc)
         return IX_OPEN_FAILED;
 
-    void *pageData = calloc(PAGE_SIZE, 1);
+    void *pageData = calloc(handle.getPageSize(), 1);
     if (pageData == NULL)
         return IX_MALLOC_FAILED;
 
     // Initialize the first page with metadata. root page will be page 1
     MetaHeader meta;
-    meta.rootPage = 1;
+    meta.rootPage = kind == LSM_INDEX ? 0 : 1;
+    meta.kind = kind;
     setMetaData(meta, pageData);
+    // A B-epsilon index takes changes into the buffer after the MetaHeader
+    if (kind == BEPSILON_INDEX)
+        clearMessages((char *)pageData + sizeof(MetaHeader));
     rc = handle.appendPage(pageData);
     if (rc)
     {
@@ -56,12 +87,29 @@ RC IndexManager::createFile(const string &fileName)
         return IX_APPEND_FAILED;
     }
 
+    // An LSM index has no runs yet, and an empty log. Any index of the same name that was
+    // opened before is gone.
+    if (kind == LSM_INDEX)
+    {
+        closeFile(handle);
+        free(pageData);
+        lock_guard<mutex> lock(lsmTreesLock);
+        auto tree = lsmTrees.find(fileName);
+        if (tree != lsmTrees.end())
+        {
+            delete tree->second;
+            lsmTrees.erase(tree);
+        }
+        return LsmTree::create(fileName, pageSize);
+    }
+
     // Initialize root page as internal node with a single child
     setNodeType(IX_TYPE_INTERNAL, pageData);
     InternalHeader header;
     header.entriesNumber = 0;
-    header.freeSpaceOffset = PAGE_SIZE;
+    header.freeSpaceOffset = handle.getPageSize();
     header.leftChildPage = 2;
+    header.bufferPage = kind == BEPSILON_INDEX ? 3 : 0;
     setInternalHeader(header, pageData);
     rc = handle.appendPage(pageData);
     if (rc)
@@ -77,7 +125,7 @@ RC IndexManager::createFile(const string &fileName)
     leafHeader.next = 0;
     leafHeader.prev = 0;
     leafHeader.entriesNumber = 0;
-    leafHeader.freeSpaceOffset = PAGE_SIZE;
+    leafHeader.freeSpaceOffset = handle.getPageSize();
     setLeafHeader(leafHeader, pageData);
     rc = handle.appendPage(pageData);
     if (rc)
@@ -87,6 +135,15 @@ RC IndexManager::createFile(const string &fileName)
         return IX_APPEND_FAILED;
     }
 
+    // And the root's buffer, after the leaf
+    uint32_t bufferPage;
+    if (kind == BEPSILON_INDEX && appendBuffer(handle, bufferPage))
+    {
+        closeFile(handle);
+        free(pageData);
+        return IX_APPEND_FAILED;
+    }
+
     closeFile(handle);
     free(pageData);
     return SUCCESS;
@@ -94,6 +151,23 @@ RC IndexManager::createFile(const string &fileName)
 
 RC IndexManager::destroyFile(const string &fileName)
 {
+    // An LSM index has the files of its runs and log to remove too
+    IXFileHandle handle;
+    if (openFile(fileName, handle) == SUCCESS)
+    {
+        LsmTree *tree = handle.lsm;
+        closeFile(handle);
+        if (tree != NULL)
+        {
+            tree->destroy();
+            lock_guard<mutex> lock(lsmTreesLock);
+            lsmTrees.erase(fileName);
+            delete tree;
+        }
+    }
+    unpinTree(fileName);
+    dropFilter(fileName);
+
     PagedFileManager *pfm = PagedFileManager::instance();
     if (pfm->destroyFile(fileName))
         return IX_DESTROY_FAILED;
@@ -105,12 +179,83 @@ RC IndexManager::openFile(const string &fileName, IXFileHandle &ixfileHandle)
     PagedFileManager *pfm = PagedFileManager::instance();
     if (pfm->openFile(fileName, ixfileHandle.fh))
         return IX_OPEN_FAILED;
+    ixfileHandle.fileName = fileName;
+
+    // The meta page says what kind of index this is, once createFile has written it. It is
+    // read past the handle's counters, which only count the pages of the index's operations.
+    if (ixfileHandle.fh.getNumberOfPages() == 0)
+        return SUCCESS;
+    void *metaPage = malloc(ixfileHandle.getPageSize());
+    if (metaPage == NULL)
+    {
+        pfm->closeFile(ixfileHandle.fh);
+        return IX_MALLOC_FAILED;
+    }
+    RC rc = ixfileHandle.fh.readPage(0, metaPage);
+    MetaHeader meta = getMetaData(metaPage);
+    ixfileHandle.kind = (IndexKind)meta.kind;
+    if (rc == SUCCESS && meta.kind == LSM_INDEX)
+        rc = getLsmTree(fileName, ixfileHandle.getPageSize(), ixfileHandle.lsm);
+    else if (rc == SUCCESS)
+    {
+        // The handles of the file share its pinned pages, starting with the meta page just read
+        lock_guard<mutex> lock(pinnedTreesLock);
+        PinnedTree *&tree = pinnedTrees[fileName];
+        if (tree == NULL)
+        {
+            tree = new PinnedTree();
+            tree->metaPage = metaPage;
+            tree->root = NULL;
+            metaPage = NULL;
+        }
+        ixfileHandle.pinned = tree;
+    }
+    free(metaPage);
+    if (rc)
+    {
+        pfm->closeFile(ixfileHandle.fh);
+        return IX_OPEN_FAILED;
+    }
+    return SUCCESS;
+}
+
+RC IndexManager::getLsmTree(const string &fileName, unsigned pageSize, LsmTree *&tree)
+{
+    lock_guard<mutex> lock(lsmTreesLock);
+    auto open = lsmTrees.find(fileName);
+    if (open != lsmTrees.end())
+    {
+        tree = open->second;
+        return SUCCESS;
+    }
+    tree = new LsmTree(fileName, pageSize);
+    RC rc = tree->open();
+    if (rc)
+    {
+        delete tree;
+        tree = NULL;
+        return rc;
+    }
+    lsmTrees[fileName] = tree;
     return SUCCESS;
 }
 
 RC IndexManager::closeFile(IXFileHandle &ixfileHandle)
 {
     PagedFileManager *pfm = PagedFileManager::instance();
+    // The filter's pages are written as keys are added, and its count of keys here
+    IndexFilter *filter = NULL;
+    {
+        lock_guard<mutex> lock(filtersLock);
+        auto open = filters.find(ixfileHandle.fileName);
+        if (open != filters.end())
+            filter = open->second;
+    }
+    if (filter != NULL)
+        filter->writeHeader();
+    ixfileHandle.lsm = NULL;
+    ixfileHandle.pinned = NULL;
+    ixfileHandle.kind = BTREE_INDEX;
     if (pfm->closeFile(ixfileHandle.fh))
         return IX_CLOSE_FAILED;
     return SUCCESS;
@@ -118,17 +263,54 @@ RC IndexManager::closeFile(IXFileHandle &ixfileHandle)
 
 RC IndexManager::insertEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid)
 {
-    ChildEntry childEntry = {.key = NULL, .childPage = 0};
-    int32_t rootPage;
-    RC rc = getRootPageNum(ixfileHandle, rootPage);
+    return insertEntry(ixfileHandle, attribute, key, rid, NULL, 0);
+}
+
+RC IndexManager::insertEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid,
+                             const void *included, unsigned includedSize)
+{
+    RC rc;
+    if (ixfileHandle.lsm != NULL)
+        rc = ixfileHandle.lsm->insertEntry(ixfileHandle, attribute, key, rid, included, includedSize);
+    else if (ixfileHandle.kind == BEPSILON_INDEX)
+    {
+        Message message;
+        message.isDelete = false;
+        message.rid = rid;
+        message.key.assign((const char *)key, getKeySize(attribute, key));
+        message.included.assign((const char *)included, includedSize);
+        rc = bufferMessage(ixfileHandle, attribute, message);
+    }
+    else
+    {
+        ChildEntry childEntry = {.key = NULL, .childPage = 0};
+        int32_t rootPage;
+        rc = getRootPageNum(ixfileHandle, rootPage);
+        if (rc)
+            return rc;
+        // Pin the nodes on the way to the leaf, so that insert reads them from memory
+        int32_t leafPage;
+        if (ixfileHandle.pinned != NULL && (rc = pinnedSearch(ixfileHandle, attribute, key, rootPage, leafPage)))
+            return rc;
+        rc = insert(attribute, key, rid, included, includedSize, ixfileHandle, rootPage, childEntry);
+    }
     if (rc)
         return rc;
-    return insert(attribute, key, rid, ixfileHandle, rootPage, childEntry);
+
+    // The filter learns the key once the entry is in, so that building it again finds the entry
+    IndexFilter *filter = getFilter(ixfileHandle);
+    if (filter == NULL)
+        return SUCCESS;
+    rc = filter->add(IndexFilter::getKeyHash(attribute, key));
+    if (rc == SUCCESS && filter->isFull())
+        rc = createFilter(ixfileHandle, attribute);
+    return rc;
 }
 
-RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &rid, IXFileHandle &fileHandle, int32_t pageID, ChildEntry &childEntry)
+RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &rid, const void *included, unsigned includedSize,
+                        IXFileHandle &fileHandle, int32_t pageID, ChildEntry &childEntry)
 {
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = malloc(fileHandle.getPageSize());
     if (pageData == NULL)
         return IX_MALLOC_FAILED;
     if (fileHandle.readPage(pageID, pageData))
@@ -147,13 +329,13 @@ RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &
             return IX_BAD_CHILD;
 
         // Recursively insert
-        RC rc = insert(attribute, key, rid, fileHandle, childPage, childEntry);
+        RC rc = insert(attribute, key, rid, included, includedSize, fileHandle, childPage, childEntry);
         if (rc)
             return rc;
         if (childEntry.key == NULL)
             return SUCCESS;
         // If we're here, we need to handle a split
-        pageData = malloc(PAGE_SIZE);
+        pageData = malloc(fileHandle.getPageSize());
         if (fileHandle.readPage(pageID, pageData))
         {
             free(pageData);
@@ -192,7 +374,7 @@ RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &
     else // This is a leaf node
     {
         // Try to insert
-        RC rc = insertIntoLeaf(attribute, key, rid, pageData);
+        RC rc = insertIntoLeaf(attribute, key, rid, included, includedSize, pageData);
         if (rc == SUCCESS) // We managed to insert the new pair into this leaf.
         {
             // Write our changes
@@ -210,7 +392,7 @@ RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &
         }
         else if (rc == IX_NO_FREE_SPACE) // Leaf is full and needs to be split
         {
-            rc = splitLeaf(fileHandle, attribute, key, rid, pageID, pageData, childEntry);
+            rc = splitLeaf(fileHandle, attribute, key, rid, included, includedSize, pageID, pageData, childEntry);
             free(pageData);
             pageData = NULL;
             return rc;
@@ -226,18 +408,20 @@ RC IndexManager::insert(const Attribute &attribute, const void *key, const RID &
     }
 }
 
-RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute, const void *ins_key, const RID ins_rid, const int32_t pageID, void *originalLeaf, ChildEntry &childEntry)
+RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute, const void *ins_key, const RID ins_rid,
+                           const void *ins_included, unsigned ins_includedSize, const int32_t pageID, void *originalLeaf,
+                           ChildEntry &childEntry)
 {
     LeafHeader originalHeader = getLeafHeader(originalLeaf);
 
     // Create new leaf to hold overflow
-    void *newLeaf = calloc(PAGE_SIZE, 1);
+    void *newLeaf = calloc(fileHandle.getPageSize(), 1);
     setNodeType(IX_TYPE_LEAF, newLeaf);
     LeafHeader newHeader;
     newHeader.prev = pageID;
     newHeader.next = originalHeader.next;
     newHeader.entriesNumber = 0;
-    newHeader.freeSpaceOffset = PAGE_SIZE;
+    newHeader.freeSpaceOffset = fileHandle.getPageSize();
     setLeafHeader(newHeader, newLeaf);
 
     int32_t newPageNum = fileHandle.getNumberOfPages();
@@ -260,8 +444,9 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
             key = (char *)originalLeaf + entry.varcharOffset;
 
         lastSize = getKeyLengthLeaf(attribute, key);
-        size += lastSize;
-        if (size >= PAGE_SIZE / 2)
+        const char *included;
+        size += lastSize + getIncludedLength(originalLeaf, i, included);
+        if (size >= (int)fileHandle.getPageSize() / 2)
         {
             if (i >= originalHeader.entriesNumber - 1 || compareLeafSlot(attribute, key, originalLeaf, i + 1) != 0)
                 break;
@@ -280,11 +465,19 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
         memcpy(childEntry.key, &(middleEntry.integer), keySize);
 
     void *moving_key = malloc(attribute.length + 4);
+    void *moving_included = malloc(fileHandle.getPageSize());
     for (int j = 1; j < originalHeader.entriesNumber - i; j++)
     {
         // Grab data entry after the middle entry. We then delete it and the rest are shifted over
         DataEntry entry = getDataEntry(i + 1, originalLeaf);
         RID moving_rid = entry.rid;
+        const char *included;
+        uint32_t moving_includedSize = 0;
+        if (getIncludedLength(originalLeaf, i + 1, included))
+        {
+            memcpy(&moving_includedSize, included, sizeof(uint32_t));
+            memcpy(moving_included, included + sizeof(uint32_t), moving_includedSize);
+        }
         if (attribute.type == TypeVarChar)
         {
             int32_t len;
@@ -297,16 +490,17 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
             memcpy(moving_key, &(entry.integer), INT_SIZE);
         }
         // Insert into new leaf, delete from old
-        insertIntoLeaf(attribute, moving_key, moving_rid, newLeaf);
+        insertIntoLeaf(attribute, moving_key, moving_rid, moving_included, moving_includedSize, newLeaf);
         deleteEntryFromLeaf(attribute, moving_key, moving_rid, originalLeaf);
     }
     free(moving_key);
+    free(moving_included);
 
     // Still need to: Write back both (append new leaf)
     // Add new record to correct page
     if (compareLeafSlot(attribute, ins_key, originalLeaf, i) <= 0)
     {
-        if (insertIntoLeaf(attribute, ins_key, ins_rid, originalLeaf))
+        if (insertIntoLeaf(attribute, ins_key, ins_rid, ins_included, ins_includedSize, originalLeaf))
         {
             free(newLeaf);
             return -1;
@@ -314,7 +508,7 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
     }
     else
     {
-        if (insertIntoLeaf(attribute, ins_key, ins_rid, newLeaf))
+        if (insertIntoLeaf(attribute, ins_key, ins_rid, ins_included, ins_includedSize, newLeaf))
         {
             free(newLeaf);
             return -1;
@@ -331,6 +525,23 @@ RC IndexManager::splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute,
         free(newLeaf);
         return IX_APPEND_FAILED;
     }
+    // The leaf that followed the original one now follows the new one
+    if (newHeader.next != 0)
+    {
+        if (fileHandle.readPage(newHeader.next, newLeaf))
+        {
+            free(newLeaf);
+            return IX_READ_FAILED;
+        }
+        LeafHeader nextHeader = getLeafHeader(newLeaf);
+        nextHeader.prev = newPageNum;
+        setLeafHeader(nextHeader, newLeaf);
+        if (fileHandle.writePage(newHeader.next, newLeaf))
+        {
+            free(newLeaf);
+            return IX_WRITE_FAILED;
+        }
+    }
     free(newLeaf);
     return SUCCESS;
 }
@@ -342,13 +553,11 @@ RC IndexManager::insertIntoInternal(const Attribute attribute, ChildEntry entry,
 
     if (getFreeSpaceInternal(pageData) < len)
         return IX_NO_FREE_SPACE;
+    // A node with a buffer keeps few children
+    if (header.bufferPage != 0 && header.entriesNumber + 1 >= BEPSILON_FANOUT)
+        return IX_NO_FREE_SPACE;
 
-    int i;
-    for (i = 0; i < header.entriesNumber; i++)
-    {
-        if (compareSlot(attribute, entry.key, pageData, i) <= 0)
-            break;
-    }
+    int i = findInternalSlot(attribute, entry.key, pageData, false);
 
     // i is slot number where new entry will go
     // i is slot number to move
@@ -359,6 +568,7 @@ RC IndexManager::insertIntoInternal(const Attribute attribute, ChildEntry entry,
 
     IndexEntry newEntry;
     newEntry.childPage = entry.childPage;
+    newEntry.prefix = getKeyPrefix(attribute, entry.key);
     if (attribute.type == TypeInt)
         memcpy(&newEntry.integer, entry.key, INT_SIZE);
     else if (attribute.type == TypeReal)
@@ -377,20 +587,19 @@ RC IndexManager::insertIntoInternal(const Attribute attribute, ChildEntry entry,
     return SUCCESS;
 }
 
-RC IndexManager::insertIntoLeaf(const Attribute attribute, const void *key, const RID &rid, void *pageData)
+RC IndexManager::insertIntoLeaf(const Attribute attribute, const void *key, const RID &rid, const void *included,
+                                unsigned includedSize, void *pageData)
 {
     LeafHeader header = getLeafHeader(pageData);
 
     int32_t key_len = getKeyLengthLeaf(attribute, key);
+    if (includedSize > 0)
+        key_len += sizeof(uint32_t) + includedSize;
     if (getFreeSpaceLeaf(pageData) < key_len)
         return IX_NO_FREE_SPACE;
 
-    int i;
-    for (i = 0; i < header.entriesNumber; i++)
-    {
-        if (compareLeafSlot(attribute, key, pageData, i) < 0)
-            break;
-    }
+    // After any entries with an equal key
+    int i = findLeafSlot(attribute, key, pageData, true);
 
     // i is slot number to move
     int start_offset = getOffsetOfLeafSlot(i);
@@ -400,6 +609,7 @@ RC IndexManager::insertIntoLeaf(const Attribute attribute, const void *key, cons
 
     DataEntry newEntry;
     newEntry.rid = rid;
+    newEntry.prefix = getKeyPrefix(attribute, key);
     if (attribute.type == TypeInt)
         memcpy(&(newEntry.integer), key, INT_SIZE);
     else if (attribute.type == TypeReal)
@@ -412,6 +622,14 @@ RC IndexManager::insertIntoLeaf(const Attribute attribute, const void *key, cons
         memcpy((char *)pageData + newEntry.varcharOffset, key, len + VARCHAR_LENGTH_SIZE);
         header.freeSpaceOffset = newEntry.varcharOffset;
     }
+    newEntry.includedOffset = 0;
+    if (includedSize > 0)
+    {
+        newEntry.includedOffset = header.freeSpaceOffset - (sizeof(uint32_t) + includedSize);
+        memcpy((char *)pageData + newEntry.includedOffset, &includedSize, sizeof(uint32_t));
+        memcpy((char *)pageData + newEntry.includedOffset + sizeof(uint32_t), included, includedSize);
+        header.freeSpaceOffset = newEntry.includedOffset;
+    }
     header.entriesNumber += 1;
     setLeafHeader(header, pageData);
     setDataEntry(newEntry, i, pageData);
@@ -432,6 +650,10 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
 {
     InternalHeader originalHeader = getInternalHeader(original);
 
+    // In a B-epsilon index the new node gets an empty buffer, as the node split has
+    uint32_t newBufferPage = 0;
+    if (originalHeader.bufferPage != 0 && appendBuffer(fileHandle, newBufferPage))
+        return IX_APPEND_FAILED;
     int32_t newPageNum = fileHandle.getNumberOfPages();
 
     int size = 0;
@@ -451,21 +673,24 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
 
         lastSize = getKeyLengthInternal(attribute, key);
         size += lastSize;
-        if (size >= PAGE_SIZE / 2)
+        if (size >= (int)fileHandle.getPageSize() / 2)
         {
             break;
         }
+        if (originalHeader.bufferPage != 0 && i >= originalHeader.entriesNumber / 2)
+            break;
     }
     // i is now middle key
     IndexEntry middleEntry = getIndexEntry(i, original);
 
     // Create new leaf to hold overflow
-    void *newIntern = calloc(PAGE_SIZE, 1);
+    void *newIntern = calloc(fileHandle.getPageSize(), 1);
     setNodeType(IX_TYPE_INTERNAL, newIntern);
     InternalHeader newHeader;
     newHeader.entriesNumber = 0;
-    newHeader.freeSpaceOffset = PAGE_SIZE;
+    newHeader.freeSpaceOffset = fileHandle.getPageSize();
     newHeader.leftChildPage = middleEntry.childPage;
+    newHeader.bufferPage = newBufferPage;
     setInternalHeader(newHeader, newIntern);
 
     // Get size of middle key, and store middle key for later
@@ -506,7 +731,7 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
     deleteEntryFromInternal(attribute, middleKey, original);
 
     // If new key is less than middle key, put it in original node, else put it in new node
-    if (compareSlot(attribute, childEntry.key, original, i) < 0)
+    if (compareKeys(attribute, childEntry.key, middleKey) < 0)
     {
         if (insertIntoInternal(attribute, childEntry, original))
         {
@@ -546,14 +771,20 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
     if (pageID == rootPage)
     {
         // Create new page and set appropriate headers
-        void *newRoot = calloc(PAGE_SIZE, 1);
+        void *newRoot = calloc(fileHandle.getPageSize(), 1);
 
         setNodeType(IX_TYPE_INTERNAL, newRoot);
         InternalHeader rootHeader;
         rootHeader.entriesNumber = 0;
-        rootHeader.freeSpaceOffset = PAGE_SIZE;
+        rootHeader.freeSpaceOffset = fileHandle.getPageSize();
         // Left most will be the smaller of these two pages
         rootHeader.leftChildPage = pageID;
+        rootHeader.bufferPage = 0;
+        if (originalHeader.bufferPage != 0 && appendBuffer(fileHandle, rootHeader.bufferPage))
+        {
+            free(newRoot);
+            return IX_APPEND_FAILED;
+        }
         setInternalHeader(rootHeader, newRoot);
         // Insert larger of these two pages after
         insertIntoInternal(attribute, childEntry, newRoot);
@@ -562,7 +793,9 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
         int newRootPage = fileHandle.getNumberOfPages();
         if (fileHandle.appendPage(newRoot))
             return IX_APPEND_FAILED;
-        MetaHeader metahead;
+        if (fileHandle.readPage(0, newRoot))
+            return IX_READ_FAILED;
+        MetaHeader metahead = getMetaData(newRoot);
         metahead.rootPage = newRootPage;
         setMetaData(metahead, newRoot);
         if (fileHandle.writePage(0, newRoot))
@@ -578,13 +811,26 @@ RC IndexManager::splitInternal(IXFileHandle &fileHandle, const Attribute &attrib
 
 RC IndexManager::deleteEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid)
 {
+    if (ixfileHandle.lsm != NULL)
+        return ixfileHandle.lsm->deleteEntry(ixfileHandle, attribute, key, rid);
+    // A delete in a B-epsilon index is a message like an insert, and the entry is looked for only
+    // once it reaches the leaf
+    if (ixfileHandle.kind == BEPSILON_INDEX)
+    {
+        Message message;
+        message.isDelete = true;
+        message.rid = rid;
+        message.key.assign((const char *)key, getKeySize(attribute, key));
+        return bufferMessage(ixfileHandle, attribute, message);
+    }
+
     int32_t leafPage;
     RC rc = find(ixfileHandle, attribute, key, leafPage);
     if (rc)
         return rc;
     // leafPage is page number of leaf where this entry would be
     // Read in page
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = malloc(ixfileHandle.getPageSize());
     if (ixfileHandle.readPage(leafPage, pageData))
     {
         free(pageData);
@@ -610,13 +856,52 @@ RC IndexManager::scan(IXFileHandle &ixfileHandle,
                       const void *highKey,
                       bool lowKeyInclusive,
                       bool highKeyInclusive,
-                      IX_ScanIterator &ix_ScanIterator)
+                      IX_ScanIterator &ix_ScanIterator,
+                      bool descending)
 {
-    return ix_ScanIterator.initialize(ixfileHandle, attribute, lowKey, highKey, lowKeyInclusive, highKeyInclusive);
+    // An equality scan first asks the filter whether the key can be there
+    IndexFilter *filter = getFilter(ixfileHandle);
+    if (filter != NULL && lowKey != NULL && highKey != NULL && lowKeyInclusive && highKeyInclusive
+        && compareKeys(attribute, lowKey, highKey) == 0)
+    {
+        filter->probes++;
+        if (!filter->mayContain(IndexFilter::getKeyHash(attribute, lowKey)))
+        {
+            filter->negatives++;
+            ix_ScanIterator.filteredOut = true;
+            return SUCCESS;
+        }
+        ix_ScanIterator.probedFilter = filter;
+    }
+
+    if (ixfileHandle.lsm != NULL)
+    {
+        ix_ScanIterator.lsmScan = new LsmScanIterator();
+        RC rc = ixfileHandle.lsm->scan(ixfileHandle, attribute, lowKey, highKey, lowKeyInclusive, highKeyInclusive,
+                                       *ix_ScanIterator.lsmScan);
+        if (rc == SUCCESS && descending)
+        {
+            ix_ScanIterator.fileHandle = &ixfileHandle;
+            ix_ScanIterator.attr = attribute;
+            ix_ScanIterator.descending = true;
+            rc = ix_ScanIterator.collectLsmEntries();
+        }
+        if (rc)
+            ix_ScanIterator.close();
+        return rc;
+    }
+    return ix_ScanIterator.initialize(ixfileHandle, attribute, lowKey, highKey, lowKeyInclusive, highKeyInclusive,
+                                      descending);
 }
 
 void IndexManager::printBtree(IXFileHandle &ixfileHandle, const Attribute &attribute) const
 {
+    if (ixfileHandle.lsm != NULL)
+    {
+        ixfileHandle.lsm->print();
+        return;
+    }
+
     int32_t rootPage;
     getRootPageNum(ixfileHandle, rootPage);
 
@@ -629,7 +914,7 @@ void IndexManager::printBtree(IXFileHandle &ixfileHandle, const Attribute &attri
 // Print comma from calling context.
 void IndexManager::printBtree_rec(IXFileHandle &ixfileHandle, string prefix, const int32_t currPage, const Attribute &attr) const
 {
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = malloc(ixfileHandle.getPageSize());
     ixfileHandle.readPage(currPage, pageData);
 
     NodeType type = getNodetype(pageData);
@@ -784,33 +1069,50 @@ void IndexManager::printInternalSlot(const Attribute &attr, const int32_t slotNu
 
 IX_ScanIterator::IX_ScanIterator()
 {
+    page = NULL;
+    lsmScan = NULL;
+    descending = false;
+    hasLeafEntry = false;
+    leavesDone = false;
+    filteredOut = false;
+    probedFilter = NULL;
 }
 
 IX_ScanIterator::~IX_ScanIterator()
 {
 }
 
-RC IX_ScanIterator::initialize(IXFileHandle &fh, Attribute attribute, const void *low, const void *high, bool lowInc, bool highInc)
+RC IX_ScanIterator::initialize(IXFileHandle &fh, Attribute attribute, const void *low, const void *high, bool lowInc,
+                               bool highInc, bool desc)
 {
     // Store all parameters because we will need them later
     attr = attribute;
     fileHandle = &fh;
     lowKey = low;
     highKey = high;
+    lowKeyPrefix = low == NULL ? 0 : IndexManager::getKeyPrefix(attr, low);
+    highKeyPrefix = high == NULL ? 0 : IndexManager::getKeyPrefix(attr, high);
     lowKeyInclusive = lowInc;
     highKeyInclusive = highInc;
+    descending = desc;
 
     // Initialize our storage
-    page = malloc(PAGE_SIZE);
+    page = malloc(fh.getPageSize());
     if (page == NULL)
         return IX_MALLOC_FAILED;
     // Initialize starting slot number
     slotNum = 0;
 
-    // Find the starting page
+    // Find the starting page, which for a descending scan has the high key
     IndexManager *im = IndexManager::instance();
     int32_t startPageNum;
-    RC rc = im->find(*fileHandle, attr, lowKey, startPageNum);
+    RC rc;
+    if (!descending)
+        rc = im->find(*fileHandle, attr, lowKey, startPageNum);
+    else if (highKey == NULL)
+        rc = im->findLast(*fileHandle, startPageNum);
+    else
+        rc = im->find(*fileHandle, attr, highKey, startPageNum);
     if (rc)
     {
         free(page);
@@ -824,46 +1126,192 @@ RC IX_ScanIterator::initialize(IXFileHandle &fh, Attribute attribute, const void
     }
 
     // Find the starting entry
-    LeafHeader header = im->getLeafHeader(page);
-    int i = 0;
-    for (i = 0; i < header.entriesNumber; i++)
+    if (!descending)
+        slotNum = low == NULL ? 0 : im->findLeafSlot(attr, lowKey, page, !lowKeyInclusive);
+    else if (high == NULL)
+        slotNum = im->getLeafHeader(page).entriesNumber - 1;
+    else
+        slotNum = im->findLeafSlot(attr, highKey, page, highKeyInclusive) - 1;
+
+    // The entries of a B-epsilon index are not all in the leaves yet
+    changes.clear();
+    hasLeafEntry = false;
+    leavesDone = false;
+    if (fh.kind == BEPSILON_INDEX)
     {
-        int cmp = (low == NULL ? -1 : im->compareLeafSlot(attr, lowKey, page, i));
-        if (cmp < 0)
-            break;
-        if (cmp == 0 && lowKeyInclusive)
-            break;
-        if (cmp > 0)
-            continue;
+        rc = im->collectChanges(fh, attr, lowKey, highKey, lowKeyInclusive, highKeyInclusive, changes);
+        if (rc)
+        {
+            free(page);
+            page = NULL;
+            return rc;
+        }
     }
-    slotNum = i;
+    nextChange = descending ? changes.end() : changes.begin();
     return SUCCESS;
 }
 
+RC IX_ScanIterator::collectLsmEntries()
+{
+    Message entry;
+    entry.isDelete = false;
+    entry.key.resize(attr.length + VARCHAR_LENGTH_SIZE);
+    entry.included.resize(fileHandle->getPageSize());
+    unsigned size;
+    RC rc;
+    while ((rc = lsmScan->getNextEntry(entry.rid, &entry.key[0], &entry.included[0], size)) == SUCCESS)
+    {
+        Message &change = changes[IndexManager::getSortKey(attr, entry.key.data(), entry.rid)];
+        change.isDelete = false;
+        change.rid = entry.rid;
+        change.key.assign(entry.key.data(), getKeySize(attr, entry.key.data()));
+        change.included.assign(entry.included.data(), size);
+    }
+    delete lsmScan;
+    lsmScan = NULL;
+    hasLeafEntry = false;
+    leavesDone = true;
+    nextChange = changes.end();
+    return rc == IX_EOF ? SUCCESS : rc;
+}
+
 RC IX_ScanIterator::getNextEntry(RID &rid, void *key)
+{
+    unsigned includedSize;
+    return getNextEntry(rid, key, NULL, includedSize);
+}
+
+RC IX_ScanIterator::getNextEntry(RID &rid, void *key, void *included, unsigned &includedSize)
+{
+    if (filteredOut)
+        return IX_EOF;
+    RC rc = getNextIndexEntry(rid, key, included, includedSize);
+    if (probedFilter != NULL)
+    {
+        if (rc == IX_EOF)
+            probedFilter->falsePositives++;
+        probedFilter = NULL;
+    }
+    return rc;
+}
+
+RC IX_ScanIterator::getNextIndexEntry(RID &rid, void *key, void *included, unsigned &includedSize)
+{
+    if (lsmScan != NULL)
+        return lsmScan->getNextEntry(rid, key, included, includedSize);
+    if (fileHandle->kind != BEPSILON_INDEX && fileHandle->lsm == NULL)
+        return getNextLeafEntry(rid, key, included, includedSize);
+
+    // Merge the entries of the leaves with the changes in buffers, which are newer
+    while (true)
+    {
+        if (!hasLeafEntry && !leavesDone)
+        {
+            unsigned size;
+            leafEntry.key.resize(attr.length + VARCHAR_LENGTH_SIZE);
+            leafEntry.included.resize(fileHandle->getPageSize());
+            RC rc = getNextLeafEntry(leafEntry.rid, &leafEntry.key[0], &leafEntry.included[0], size);
+            if (rc == IX_EOF)
+                leavesDone = true;
+            else if (rc)
+                return rc;
+            else
+            {
+                leafEntry.key.resize(getKeySize(attr, leafEntry.key.data()));
+                leafEntry.included.resize(size);
+                hasLeafEntry = true;
+            }
+        }
+        // A delete only hides an entry of the leaves
+        if (descending)
+        {
+            while (nextChange != changes.begin() && prev(nextChange)->second.isDelete)
+                nextChange--;
+        }
+        else
+        {
+            while (nextChange != changes.end() && nextChange->second.isDelete)
+                nextChange++;
+        }
+
+        const Message *next;
+        bool hasChange = descending ? nextChange != changes.begin() : nextChange != changes.end();
+        auto change = descending && hasChange ? prev(nextChange) : nextChange;
+        int cmp = hasChange && hasLeafEntry ? IndexManager::compareKeys(attr, change->second.key.data(), leafEntry.key.data()) : 0;
+        if (hasChange && (!hasLeafEntry || (descending ? cmp > 0 : cmp < 0)))
+        {
+            next = &change->second;
+            if (descending)
+                nextChange = change;
+            else
+                nextChange++;
+        }
+        else if (hasLeafEntry)
+        {
+            hasLeafEntry = false;
+            auto change = changes.find(IndexManager::getSortKey(attr, leafEntry.key.data(), leafEntry.rid));
+            if (change != changes.end())
+            {
+                if (change->second.isDelete)
+                    continue;
+                // Inserted again, with the included values it has now
+                leafEntry.included = change->second.included;
+                if (change == nextChange)
+                    nextChange = changes.erase(change);
+                else
+                    changes.erase(change);
+            }
+            next = &leafEntry;
+        }
+        else
+            return IX_EOF;
+
+        rid = next->rid;
+        memcpy(key, next->key.data(), next->key.size());
+        includedSize = next->included.size();
+        if (included != NULL)
+            memcpy(included, next->included.data(), includedSize);
+        return SUCCESS;
+    }
+}
+
+RC IX_ScanIterator::getNextLeafEntry(RID &rid, void *key, void *included, unsigned &includedSize)
 {
     IndexManager *im = IndexManager::instance();
     LeafHeader header = im->getLeafHeader(page);
-    // If we have run off the end of the page, jump to the next one
-    if (slotNum >= header.entriesNumber)
+    // If we have run off the end of the page, jump to the next one, or the previous one
+    if (descending ? slotNum < 0 : slotNum >= header.entriesNumber)
     {
+        uint32_t nextPage = descending ? header.prev : header.next;
         // If there is no next page, return EOF
-        if (header.next == 0)
+        if (nextPage == 0)
             return IX_EOF;
-        slotNum = 0;
-        fileHandle->readPage(header.next, page);
-        return getNextEntry(rid, key);
-    }
-    // If highkey is null, always carry on
-    // Otherwise, carry on only if highkey is greater than the current key
-    int cmp = highKey == NULL ? 1 : im->compareLeafSlot(attr, highKey, page, slotNum);
-    if (cmp == 0 && !highKeyInclusive)
-        return IX_EOF;
-    if (cmp < 0)
-        return IX_EOF;
-
-    // Grab the data entry, grab its rid
+        fileHandle->readPage(nextPage, page);
+        slotNum = descending ? im->getLeafHeader(page).entriesNumber - 1 : 0;
+        return getNextLeafEntry(rid, key, included, includedSize);
+    }
     DataEntry entry = im->getDataEntry(slotNum, page);
+    if (descending)
+    {
+        // Carry on only if lowkey, if any, is less than the current key
+        int cmp = lowKey == NULL ? -1
+                                 : IndexManager::compareEntry(attr, lowKey, lowKeyPrefix, entry.prefix, entry.varcharOffset, page);
+        if (cmp > 0 || (cmp == 0 && !lowKeyInclusive))
+            return IX_EOF;
+    }
+    else
+    {
+        // If highkey is null, always carry on
+        // Otherwise, carry on only if highkey is greater than the current key
+        int cmp = highKey == NULL ? 1
+                                  : IndexManager::compareEntry(attr, highKey, highKeyPrefix, entry.prefix, entry.varcharOffset, page);
+        if (cmp == 0 && !highKeyInclusive)
+            return IX_EOF;
+        if (cmp < 0)
+            return IX_EOF;
+    }
+
+    // Grab its rid
     rid.pageNum = entry.rid.pageNum;
     rid.slotNum = entry.rid.slotNum;
     // grab its key
@@ -878,14 +1326,29 @@ RC IX_ScanIterator::getNextEntry(RID &rid, void *key)
         memcpy(key, &len, VARCHAR_LENGTH_SIZE);
         memcpy((char *)key + VARCHAR_LENGTH_SIZE, (char *)page + entry.varcharOffset + VARCHAR_LENGTH_SIZE, len);
     }
-    // increment slotNum for the next call to getNextEntry
-    slotNum++;
+    // and what it includes
+    includedSize = 0;
+    if (entry.includedOffset != 0)
+    {
+        memcpy(&includedSize, (char *)page + entry.includedOffset, sizeof(uint32_t));
+        if (included != NULL)
+            memcpy(included, (char *)page + entry.includedOffset + sizeof(uint32_t), includedSize);
+    }
+    // move slotNum on for the next call to getNextEntry
+    slotNum += descending ? -1 : 1;
     return SUCCESS;
 }
 
 RC IX_ScanIterator::close()
 {
     free(page);
+    page = NULL;
+    delete lsmScan;
+    lsmScan = NULL;
+    changes.clear();
+    descending = false;
+    filteredOut = false;
+    probedFilter = NULL;
     return SUCCESS;
 }
 
@@ -894,6 +1357,9 @@ IXFileHandle::IXFileHandle()
     ixReadPageCounter = 0;
     ixWritePageCounter = 0;
     ixAppendPageCounter = 0;
+    kind = BTREE_INDEX;
+    lsm = NULL;
+    pinned = NULL;
 }
 
 IXFileHandle::~IXFileHandle()
@@ -910,6 +1376,25 @@ RC IXFileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePa
 
 RC IXFileHandle::readPage(PageNum pageNum, void *data)
 {
+    // A pinned page is read from memory
+    if (pinned != NULL)
+    {
+        lock_guard<mutex> lock(pinned->lock);
+        const void *page = NULL;
+        if (pageNum == 0)
+            page = pinned->metaPage;
+        else
+        {
+            auto node = pinned->nodes.find(pageNum);
+            if (node != pinned->nodes.end())
+                page = node->second->page;
+        }
+        if (page != NULL)
+        {
+            memcpy(data, page, getPageSize());
+            return SUCCESS;
+        }
+    }
     ixReadPageCounter++;
     return fh.readPage(pageNum, data);
 }
@@ -917,7 +1402,33 @@ RC IXFileHandle::readPage(PageNum pageNum, void *data)
 RC IXFileHandle::writePage(PageNum pageNum, const void *data)
 {
     ixWritePageCounter++;
-    return fh.writePage(pageNum, data);
+    RC rc = fh.writePage(pageNum, data);
+    if (rc == SUCCESS && pinned != NULL)
+        updatePinned(pageNum, data);
+    return rc;
+}
+
+void IXFileHandle::updatePinned(PageNum pageNum, const void *data)
+{
+    IndexManager *im = IndexManager::instance();
+    lock_guard<mutex> lock(pinned->lock);
+    if (pageNum == 0)
+    {
+        if (pinned->metaPage == NULL)
+            return;
+        uint32_t rootPage = im->getMetaData(pinned->metaPage).rootPage;
+        memcpy(pinned->metaPage, data, getPageSize());
+        // The nodes are pinned again from the new root down
+        if (im->getMetaData(data).rootPage != rootPage)
+            im->unpinNodes(pinned);
+        return;
+    }
+    auto node = pinned->nodes.find(pageNum);
+    if (node == pinned->nodes.end())
+        return;
+    memcpy(node->second->page, data, getPageSize());
+    // Children may have moved to a node split off
+    im->resetChildren(node->second);
 }
 
 RC IXFileHandle::appendPage(const void *data)
@@ -926,6 +1437,11 @@ RC IXFileHandle::appendPage(const void *data)
     return fh.appendPage(data);
 }
 
+unsigned IXFileHandle::getPageSize() const
+{
+    return fh.getPageSize();
+}
+
 unsigned IXFileHandle::getNumberOfPages()
 {
     return fh.getNumberOfPages();
@@ -1019,7 +1535,7 @@ DataEntry IndexManager::getDataEntry(const int slotNum, const void *pageData) co
 
 RC IndexManager::getRootPageNum(IXFileHandle &fileHandle, int32_t &result) const
 {
-    void *metaPage = malloc(PAGE_SIZE);
+    void *metaPage = malloc(fileHandle.getPageSize());
     if (metaPage == NULL)
         return IX_MALLOC_FAILED;
     RC rc = fileHandle.readPage(0, metaPage);
@@ -1041,190 +1557,569 @@ RC IndexManager::find(IXFileHandle &handle, const Attribute attr, const void *ke
     RC rc = getRootPageNum(handle, rootPageNum);
     if (rc)
         return rc;
+    if (handle.pinned != NULL)
+        return pinnedSearch(handle, attr, key, rootPageNum, resultPageNum);
     return treeSearch(handle, attr, key, rootPageNum, resultPageNum);
 }
 
-RC IndexManager::treeSearch(IXFileHandle &handle, const Attribute attr, const void *key, const int32_t currPageNum, int32_t &resultPageNum)
+RC IndexManager::findLast(IXFileHandle &handle, int32_t &resultPageNum)
 {
-    void *pageData = malloc(PAGE_SIZE);
-
-    if (handle.readPage(currPageNum, pageData))
-    {
-        free(pageData);
-        return IX_READ_FAILED;
-    }
-
-    // Found our leaf!
-    if (getNodetype(pageData) == IX_TYPE_LEAF)
+    int32_t pageNum;
+    RC rc = getRootPageNum(handle, pageNum);
+    if (rc)
+        return rc;
+    void *pageData = malloc(handle.getPageSize());
+    if (pageData == NULL)
+        return IX_MALLOC_FAILED;
+    // Down the last child of each node
+    while (true)
     {
-        resultPageNum = currPageNum;
-        free(pageData);
-        return SUCCESS;
+        if (handle.readPage(pageNum, pageData))
+        {
+            free(pageData);
+            return IX_READ_FAILED;
+        }
+        if (getNodetype(pageData) == IX_TYPE_LEAF)
+            break;
+        InternalHeader header = getInternalHeader(pageData);
+        pageNum = header.entriesNumber == 0 ? header.leftChildPage : getIndexEntry(header.entriesNumber - 1, pageData).childPage;
     }
-
-    int32_t nextChildPage = getNextChildPage(attr, key, pageData);
-
     free(pageData);
-    return treeSearch(handle, attr, key, nextChildPage, resultPageNum);
+    resultPageNum = pageNum;
+    return SUCCESS;
 }
 
-int32_t IndexManager::getNextChildPage(const Attribute attr, const void *key, void *pageData)
+RC IndexManager::pinnedSearch(IXFileHandle &handle, const Attribute &attr, const void *key, int32_t rootPageNum,
+                              int32_t &resultPageNum)
 {
-    InternalHeader header = getInternalHeader(pageData);
-    if (key == NULL)
-        return header.leftChildPage;
-
-    int i = 0;
-    for (i = 0; i < header.entriesNumber; i++)
-    {
-        // If key < slot key we have, then the previous entry holds the path
-        if (compareSlot(attr, key, pageData, i) <= 0)
-            break;
-    }
-    int32_t result;
-    // Special case where key is less than all entries in this node
-    if (i == 0)
-    {
-        result = header.leftChildPage;
-    }
-    // Usual case where we grab the child to the right of the largest entry less than key
-    // This also works if key is larger than all entries
-    else
+    // The descent through the pinned levels holds the tree's lock; the one below them, which
+    // reads pages through the handle, does not
+    int32_t unpinnedPageNum;
     {
-        IndexEntry entry = getIndexEntry(i - 1, pageData);
-        result = entry.childPage;
+        lock_guard<mutex> lock(handle.pinned->lock);
+        RC rc = pinnedDescend(handle, attr, key, rootPageNum, resultPageNum, unpinnedPageNum);
+        if (rc || unpinnedPageNum < 0)
+            return rc;
     }
-    return result;
+    return treeSearch(handle, attr, key, unpinnedPageNum, resultPageNum);
 }
 
-int IndexManager::compareSlot(const Attribute attr, const void *key, const void *pageData, const int slotNum) const
+RC IndexManager::pinnedDescend(IXFileHandle &handle, const Attribute &attr, const void *key, int32_t rootPageNum,
+                               int32_t &resultPageNum, int32_t &unpinnedPageNum)
 {
-    IndexEntry entry = getIndexEntry(slotNum, pageData);
-    if (attr.type == TypeInt)
+    unpinnedPageNum = -1;
+    PinnedNode *node = handle.pinned->root;
+    bool isLeaf;
+    if (node == NULL || node->pageNum != (PageNum)rootPageNum)
     {
-        int32_t int_key;
-        memcpy(&int_key, key, INT_SIZE);
-        return compare(int_key, entry.integer);
+        RC rc = pinNode(handle, rootPageNum, 0, node, isLeaf);
+        if (rc)
+            return rc;
+        if (node == NULL)
+        {
+            unpinnedPageNum = rootPageNum;
+            return SUCCESS;
+        }
+        handle.pinned->root = node;
     }
-    else if (attr.type == TypeReal)
+
+    while (true)
     {
-        float real_key;
-        memcpy(&real_key, key, REAL_SIZE);
-        return compare(real_key, entry.real);
+        int slot = key == NULL ? 0 : findInternalSlot(attr, key, node->page, false);
+        int32_t childPage = slot == 0 ? getInternalHeader(node->page).leftChildPage
+                                      : getIndexEntry(slot - 1, node->page).childPage;
+        if (node->leafChildren)
+        {
+            resultPageNum = childPage;
+            return SUCCESS;
+        }
+        PinnedNode *child = node->children[slot];
+        if (child == NULL)
+        {
+            RC rc = pinNode(handle, childPage, node->level + 1, child, isLeaf);
+            if (rc)
+                return rc;
+            if (isLeaf)
+            {
+                node->leafChildren = true;
+                resultPageNum = childPage;
+                return SUCCESS;
+            }
+            // Below the pinned levels
+            if (child == NULL)
+            {
+                unpinnedPageNum = childPage;
+                return SUCCESS;
+            }
+            node->children[slot] = child;
+        }
+        node = child;
     }
-    else
+}
+
+RC IndexManager::pinNode(IXFileHandle &fileHandle, PageNum pageNum, unsigned level, PinnedNode *&node, bool &isLeaf)
+{
+    PinnedTree *tree = fileHandle.pinned;
+    node = NULL;
+    isLeaf = false;
+    auto pinned = tree->nodes.find(pageNum);
+    if (pinned != tree->nodes.end())
+    {
+        node = pinned->second;
+        return SUCCESS;
+    }
+    if (level >= IX_PINNED_LEVELS || (tree->nodes.size() + 1) * fileHandle.getPageSize() > IX_PINNED_BYTES)
+        return SUCCESS;
+
+    // The page is not pinned, so it is read from the file; readPage would take the tree's lock
+    void *page = malloc(fileHandle.getPageSize());
+    if (page == NULL)
+        return IX_MALLOC_FAILED;
+    fileHandle.ixReadPageCounter++;
+    if (fileHandle.fh.readPage(pageNum, page))
     {
-        int32_t key_size;
-        memcpy(&key_size, key, VARCHAR_LENGTH_SIZE);
-        char key_text[key_size + 1];
-        key_text[key_size] = '\0';
-        memcpy(key_text, (char *)key + VARCHAR_LENGTH_SIZE, key_size);
+        free(page);
+        return IX_READ_FAILED;
+    }
+    if (getNodetype(page) == IX_TYPE_LEAF)
+    {
+        free(page);
+        isLeaf = true;
+        return SUCCESS;
+    }
+    node = new PinnedNode();
+    node->pageNum = pageNum;
+    node->level = level;
+    node->page = page;
+    node->leafChildren = false;
+    resetChildren(node);
+    tree->nodes[pageNum] = node;
+    return SUCCESS;
+}
 
-        int32_t value_offset = entry.varcharOffset;
-        int32_t value_size;
-        memcpy(&value_size, (char *)pageData + value_offset, VARCHAR_LENGTH_SIZE);
-        char value_text[value_size + 1];
-        value_text[value_size] = '\0';
-        memcpy(value_text, (char *)pageData + value_offset + VARCHAR_LENGTH_SIZE, value_size);
+void IndexManager::resetChildren(PinnedNode *node) const
+{
+    node->children.assign(getInternalHeader(node->page).entriesNumber + 1, NULL);
+}
 
-        return compare(key_text, value_text);
+void IndexManager::unpinNodes(PinnedTree *tree) const
+{
+    for (auto &node : tree->nodes)
+    {
+        free(node.second->page);
+        delete node.second;
     }
-    return 0;
+    tree->nodes.clear();
+    tree->root = NULL;
 }
 
-int IndexManager::compareLeafSlot(const Attribute attr, const void *key, const void *pageData, const int slotNum) const
+IndexFilter *IndexManager::getFilter(IXFileHandle &ixfileHandle)
 {
-    DataEntry entry = getDataEntry(slotNum, pageData);
-    if (attr.type == TypeInt)
+    lock_guard<mutex> lock(filtersLock);
+    auto open = filters.find(ixfileHandle.fileName);
+    if (open != filters.end())
+        return open->second;
+    // An index without a filter has no file of one to open
+    IndexFilter *filter = new IndexFilter(ixfileHandle.fileName, ixfileHandle.getPageSize());
+    if (filter->open() != SUCCESS)
     {
-        int32_t int_key;
-        memcpy(&int_key, key, INT_SIZE);
-        return compare(int_key, entry.integer);
+        delete filter;
+        filter = NULL;
     }
-    else if (attr.type == TypeReal)
+    filters[ixfileHandle.fileName] = filter;
+    return filter;
+}
+
+void IndexManager::dropFilter(const string &fileName)
+{
+    IndexFilter *dropped = NULL;
     {
-        float real_key;
-        memcpy(&real_key, key, REAL_SIZE);
-        return compare(real_key, entry.real);
+        lock_guard<mutex> lock(filtersLock);
+        auto filter = filters.find(fileName);
+        if (filter != filters.end())
+        {
+            dropped = filter->second;
+            filters.erase(filter);
+        }
     }
+    delete dropped;
+    PagedFileManager::instance()->destroyFile(fileName + ".filter");
+}
+
+RC IndexManager::createFilter(IXFileHandle &ixfileHandle, const Attribute &attribute)
+{
+    // The keys of all entries, scanned without the filter there may be
+    IndexFilter *filter = getFilter(ixfileHandle);
+    setFilter(ixfileHandle.fileName, NULL);
+    vector<uint64_t> hashes;
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    if (rc == SUCCESS)
+    {
+        RID rid;
+        void *key = malloc(attribute.length + VARCHAR_LENGTH_SIZE);
+        while ((rc = ix_ScanIterator.getNextEntry(rid, key)) == SUCCESS)
+            hashes.push_back(IndexFilter::getKeyHash(attribute, key));
+        free(key);
+        ix_ScanIterator.close();
+        if (rc == IX_EOF)
+            rc = SUCCESS;
+    }
+
+    // Sized for twice the keys, so that it is built again once as many more are added
+    if (filter == NULL)
+        filter = new IndexFilter(ixfileHandle.fileName, ixfileHandle.getPageSize());
+    if (rc == SUCCESS)
+        rc = filter->create(2 * hashes.size(), hashes);
+    setFilter(ixfileHandle.fileName, filter);
+    if (rc)
+        dropFilter(ixfileHandle.fileName);
+    return rc;
+}
+
+void IndexManager::setFilter(const string &fileName, IndexFilter *filter)
+{
+    lock_guard<mutex> lock(filtersLock);
+    filters[fileName] = filter;
+}
+
+RC IndexManager::getFilterStats(IXFileHandle &ixfileHandle, FilterStats &stats)
+{
+    IndexFilter *filter = getFilter(ixfileHandle);
+    if (filter == NULL)
+        return IX_NO_FILTER;
+    filter->getStats(stats);
+    return SUCCESS;
+}
+
+void IndexManager::unpinTree(const string &fileName)
+{
+    lock_guard<mutex> lock(pinnedTreesLock);
+    auto tree = pinnedTrees.find(fileName);
+    if (tree == pinnedTrees.end())
+        return;
+    unpinNodes(tree->second);
+    free(tree->second->metaPage);
+    delete tree->second;
+    pinnedTrees.erase(tree);
+}
+
+RC IndexManager::treeSearch(IXFileHandle &handle, const Attribute attr, const void *key, const int32_t currPageNum, int32_t &resultPageNum)
+{
+    void *pageData = malloc(handle.getPageSize());
+
+    if (handle.readPage(currPageNum, pageData))
+    {
+        free(pageData);
+        return IX_READ_FAILED;
+    }
+
+    // Found our leaf!
+    if (getNodetype(pageData) == IX_TYPE_LEAF)
+    {
+        resultPageNum = currPageNum;
+        free(pageData);
+        return SUCCESS;
+    }
+
+    int32_t nextChildPage = getNextChildPage(attr, key, pageData);
+
+    free(pageData);
+    return treeSearch(handle, attr, key, nextChildPage, resultPageNum);
+}
+
+int32_t IndexManager::getNextChildPage(const Attribute attr, const void *key, void *pageData)
+{
+    InternalHeader header = getInternalHeader(pageData);
+    if (key == NULL)
+        return header.leftChildPage;
+
+    // If key <= slot key we have, then the previous entry holds the path
+    int i = findInternalSlot(attr, key, pageData, false);
+    int32_t result;
+    // Special case where key is less than all entries in this node
+    if (i == 0)
+    {
+        result = header.leftChildPage;
+    }
+    // Usual case where we grab the child to the right of the largest entry less than key
+    // This also works if key is larger than all entries
     else
     {
-        int32_t key_size;
-        memcpy(&key_size, key, VARCHAR_LENGTH_SIZE);
-        char key_text[key_size + 1];
-        key_text[key_size] = '\0';
-        memcpy(key_text, (char *)key + VARCHAR_LENGTH_SIZE, key_size);
+        IndexEntry entry = getIndexEntry(i - 1, pageData);
+        result = entry.childPage;
+    }
+    return result;
+}
 
-        int32_t value_offset = entry.varcharOffset;
-        int32_t value_size;
-        memcpy(&value_size, (char *)pageData + value_offset, VARCHAR_LENGTH_SIZE);
-        char value_text[value_size + 1];
-        value_text[value_size] = '\0';
-        memcpy(value_text, (char *)pageData + value_offset + VARCHAR_LENGTH_SIZE, value_size);
+int IndexManager::compareSlot(const Attribute attr, const void *key, const void *pageData, const int slotNum) const
+{
+    IndexEntry entry = getIndexEntry(slotNum, pageData);
+    return compareEntry(attr, key, getKeyPrefix(attr, key), entry.prefix, entry.varcharOffset, pageData);
+}
 
-        return compare(key_text, value_text);
+int IndexManager::compareLeafSlot(const Attribute attr, const void *key, const void *pageData, const int slotNum) const
+{
+    DataEntry entry = getDataEntry(slotNum, pageData);
+    return compareEntry(attr, key, getKeyPrefix(attr, key), entry.prefix, entry.varcharOffset, pageData);
+}
+
+int IndexManager::compareEntry(const Attribute &attr, const void *key, uint32_t keyPrefix, uint32_t prefix,
+                               int32_t varcharOffset, const void *pageData)
+{
+    if (keyPrefix != prefix)
+        return keyPrefix < prefix ? -1 : 1;
+    if (attr.type != TypeVarChar)
+        return 0;
+    int32_t key_size;
+    memcpy(&key_size, key, VARCHAR_LENGTH_SIZE);
+    int32_t value_size;
+    memcpy(&value_size, (char *)pageData + varcharOffset, VARCHAR_LENGTH_SIZE);
+    return compare((char *)key + VARCHAR_LENGTH_SIZE, key_size,
+                   (char *)pageData + varcharOffset + VARCHAR_LENGTH_SIZE, value_size);
+}
+
+int IndexManager::compareKeys(const Attribute &attr, const void *key, const void *value)
+{
+    uint32_t keyPrefix = getKeyPrefix(attr, key);
+    uint32_t valuePrefix = getKeyPrefix(attr, value);
+    if (keyPrefix != valuePrefix)
+        return keyPrefix < valuePrefix ? -1 : 1;
+    if (attr.type != TypeVarChar)
+        return 0;
+    int32_t key_size;
+    int32_t value_size;
+    memcpy(&key_size, key, VARCHAR_LENGTH_SIZE);
+    memcpy(&value_size, value, VARCHAR_LENGTH_SIZE);
+    return compare((char *)key + VARCHAR_LENGTH_SIZE, key_size, (char *)value + VARCHAR_LENGTH_SIZE, value_size);
+}
+
+int IndexManager::compare(const char *key, int32_t keySize, const char *value, int32_t valueSize)
+{
+    int cmp = memcmp(key, value, min(keySize, valueSize));
+    if (cmp != 0)
+        return cmp < 0 ? -1 : 1;
+    return (keySize > valueSize) - (keySize < valueSize);
+}
+
+int IndexManager::findLeafSlot(const Attribute &attr, const void *key, const void *pageData, bool after) const
+{
+    uint32_t keyPrefix = getKeyPrefix(attr, key);
+    int low = 0;
+    int high = getLeafHeader(pageData).entriesNumber;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        DataEntry entry = getDataEntry(middle, pageData);
+        int cmp = compareEntry(attr, key, keyPrefix, entry.prefix, entry.varcharOffset, pageData);
+        if (cmp > 0 || (cmp == 0 && after))
+            low = middle + 1;
+        else
+            high = middle;
     }
-    return 0; // suppress warnings
+    return low;
+}
+
+int IndexManager::findInternalSlot(const Attribute &attr, const void *key, const void *pageData, bool after) const
+{
+    uint32_t keyPrefix = getKeyPrefix(attr, key);
+    int low = 0;
+    int high = getInternalHeader(pageData).entriesNumber;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        IndexEntry entry = getIndexEntry(middle, pageData);
+        int cmp = compareEntry(attr, key, keyPrefix, entry.prefix, entry.varcharOffset, pageData);
+        if (cmp > 0 || (cmp == 0 && after))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// The normalized forms of an int and of a real, as numbers whose big-endian bytes are the key.
+// Both zeros of a real are equal, so -0 is normalized as 0.
+static uint32_t normalizeInt(uint32_t bits)
+{
+    return bits ^ 0x80000000;
 }
-int IndexManager::compare(const void *key, const void *value, const Attribute attr) const
+
+static uint32_t normalizeReal(uint32_t bits)
+{
+    if (bits == 0x80000000)
+        bits = 0;
+    return bits & 0x80000000 ? ~bits : bits ^ 0x80000000;
+}
+
+static uint32_t denormalizeReal(uint32_t normalized)
+{
+    return normalized & 0x80000000 ? normalized ^ 0x80000000 : ~normalized;
+}
+
+uint32_t IndexManager::getKeyPrefix(const Attribute &attr, const void *key)
 {
+    uint32_t bits;
     switch (attr.type)
     {
     case TypeInt:
+        memcpy(&bits, key, INT_SIZE);
+        return normalizeInt(bits);
+    case TypeReal:
+        memcpy(&bits, key, REAL_SIZE);
+        return normalizeReal(bits);
+    case TypeVarChar:
+        break;
+    }
+    int32_t length;
+    memcpy(&length, key, VARCHAR_LENGTH_SIZE);
+    const unsigned char *bytes = (const unsigned char *)key + VARCHAR_LENGTH_SIZE;
+    uint32_t prefix = 0;
+    for (int i = 0; i < 4; i++)
+        prefix = (prefix << 8) | (i < length ? bytes[i] : 0);
+    return prefix;
+}
+
+// Each attribute of a composite key starts with a byte telling whether it is NULL, followed by
+// the normalized form of its value
+#define COMPOSITE_NULL 0x00
+#define COMPOSITE_VALUE 0x01
+#define COMPOSITE_PAST_PREFIX 0x02
+
+static void putBigEndian(uint32_t value, unsigned char *bytes)
+{
+    for (int i = 3; i >= 0; i--)
     {
-        int key_int = *(int *)key;
-        int value_int = *(int *)value;
-        return compare(key_int, value_int);
+        bytes[i] = value & 0xFF;
+        value >>= 8;
     }
-    case TypeReal:
+}
+
+static uint32_t getBigEndian(const unsigned char *bytes)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+unsigned IndexManager::normalizeKey(const Attribute &attr, const void *key, void *normalized)
+{
+    unsigned char *bytes = (unsigned char *)normalized;
+    if (attr.type != TypeVarChar)
     {
-        float key_float = *(float *)key;
-        float value_float = *(float *)value;
-        return compare(key_float, value_float);
+        putBigEndian(getKeyPrefix(attr, key), bytes);
+        return INT_SIZE;
     }
-    case TypeVarChar:
+    int32_t length;
+    memcpy(&length, key, VARCHAR_LENGTH_SIZE);
+    const char *text = (const char *)key + VARCHAR_LENGTH_SIZE;
+    unsigned size = 0;
+    for (int32_t j = 0; j < length; j++)
     {
-        size_t key_size;
-        size_t value_size;
-        memcpy(&key_size, key, sizeof(uint32_t));
-        memcpy(&value_size, value, sizeof(uint32_t));
-        char key_array[key_size + 1];
-        char value_array[value_size + 1];
-        memcpy(key_array, (char *)key + sizeof(uint32_t), key_size);
-        memcpy(value_array, (char *)value + sizeof(uint32_t), value_size);
-        key_array[key_size] = '\0';
-        value_array[value_size] = '\0';
-        return compare(key_array, value_array);
+        bytes[size++] = text[j];
+        if (text[j] == 0)
+            bytes[size++] = 0xFF;
     }
+    bytes[size++] = 0;
+    bytes[size++] = 0;
+    return size;
+}
+
+unsigned IndexManager::denormalizeKey(const Attribute &attr, const void *normalized, void *key)
+{
+    const unsigned char *bytes = (const unsigned char *)normalized;
+    uint32_t bits;
+    switch (attr.type)
+    {
+    case TypeInt:
+        bits = normalizeInt(getBigEndian(bytes));
+        memcpy(key, &bits, INT_SIZE);
+        return INT_SIZE;
+    case TypeReal:
+        bits = denormalizeReal(getBigEndian(bytes));
+        memcpy(key, &bits, REAL_SIZE);
+        return REAL_SIZE;
+    case TypeVarChar:
+        break;
+    }
+    int32_t length = 0;
+    unsigned size = 0;
+    char *text = (char *)key + VARCHAR_LENGTH_SIZE;
+    while (bytes[size] != 0 || bytes[size + 1] != 0)
+    {
+        text[length++] = bytes[size];
+        size += bytes[size] == 0 ? 2 : 1;
     }
-    throw "Attribute is malformed";
-    return -2;
+    memcpy(key, &length, VARCHAR_LENGTH_SIZE);
+    return size + 2;
 }
-int IndexManager::compare(const int key, const int value) const
+
+string IndexManager::getSortKey(const Attribute &attr, const void *key, const RID &rid)
 {
-    if (key == value)
-        return 0;
-    if (key > value)
-        return 1;
-    if (key < value)
-        return -1;
-    return 0; // suppress warnings
+    int32_t length = INT_SIZE;
+    if (attr.type == TypeVarChar)
+        memcpy(&length, key, VARCHAR_LENGTH_SIZE);
+    // At worst every byte of a varchar is followed by another, and then two more end it
+    string sortKey(2 * length + 2 + 2 * sizeof(uint32_t), 0);
+    unsigned size = normalizeKey(attr, key, &sortKey[0]);
+    putBigEndian(rid.pageNum, (unsigned char *)&sortKey[size]);
+    putBigEndian(rid.slotNum, (unsigned char *)&sortKey[size + sizeof(uint32_t)]);
+    sortKey.resize(size + 2 * sizeof(uint32_t));
+    return sortKey;
 }
 
-int IndexManager::compare(const float key, const float value) const
+void IndexManager::encodeCompositeKey(const vector<Attribute> &attrs, unsigned attrCount, const void *tuple, void *key,
+                                      bool pastPrefix)
 {
-    if (key == value)
-        return 0;
-    if (key > value)
-        return 1;
-    if (key < value)
-        return -1;
-    return 0;
+    char *nullIndicator = (char *)tuple;
+    const char *value = (const char *)tuple + RecordBasedFileManager::getNullIndicatorSize(attrCount);
+    unsigned char *bytes = (unsigned char *)key + VARCHAR_LENGTH_SIZE;
+    unsigned size = 0;
+    for (unsigned i = 0; i < attrCount; i++)
+    {
+        if (RecordBasedFileManager::fieldIsNull(nullIndicator, i))
+        {
+            bytes[size++] = COMPOSITE_NULL;
+            continue;
+        }
+        bytes[size++] = COMPOSITE_VALUE;
+        size += normalizeKey(attrs[i], value, bytes + size);
+        value += getKeySize(attrs[i], value);
+    }
+    // Every longer key has a NULL or value byte next
+    if (pastPrefix && attrCount < attrs.size())
+        bytes[size++] = COMPOSITE_PAST_PREFIX;
+    int32_t length = size;
+    memcpy(key, &length, VARCHAR_LENGTH_SIZE);
 }
 
-int IndexManager::compare(const char *key, const char *value) const
+void IndexManager::decodeCompositeKey(const vector<Attribute> &attrs, const void *key, void *tuple)
 {
-    return strcmp(key, value);
+    int nullIndicatorSize = RecordBasedFileManager::getNullIndicatorSize(attrs.size());
+    memset(tuple, 0, nullIndicatorSize);
+    const unsigned char *bytes = (const unsigned char *)key + VARCHAR_LENGTH_SIZE;
+    char *value = (char *)tuple + nullIndicatorSize;
+    for (unsigned i = 0; i < attrs.size(); i++)
+    {
+        if (*bytes++ == COMPOSITE_NULL)
+        {
+            ((char *)tuple)[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - i % CHAR_BIT);
+            continue;
+        }
+        bytes += denormalizeKey(attrs[i], bytes, value);
+        value += getKeySize(attrs[i], value);
+    }
+}
+
+unsigned IndexManager::getCompositeKeyLength(const vector<Attribute> &attrs)
+{
+    // The NULL byte of each, a 0xFF after every byte of a varchar and its two closing bytes, and
+    // the byte that ends a prefix
+    unsigned length = 1;
+    for (const Attribute &attr : attrs)
+        length += 1 + (attr.type == TypeVarChar ? 2 * attr.length + 2 : 4);
+    return length;
 }
 
 // Get size needed to insert key into page
@@ -1254,6 +2149,17 @@ int IndexManager::getKeyLengthLeaf(const Attribute attr, const void *key) const
     return size;
 }
 
+int IndexManager::getIncludedLength(const void *pageData, const int slotNum, const char *&included) const
+{
+    DataEntry entry = getDataEntry(slotNum, pageData);
+    if (entry.includedOffset == 0)
+        return 0;
+    included = (const char *)pageData + entry.includedOffset;
+    uint32_t includedSize;
+    memcpy(&includedSize, included, sizeof(uint32_t));
+    return sizeof(uint32_t) + includedSize;
+}
+
 int IndexManager::getFreeSpaceInternal(void *pageData) const
 {
     InternalHeader header = getInternalHeader(pageData);
@@ -1270,18 +2176,15 @@ RC IndexManager::deleteEntryFromLeaf(const Attribute attr, const void *key, cons
 {
     LeafHeader header = getLeafHeader(pageData);
 
+    // Find a slot whose key and rid are equal to the given key and rid, among those with the key
     int i;
-    for (i = 0; i < header.entriesNumber; i++)
+    for (i = findLeafSlot(attr, key, pageData, false); i < header.entriesNumber; i++)
     {
-        // Find a slot whose key and rid are equal to the given key and rid
-        if (compareLeafSlot(attr, key, pageData, i) == 0)
-        {
-            DataEntry entry = getDataEntry(i, pageData);
-            if (entry.rid.pageNum == rid.pageNum && entry.rid.slotNum == rid.slotNum)
-            {
-                break;
-            }
-        }
+        if (compareLeafSlot(attr, key, pageData, i) != 0)
+            return IX_RECORD_DN_EXIST;
+        DataEntry entry = getDataEntry(i, pageData);
+        if (entry.rid.pageNum == rid.pageNum && entry.rid.slotNum == rid.slotNum)
+            break;
     }
     // If we failed to find one, error out
     if (i == header.entriesNumber)
@@ -1297,45 +2200,53 @@ RC IndexManager::deleteEntryFromLeaf(const Attribute attr, const void *key, cons
     memmove((char *)pageData + slotStartOffset, (char *)pageData + slotStartOffset + sizeof(DataEntry), slotEndOffset - slotStartOffset - sizeof(DataEntry));
 
     header.entriesNumber -= 1;
+    setLeafHeader(header, pageData);
 
     // Now, if we're a varchar, we need to move all of the varchars over as well
     if (attr.type == TypeVarChar)
     {
-        int32_t varcharOffset = entry.varcharOffset;
         int32_t varchar_len;
-        memcpy(&varchar_len, (char *)pageData + varcharOffset, VARCHAR_LENGTH_SIZE);
-        int32_t entryLen = varchar_len + VARCHAR_LENGTH_SIZE;
-
-        // Take everything from the start of the free space to the start of the varchar being deleted, and move it over the deleted varchar
-        memmove((char *)pageData + header.freeSpaceOffset + entryLen, (char *)pageData + header.freeSpaceOffset, varcharOffset - header.freeSpaceOffset);
-        header.freeSpaceOffset += entryLen;
-        // Update all of the slots that are moved over
-        for (i = 0; i < header.entriesNumber; i++)
-        {
-            entry = getDataEntry(i, pageData);
-            if (entry.varcharOffset < varcharOffset)
-                entry.varcharOffset += entryLen;
-            setDataEntry(entry, i, pageData);
-        }
+        memcpy(&varchar_len, (char *)pageData + entry.varcharOffset, VARCHAR_LENGTH_SIZE);
+        freeLeafSpace(attr, pageData, entry.varcharOffset, varchar_len + VARCHAR_LENGTH_SIZE);
+        // The included values may have moved over with it
+        if (entry.includedOffset != 0 && entry.includedOffset < entry.varcharOffset)
+            entry.includedOffset += varchar_len + VARCHAR_LENGTH_SIZE;
+    }
+    if (entry.includedOffset != 0)
+    {
+        uint32_t includedSize;
+        memcpy(&includedSize, (char *)pageData + entry.includedOffset, sizeof(uint32_t));
+        freeLeafSpace(attr, pageData, entry.includedOffset, includedSize + sizeof(uint32_t));
     }
-    setLeafHeader(header, pageData);
     return SUCCESS;
 }
 
+void IndexManager::freeLeafSpace(const Attribute attr, void *pageData, int32_t offset, int32_t length)
+{
+    LeafHeader header = getLeafHeader(pageData);
+    // Take everything from the start of the free space to offset, and move it over the bytes being freed
+    memmove((char *)pageData + header.freeSpaceOffset + length, (char *)pageData + header.freeSpaceOffset, offset - header.freeSpaceOffset);
+    header.freeSpaceOffset += length;
+    setLeafHeader(header, pageData);
+    // Update all of the slots that are moved over
+    for (int i = 0; i < header.entriesNumber; i++)
+    {
+        DataEntry entry = getDataEntry(i, pageData);
+        if (attr.type == TypeVarChar && entry.varcharOffset < offset)
+            entry.varcharOffset += length;
+        if (entry.includedOffset != 0 && entry.includedOffset < offset)
+            entry.includedOffset += length;
+        setDataEntry(entry, i, pageData);
+    }
+}
+
 RC IndexManager::deleteEntryFromInternal(const Attribute attr, const void *key, void *pageData)
 {
     InternalHeader header = getInternalHeader(pageData);
 
-    int i;
-    for (i = 0; i < header.entriesNumber; i++)
-    {
-        // Scan through until we find a matching key
-        if (compareSlot(attr, key, pageData, i) == 0)
-        {
-            break;
-        }
-    }
-    if (i == header.entriesNumber)
+    // Find the first matching key
+    int i = findInternalSlot(attr, key, pageData, false);
+    if (i == header.entriesNumber || compareSlot(attr, key, pageData, i) != 0)
     {
         // error out if no match
         return IX_RECORD_DN_EXIST;
@@ -1374,4 +2285,447 @@ RC IndexManager::deleteEntryFromInternal(const Attribute attr, const void *key,
     }
     setInternalHeader(header, pageData);
     return SUCCESS;
-}
\ No newline at end of file
+}
+// A copy of a key, for a ChildEntry to own
+static void *copyKey(const Attribute &attr, const void *key)
+{
+    void *copy = malloc(getKeySize(attr, key));
+    if (copy != NULL)
+        memcpy(copy, key, getKeySize(attr, key));
+    return copy;
+}
+
+static void freeKeys(vector<ChildEntry> &entries)
+{
+    for (ChildEntry &entry : entries)
+        free(entry.key);
+    entries.clear();
+}
+
+// The node a key is for once pageID has split into the nodes from first on: the one split off
+// at the greatest separator below the key
+static int32_t findSplitNode(const Attribute &attr, const vector<ChildEntry> &nodes, size_t first, int32_t pageID,
+                             const void *key)
+{
+    int32_t node = pageID;
+    const void *separator = NULL;
+    for (size_t i = first; i < nodes.size(); i++)
+    {
+        if (IndexManager::compareKeys(attr, key, nodes[i].key) > 0
+            && (separator == NULL || IndexManager::compareKeys(attr, nodes[i].key, separator) > 0))
+        {
+            node = nodes[i].childPage;
+            separator = nodes[i].key;
+        }
+    }
+    return node;
+}
+
+static bool isInRange(const Attribute &attr, const void *key, const void *lowKey, const void *highKey,
+                      bool lowKeyInclusive, bool highKeyInclusive)
+{
+    return (lowKey == NULL || IndexManager::compareKeys(attr, key, lowKey) >= (lowKeyInclusive ? 0 : 1))
+           && (highKey == NULL || IndexManager::compareKeys(attr, key, highKey) <= (highKeyInclusive ? 0 : -1));
+}
+
+RC IndexManager::bufferMessage(IXFileHandle &fileHandle, const Attribute &attribute, const Message &message)
+{
+    void *metaPage = malloc(fileHandle.getPageSize());
+    if (metaPage == NULL)
+        return IX_MALLOC_FAILED;
+    if (fileHandle.readPage(0, metaPage))
+    {
+        free(metaPage);
+        return IX_READ_FAILED;
+    }
+    char *buffer = (char *)metaPage + sizeof(MetaHeader);
+    vector<Message> messages(1, message);
+    RC rc = appendMessages(messages, buffer, fileHandle.getPageSize() - sizeof(MetaHeader));
+    if (rc == SUCCESS)
+    {
+        rc = fileHandle.writePage(0, metaPage) ? IX_WRITE_FAILED : SUCCESS;
+        free(metaPage);
+        return rc;
+    }
+
+    // The buffer is full: it empties into the root
+    messages.clear();
+    getMessages(attribute, buffer, NULL, NULL, true, true, messages);
+    if (messages.empty())
+    {
+        free(metaPage);
+        return IX_ENTRY_TOO_LARGE;
+    }
+    messages.push_back(message);
+    clearMessages(buffer);
+    rc = fileHandle.writePage(0, metaPage) ? IX_WRITE_FAILED : SUCCESS;
+    MetaHeader meta = getMetaData(metaPage);
+    free(metaPage);
+    vector<ChildEntry> splits;
+    if (rc == SUCCESS)
+        rc = pushMessages(fileHandle, attribute, meta.rootPage, messages, splits);
+    // Once the root has split, nodes split off below it are added to the new root
+    while (rc == SUCCESS && !splits.empty())
+    {
+        int32_t rootPage;
+        vector<ChildEntry> children;
+        children.swap(splits);
+        rc = getRootPageNum(fileHandle, rootPage);
+        if (rc == SUCCESS)
+            rc = addChildren(fileHandle, attribute, rootPage, children, splits);
+        freeKeys(children);
+    }
+    freeKeys(splits);
+    return rc;
+}
+
+RC IndexManager::pushMessages(IXFileHandle &fileHandle, const Attribute &attribute, int32_t pageID,
+                              vector<Message> &messages, vector<ChildEntry> &splits)
+{
+    void *pageData = malloc(fileHandle.getPageSize());
+    if (pageData == NULL)
+        return IX_MALLOC_FAILED;
+    if (fileHandle.readPage(pageID, pageData))
+    {
+        free(pageData);
+        return IX_READ_FAILED;
+    }
+    if (getNodetype(pageData) == IX_TYPE_LEAF)
+    {
+        RC rc = applyMessages(fileHandle, attribute, pageID, pageData, messages, splits);
+        free(pageData);
+        return rc;
+    }
+
+    InternalHeader header = getInternalHeader(pageData);
+    void *buffer = malloc(fileHandle.getPageSize());
+    if (buffer == NULL)
+    {
+        free(pageData);
+        return IX_MALLOC_FAILED;
+    }
+    if (fileHandle.readPage(header.bufferPage, buffer))
+    {
+        free(buffer);
+        free(pageData);
+        return IX_READ_FAILED;
+    }
+    RC rc = appendMessages(messages, buffer, fileHandle.getPageSize());
+    if (rc == SUCCESS)
+    {
+        rc = fileHandle.writePage(header.bufferPage, buffer) ? IX_WRITE_FAILED : SUCCESS;
+        free(buffer);
+        free(pageData);
+        return rc;
+    }
+
+    // The buffer is full: all of it is flushed, each message to the child whose keys it is for,
+    // keeping the order of the messages of each child
+    vector<Message> buffered;
+    getMessages(attribute, buffer, NULL, NULL, true, true, buffered);
+    buffered.insert(buffered.end(), messages.begin(), messages.end());
+    clearMessages(buffer);
+    rc = fileHandle.writePage(header.bufferPage, buffer) ? IX_WRITE_FAILED : SUCCESS;
+    free(buffer);
+    map<int, vector<Message>> byChild;
+    for (const Message &message : buffered)
+        byChild[findInternalSlot(attribute, message.key.data(), pageData, false)].push_back(message);
+    buffered.clear();
+
+    // The children split, in key order
+    vector<ChildEntry> children;
+    for (auto child = byChild.begin(); rc == SUCCESS && child != byChild.end(); child++)
+    {
+        int32_t childPage = child->first == 0 ? header.leftChildPage : getIndexEntry(child->first - 1, pageData).childPage;
+        rc = pushMessages(fileHandle, attribute, childPage, child->second, children);
+    }
+    free(pageData);
+    if (rc == SUCCESS && !children.empty())
+        rc = addChildren(fileHandle, attribute, pageID, children, splits);
+    freeKeys(children);
+    return rc;
+}
+
+RC IndexManager::applyMessages(IXFileHandle &fileHandle, const Attribute &attribute, int32_t pageID, void *pageData,
+                               vector<Message> &messages, vector<ChildEntry> &splits)
+{
+    // In key order, the changes to an entry in the order they were made
+    stable_sort(messages.begin(), messages.end(), [&](const Message &a, const Message &b) {
+        return compareKeys(attribute, a.key.data(), b.key.data()) < 0;
+    });
+
+    // Once the leaf has split, each key goes to the leaf that has its range
+    size_t firstSplit = splits.size();
+    int32_t current = pageID;
+    RC rc = SUCCESS;
+    for (const Message &message : messages)
+    {
+        int32_t leaf = findSplitNode(attribute, splits, firstSplit, pageID, message.key.data());
+        if (leaf != current)
+        {
+            if (fileHandle.writePage(current, pageData))
+                return IX_WRITE_FAILED;
+            current = leaf;
+            if (fileHandle.readPage(current, pageData))
+                return IX_READ_FAILED;
+        }
+
+        // A delete of an entry that is not there has nothing to do
+        if (message.isDelete)
+        {
+            deleteEntryFromLeaf(attribute, message.key.data(), message.rid, pageData);
+            continue;
+        }
+        rc = insertIntoLeaf(attribute, message.key.data(), message.rid, message.included.data(), message.included.size(),
+                            pageData);
+        if (rc == IX_NO_FREE_SPACE)
+        {
+            // splitLeaf writes both leaves
+            ChildEntry childEntry = {.key = NULL, .childPage = 0};
+            rc = splitLeaf(fileHandle, attribute, message.key.data(), message.rid, message.included.data(),
+                           message.included.size(), current, pageData, childEntry);
+            if (rc)
+                return rc;
+            splits.push_back(childEntry);
+            if (fileHandle.readPage(current, pageData))
+                return IX_READ_FAILED;
+        }
+        else if (rc)
+            return rc;
+    }
+    return fileHandle.writePage(current, pageData) ? IX_WRITE_FAILED : SUCCESS;
+}
+
+RC IndexManager::addChildren(IXFileHandle &fileHandle, const Attribute &attribute, int32_t pageID,
+                             vector<ChildEntry> &children, vector<ChildEntry> &splits)
+{
+    void *pageData = malloc(fileHandle.getPageSize());
+    if (pageData == NULL)
+        return IX_MALLOC_FAILED;
+    if (fileHandle.readPage(pageID, pageData))
+    {
+        free(pageData);
+        return IX_READ_FAILED;
+    }
+
+    // Once the node has split, each child goes to the node that has its range
+    vector<ChildEntry> nodes;
+    int32_t current = pageID;
+    RC rc = SUCCESS;
+    for (const ChildEntry &child : children)
+    {
+        int32_t node = findSplitNode(attribute, nodes, 0, pageID, child.key);
+        if (node != current)
+        {
+            if (fileHandle.writePage(current, pageData))
+            {
+                rc = IX_WRITE_FAILED;
+                break;
+            }
+            current = node;
+            if (fileHandle.readPage(current, pageData))
+            {
+                rc = IX_READ_FAILED;
+                break;
+            }
+        }
+
+        rc = insertIntoInternal(attribute, child, pageData);
+        if (rc != IX_NO_FREE_SPACE)
+        {
+            if (rc)
+                break;
+            continue;
+        }
+
+        // splitInternal writes both nodes, and frees the key it is given
+        ChildEntry split = {.key = copyKey(attribute, child.key), .childPage = child.childPage};
+        rc = splitInternal(fileHandle, attribute, current, pageData, split);
+        if (rc)
+            break;
+        if (split.key == NULL)
+        {
+            // The node was the root, and the new root has the separator
+            int32_t rootPage;
+            rc = getRootPageNum(fileHandle, rootPage);
+            if (rc == SUCCESS && fileHandle.readPage(rootPage, pageData))
+                rc = IX_READ_FAILED;
+            if (rc)
+                break;
+            IndexEntry entry = getIndexEntry(0, pageData);
+            split.key = copyKey(attribute, attribute.type == TypeVarChar ? (char *)pageData + entry.varcharOffset
+                                                                         : (char *)&entry.integer);
+            split.childPage = entry.childPage;
+        }
+        else
+            splits.push_back({.key = copyKey(attribute, split.key), .childPage = split.childPage});
+        nodes.push_back(split);
+        if (fileHandle.readPage(current, pageData))
+        {
+            rc = IX_READ_FAILED;
+            break;
+        }
+    }
+    if (rc == SUCCESS && fileHandle.writePage(current, pageData))
+        rc = IX_WRITE_FAILED;
+    freeKeys(nodes);
+    free(pageData);
+    return rc;
+}
+
+RC IndexManager::collectChanges(IXFileHandle &fileHandle, const Attribute &attribute, const void *lowKey,
+                                const void *highKey, bool lowKeyInclusive, bool highKeyInclusive,
+                                map<string, Message> &changes)
+{
+    void *pageData = malloc(fileHandle.getPageSize());
+    if (pageData == NULL)
+        return IX_MALLOC_FAILED;
+
+    // The number of internal levels, down the leftmost children
+    int32_t rootPage;
+    RC rc = getRootPageNum(fileHandle, rootPage);
+    unsigned height = 0;
+    for (int32_t page = rootPage; rc == SUCCESS; height++)
+    {
+        if (fileHandle.readPage(page, pageData))
+            rc = IX_READ_FAILED;
+        else if (getNodetype(pageData) == IX_TYPE_LEAF)
+            break;
+        else
+            page = getInternalHeader(pageData).leftChildPage;
+    }
+    if (rc == SUCCESS)
+        rc = collectMessages(fileHandle, attribute, rootPage, height, lowKey, highKey, lowKeyInclusive,
+                             highKeyInclusive, changes);
+
+    // The messages yet to reach the root are the newest
+    if (rc == SUCCESS && fileHandle.readPage(0, pageData))
+        rc = IX_READ_FAILED;
+    if (rc == SUCCESS)
+    {
+        vector<Message> messages;
+        getMessages(attribute, (char *)pageData + sizeof(MetaHeader), lowKey, highKey, lowKeyInclusive,
+                    highKeyInclusive, messages);
+        for (const Message &message : messages)
+            changes[getSortKey(attribute, message.key.data(), message.rid)] = message;
+    }
+    free(pageData);
+    return rc;
+}
+
+RC IndexManager::collectMessages(IXFileHandle &fileHandle, const Attribute &attribute, int32_t pageID, unsigned height,
+                                 const void *lowKey, const void *highKey, bool lowKeyInclusive, bool highKeyInclusive,
+                                 map<string, Message> &changes)
+{
+    void *pageData = malloc(fileHandle.getPageSize());
+    if (pageData == NULL)
+        return IX_MALLOC_FAILED;
+    if (fileHandle.readPage(pageID, pageData))
+    {
+        free(pageData);
+        return IX_READ_FAILED;
+    }
+    InternalHeader header = getInternalHeader(pageData);
+
+    // The children over the range have older messages than the node
+    RC rc = SUCCESS;
+    if (height > 1)
+    {
+        int first = lowKey == NULL ? 0 : findInternalSlot(attribute, lowKey, pageData, false);
+        int last = highKey == NULL ? header.entriesNumber : findInternalSlot(attribute, highKey, pageData, false);
+        for (int i = first; rc == SUCCESS && i <= last; i++)
+        {
+            int32_t childPage = i == 0 ? header.leftChildPage : getIndexEntry(i - 1, pageData).childPage;
+            rc = collectMessages(fileHandle, attribute, childPage, height - 1, lowKey, highKey, lowKeyInclusive,
+                                 highKeyInclusive, changes);
+        }
+    }
+
+    if (rc == SUCCESS && fileHandle.readPage(header.bufferPage, pageData))
+        rc = IX_READ_FAILED;
+    if (rc == SUCCESS)
+    {
+        vector<Message> messages;
+        getMessages(attribute, pageData, lowKey, highKey, lowKeyInclusive, highKeyInclusive, messages);
+        for (const Message &message : messages)
+            changes[getSortKey(attribute, message.key.data(), message.rid)] = message;
+    }
+    free(pageData);
+    return rc;
+}
+
+void IndexManager::getMessages(const Attribute &attribute, const void *buffer, const void *lowKey,
+                               const void *highKey, bool lowKeyInclusive, bool highKeyInclusive,
+                               vector<Message> &messages) const
+{
+    BufferHeader header;
+    memcpy(&header, buffer, sizeof(BufferHeader));
+    const char *position = (const char *)buffer + sizeof(BufferHeader);
+    for (unsigned i = 0; i < header.messagesNumber; i++)
+    {
+        const char *key = position + 1 + sizeof(RID);
+        unsigned keySize = getKeySize(attribute, key);
+        uint32_t includedSize;
+        memcpy(&includedSize, key + keySize, sizeof(uint32_t));
+        if (isInRange(attribute, key, lowKey, highKey, lowKeyInclusive, highKeyInclusive))
+        {
+            Message message;
+            message.isDelete = *position == 1;
+            memcpy(&message.rid, position + 1, sizeof(RID));
+            message.key.assign(key, keySize);
+            message.included.assign(key + keySize + sizeof(uint32_t), includedSize);
+            messages.push_back(message);
+        }
+        position = key + keySize + sizeof(uint32_t) + includedSize;
+    }
+}
+
+RC IndexManager::appendMessages(const vector<Message> &messages, void *buffer, unsigned bufferSize) const
+{
+    BufferHeader header;
+    memcpy(&header, buffer, sizeof(BufferHeader));
+    unsigned size = 0;
+    for (const Message &message : messages)
+        size += 1 + sizeof(RID) + message.key.size() + sizeof(uint32_t) + message.included.size();
+    if (header.freeSpaceOffset + size > bufferSize)
+        return IX_NO_FREE_SPACE;
+
+    char *position = (char *)buffer + header.freeSpaceOffset;
+    for (const Message &message : messages)
+    {
+        *position = message.isDelete ? 1 : 0;
+        position++;
+        memcpy(position, &message.rid, sizeof(RID));
+        position += sizeof(RID);
+        memcpy(position, message.key.data(), message.key.size());
+        position += message.key.size();
+        uint32_t includedSize = message.included.size();
+        memcpy(position, &includedSize, sizeof(uint32_t));
+        memcpy(position + sizeof(uint32_t), message.included.data(), includedSize);
+        position += sizeof(uint32_t) + includedSize;
+    }
+    header.freeSpaceOffset += size;
+    header.messagesNumber += messages.size();
+    memcpy(buffer, &header, sizeof(BufferHeader));
+    return SUCCESS;
+}
+
+void IndexManager::clearMessages(void *buffer) const
+{
+    BufferHeader header;
+    header.freeSpaceOffset = sizeof(BufferHeader);
+    header.messagesNumber = 0;
+    memcpy(buffer, &header, sizeof(BufferHeader));
+}
+
+RC IndexManager::appendBuffer(IXFileHandle &fileHandle, uint32_t &bufferPage)
+{
+    void *buffer = calloc(fileHandle.getPageSize(), 1);
+    if (buffer == NULL)
+        return IX_MALLOC_FAILED;
+    clearMessages(buffer);
+    bufferPage = fileHandle.getNumberOfPages();
+    RC rc = fileHandle.appendPage(buffer) ? IX_APPEND_FAILED : SUCCESS;
+    free(buffer);
+    return rc;
+}
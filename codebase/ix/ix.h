@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <string>
+#include <map>
+#include <mutex>
 
 #include "../rbf/rbfm.h"
 #include "../rbf/pfm.h"
@@ -24,6 +26,8 @@
 #define IX_INSERT_INTERNAL_FAILED 11
 #define IX_WRITE_FAILED 12
 #define IX_NO_FREE_SPACE 13
+#define IX_ENTRY_TOO_LARGE 14
+#define IX_NO_FILTER 15
 
 // Headers and data types
 
@@ -38,9 +42,13 @@ typedef struct LeafHeader
     uint32_t next;
     uint32_t prev;
     uint16_t entriesNumber;
-    uint16_t freeSpaceOffset;
+    uint32_t freeSpaceOffset;
 } LeafHeader;
 
+// A key and its rid. An entry of a covering index also has the values of the columns it
+// includes, kept with the varchar keys at the end of the leaf as a uint32_t length followed by
+// that many bytes; includedOffset is 0 when there are none. prefix is the start of the key's
+// normalized form (see IndexManager::getKeyPrefix), so that a search rarely leaves the slots.
 typedef struct DataEntry
 {
     union {
@@ -49,9 +57,11 @@ typedef struct DataEntry
         int32_t varcharOffset;
     };
     RID rid;
+    int32_t includedOffset;
+    uint32_t prefix;
 } DataEntry;
 
-// each entry has offset to key and link to child
+// each entry has offset to key, the key's normalized prefix and link to child
 typedef struct IndexEntry
 {
     union {
@@ -59,15 +69,18 @@ typedef struct IndexEntry
         float real;
         int32_t varcharOffset;
     };
+    uint32_t prefix;
     uint32_t childPage;
 } IndexEntry;
 
-// Internal nodes contain number of keys and pointer to free space
+// Internal nodes contain number of keys and pointer to free space. In a B-epsilon index each
+// also has a page for the buffer of messages on their way to its children; 0 if it has none.
 typedef struct InternalHeader
 {
     uint16_t entriesNumber;
-    uint16_t freeSpaceOffset;
+    uint32_t freeSpaceOffset;
     uint32_t leftChildPage;
+    uint32_t bufferPage;
 } InternalHeader;
 
 // Used in insert to carry up result of each recursive insert
@@ -77,15 +90,99 @@ typedef struct ChildEntry
     uint32_t childPage;
 } ChildEntry;
 
+// The structure of an index: a B+ tree; an LSM tree for tables that see many more writes than
+// reads (see lsm.h); or a B-epsilon tree, a B+ tree whose changes wait in buffers on the way
+// down and reach the leaves in batches
+typedef enum
+{
+    BTREE_INDEX = 0,
+    LSM_INDEX,
+    BEPSILON_INDEX
+} IndexKind;
+
+// An internal node of a B-epsilon index has at most this many children, so that a flush of
+// its buffer brings each child several changes at once
+#define BEPSILON_FANOUT 16
+
+// A change a B-epsilon index keeps in a buffer until it is flushed towards the leaves
+typedef struct Message
+{
+    bool isDelete;
+    RID rid;
+    string key;         // As passed to insertEntry
+    string included;
+} Message;
+
+// Header of a buffer of messages: on the meta page after the MetaHeader, for the messages that
+// are yet to reach the root, and on the buffer page of each internal node. Each message is a
+// byte that is 1 for a delete, the rid, the key, and a uint32_t length followed by the
+// included values.
+typedef struct BufferHeader
+{
+    uint32_t freeSpaceOffset;
+    uint32_t messagesNumber;
+} BufferHeader;
+
 // Header for metadata page, page 0
 // Contains pointer to root node so that root node can be moved when split
 typedef struct MetaHeader
 {
     uint32_t rootPage;
+    uint32_t kind;      // An IndexKind
 } MetaHeader;
 
+// The meta page and upper levels of a B+ or B-epsilon index are kept in memory, for all the
+// handles of its file, so that a descent reads no page above the leaves. Internal nodes are
+// pinned as descents reach them, down to IX_PINNED_LEVELS levels and up to IX_PINNED_BYTES of
+// pages for each index. A pinned node points to its pinned children (swizzled references)
+// instead of naming their pages. Pages written through a handle are written through to the
+// pinned copies, and a new root unpins every node, to be pinned again from the new root down.
+// The handles of an index may be used on different threads: its pinned pages are only
+// touched with the mutex of its PinnedTree held.
+#define IX_PINNED_LEVELS 3
+#define IX_PINNED_BYTES (1024 * 1024)
+
+typedef struct PinnedNode
+{
+    PageNum pageNum;
+    unsigned level;                 // 0 for the root
+    void *page;
+    vector<PinnedNode *> children;  // By child slot, the leftmost child first; NULL until pinned and reached
+    bool leafChildren;              // Whether the children are leaves, once a descent has found out
+} PinnedNode;
+
+typedef struct PinnedTree
+{
+    void *metaPage;                 // NULL until read
+    map<PageNum, PinnedNode *> nodes;
+    PinnedNode *root;               // NULL until reached
+    mutex lock;
+} PinnedTree;
+
+// The Bloom filter of an index (see filter.h), as the stats report it
+typedef struct FilterStats
+{
+    unsigned keys;                      // Keys added since it was built
+    unsigned capacity;                  // Keys it was sized for; past them it is built again
+    unsigned memoryBytes;
+    double expectedFalsePositiveRate;   // For as many keys as were added
+    // Equality scans since the filter was opened: all that consulted it, those it ruled out
+    // without reading a page, and those it let through that found nothing
+    unsigned probes;
+    unsigned negatives;
+    unsigned falsePositives;
+    double falsePositiveRate;           // Of the scans for keys that were not there, those let through
+    // Pages of the filter's own file read and written since it was opened; the counters of
+    // the index's handles leave them out
+    unsigned pageReads;
+    unsigned pageWrites;
+} FilterStats;
+
 class IX_ScanIterator;
 class IXFileHandle;
+class IndexFilter;
+class LsmTree;
+class LsmScanIterator;
 
 class IndexManager
 {
@@ -93,10 +190,12 @@ class IndexManager
 public:
     static IndexManager *instance();
 
-    // Create an index file.
-    RC createFile(const string &fileName);
+    // Create an index file, whose nodes are pages of pageSize bytes; see PagedFileManager::createFile
+    RC createFile(const string &fileName, unsigned pageSize = PAGE_SIZE);
+    // Create an index file of the given kind
+    RC createFile(const string &fileName, IndexKind kind, unsigned pageSize = PAGE_SIZE);
 
-    // Delete an index file.
+    // Delete an index file, and for an LSM index the files of its runs and log.
     RC destroyFile(const string &fileName);
 
     // Open an index and return an ixfileHandle.
@@ -107,22 +206,70 @@ public:
 
     // Insert an entry into the given index that is indicated by the given ixfileHandle.
     RC insertEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid);
+    // Insert an entry that also carries includedSize bytes of included column values, which
+    // scans return with it
+    RC insertEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid,
+                   const void *included, unsigned includedSize);
 
     // Delete an entry from the given index that is indicated by the given ixfileHandle.
     RC deleteEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid);
 
-    // Initialize and IX_ScanIterator to support a range search
+    // Initialize and IX_ScanIterator to support a range search. A descending scan returns the
+    // entries from the high key down, so that the last entries of a range cost no more to read
+    // than the first.
     RC scan(IXFileHandle &ixfileHandle,
             const Attribute &attribute,
             const void *lowKey,
             const void *highKey,
             bool lowKeyInclusive,
             bool highKeyInclusive,
-            IX_ScanIterator &ix_ScanIterator);
+            IX_ScanIterator &ix_ScanIterator,
+            bool descending = false);
 
     // Print the B+ tree in pre-order (in a JSON record format)
     void printBtree(IXFileHandle &ixfileHandle, const Attribute &attribute) const;
+
+    // Gives an index a Bloom filter over the keys it has, or builds its filter again, as after
+    // many deletes. From then on inserts add their keys to it, and equality scans for keys it
+    // rules out read no page.
+    RC createFilter(IXFileHandle &ixfileHandle, const Attribute &attribute);
+    // Returns IX_NO_FILTER for an index without a filter
+    RC getFilterStats(IXFileHandle &ixfileHandle, FilterStats &stats);
+
+    // Normalized keys: a key rewritten as bytes that order as unsigned bytes the way the keys
+    // order by value. An int is big-endian with the sign bit flipped, a real the same but with
+    // all bits flipped when negative, and a varchar is its characters. Returns the first four
+    // bytes of the normalized form of key as a big-endian number, padded with zeros. Keys whose
+    // prefixes differ order as their prefixes do; for ints and reals equal prefixes mean equal
+    // keys, and only varchars need their remaining bytes compared.
+    static uint32_t getKeyPrefix(const Attribute &attr, const void *key);
+    // Returns -1, 0, or 1 if key is less than, equal to, or greater than value
+    static int compareKeys(const Attribute &attr, const void *key, const void *value);
+
+    // Composite keys: the values of several attributes, encoded so that comparing the bytes
+    // orders keys as comparing their values one attribute after another would. An index on
+    // them takes the key as a varchar of at most getCompositeKeyLength(attrs) bytes.
+    // tuple has the first attrCount of attrs, in the format of RelationManager::insertTuple; a
+    // NULL value orders before any other. With pastPrefix and fewer than all attrs, the key
+    // is made to order after every key that starts with those values instead of before.
+    static void encodeCompositeKey(const vector<Attribute> &attrs, unsigned attrCount, const void *tuple, void *key,
+                                   bool pastPrefix = false);
+    // Gets the values of a key made by encodeCompositeKey back, as a tuple of attrs
+    static void decodeCompositeKey(const vector<Attribute> &attrs, const void *key, void *tuple);
+    static unsigned getCompositeKeyLength(const vector<Attribute> &attrs);
+
+    // Writes the whole normalized form of key into normalized and returns its length. A
+    // varchar has every 0 byte followed by 0xFF and ends with two 0 bytes, so that no normalized
+    // key starts another and a shorter varchar orders before a longer one it starts.
+    static unsigned normalizeKey(const Attribute &attr, const void *key, void *normalized);
+    // Gets a key back from its normalized form; returns the length of the normalized form
+    static unsigned denormalizeKey(const Attribute &attr, const void *normalized, void *key);
+    // The normalized key followed by the page and slot numbers of rid as big-endian numbers,
+    // bytes that order entries by key and then by rid
+    static string getSortKey(const Attribute &attr, const void *key, const RID &rid);
+
     friend class IX_ScanIterator;
+    friend class IXFileHandle;
 
 protected:
     IndexManager();
@@ -131,12 +278,54 @@ protected:
 private:
     static IndexManager *_index_manager;
 
+    // The LSM indexes opened so far, by file name. Their memtables outlive the handles, since
+    // the layers above open an index for each change they make to it.
+    map<string, LsmTree *> lsmTrees;
+    mutex lsmTreesLock;
+
+    // Gets the LSM index of a file, reading its runs and log the first time
+    RC getLsmTree(const string &fileName, unsigned pageSize, LsmTree *&tree);
+
+    // The filters of the indexes opened so far, by file name; NULL for an index without one
+    map<string, IndexFilter *> filters;
+    mutex filtersLock;
+    // Gets the filter of an index, reading it the first time; NULL if it has none
+    IndexFilter *getFilter(IXFileHandle &ixfileHandle);
+    void setFilter(const string &fileName, IndexFilter *filter);
+    void dropFilter(const string &fileName);
+
+    // The pinned nodes of the B+ and B-epsilon indexes opened so far, by file name
+    map<string, PinnedTree *> pinnedTrees;
+    mutex pinnedTreesLock;
+
+    // Unpins the pages of an index, as when its file is destroyed or created again
+    void unpinTree(const string &fileName);
+    // Unpins the nodes of an index but not its meta page; the tree's lock is held
+    void unpinNodes(PinnedTree *tree) const;
+    // Makes a node find its children by page number again, as when it was written
+    void resetChildren(PinnedNode *node) const;
+    // The pinned node of a page at level, which is pinned if there is room; NULL if it is not
+    // pinned. isLeaf tells whether the page, read for that, is a leaf, which is never pinned.
+    // The tree's lock is held.
+    RC pinNode(IXFileHandle &fileHandle, PageNum pageNum, unsigned level, PinnedNode *&node, bool &isLeaf);
+    // find, through the pinned nodes and then reading pages from the first level not pinned
+    RC pinnedSearch(IXFileHandle &handle, const Attribute &attr, const void *key, int32_t rootPageNum,
+                    int32_t &resultPageNum);
+    // The part of pinnedSearch through the pinned nodes, with the tree's lock held. Sets
+    // unpinnedPageNum to the first page below them to search from, or to -1 if the search
+    // reached the leaf resultPageNum.
+    RC pinnedDescend(IXFileHandle &handle, const Attribute &attr, const void *key, int32_t rootPageNum,
+                     int32_t &resultPageNum, int32_t &unpinnedPageNum);
+
     // Utility function for insertEntry
-    RC insert(const Attribute &attribute, const void *key, const RID &rid, IXFileHandle &fileHandle, int32_t pageID, ChildEntry &childEntry);
+    RC insert(const Attribute &attribute, const void *key, const RID &rid, const void *included, unsigned includedSize,
+              IXFileHandle &fileHandle, int32_t pageID, ChildEntry &childEntry);
     // Inserts ChildEntry <key, pageNum> into internal node. Returns an error if there's not enough space
     RC insertIntoInternal(const Attribute attribute, ChildEntry entry, void *pageData);
-    // Inserts <key, rid> into the given leaf node. Returns an error if there's not enough free space
-    RC insertIntoLeaf(const Attribute attribute, const void *key, const RID &rid, void *pageData);
+    // Inserts <key, rid> and its included values, if any, into the given leaf node. Returns an
+    // error if there's not enough free space
+    RC insertIntoLeaf(const Attribute attribute, const void *key, const RID &rid, const void *included, unsigned includedSize,
+                      void *pageData);
 
     // Gets offset to a leaf slot with the given slot number
     int getOffsetOfLeafSlot(int slotNum) const;
@@ -144,7 +333,8 @@ private:
     int getOffsetOfInternalSlot(int slotNum) const;
 
     // Handles splitting a leaf
-    RC splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute, const void *key, const RID rid, const int32_t pageID, void *originalLeaf, ChildEntry &childEntry);
+    RC splitLeaf(IXFileHandle &fileHandle, const Attribute &attribute, const void *key, const RID rid, const void *included,
+                 unsigned includedSize, const int32_t pageID, void *originalLeaf, ChildEntry &childEntry);
     // Handles splitting an internal node, including the case where the root needs to be split
     RC splitInternal(IXFileHandle &fileHandle, const Attribute &attribute, const int32_t pageID, void *original, ChildEntry &childEntry);
 
@@ -172,6 +362,8 @@ private:
 
     // Finds the leaf page that would contain key
     RC find(IXFileHandle &handle, const Attribute attr, const void *key, int32_t &resultPageNum);
+    // Finds the last leaf page, which has the greatest keys
+    RC findLast(IXFileHandle &handle, int32_t &resultPageNum);
     // Finds the leaf page that would contain key, starting at currPageNum. Utility function for find.
     RC treeSearch(IXFileHandle &handle, const Attribute attr, const void *key, const int32_t currPageNum, int32_t &resultPageNum);
     // Given an attribute, key, and internal node, returns the pagenumber of the childPage who would contain key
@@ -181,21 +373,60 @@ private:
     int compareSlot(const Attribute attr, const void *key, const void *pageData, const int slotNum) const;
     // Compares key to the value in pageData at slotNum. For leaf nodes.
     int compareLeafSlot(const Attribute attr, const void *key, const void *pageData, const int slotNum) const;
-    // Returns -1, 0, or 1 if key is less than, equal to, or greater than value
-    int compare(const void *key, const void *value, const Attribute attr) const;
-    int compare(const int key, const int value) const;
-    int compare(const float key, const float value) const;
-    int compare(const char *key, const char *value) const;
+    // Compares key, whose prefix is keyPrefix, to the key of a slot with the given prefix and,
+    // for a varchar, offset in pageData. Only a tie on the prefixes of varchars reads the page.
+    static int compareEntry(const Attribute &attr, const void *key, uint32_t keyPrefix, uint32_t prefix,
+                            int32_t varcharOffset, const void *pageData);
+    // Compares two varchars given as their bytes; a prefix of the other orders first
+    static int compare(const char *key, int32_t keySize, const char *value, int32_t valueSize);
+    // Binary searches a node for the first slot whose key is not less than key, or with after
+    // the first whose key is greater. Returns the number of entries if there is none.
+    int findLeafSlot(const Attribute &attr, const void *key, const void *pageData, bool after) const;
+    int findInternalSlot(const Attribute &attr, const void *key, const void *pageData, bool after) const;
 
     // Returns the amount of space requried to store this key in an internal node
     int getKeyLengthInternal(const Attribute attr, const void *key) const;
     // Returns the amount of space required to store this key in a leaf
     int getKeyLengthLeaf(const Attribute attr, const void *key) const;
+    // Returns the amount of space taken by the included values of the entry at slotNum, and points included at them
+    int getIncludedLength(const void *pageData, const int slotNum, const char *&included) const;
+    // Frees length bytes at offset in the space at the end of a leaf, moving up what is below them
+    void freeLeafSpace(const Attribute attr, void *pageData, int32_t offset, int32_t length);
     // Returns the amount of free space in the internal node
     int getFreeSpaceInternal(void *pageData) const;
     // Returns the amount of free space in the leaf
     int getFreeSpaceLeaf(void *pageData) const;
 
+    // B-epsilon indexes. A change is added to the buffer on the meta page, which is flushed
+    // into the root when it fills.
+    RC bufferMessage(IXFileHandle &fileHandle, const Attribute &attribute, const Message &message);
+    // Adds messages to the buffer of an internal node. When it fills, the whole buffer is
+    // flushed, each message to the child whose keys it is for, so that a node only splits with
+    // its buffer empty. At a leaf the messages are applied. New nodes from splits are appended
+    // to splits, for the parent to add.
+    RC pushMessages(IXFileHandle &fileHandle, const Attribute &attribute, int32_t pageID, vector<Message> &messages,
+                    vector<ChildEntry> &splits);
+    RC applyMessages(IXFileHandle &fileHandle, const Attribute &attribute, int32_t pageID, void *pageData,
+                     vector<Message> &messages, vector<ChildEntry> &splits);
+    // Adds children, in key order, to an internal node, splitting it as often as it fills
+    RC addChildren(IXFileHandle &fileHandle, const Attribute &attribute, int32_t pageID, vector<ChildEntry> &children,
+                   vector<ChildEntry> &splits);
+    // Collects the messages of the buffers over the range into changes by sort key, the newest
+    // message of each entry last
+    RC collectChanges(IXFileHandle &fileHandle, const Attribute &attribute, const void *lowKey, const void *highKey,
+                      bool lowKeyInclusive, bool highKeyInclusive, map<string, Message> &changes);
+    RC collectMessages(IXFileHandle &fileHandle, const Attribute &attribute, int32_t pageID, unsigned height,
+                       const void *lowKey, const void *highKey, bool lowKeyInclusive, bool highKeyInclusive,
+                       map<string, Message> &changes);
+    // Reads the messages of a buffer with keys in the range (all of them without bounds)
+    void getMessages(const Attribute &attribute, const void *buffer, const void *lowKey, const void *highKey,
+                     bool lowKeyInclusive, bool highKeyInclusive, vector<Message> &messages) const;
+    // Adds messages to the end of a buffer; returns IX_NO_FREE_SPACE, leaving it as it was, if they do not fit
+    RC appendMessages(const vector<Message> &messages, void *buffer, unsigned bufferSize) const;
+    void clearMessages(void *buffer) const;
+    // Returns the page of a new, empty buffer
+    RC appendBuffer(IXFileHandle &fileHandle, uint32_t &bufferPage);
+
     // Deletes an entry with key key and rid rid from leaf given by pageData
     RC deleteEntryFromLeaf(const Attribute attr, const void *key, const RID &rid, void *pageData);
     // Deletes key key from the Internal node given by pageData
@@ -219,6 +450,7 @@ public:
     // Put the current counter values of associated PF FileHandles into variables
     RC collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount);
     unsigned getNumberOfPages();
+    unsigned getPageSize() const;
 
     // Added these
     RC readPage(PageNum pageNum, void *data);
@@ -226,9 +458,17 @@ public:
     RC appendPage(const void *data);
 
     friend class IndexManager;
+    friend class IX_ScanIterator;
 
 private:
     FileHandle fh;
+    string fileName;
+    IndexKind kind;
+    LsmTree *lsm;       // The LSM index the file is the meta page of; NULL for a B+ tree
+    PinnedTree *pinned; // The pages of the index kept in memory; NULL for an LSM index
+
+    // Brings the pinned copy of a page, if there is one, up to date with what was written to it
+    void updatePinned(PageNum pageNum, const void *data);
 };
 
 class IX_ScanIterator
@@ -242,6 +482,8 @@ public:
 
     // Get next matching entry
     RC getNextEntry(RID &rid, void *key);
+    // Get next matching entry and the values it includes, if any; includedSize is 0 if none
+    RC getNextEntry(RID &rid, void *key, void *included, unsigned &includedSize);
 
     // Terminate index scan
     RC close();
@@ -253,13 +495,38 @@ private:
     Attribute attr;
     const void *lowKey;
     const void *highKey;
+    uint32_t lowKeyPrefix;
+    uint32_t highKeyPrefix;
     bool lowKeyInclusive;
     bool highKeyInclusive;
+    bool descending;    // From the high key down, following the leaves' prev
 
     void *page;
     int slotNum;
 
-    RC initialize(IXFileHandle &, Attribute, const void *, const void *, bool, bool);
+    LsmScanIterator *lsmScan;   // Set for a scan of an LSM index, which does the work instead
+
+    // An equality scan for a key the index's filter ruled out has no entries. One whose key the
+    // filter let through counts as a false positive if it finds none.
+    bool filteredOut;
+    IndexFilter *probedFilter;
+
+    // For a B-epsilon index, the changes still in buffers over the range, by sort key, merged
+    // with the entries of the leaves; leafEntry is the next of those. A descending scan takes
+    // the changes before nextChange, from the last. A descending scan of an LSM index, whose
+    // runs are only read forward, has its entries here too, and no leaves.
+    map<string, Message> changes;
+    map<string, Message>::iterator nextChange;
+    bool hasLeafEntry;
+    bool leavesDone;
+    Message leafEntry;
+
+    RC initialize(IXFileHandle &, Attribute, const void *, const void *, bool, bool, bool);
+    // Reads the entries of a forward scan of an LSM index into changes
+    RC collectLsmEntries();
+    RC getNextIndexEntry(RID &rid, void *key, void *included, unsigned &includedSize);
+    // The next entry of the leaves
+    RC getNextLeafEntry(RID &rid, void *key, void *included, unsigned &includedSize);
 };
 
 #endif
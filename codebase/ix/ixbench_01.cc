@@ -0,0 +1,127 @@
+#include <chrono>
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+// Page sizes: the same table and index on an int attribute built with 4K, 16K and 64K pages.
+// Reports the time of the inserts, of a full table scan, and of point lookups through the
+// index followed by a read of the record found.
+// Usage: ixbench_01 [numRecords] [numLookups]
+
+IndexManager *indexManager;
+RecordBasedFileManager *rbfm;
+
+double elapsed(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void prepareTuple(const vector<Attribute> &recordDescriptor, int i, void *record, int *recordSize)
+{
+    unsigned char nullsIndicator = 0;
+    char name[16];
+    int nameLength = sprintf(name, "Employee%d", i % 1000);
+    prepareRecord(recordDescriptor.size(), &nullsIndicator, nameLength, name, i, (float)i / 3, i * 7, record, recordSize);
+}
+
+int runPageSize(const vector<Attribute> &recordDescriptor, const Attribute &attribute, unsigned pageSize,
+                int numRecords, int numLookups)
+{
+    const char *fileName = "bench01table";
+    const char *indexFileName = "bench01idx";
+    rbfm->destroyFile(fileName);
+    indexManager->destroyFile(indexFileName);
+    if (rbfm->createFile(fileName, ROW_LAYOUT, vector<string>(), pageSize) != success
+        || indexManager->createFile(indexFileName, pageSize) != success)
+        return fail;
+
+    FileHandle fileHandle;
+    IXFileHandle ixfileHandle;
+    rbfm->openFile(fileName, fileHandle);
+    indexManager->openFile(indexFileName, ixfileHandle);
+
+    // Inserts into the table and into the index, keys in a scattered order
+    char record[100];
+    int recordSize;
+    RID rid;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < numRecords; i++) {
+        int key = (int)(((long long)i * 7919) % numRecords);
+        prepareTuple(recordDescriptor, key, record, &recordSize);
+        if (rbfm->insertRecord(fileHandle, recordDescriptor, record, rid) != success
+            || indexManager->insertEntry(ixfileHandle, attribute, &key, rid) != success)
+            return fail;
+    }
+    double insertTime = elapsed(start);
+    unsigned tablePages = fileHandle.getNumberOfPages();
+    unsigned readPageCount, writePageCount, indexPages;
+    ixfileHandle.collectCounterValues(readPageCount, writePageCount, indexPages);
+
+    // Full scan of one attribute
+    start = chrono::steady_clock::now();
+    vector<string> attributeNames;
+    attributeNames.push_back("Salary");
+    RBFM_ScanIterator iter;
+    rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, iter);
+    long long sum = 0;
+    while (iter.getNextRecord(rid, record) != RBFM_EOF)
+        sum += *(int *)(record + 1);
+    iter.close();
+    double scanTime = elapsed(start);
+
+    // Point lookups through the index
+    unsigned readsBefore, writesBefore, appendsBefore;
+    ixfileHandle.collectCounterValues(readsBefore, writesBefore, appendsBefore);
+    start = chrono::steady_clock::now();
+    int found = 0;
+    for (int i = 0; i < numLookups; i++) {
+        int key = (int)(((long long)i * 104729) % numRecords);
+        IX_ScanIterator ix_ScanIterator;
+        indexManager->scan(ixfileHandle, attribute, &key, &key, true, true, ix_ScanIterator);
+        int returnedKey;
+        while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+            if (rbfm->readRecord(fileHandle, recordDescriptor, rid, record) == success)
+                found++;
+        ix_ScanIterator.close();
+    }
+    double lookupTime = elapsed(start);
+    ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendsBefore);
+
+    cout << pageSize / 1024 << "K pages: " << tablePages << " table pages, " << indexPages << " index pages" << endl;
+    cout << "  inserts " << insertTime * 1000 << " ms, scan " << scanTime * 1000 << " ms (sum " << sum << "), "
+         << found << " lookups " << lookupTime * 1000 << " ms, "
+         << (double)(readPageCount - readsBefore) / numLookups << " index pages read per lookup" << endl;
+
+    rbfm->closeFile(fileHandle);
+    indexManager->closeFile(ixfileHandle);
+    rbfm->destroyFile(fileName);
+    indexManager->destroyFile(indexFileName);
+    return found == numLookups ? success : fail;
+}
+
+int main(int argc, char **argv)
+{
+    int numRecords = argc > 1 ? atoi(argv[1]) : 200000;
+    int numLookups = argc > 2 ? atoi(argv[2]) : 20000;
+
+    indexManager = IndexManager::instance();
+    rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    Attribute attrAge = recordDescriptor[1];
+
+    cout << numRecords << " records, " << numLookups << " lookups" << endl;
+    unsigned pageSizes[] = {PAGE_SIZE, 16384, MAX_PAGE_SIZE};
+    for (unsigned pageSize : pageSizes) {
+        if (runPageSize(recordDescriptor, attrAge, pageSize, numRecords, numLookups) != success) {
+            cout << "The benchmark failed at " << pageSize << " bytes per page." << endl;
+            return fail;
+        }
+    }
+    return success;
+}
@@ -0,0 +1,167 @@
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+// Normalized keys: node search and sorting with keys compared through their normalized
+// prefixes. Reports the time of point lookups in an index of int keys, of varchar keys that
+// differ early and of varchar keys that share their first bytes, and the time to sort the same
+// keys by comparing values by type, by IndexManager::compareKeys, and by prefix first.
+// Usage: ixbench_02 [numKeys] [numLookups]
+
+IndexManager *indexManager;
+
+double elapsed(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Writes key i of the set into key: an int, a varchar that differs from the others in its
+// first bytes, or one that only differs after a long common start
+void prepareKey(const Attribute &attribute, bool sharedStart, int i, void *key)
+{
+    if (attribute.type == TypeInt) {
+        *(int *)key = i;
+        return;
+    }
+    char *name = (char *)key + sizeof(int);
+    int length = sharedStart ? sprintf(name, "Employee%08d", i) : sprintf(name, "%08x", (unsigned)i * 2654435761u);
+    *(int *)key = length;
+}
+
+// Compares by value the way a comparison that switches on the type would
+int compareByType(const Attribute &attribute, const void *key, const void *value)
+{
+    switch (attribute.type) {
+    case TypeInt:
+        return (*(int *)key > *(int *)value) - (*(int *)key < *(int *)value);
+    case TypeReal:
+        return (*(float *)key > *(float *)value) - (*(float *)key < *(float *)value);
+    case TypeVarChar:
+        break;
+    }
+    int keySize = *(int *)key;
+    int valueSize = *(int *)value;
+    char keyString[keySize + 1];
+    char valueString[valueSize + 1];
+    memcpy(keyString, (char *)key + sizeof(int), keySize);
+    memcpy(valueString, (char *)value + sizeof(int), valueSize);
+    keyString[keySize] = 0;
+    valueString[valueSize] = 0;
+    return strcmp(keyString, valueString);
+}
+
+int runKeys(const string &description, const Attribute &attribute, bool sharedStart, int numKeys, int numLookups)
+{
+    const char *indexFileName = "bench02idx";
+    indexManager->destroyFile(indexFileName);
+    if (indexManager->createFile(indexFileName) != success)
+        return fail;
+    IXFileHandle ixfileHandle;
+    indexManager->openFile(indexFileName, ixfileHandle);
+
+    // The keys, in a scattered order
+    unsigned keySize = attribute.type == TypeVarChar ? sizeof(int) + attribute.length : sizeof(int);
+    char *keys = (char *)malloc((size_t)numKeys * keySize);
+    RID rid;
+    for (int i = 0; i < numKeys; i++) {
+        int k = (int)(((long long)i * 7919) % numKeys);
+        prepareKey(attribute, sharedStart, k, keys + (size_t)i * keySize);
+        rid.pageNum = k;
+        rid.slotNum = 1;
+        if (indexManager->insertEntry(ixfileHandle, attribute, keys + (size_t)i * keySize, rid) != success) {
+            free(keys);
+            return fail;
+        }
+    }
+    unsigned readPageCount, writePageCount, indexPages;
+    ixfileHandle.collectCounterValues(readPageCount, writePageCount, indexPages);
+
+    // Point lookups, each a search of every node on the way to a leaf
+    auto start = chrono::steady_clock::now();
+    int found = 0;
+    char key[100];
+    char returnedKey[100];
+    for (int i = 0; i < numLookups; i++) {
+        prepareKey(attribute, sharedStart, (int)(((long long)i * 104729) % numKeys), key);
+        IX_ScanIterator ix_ScanIterator;
+        indexManager->scan(ixfileHandle, attribute, key, key, true, true, ix_ScanIterator);
+        while (ix_ScanIterator.getNextEntry(rid, returnedKey) == success)
+            found++;
+        ix_ScanIterator.close();
+    }
+    double lookupTime = elapsed(start);
+
+    // Sorts of the keys
+    vector<const char *> byType(numKeys);
+    for (int i = 0; i < numKeys; i++)
+        byType[i] = keys + (size_t)i * keySize;
+    vector<const char *> byKeys = byType;
+    start = chrono::steady_clock::now();
+    sort(byType.begin(), byType.end(),
+         [&](const char *a, const char *b) { return compareByType(attribute, a, b) < 0; });
+    double byTypeTime = elapsed(start);
+
+    start = chrono::steady_clock::now();
+    sort(byKeys.begin(), byKeys.end(),
+         [&](const char *a, const char *b) { return IndexManager::compareKeys(attribute, a, b) < 0; });
+    double byKeysTime = elapsed(start);
+
+    start = chrono::steady_clock::now();
+    vector<pair<uint32_t, const char *>> byPrefix(numKeys);
+    for (int i = 0; i < numKeys; i++)
+        byPrefix[i] = make_pair(IndexManager::getKeyPrefix(attribute, keys + (size_t)i * keySize), keys + (size_t)i * keySize);
+    sort(byPrefix.begin(), byPrefix.end(), [&](const pair<uint32_t, const char *> &a, const pair<uint32_t, const char *> &b) {
+        if (a.first != b.first)
+            return a.first < b.first;
+        return attribute.type == TypeVarChar && IndexManager::compareKeys(attribute, a.second, b.second) < 0;
+    });
+    double byPrefixTime = elapsed(start);
+
+    bool sorted = true;
+    for (int i = 0; i < numKeys; i++)
+        sorted = sorted && compareByType(attribute, byType[i], byKeys[i]) == 0
+                 && compareByType(attribute, byType[i], byPrefix[i].second) == 0;
+
+    cout << description << ": " << indexPages << " index pages" << endl;
+    cout << "  " << found << " lookups " << lookupTime * 1000 << " ms, " << lookupTime * 1e6 / numLookups
+         << " us each" << endl;
+    cout << "  sort by type " << byTypeTime * 1000 << " ms, by compareKeys " << byKeysTime * 1000
+         << " ms, by prefix first " << byPrefixTime * 1000 << " ms" << endl;
+
+    free(keys);
+    indexManager->closeFile(ixfileHandle);
+    indexManager->destroyFile(indexFileName);
+    return found == numLookups && sorted ? success : fail;
+}
+
+int main(int argc, char **argv)
+{
+    int numKeys = argc > 1 ? atoi(argv[1]) : 200000;
+    int numLookups = argc > 2 ? atoi(argv[2]) : 50000;
+
+    indexManager = IndexManager::instance();
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+    Attribute attrEmpName;
+    attrEmpName.name = "EmpName";
+    attrEmpName.type = TypeVarChar;
+    attrEmpName.length = 20;
+
+    cout << numKeys << " keys, " << numLookups << " lookups" << endl;
+    if (runKeys("int keys", attrAge, false, numKeys, numLookups) != success
+        || runKeys("varchar keys", attrEmpName, false, numKeys, numLookups) != success
+        || runKeys("varchar keys with a shared start", attrEmpName, true, numKeys, numLookups) != success) {
+        cout << "The benchmark failed." << endl;
+        return fail;
+    }
+    return success;
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+// B-epsilon indexes: insert throughput against the B+ tree. Reports, for each kind of index,
+// the time to insert int keys in a scattered order with the pages read and written, and the
+// time of point lookups in the index that results.
+// Usage: ixbench_03 [numKeys] [numLookups]  (ixbench_03 10000000 for the full-size comparison)
+
+IndexManager *indexManager;
+
+double elapsed(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int runKind(const string &description, IndexKind kind, int numKeys, int numLookups)
+{
+    const char *indexFileName = "bench03idx";
+    indexManager->destroyFile(indexFileName);
+    if (indexManager->createFile(indexFileName, kind) != success)
+        return fail;
+    IXFileHandle ixfileHandle;
+    indexManager->openFile(indexFileName, ixfileHandle);
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+
+    auto start = chrono::steady_clock::now();
+    RID rid;
+    for (int i = 0; i < numKeys; i++) {
+        int key = (int)(((long long)i * 7919) % numKeys);
+        rid.pageNum = key;
+        rid.slotNum = 1;
+        if (indexManager->insertEntry(ixfileHandle, attrAge, &key, rid) != success)
+            return fail;
+    }
+    double insertTime = elapsed(start);
+    unsigned readPageCount, writePageCount, appendPageCount;
+    ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+
+    start = chrono::steady_clock::now();
+    int found = 0;
+    for (int i = 0; i < numLookups; i++) {
+        int key = (int)(((long long)i * 104729) % numKeys);
+        int returnedKey;
+        IX_ScanIterator ix_ScanIterator;
+        indexManager->scan(ixfileHandle, attrAge, &key, &key, true, true, ix_ScanIterator);
+        while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+            found++;
+        ix_ScanIterator.close();
+    }
+    double lookupTime = elapsed(start);
+
+    cout << description << ": inserts " << insertTime * 1000 << " ms, " << numKeys / insertTime << " per second"
+         << endl;
+    cout << "  pages read " << readPageCount << ", written " << writePageCount << ", appended " << appendPageCount
+         << endl;
+    cout << "  " << found << " lookups " << lookupTime * 1000 << " ms, " << lookupTime * 1e6 / numLookups
+         << " us each" << endl;
+
+    indexManager->closeFile(ixfileHandle);
+    indexManager->destroyFile(indexFileName);
+    return found == numLookups ? success : fail;
+}
+
+int main(int argc, char **argv)
+{
+    int numKeys = argc > 1 ? atoi(argv[1]) : 1000000;
+    int numLookups = argc > 2 ? atoi(argv[2]) : 10000;
+
+    indexManager = IndexManager::instance();
+    cout << numKeys << " keys, " << numLookups << " lookups" << endl;
+    if (runKind("B+ tree", BTREE_INDEX, numKeys, numLookups) != success
+        || runKind("B-epsilon tree", BEPSILON_INDEX, numKeys, numLookups) != success) {
+        cout << "The benchmark failed." << endl;
+        return fail;
+    }
+    return success;
+}
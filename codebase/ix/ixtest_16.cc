@@ -0,0 +1,182 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// Writes key i of the attribute's type into buffer
+void prepareKey(const Attribute &attribute, unsigned i, void *key)
+{
+    if (attribute.type == TypeInt) {
+        *(int *)key = i;
+    } else {
+        // keys of different lengths that still sort in the order of i
+        char *name = (char *)key + sizeof(int);
+        int length = sprintf(name, "key%08u", i);
+        memset(name + length, 'x', i % 20);
+        *(int *)key = length + i % 20;
+    }
+}
+
+// Scans keys in [low, high) and checks that every key not yet deleted comes back once
+int checkRange(IXFileHandle &ixfileHandle, const Attribute &attribute, unsigned low, unsigned high, unsigned deletedStep)
+{
+    char lowKey[100];
+    char highKey[100];
+    char key[100];
+    prepareKey(attribute, low, lowKey);
+    prepareKey(attribute, high, highKey);
+
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, lowKey, highKey, true, false, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    RID rid;
+    unsigned expected = low;
+    int result = success;
+    while (ix_ScanIterator.getNextEntry(rid, key) == success) {
+        while (deletedStep != 0 && expected % deletedStep == 0)
+            expected++;
+        if (rid.pageNum != expected || rid.slotNum != expected % 100 + 1) {
+            cerr << "Expected key " << expected << " but got rid " << rid.pageNum << " " << rid.slotNum << endl;
+            result = fail;
+            break;
+        }
+        expected++;
+    }
+    while (deletedStep != 0 && expected < high && expected % deletedStep == 0)
+        expected++;
+    if (result == success && expected != high) {
+        cerr << "The scan stopped at key " << expected << " instead of " << high << endl;
+        result = fail;
+    }
+
+    rc = ix_ScanIterator.close();
+    assert(rc == success && "IX_ScanIterator::close() should not fail.");
+    return result;
+}
+
+int testPageSize(const string &indexFileName, const Attribute &attribute, unsigned pageSize)
+{
+    cerr << "Attribute " << attribute.name << ", pages of " << pageSize << " bytes" << endl;
+
+    IXFileHandle ixfileHandle;
+    RID rid;
+    char key[100];
+    unsigned numOfTuples = 30000;
+
+    // create index file
+    RC rc = indexManager->createFile(indexFileName, pageSize);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+
+    // open index file
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (ixfileHandle.getPageSize() != pageSize) {
+        cerr << "The index has pages of " << ixfileHandle.getPageSize() << " bytes." << endl;
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // insert entries in a scattered order
+    for (unsigned i = 0; i < numOfTuples; i++) {
+        unsigned k = (i * 7919) % numOfTuples;
+        prepareKey(attribute, k, key);
+        rid.pageNum = k;
+        rid.slotNum = k % 100 + 1;
+        rc = indexManager->insertEntry(ixfileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    unsigned readPageCount, writePageCount, appendPageCount;
+    rc = ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    cerr << numOfTuples << " entries on " << appendPageCount << " pages" << endl;
+
+    int result = checkRange(ixfileHandle, attribute, 0, numOfTuples, 0);
+    if (result == success)
+        result = checkRange(ixfileHandle, attribute, 10000, 20000, 0);
+
+    // delete every third entry
+    if (result == success) {
+        for (unsigned k = 0; k < numOfTuples; k += 3) {
+            prepareKey(attribute, k, key);
+            rid.pageNum = k;
+            rid.slotNum = k % 100 + 1;
+            rc = indexManager->deleteEntry(ixfileHandle, attribute, key, rid);
+            assert(rc == success && "indexManager::deleteEntry() should not fail.");
+        }
+        result = checkRange(ixfileHandle, attribute, 0, numOfTuples, 3);
+    }
+
+    // the page size is kept with the index file
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (result == success)
+        result = checkRange(ixfileHandle, attribute, 5000, 25000, 3);
+
+    // Close Index
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // Destroy Index
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    return result;
+}
+
+int testCase_16(const string &indexFileName, const Attribute &attrAge, const Attribute &attrEmpName)
+{
+    // Checks indexes whose pages are larger than the default.
+    //
+    // Functions tested
+    // 1. Create Index File with 16K and 64K pages **
+    // 2. Insert, Scan and Delete entries
+    // 3. Reopen Index File
+    // 4. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+	cerr << endl << "***** In IX Test Case 16 *****" << endl;
+
+    RC rc = testPageSize(indexFileName, attrAge, 16384);
+    if (rc == success)
+        rc = testPageSize(indexFileName, attrEmpName, MAX_PAGE_SIZE);
+    return rc;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "page_size_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    Attribute attrEmpName;
+    attrEmpName.length = 40;
+    attrEmpName.name = "EmpName";
+    attrEmpName.type = TypeVarChar;
+
+    remove("page_size_idx");
+
+    RC result = testCase_16(indexFileName, attrAge, attrEmpName);
+    if (result == success) {
+        cerr << "***** IX Test Case 16 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 16 failed. *****" << endl;
+        return fail;
+    }
+
+}
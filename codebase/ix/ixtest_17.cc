@@ -0,0 +1,211 @@
+#include <iostream>
+#include <climits>
+#include <cfloat>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// The keys of one attribute, each as it is passed to the index, in the order of their values
+typedef struct KeySet
+{
+    Attribute attribute;
+    vector<string> keys;
+} KeySet;
+
+string intKey(int value)
+{
+    return string((char *)&value, sizeof(int));
+}
+
+string realKey(float value)
+{
+    return string((char *)&value, sizeof(float));
+}
+
+string varcharKey(const string &value)
+{
+    int length = value.size();
+    return string((char *)&length, sizeof(int)) + value;
+}
+
+// Checks that the index returns keys in [low, high] in order, each with the rid of its position
+int checkRange(IXFileHandle &ixfileHandle, const KeySet &set, unsigned low, unsigned high, bool lowInclusive,
+               bool highInclusive)
+{
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, set.attribute, set.keys[low].data(), set.keys[high].data(), lowInclusive,
+                               highInclusive, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    RID rid;
+    char key[100];
+    unsigned expected = lowInclusive ? low : low + 1;
+    int result = success;
+    while (ix_ScanIterator.getNextEntry(rid, key) == success) {
+        if (rid.pageNum != expected || memcmp(key, set.keys[expected].data(), set.keys[expected].size()) != 0) {
+            cerr << "Expected key " << expected << " but got the key of rid " << rid.pageNum << endl;
+            result = fail;
+            break;
+        }
+        expected++;
+    }
+    if (result == success && expected != (highInclusive ? high + 1 : high)) {
+        cerr << "The scan from key " << low << " stopped at key " << expected << " instead of " << high << endl;
+        result = fail;
+    }
+    ix_ScanIterator.close();
+    return result;
+}
+
+int testKeys(const string &indexFileName, const KeySet &set)
+{
+    cerr << "Attribute " << set.attribute.name << ", " << set.keys.size() << " keys" << endl;
+
+    // Keys are given in order, and compareKeys must agree
+    for (unsigned i = 0; i < set.keys.size(); i++)
+        for (unsigned j = 0; j < set.keys.size(); j++) {
+            int expected = (i > j) - (i < j);
+            if (IndexManager::compareKeys(set.attribute, set.keys[i].data(), set.keys[j].data()) != expected) {
+                cerr << "compareKeys() orders key " << i << " and key " << j << " wrongly." << endl;
+                return fail;
+            }
+        }
+
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    IXFileHandle ixfileHandle;
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    // Every key many times, over several leaves, in a scattered order; the rid of an entry is
+    // the position of its key
+    unsigned copies = 50;
+    unsigned numEntries = set.keys.size() * copies;
+    RID rid;
+    for (unsigned n = 0; n < numEntries; n++) {
+        unsigned i = (n * 7919) % numEntries;
+        rid.pageNum = i % set.keys.size();
+        rid.slotNum = i / set.keys.size() + 1;
+        rc = indexManager->insertEntry(ixfileHandle, set.attribute, set.keys[rid.pageNum].data(), rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    // Each key comes back with all its copies, and no other
+    int result = success;
+    for (unsigned i = 0; i < set.keys.size() && result == success; i++) {
+        IX_ScanIterator ix_ScanIterator;
+        rc = indexManager->scan(ixfileHandle, set.attribute, set.keys[i].data(), set.keys[i].data(), true, true,
+                                ix_ScanIterator);
+        assert(rc == success && "indexManager::scan() should not fail.");
+        unsigned count = 0;
+        char key[100];
+        while (ix_ScanIterator.getNextEntry(rid, key) == success)
+            count += rid.pageNum == i;
+        ix_ScanIterator.close();
+        if (count != copies) {
+            cerr << "Key " << i << " was found " << count << " times instead of " << copies << endl;
+            result = fail;
+        }
+    }
+
+    // Then delete all but the first copy of each, and scan ranges with every kind of bound
+    for (unsigned n = 0; n < numEntries && result == success; n++) {
+        rid.pageNum = n % set.keys.size();
+        rid.slotNum = n / set.keys.size() + 1;
+        if (rid.slotNum == 1)
+            continue;
+        rc = indexManager->deleteEntry(ixfileHandle, set.attribute, set.keys[rid.pageNum].data(), rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+    unsigned last = set.keys.size() - 1;
+    if (result == success)
+        result = checkRange(ixfileHandle, set, 0, last, true, true);
+    if (result == success)
+        result = checkRange(ixfileHandle, set, 1, last - 1, false, false);
+    if (result == success)
+        result = checkRange(ixfileHandle, set, last / 2, last, false, true);
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return result;
+}
+
+int testCase_17(const string &indexFileName)
+{
+    // Checks that keys order by value where their bytes do not: negative numbers, and
+    // varchars with bytes above 127, with 0 bytes, and alike in their first bytes.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Insert, Scan and Delete entries **
+    // 3. Compare keys **
+    // 4. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 17 *****" << endl;
+
+    KeySet ints;
+    ints.attribute.name = "age";
+    ints.attribute.type = TypeInt;
+    ints.attribute.length = 4;
+    int intValues[] = {INT_MIN, INT_MIN + 1, -65536, -256, -1, 0, 1, 255, 256, 65536, INT_MAX - 1, INT_MAX};
+    for (int value : intValues)
+        ints.keys.push_back(intKey(value));
+
+    KeySet reals;
+    reals.attribute.name = "height";
+    reals.attribute.type = TypeReal;
+    reals.attribute.length = 4;
+    float realValues[] = {-FLT_MAX, -1e10, -2.5, -1, -FLT_MIN, 0, FLT_MIN, 0.5, 1, 1.5, 1e10, FLT_MAX};
+    for (float value : realValues)
+        reals.keys.push_back(realKey(value));
+
+    KeySet varchars;
+    varchars.attribute.name = "EmpName";
+    varchars.attribute.type = TypeVarChar;
+    varchars.attribute.length = 20;
+    string varcharValues[] = {"", string("\0", 1), string("\0\0", 2), "A", "AB", "ABC", "ABCD", string("ABCD\0", 5),
+                              "ABCDA", "ABCDB", "ABCDBx", "ABCE", "Z", "a", "\x7F", "\x80", "\x80\x01",
+                              "\xFF\xFF\xFF\xFF", "\xFF\xFF\xFF\xFF\xFF"};
+    for (const string &value : varcharValues)
+        varchars.keys.push_back(varcharKey(value));
+
+    RC rc = testKeys(indexFileName, ints);
+    if (rc == success)
+        rc = testKeys(indexFileName, reals);
+    if (rc == success)
+        rc = testKeys(indexFileName, varchars);
+
+    // The two zeros of a real are the same key
+    float zero = 0, negativeZero = -0.0f;
+    if (rc == success && IndexManager::compareKeys(reals.attribute, &zero, &negativeZero) != 0) {
+        cerr << "0 and -0 are different keys." << endl;
+        rc = fail;
+    }
+    return rc;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "normalized_idx";
+    remove("normalized_idx");
+
+    RC result = testCase_17(indexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 17 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 17 failed. *****" << endl;
+        return fail;
+    }
+}
@@ -0,0 +1,240 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "lsm.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+bool fileExists(const string &fileName)
+{
+    FILE *file = fopen(fileName.c_str(), "r");
+    if (file != NULL)
+        fclose(file);
+    return file != NULL;
+}
+
+// The number of run files of an index
+int countRuns(const string &indexFileName)
+{
+    int count = 0;
+    for (int id = 0; id < 100; id++)
+        count += fileExists(indexFileName + ".run" + to_string(id));
+    return count;
+}
+
+// Checks that the entries with keys in [low, high] are those whose key is not deleted, in order
+int checkRange(IXFileHandle &ixfileHandle, const Attribute &attribute, int low, int high, int numEntries)
+{
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, &low, &high, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    RID rid;
+    int key;
+    int expected = max(low, 0);
+    int result = success;
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+        // Every third key is deleted
+        while (expected % 3 == 0)
+            expected++;
+        if (key != expected || rid.pageNum != (unsigned)key || rid.slotNum != (unsigned)key % 7) {
+            cerr << "Expected key " << expected << " but got key " << key << endl;
+            result = fail;
+            break;
+        }
+        expected++;
+    }
+    while (result == success && expected % 3 == 0)
+        expected++;
+    if (result == success && expected <= min(high, numEntries - 1)) {
+        cerr << "The scan from " << low << " stopped at key " << expected << endl;
+        result = fail;
+    }
+    ix_ScanIterator.close();
+    return result;
+}
+
+int testCase_18(const string &indexFileName, const string &varcharIndexFileName)
+{
+    // An LSM index: enough entries to fill the memtable several times over, so that they are
+    // in several runs and levels, then deletes and scans across the memtable and the runs.
+    //
+    // Functions tested
+    // 1. Create LSM Index File **
+    // 2. Insert, Delete and Scan entries **
+    // 3. Destroy Index File with its runs **
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 18 *****" << endl;
+
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+
+    RC rc = indexManager->createFile(indexFileName, LSM_INDEX);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    IXFileHandle ixfileHandle;
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    // Keys in a scattered order; the rid of an entry is made from its key
+    int numEntries = 80000;
+    RID rid;
+    for (int i = 0; i < numEntries; i++) {
+        int key = (int)(((long long)i * 7919) % numEntries);
+        rid.pageNum = key;
+        rid.slotNum = key % 7;
+        rc = indexManager->insertEntry(ixfileHandle, attrAge, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    if (countRuns(indexFileName) == 0) {
+        cerr << "The memtable was never written out as a run." << endl;
+        return fail;
+    }
+
+    // Delete every third key, some of them from the runs and some from the memtable, and once
+    // more to fail
+    for (int key = 0; key < numEntries; key += 3) {
+        rid.pageNum = key;
+        rid.slotNum = key % 7;
+        rc = indexManager->deleteEntry(ixfileHandle, attrAge, &key, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+    int key = 3;
+    rid.pageNum = 3;
+    rid.slotNum = 3;
+    if (indexManager->deleteEntry(ixfileHandle, attrAge, &key, rid) == success) {
+        cerr << "A deleted entry was deleted again." << endl;
+        return fail;
+    }
+    key = 4;
+    rid.slotNum = 5;
+    if (indexManager->deleteEntry(ixfileHandle, attrAge, &key, rid) == success) {
+        cerr << "An entry that was never inserted was deleted." << endl;
+        return fail;
+    }
+
+    // The handle counts the pages of the index's runs and log: inserts write, and read only to merge runs
+    unsigned readPageCount, writePageCount, appendPageCount;
+    ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    cerr << "Pages read " << readPageCount << ", written " << writePageCount << ", appended " << appendPageCount << endl;
+    if (writePageCount + appendPageCount < (unsigned)numEntries) {
+        cerr << "The changes were not all logged." << endl;
+        return fail;
+    }
+
+    // A reopened handle finds the same entries
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    indexManager->printBtree(ixfileHandle, attrAge);
+
+    if (checkRange(ixfileHandle, attrAge, -10, numEntries + 10, numEntries) != success
+        || checkRange(ixfileHandle, attrAge, 1000, 1500, numEntries) != success
+        || checkRange(ixfileHandle, attrAge, numEntries - 2, numEntries + 2, numEntries) != success)
+        return fail;
+    for (key = 0; key < numEntries; key += 997) {
+        IX_ScanIterator ix_ScanIterator;
+        rc = indexManager->scan(ixfileHandle, attrAge, &key, &key, true, true, ix_ScanIterator);
+        assert(rc == success && "indexManager::scan() should not fail.");
+        int returnedKey;
+        int count = 0;
+        while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+            count++;
+        ix_ScanIterator.close();
+        if (count != (key % 3 != 0)) {
+            cerr << "Key " << key << " was found " << count << " times." << endl;
+            return fail;
+        }
+    }
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // Varchar keys, and entries that include values
+    Attribute attrEmpName;
+    attrEmpName.name = "EmpName";
+    attrEmpName.type = TypeVarChar;
+    attrEmpName.length = 20;
+    rc = indexManager->createFile(varcharIndexFileName, LSM_INDEX);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(varcharIndexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    char name[100];
+    int numNames = 30000;
+    for (int i = 0; i < numNames; i++) {
+        int length = sprintf(name + sizeof(int), "Emp%c%05d", i % 2 ? '\0' : 'A', i);
+        *(int *)name = length;
+        rid.pageNum = i;
+        rid.slotNum = 1;
+        float salary = i * 1.5f;
+        rc = indexManager->insertEntry(ixfileHandle, attrEmpName, name, rid, &salary, sizeof(float));
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    IX_ScanIterator ix_ScanIterator;
+    rc = indexManager->scan(ixfileHandle, attrEmpName, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    char previous[100];
+    char included[100];
+    unsigned includedSize;
+    int count = 0;
+    while (ix_ScanIterator.getNextEntry(rid, name, included, includedSize) == success) {
+        float salary;
+        memcpy(&salary, included, sizeof(float));
+        if (includedSize != sizeof(float) || salary != rid.pageNum * 1.5f
+            || (count > 0 && IndexManager::compareKeys(attrEmpName, previous, name) >= 0)) {
+            cerr << "Entry " << count << " is wrong or out of order." << endl;
+            ix_ScanIterator.close();
+            return fail;
+        }
+        memcpy(previous, name, sizeof(int) + *(int *)name);
+        count++;
+    }
+    ix_ScanIterator.close();
+    if (count != numNames) {
+        cerr << count << " of " << numNames << " names were found." << endl;
+        return fail;
+    }
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // Destroying the indexes removes their runs and logs
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    rc = indexManager->destroyFile(varcharIndexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    if (countRuns(indexFileName) != 0 || countRuns(varcharIndexFileName) != 0) {
+        cerr << "Runs were left behind." << endl;
+        return fail;
+    }
+    if (fileExists(indexFileName + ".log") || fileExists(varcharIndexFileName + ".log")) {
+        cerr << "A log was left behind." << endl;
+        return fail;
+    }
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "lsm_age_idx";
+    const string varcharIndexFileName = "lsm_name_idx";
+    indexManager->destroyFile(indexFileName);
+    indexManager->destroyFile(varcharIndexFileName);
+
+    RC result = testCase_18(indexFileName, varcharIndexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 18 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 18 failed. *****" << endl;
+        return fail;
+    }
+}
@@ -0,0 +1,223 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// Checks that the entries with keys in the range are those whose key is not deleted, in order
+int checkRange(IXFileHandle &ixfileHandle, const Attribute &attribute, int low, int high, bool inclusive, int numEntries)
+{
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, &low, &high, inclusive, inclusive, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    RID rid;
+    int key;
+    int expected = max(inclusive ? low : low + 1, 0);
+    int last = min(inclusive ? high : high - 1, numEntries - 1);
+    int result = success;
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+        // Every third key is deleted
+        while (expected % 3 == 0)
+            expected++;
+        if (key != expected || rid.pageNum != (unsigned)key || rid.slotNum != (unsigned)key % 7) {
+            cerr << "Expected key " << expected << " but got key " << key << endl;
+            result = fail;
+            break;
+        }
+        expected++;
+    }
+    while (result == success && expected % 3 == 0)
+        expected++;
+    if (result == success && expected <= last) {
+        cerr << "The scan from " << low << " stopped at key " << expected << endl;
+        result = fail;
+    }
+    ix_ScanIterator.close();
+    return result;
+}
+
+int testCase_19(const string &indexFileName, const string &varcharIndexFileName)
+{
+    // A B-epsilon index: enough entries for the buffers to be flushed down to the leaves many
+    // times and for the tree to grow, then deletes, and scans that find entries both in the
+    // leaves and in buffers.
+    //
+    // Functions tested
+    // 1. Create B-epsilon Index File **
+    // 2. Insert, Delete and Scan entries **
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 19 *****" << endl;
+
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+
+    RC rc = indexManager->createFile(indexFileName, BEPSILON_INDEX);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    IXFileHandle ixfileHandle;
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    // Keys in a scattered order; the rid of an entry is made from its key
+    int numEntries = 60000;
+    RID rid;
+    for (int i = 0; i < numEntries; i++) {
+        int key = (int)(((long long)i * 7919) % numEntries);
+        rid.pageNum = key;
+        rid.slotNum = key % 7;
+        rc = indexManager->insertEntry(ixfileHandle, attrAge, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    IX_ScanIterator allEntries;
+    rc = indexManager->scan(ixfileHandle, attrAge, NULL, NULL, true, true, allEntries);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    int key;
+    int count = 0;
+    while (allEntries.getNextEntry(rid, &key) == success)
+        count++;
+    allEntries.close();
+    if (count != numEntries) {
+        cerr << count << " of " << numEntries << " entries were found." << endl;
+        return fail;
+    }
+
+    // Delete every third key: some of the entries are in the leaves and some still in buffers
+    for (int key = 0; key < numEntries; key += 3) {
+        rid.pageNum = key;
+        rid.slotNum = key % 7;
+        rc = indexManager->deleteEntry(ixfileHandle, attrAge, &key, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+
+    // Each insert reads and writes the buffer on the meta page; the leaves are written in batches
+    unsigned readPageCount, writePageCount, appendPageCount;
+    ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    cerr << "Pages read " << readPageCount << ", written " << writePageCount << ", appended " << appendPageCount << endl;
+    if (readPageCount > 2 * (unsigned)(numEntries + numEntries / 3)) {
+        cerr << "The changes did not wait in buffers." << endl;
+        return fail;
+    }
+
+    // A reopened handle finds the same entries
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    if (checkRange(ixfileHandle, attrAge, -10, numEntries + 10, true, numEntries) != success
+        || checkRange(ixfileHandle, attrAge, 1000, 1500, true, numEntries) != success
+        || checkRange(ixfileHandle, attrAge, 2001, 2999, false, numEntries) != success
+        || checkRange(ixfileHandle, attrAge, numEntries - 2, numEntries + 2, true, numEntries) != success)
+        return fail;
+    for (key = 0; key < numEntries; key += 997) {
+        IX_ScanIterator ix_ScanIterator;
+        rc = indexManager->scan(ixfileHandle, attrAge, &key, &key, true, true, ix_ScanIterator);
+        assert(rc == success && "indexManager::scan() should not fail.");
+        int returnedKey;
+        int count = 0;
+        while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+            count++;
+        ix_ScanIterator.close();
+        if (count != (key % 3 != 0)) {
+            cerr << "Key " << key << " was found " << count << " times." << endl;
+            return fail;
+        }
+    }
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // Varchar keys, each with several entries that include values, whose values then change
+    Attribute attrEmpName;
+    attrEmpName.name = "EmpName";
+    attrEmpName.type = TypeVarChar;
+    attrEmpName.length = 20;
+    rc = indexManager->createFile(varcharIndexFileName, BEPSILON_INDEX);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(varcharIndexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    char name[100];
+    int numNames = 8000;
+    int entriesPerName = 3;
+    for (int i = 0; i < numNames * entriesPerName; i++) {
+        int length = sprintf(name + sizeof(int), "Emp%05d", (i * 7919) % numNames);
+        *(int *)name = length;
+        rid.pageNum = i;
+        rid.slotNum = 1;
+        float salary = i * 1.5f;
+        rc = indexManager->insertEntry(ixfileHandle, attrEmpName, name, rid, &salary, sizeof(float));
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    // A delete and a new insert of an entry is its update
+    for (int i = 0; i < numNames * entriesPerName; i += 2) {
+        int length = sprintf(name + sizeof(int), "Emp%05d", (i * 7919) % numNames);
+        *(int *)name = length;
+        rid.pageNum = i;
+        rid.slotNum = 1;
+        rc = indexManager->deleteEntry(ixfileHandle, attrEmpName, name, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+        float salary = -i * 1.5f;
+        rc = indexManager->insertEntry(ixfileHandle, attrEmpName, name, rid, &salary, sizeof(float));
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    IX_ScanIterator ix_ScanIterator;
+    rc = indexManager->scan(ixfileHandle, attrEmpName, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    char previous[100];
+    char included[100];
+    unsigned includedSize;
+    count = 0;
+    while (ix_ScanIterator.getNextEntry(rid, name, included, includedSize) == success) {
+        float salary;
+        memcpy(&salary, included, sizeof(float));
+        float expectedSalary = rid.pageNum % 2 ? rid.pageNum * 1.5f : -(int)rid.pageNum * 1.5f;
+        if (includedSize != sizeof(float) || salary != expectedSalary
+            || (count > 0 && IndexManager::compareKeys(attrEmpName, previous, name) > 0)) {
+            cerr << "Entry " << count << " is wrong or out of order." << endl;
+            ix_ScanIterator.close();
+            return fail;
+        }
+        memcpy(previous, name, sizeof(int) + *(int *)name);
+        count++;
+    }
+    ix_ScanIterator.close();
+    if (count != numNames * entriesPerName) {
+        cerr << count << " of " << numNames * entriesPerName << " entries were found." << endl;
+        return fail;
+    }
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    rc = indexManager->destroyFile(varcharIndexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "bepsilon_age_idx";
+    const string varcharIndexFileName = "bepsilon_name_idx";
+    indexManager->destroyFile(indexFileName);
+    indexManager->destroyFile(varcharIndexFileName);
+
+    RC result = testCase_19(indexFileName, varcharIndexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 19 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 19 failed. *****" << endl;
+        return fail;
+    }
+}
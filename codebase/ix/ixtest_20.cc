@@ -0,0 +1,144 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// The number of entries with key, found by a point scan; pages read is what the scan read
+int lookup(IXFileHandle &ixfileHandle, const Attribute &attribute, int key, unsigned &pagesRead)
+{
+    unsigned readBefore, readAfter, writePageCount, appendPageCount;
+    ixfileHandle.collectCounterValues(readBefore, writePageCount, appendPageCount);
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, &key, &key, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    RID rid;
+    int returnedKey;
+    int count = 0;
+    while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+        count += returnedKey == key && rid.pageNum == (unsigned)key;
+    ix_ScanIterator.close();
+    ixfileHandle.collectCounterValues(readAfter, writePageCount, appendPageCount);
+    pagesRead = readAfter - readBefore;
+    return count;
+}
+
+int insertKeys(IXFileHandle &ixfileHandle, const Attribute &attribute, int from, int to)
+{
+    // The keys from from to to, in a scattered order
+    RID rid;
+    for (int i = 0; i < to - from; i++) {
+        int key = from + (int)(((long long)i * 7919) % (to - from));
+        rid.pageNum = key;
+        rid.slotNum = 1;
+        if (indexManager->insertEntry(ixfileHandle, attribute, &key, rid) != success)
+            return fail;
+    }
+    return success;
+}
+
+int testCase_20(const string &indexFileName)
+{
+    // Pinned upper levels: once the nodes above the leaves are pinned, point lookups read only
+    // leaves, and the pinned nodes follow the splits made through any handle of the file.
+    //
+    // Functions tested
+    // 1. Scan with pinned nodes **
+    // 2. Insert through one handle, scan through another **
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 20 *****" << endl;
+
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    IXFileHandle ixfileHandle;
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    int numEntries = 100000;
+    rc = insertKeys(ixfileHandle, attrAge, 0, numEntries);
+    assert(rc == success && "indexManager::insertEntry() should not fail.");
+
+    // After a first pass, a lookup reads its leaf, and the next one when its key ends the leaf
+    unsigned pagesRead;
+    for (int key = 0; key < numEntries; key += 50)
+        lookup(ixfileHandle, attrAge, key, pagesRead);
+    unsigned totalRead = 0;
+    int lookups = 0;
+    for (int key = 0; key < numEntries; key += 50) {
+        if (lookup(ixfileHandle, attrAge, key, pagesRead) != 1) {
+            cerr << "Key " << key << " was not found." << endl;
+            return fail;
+        }
+        totalRead += pagesRead;
+        lookups++;
+        if (pagesRead > 2) {
+            cerr << "The lookup of key " << key << " read " << pagesRead << " pages." << endl;
+            return fail;
+        }
+    }
+    cerr << lookups << " lookups read " << totalRead << " pages" << endl;
+
+    // A second handle shares the pinned nodes, which see the splits of the first handle's inserts
+    IXFileHandle otherHandle;
+    rc = indexManager->openFile(indexFileName, otherHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = insertKeys(ixfileHandle, attrAge, numEntries, 4 * numEntries);
+    assert(rc == success && "indexManager::insertEntry() should not fail.");
+    for (int key = 0; key < 4 * numEntries; key += 37) {
+        if (lookup(otherHandle, attrAge, key, pagesRead) != 1) {
+            cerr << "Key " << key << " was not found through the other handle." << endl;
+            return fail;
+        }
+    }
+    rc = indexManager->closeFile(otherHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // An index created again under the same name has none of the old nodes
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = insertKeys(ixfileHandle, attrAge, 0, 1000);
+    assert(rc == success && "indexManager::insertEntry() should not fail.");
+    if (lookup(ixfileHandle, attrAge, 500, pagesRead) != 1 || lookup(ixfileHandle, attrAge, 5000, pagesRead) != 0) {
+        cerr << "The index created again has the wrong entries." << endl;
+        return fail;
+    }
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "pinned_age_idx";
+    indexManager->destroyFile(indexFileName);
+
+    RC result = testCase_20(indexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 20 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 20 failed. *****" << endl;
+        return fail;
+    }
+}
@@ -0,0 +1,166 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// The number of entries with key, found by a point scan; pages read is what the scan read
+int lookup(IXFileHandle &ixfileHandle, const Attribute &attribute, int key, unsigned &pagesRead)
+{
+    unsigned readBefore, readAfter, writePageCount, appendPageCount;
+    ixfileHandle.collectCounterValues(readBefore, writePageCount, appendPageCount);
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, &key, &key, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    RID rid;
+    int returnedKey;
+    int count = 0;
+    while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+        count += returnedKey == key && rid.pageNum == (unsigned)key;
+    ix_ScanIterator.close();
+    ixfileHandle.collectCounterValues(readAfter, writePageCount, appendPageCount);
+    pagesRead = readAfter - readBefore;
+    return count;
+}
+
+// Inserts the even keys from from to to, in a scattered order
+int insertEvenKeys(IXFileHandle &ixfileHandle, const Attribute &attribute, int from, int to)
+{
+    RID rid;
+    int numKeys = (to - from) / 2;
+    for (int i = 0; i < numKeys; i++) {
+        int key = from + 2 * (int)(((long long)i * 7919) % numKeys);
+        rid.pageNum = key;
+        rid.slotNum = 1;
+        if (indexManager->insertEntry(ixfileHandle, attribute, &key, rid) != success)
+            return fail;
+    }
+    return success;
+}
+
+// Looks up the keys from from to to: the even ones must be found, and the odd ones, absent,
+// must mostly be ruled out without a page read
+int checkKeys(IXFileHandle &ixfileHandle, const Attribute &attribute, int from, int to)
+{
+    unsigned pagesRead;
+    int absentRead = 0;
+    int absent = 0;
+    for (int key = from; key < to; key++) {
+        int count = lookup(ixfileHandle, attribute, key, pagesRead);
+        if (count != (key % 2 == 0)) {
+            cerr << "Key " << key << " was found " << count << " times." << endl;
+            return fail;
+        }
+        if (key % 2) {
+            absent++;
+            absentRead += pagesRead > 0;
+        }
+    }
+    cerr << absentRead << " of " << absent << " lookups of absent keys read pages" << endl;
+    if (absentRead > absent / 20) {
+        cerr << "The filter did not rule out the absent keys." << endl;
+        return fail;
+    }
+    return success;
+}
+
+int testCase_21(const string &indexFileName)
+{
+    // Index filters: once an index has a Bloom filter, point lookups of keys it does not have
+    // read no pages. The filter learns the keys inserted after it was built, is built again
+    // when it fills up, and is kept with the index.
+    //
+    // Functions tested
+    // 1. Create Filter **
+    // 2. Insert and Scan entries with a filter **
+    // 3. Get Filter Stats **
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 21 *****" << endl;
+
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    IXFileHandle ixfileHandle;
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    FilterStats stats;
+    if (indexManager->getFilterStats(ixfileHandle, stats) != IX_NO_FILTER) {
+        cerr << "A new index has a filter." << endl;
+        return fail;
+    }
+
+    int numKeys = 40000;
+    rc = insertEvenKeys(ixfileHandle, attrAge, 0, numKeys);
+    assert(rc == success && "indexManager::insertEntry() should not fail.");
+    rc = indexManager->createFilter(ixfileHandle, attrAge);
+    assert(rc == success && "indexManager::createFilter() should not fail.");
+    if (checkKeys(ixfileHandle, attrAge, 0, numKeys) != success)
+        return fail;
+
+    // Keys inserted after the filter was built are found; inserting as many again as it was
+    // built with builds it again
+    rc = insertEvenKeys(ixfileHandle, attrAge, numKeys, 4 * numKeys);
+    assert(rc == success && "indexManager::insertEntry() should not fail.");
+    if (checkKeys(ixfileHandle, attrAge, 0, 4 * numKeys) != success)
+        return fail;
+    rc = indexManager->getFilterStats(ixfileHandle, stats);
+    assert(rc == success && "indexManager::getFilterStats() should not fail.");
+    cerr << "Filter of " << stats.keys << " keys for " << stats.capacity << ", " << stats.memoryBytes
+         << " bytes, expected false positive rate " << stats.expectedFalsePositiveRate << ", measured "
+         << stats.falsePositiveRate << ", " << stats.pageWrites << " pages written" << endl;
+    if (stats.keys != 2 * (unsigned)numKeys || stats.capacity < stats.keys || stats.negatives == 0
+        || stats.falsePositiveRate > 0.05 || stats.pageWrites == 0) {
+        cerr << "The filter was not built again, or its stats are wrong." << endl;
+        return fail;
+    }
+
+    // The filter is kept with the index
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager->getFilterStats(ixfileHandle, stats);
+    assert(rc == success && "indexManager::getFilterStats() should not fail.");
+    if (stats.keys != 2 * (unsigned)numKeys || checkKeys(ixfileHandle, attrAge, 0, 2000) != success)
+        return fail;
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // and destroyed with it
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    string filterFileName = indexFileName + ".filter";
+    if (FileExists(filterFileName)) {
+        cerr << "The filter outlived its index." << endl;
+        return fail;
+    }
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "filter_age_idx";
+    indexManager->destroyFile(indexFileName);
+
+    RC result = testCase_21(indexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 21 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 21 failed. *****" << endl;
+        return fail;
+    }
+}
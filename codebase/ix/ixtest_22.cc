@@ -0,0 +1,192 @@
+#include <iostream>
+#include <vector>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// The entries of a scan, as key and rid page pairs
+int collect(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *low, const void *high, bool inclusive,
+            bool descending, vector<pair<int, unsigned>> &entries)
+{
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, low, high, inclusive, inclusive, ix_ScanIterator, descending);
+    if (rc != success)
+        return fail;
+    entries.clear();
+    RID rid;
+    int key;
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success)
+        entries.push_back(make_pair(key, rid.pageNum));
+    ix_ScanIterator.close();
+    return success;
+}
+
+// A descending scan of a range has the entries of the ascending scan, in the reverse order
+int checkRange(IXFileHandle &ixfileHandle, const Attribute &attribute, const int *low, const int *high, bool inclusive)
+{
+    vector<pair<int, unsigned>> forward;
+    vector<pair<int, unsigned>> backward;
+    if (collect(ixfileHandle, attribute, low, high, inclusive, false, forward) != success
+        || collect(ixfileHandle, attribute, low, high, inclusive, true, backward) != success)
+        return fail;
+    if (forward.size() != backward.size()) {
+        cerr << "The ascending scan has " << forward.size() << " entries, the descending one " << backward.size() << endl;
+        return fail;
+    }
+    for (unsigned i = 0; i < backward.size(); i++) {
+        if (backward[i].first != forward[forward.size() - 1 - i].first
+            || (i > 0 && backward[i].first > backward[i - 1].first)) {
+            cerr << "Entry " << i << " of the descending scan has key " << backward[i].first << endl;
+            return fail;
+        }
+    }
+    return success;
+}
+
+// Every key is in the index twice, as two entries, except the multiples of 5, which were deleted
+int testKind(const string &indexFileName, IndexKind kind, int numKeys)
+{
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+
+    RC rc = indexManager->createFile(indexFileName, kind);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    IXFileHandle ixfileHandle;
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    RID rid;
+    for (int copy = 0; copy < 2; copy++) {
+        for (int i = 0; i < numKeys; i++) {
+            int key = (int)(((long long)i * 7919) % numKeys);
+            rid.pageNum = key;
+            rid.slotNum = copy;
+            rc = indexManager->insertEntry(ixfileHandle, attrAge, &key, rid);
+            assert(rc == success && "indexManager::insertEntry() should not fail.");
+        }
+    }
+    for (int key = 0; key < numKeys; key += 5) {
+        for (unsigned copy = 0; copy < 2; copy++) {
+            rid.pageNum = key;
+            rid.slotNum = copy;
+            rc = indexManager->deleteEntry(ixfileHandle, attrAge, &key, rid);
+            assert(rc == success && "indexManager::deleteEntry() should not fail.");
+        }
+    }
+
+    int low = numKeys / 3;
+    int high = numKeys / 2;
+    int lowest = -10;
+    int highest = numKeys + 10;
+    int equal = 1001;
+    int deleted = 1000;
+    if (checkRange(ixfileHandle, attrAge, NULL, NULL, true) != success
+        || checkRange(ixfileHandle, attrAge, &low, &high, true) != success
+        || checkRange(ixfileHandle, attrAge, &low, &high, false) != success
+        || checkRange(ixfileHandle, attrAge, &lowest, &low, true) != success
+        || checkRange(ixfileHandle, attrAge, &high, &highest, false) != success
+        || checkRange(ixfileHandle, attrAge, &equal, &equal, true) != success
+        || checkRange(ixfileHandle, attrAge, &deleted, &deleted, true) != success)
+        return fail;
+
+    vector<pair<int, unsigned>> entries;
+    collect(ixfileHandle, attrAge, NULL, NULL, true, true, entries);
+    if (entries.size() != 2 * (unsigned)(numKeys - (numKeys + 4) / 5) || entries[0].first != numKeys - 1) {
+        cerr << "The descending scan of the whole index has " << entries.size() << " entries." << endl;
+        return fail;
+    }
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int testCase_22(const string &indexFileName)
+{
+    // Descending scans: each kind of index returns the entries of a range from its high key
+    // down, and the last entries of a B+ tree cost as many page reads as the first.
+    //
+    // Functions tested
+    // 1. Descending Scan of a B+ tree, an LSM and a B-epsilon index **
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 22 *****" << endl;
+
+    if (testKind(indexFileName, BTREE_INDEX, 30000) != success
+        || testKind(indexFileName, LSM_INDEX, 30000) != success
+        || testKind(indexFileName, BEPSILON_INDEX, 30000) != success)
+        return fail;
+
+    // The 10 greatest keys of a large B+ tree, read from a leaf or two
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    IXFileHandle ixfileHandle;
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    int numKeys = 100000;
+    RID rid;
+    for (int i = 0; i < numKeys; i++) {
+        int key = (int)(((long long)i * 7919) % numKeys);
+        rid.pageNum = key;
+        rid.slotNum = 1;
+        rc = indexManager->insertEntry(ixfileHandle, attrAge, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    unsigned readBefore, readAfter, writePageCount, appendPageCount;
+    ixfileHandle.collectCounterValues(readBefore, writePageCount, appendPageCount);
+    IX_ScanIterator ix_ScanIterator;
+    rc = indexManager->scan(ixfileHandle, attrAge, NULL, NULL, true, true, ix_ScanIterator, true);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    int key;
+    for (int i = 0; i < 10; i++) {
+        if (ix_ScanIterator.getNextEntry(rid, &key) != success || key != numKeys - 1 - i) {
+            cerr << "Entry " << i << " of the descending scan is wrong." << endl;
+            return fail;
+        }
+    }
+    ix_ScanIterator.close();
+    ixfileHandle.collectCounterValues(readAfter, writePageCount, appendPageCount);
+    cerr << "The 10 greatest keys read " << readAfter - readBefore << " pages" << endl;
+    if (readAfter - readBefore > 6) {
+        cerr << "The descending scan read too many pages." << endl;
+        return fail;
+    }
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "descending_age_idx";
+    indexManager->destroyFile(indexFileName);
+
+    RC result = testCase_22(indexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 22 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 22 failed. *****" << endl;
+        return fail;
+    }
+}
@@ -0,0 +1,252 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+const int numKeys = 200000;
+const int numAbsentKeys = 20000;    // Looked up past the keys of the index
+const unsigned numThreads = 4;
+const int numLsmKeys = 40000;       // Enough for the memtable to be written out and merged
+
+// Builds the index and its filter in a child process, so that this one opens it with nothing
+// pinned yet
+int buildIndex(const string &indexFileName, const Attribute &attribute)
+{
+    pid_t pid = fork();
+    if (pid < 0)
+        return fail;
+    if (pid == 0)
+    {
+        IXFileHandle ixfileHandle;
+        if (indexManager->createFile(indexFileName) != success
+            || indexManager->openFile(indexFileName, ixfileHandle) != success)
+            exit(1);
+        RID rid;
+        for (int i = 0; i < numKeys; i++) {
+            int key = (int)(((long long)i * 7919) % numKeys);
+            rid.pageNum = key;
+            rid.slotNum = 1;
+            if (indexManager->insertEntry(ixfileHandle, attribute, &key, rid) != success)
+                exit(1);
+        }
+        if (indexManager->createFilter(ixfileHandle, attribute) != success)
+            exit(1);
+        exit(indexManager->closeFile(ixfileHandle) == success ? 0 : 1);
+    }
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return fail;
+    return success;
+}
+
+// Looks up every numThreads-th key from first through its own handle; wrong counts the keys
+// of the index not found exactly once, and the absent keys found
+void lookupKeys(const string &indexFileName, const Attribute &attribute, int first, int &wrong)
+{
+    wrong = 0;
+    IXFileHandle ixfileHandle;
+    if (indexManager->openFile(indexFileName, ixfileHandle) != success) {
+        wrong = numKeys;
+        return;
+    }
+    for (int key = first; key < numKeys + numAbsentKeys; key += numThreads) {
+        IX_ScanIterator ix_ScanIterator;
+        if (indexManager->scan(ixfileHandle, attribute, &key, &key, true, true, ix_ScanIterator) != success) {
+            wrong++;
+            continue;
+        }
+        RID rid;
+        int returnedKey;
+        int count = 0;
+        while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+            count += returnedKey == key && rid.pageNum == (unsigned)key;
+        ix_ScanIterator.close();
+        wrong += count != (key < numKeys);
+    }
+    indexManager->closeFile(ixfileHandle);
+}
+
+// Inserts every numThreads-th key from first into an LSM index through its own handle, looking
+// each up once inserted; wrong counts the keys not found exactly once
+void insertKeys(const string &indexFileName, const Attribute &attribute, int first, int &wrong)
+{
+    wrong = 0;
+    IXFileHandle ixfileHandle;
+    if (indexManager->openFile(indexFileName, ixfileHandle) != success) {
+        wrong = numLsmKeys;
+        return;
+    }
+    for (int key = first; key < numLsmKeys; key += numThreads) {
+        RID rid;
+        rid.pageNum = key;
+        rid.slotNum = 1;
+        if (indexManager->insertEntry(ixfileHandle, attribute, &key, rid) != success) {
+            wrong++;
+            continue;
+        }
+        IX_ScanIterator ix_ScanIterator;
+        if (indexManager->scan(ixfileHandle, attribute, &key, &key, true, true, ix_ScanIterator) != success) {
+            wrong++;
+            continue;
+        }
+        int returnedKey;
+        int count = 0;
+        while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+            count += returnedKey == key && rid.pageNum == (unsigned)key;
+        ix_ScanIterator.close();
+        wrong += count != 1;
+    }
+    indexManager->closeFile(ixfileHandle);
+}
+
+// Threads sharing an LSM index: the changes of each go into the one memtable, which fills and
+// is written out as runs that get merged, while the others scan it
+int testLsm(const string &indexFileName, const Attribute &attribute)
+{
+    if (indexManager->createFile(indexFileName, LSM_INDEX) != success)
+        return fail;
+    vector<thread> threads;
+    vector<int> wrong(numThreads);
+    for (unsigned t = 0; t < numThreads; t++)
+        threads.push_back(thread(insertKeys, cref(indexFileName), cref(attribute), (int)t, ref(wrong[t])));
+    for (thread &t : threads)
+        t.join();
+    for (unsigned t = 0; t < numThreads; t++) {
+        if (wrong[t] != 0) {
+            cerr << "Thread " << t << " got " << wrong[t] << " keys of the LSM index wrong." << endl;
+            return fail;
+        }
+    }
+
+    IXFileHandle ixfileHandle;
+    if (indexManager->openFile(indexFileName, ixfileHandle) != success)
+        return fail;
+    IX_ScanIterator ix_ScanIterator;
+    if (indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator) != success)
+        return fail;
+    RID rid;
+    int key;
+    int count = 0;
+    int previous = -1;
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+        if (key <= previous) {
+            cerr << "Key " << key << " of the LSM index came after " << previous << endl;
+            return fail;
+        }
+        previous = key;
+        count++;
+    }
+    ix_ScanIterator.close();
+    indexManager->closeFile(ixfileHandle);
+    if (count != numLsmKeys) {
+        cerr << "The LSM index has " << count << " entries instead of " << numLsmKeys << endl;
+        return fail;
+    }
+    return indexManager->destroyFile(indexFileName);
+}
+
+int testCase_23(const string &indexFileName)
+{
+    // Pinned pages and filters on several threads: the first descents into an index, which
+    // pin its upper levels, run at once through a handle per thread, as do the probes of its
+    // filter, and every lookup finds its key. The pinned levels are then complete, a lookup
+    // reads only its leaf, and the filter counted every probe. Threads inserting into and
+    // scanning one LSM index through their own handles lose none of their entries.
+    //
+    // Functions tested
+    // 1. Scan on several threads, each with its own handle **
+    // 2. Get Filter Stats after scans on several threads **
+    // 3. Insert Entry and Scan of an LSM index on several threads **
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 23 *****" << endl;
+
+    Attribute attrAge;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+    attrAge.length = 4;
+
+    if (buildIndex(indexFileName, attrAge) != success) {
+        cerr << "Building the index failed." << endl;
+        return fail;
+    }
+
+    vector<thread> threads;
+    vector<int> wrong(numThreads);
+    for (unsigned t = 0; t < numThreads; t++)
+        threads.push_back(thread(lookupKeys, cref(indexFileName), cref(attrAge), (int)t, ref(wrong[t])));
+    for (thread &t : threads)
+        t.join();
+    for (unsigned t = 0; t < numThreads; t++) {
+        if (wrong[t] != 0) {
+            cerr << "Thread " << t << " got " << wrong[t] << " keys wrong." << endl;
+            return fail;
+        }
+    }
+
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    FilterStats stats;
+    rc = indexManager->getFilterStats(ixfileHandle, stats);
+    assert(rc == success && "indexManager::getFilterStats() should not fail.");
+    cerr << "The filter was probed " << stats.probes << " times and ruled out " << stats.negatives << " keys" << endl;
+    if (stats.probes != (unsigned)(numKeys + numAbsentKeys) || stats.negatives == 0) {
+        cerr << "The filter did not count every probe." << endl;
+        return fail;
+    }
+    unsigned readBefore, readAfter, writePageCount, appendPageCount;
+    ixfileHandle.collectCounterValues(readBefore, writePageCount, appendPageCount);
+    int key = numKeys / 3;
+    IX_ScanIterator ix_ScanIterator;
+    rc = indexManager->scan(ixfileHandle, attrAge, &key, &key, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    RID rid;
+    int returnedKey;
+    while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success);
+    ix_ScanIterator.close();
+    ixfileHandle.collectCounterValues(readAfter, writePageCount, appendPageCount);
+    cerr << "A lookup after the threads read " << readAfter - readBefore << " pages" << endl;
+    if (readAfter - readBefore != 1) {
+        cerr << "The upper levels of the index were not pinned." << endl;
+        return fail;
+    }
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    if (testLsm(indexFileName, attrAge) != success) {
+        cerr << "The threads sharing the LSM index failed." << endl;
+        return fail;
+    }
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "threads_age_idx";
+    indexManager->destroyFile(indexFileName);
+
+    RC result = testCase_23(indexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 23 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 23 failed. *****" << endl;
+        return fail;
+    }
+}
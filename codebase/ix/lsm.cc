@@ -0,0 +1,849 @@
+#include "lsm.h"
+#include "filter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Helpers for pages of entries and fences ----------------------
+
+static void initPage(void *page)
+{
+    LsmPageHeader header;
+    header.freeSpaceOffset = sizeof(LsmPageHeader);
+    header.entriesNumber = 0;
+    memcpy(page, &header, sizeof(LsmPageHeader));
+}
+
+static LsmPageHeader getPageHeader(const void *page)
+{
+    LsmPageHeader header;
+    memcpy(&header, page, sizeof(LsmPageHeader));
+    return header;
+}
+
+static unsigned getEntrySize(const LsmEntry &entry)
+{
+    return sizeof(uint32_t) + entry.sortKey.size() + 1 + sizeof(uint32_t) + entry.included.size();
+}
+
+static void putString(const string &value, char *&position)
+{
+    uint32_t length = value.size();
+    memcpy(position, &length, sizeof(uint32_t));
+    memcpy(position + sizeof(uint32_t), value.data(), length);
+    position += sizeof(uint32_t) + length;
+}
+
+static string getString(const char *&position)
+{
+    uint32_t length;
+    memcpy(&length, position, sizeof(uint32_t));
+    string value(position + sizeof(uint32_t), length);
+    position += sizeof(uint32_t) + length;
+    return value;
+}
+
+// Stores entry at the end of a page of entries; returns IX_NO_FREE_SPACE if it does not fit
+static RC addEntry(const LsmEntry &entry, void *page, unsigned pageSize)
+{
+    LsmPageHeader header = getPageHeader(page);
+    if (header.freeSpaceOffset + getEntrySize(entry) > pageSize)
+        return IX_NO_FREE_SPACE;
+    char *position = (char *)page + header.freeSpaceOffset;
+    putString(entry.sortKey, position);
+    *position++ = entry.tombstone;
+    putString(entry.included, position);
+    header.freeSpaceOffset = position - (char *)page;
+    header.entriesNumber++;
+    memcpy(page, &header, sizeof(LsmPageHeader));
+    return SUCCESS;
+}
+
+// Appends the entries of a page of entries to entries
+static void getEntries(const void *page, vector<LsmEntry> &entries)
+{
+    LsmPageHeader header = getPageHeader(page);
+    const char *position = (const char *)page + sizeof(LsmPageHeader);
+    for (uint32_t i = 0; i < header.entriesNumber; i++)
+    {
+        LsmEntry entry;
+        entry.sortKey = getString(position);
+        entry.tombstone = *position++;
+        entry.included = getString(position);
+        entries.push_back(entry);
+    }
+}
+
+// The Bloom filters take the LSM_BLOOM_HASHES bits h1 + i * h2 from the two halves of the
+// hash of the normalized key
+static void getBloomHashes(const string &normalizedKey, uint32_t &h1, uint32_t &h2)
+{
+    uint64_t hash = hashNormalizedKey(normalizedKey);
+    h1 = (uint32_t)hash;
+    h2 = (uint32_t)(hash >> 32) | 1;
+}
+
+static void addToBloom(LsmRun &run, const string &normalizedKey)
+{
+    uint32_t h1, h2;
+    getBloomHashes(normalizedKey, h1, h2);
+    for (uint32_t i = 0; i < LSM_BLOOM_HASHES; i++)
+    {
+        uint32_t bit = (h1 + i * h2) % run.bloomBits;
+        run.bloom[bit / CHAR_BIT] |= 1 << (bit % CHAR_BIT);
+    }
+}
+
+bool LsmTree::mayContain(const LsmRun &run, const string &normalizedKey)
+{
+    uint32_t h1, h2;
+    getBloomHashes(normalizedKey, h1, h2);
+    for (uint32_t i = 0; i < LSM_BLOOM_HASHES; i++)
+    {
+        uint32_t bit = (h1 + i * h2) % run.bloomBits;
+        if (!(run.bloom[bit / CHAR_BIT] & (1 << (bit % CHAR_BIT))))
+            return false;
+    }
+    return true;
+}
+
+// The normalized key a sort key starts with
+static string getNormalizedKey(const string &sortKey)
+{
+    return sortKey.substr(0, sortKey.size() - LSM_RID_SIZE);
+}
+
+static uint32_t getBigEndian(const char *bytes)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+        value = (value << 8) | (unsigned char)bytes[i];
+    return value;
+}
+
+// LsmCursor ----------------------
+
+LsmCursor::LsmCursor()
+{
+    position = 0;
+    isOpen = false;
+    pageNum = 0;
+    lastPage = 0;
+    page = NULL;
+    counter = NULL;
+}
+
+LsmCursor::~LsmCursor()
+{
+    if (isOpen)
+        PagedFileManager::instance()->closeFile(fileHandle);
+    free(page);
+}
+
+RC LsmCursor::openRun(const string &fileName, const LsmRun &run, const string &from, IXFileHandle &ixfileHandle)
+{
+    if (PagedFileManager::instance()->openFile(fileName, fileHandle))
+        return IX_OPEN_FAILED;
+    isOpen = true;
+    counter = &ixfileHandle;
+    page = malloc(fileHandle.getPageSize());
+    if (page == NULL)
+        return IX_MALLOC_FAILED;
+
+    // Entries from "from" on start on the last page whose first entry is before it, unless
+    // some page starts with it
+    unsigned index = lower_bound(run.fences.begin(), run.fences.end(), from) - run.fences.begin();
+    if (index > 0 && (index == run.fences.size() || run.fences[index] != from))
+        index--;
+    pageNum = 1 + index;
+    lastPage = run.dataPages;
+    RC rc = readEntries();
+    while (rc == SUCCESS && valid() && entry().sortKey < from)
+        rc = next();
+    return rc;
+}
+
+void LsmCursor::openEntries(vector<LsmEntry> &from)
+{
+    entries.swap(from);
+    position = 0;
+}
+
+bool LsmCursor::valid() const
+{
+    return position < entries.size();
+}
+
+const LsmEntry &LsmCursor::entry() const
+{
+    return entries[position];
+}
+
+RC LsmCursor::next()
+{
+    position++;
+    if (position < entries.size() || !isOpen)
+        return SUCCESS;
+    return readEntries();
+}
+
+// Reads the next page of entries of a run, if there is one
+RC LsmCursor::readEntries()
+{
+    entries.clear();
+    position = 0;
+    while (entries.empty() && pageNum <= lastPage)
+    {
+        if (fileHandle.readPage(pageNum++, page))
+            return IX_READ_FAILED;
+        counter->ixReadPageCounter++;
+        getEntries(page, entries);
+    }
+    return SUCCESS;
+}
+
+// LsmMergeIterator ----------------------
+
+LsmMergeIterator::LsmMergeIterator()
+{
+    keepTombstones = false;
+}
+
+LsmMergeIterator::~LsmMergeIterator()
+{
+    close();
+}
+
+void LsmMergeIterator::open(const vector<LsmCursor *> &from, bool keep)
+{
+    close();
+    cursors = from;
+    keepTombstones = keep;
+}
+
+RC LsmMergeIterator::getNextEntry(LsmEntry &entry)
+{
+    while (true)
+    {
+        // The least sort key, from the newest cursor that has it
+        LsmCursor *first = NULL;
+        for (LsmCursor *cursor : cursors)
+            if (cursor->valid() && (first == NULL || cursor->entry().sortKey < first->entry().sortKey))
+                first = cursor;
+        if (first == NULL)
+            return IX_EOF;
+        entry = first->entry();
+
+        // Older versions of the entry are passed over
+        for (LsmCursor *cursor : cursors)
+        {
+            if (!cursor->valid() || cursor->entry().sortKey != entry.sortKey)
+                continue;
+            RC rc = cursor->next();
+            if (rc)
+                return rc;
+        }
+        if (keepTombstones || !entry.tombstone)
+            return SUCCESS;
+    }
+}
+
+void LsmMergeIterator::close()
+{
+    for (LsmCursor *cursor : cursors)
+        delete cursor;
+    cursors.clear();
+}
+
+// LsmScanIterator ----------------------
+
+RC LsmScanIterator::getNextEntry(RID &rid, void *key, void *included, unsigned &includedSize)
+{
+    LsmEntry entry;
+    string normalizedKey;
+    while (true)
+    {
+        RC rc = entries.getNextEntry(entry);
+        if (rc)
+            return rc;
+        normalizedKey = getNormalizedKey(entry.sortKey);
+        if (hasLowKey && !lowKeyInclusive && normalizedKey == lowKey)
+            continue;
+        if (hasHighKey)
+        {
+            int cmp = normalizedKey.compare(highKey);
+            if (cmp > 0 || (cmp == 0 && !highKeyInclusive))
+                return IX_EOF;
+        }
+        break;
+    }
+
+    IndexManager::denormalizeKey(attr, normalizedKey.data(), key);
+    const char *ridBytes = entry.sortKey.data() + normalizedKey.size();
+    rid.pageNum = getBigEndian(ridBytes);
+    rid.slotNum = getBigEndian(ridBytes + sizeof(uint32_t));
+    includedSize = entry.included.size();
+    if (included != NULL)
+        memcpy(included, entry.included.data(), includedSize);
+    return SUCCESS;
+}
+
+// LsmTree ----------------------
+
+LsmTree::LsmTree(const string &name, unsigned size)
+{
+    fileName = name;
+    pageSize = size;
+    memtableSize = 0;
+    nextRunId = 0;
+    logPage = NULL;
+    logPageNum = 0;
+    logPages = 0;
+}
+
+LsmTree::~LsmTree()
+{
+    PagedFileManager::instance()->closeFile(log);
+    free(logPage);
+    for (LsmRun *run : runs)
+        delete run;
+}
+
+string LsmTree::getRunFileName(uint32_t id) const
+{
+    return fileName + ".run" + to_string(id);
+}
+
+string LsmTree::getLogFileName() const
+{
+    return fileName + ".log";
+}
+
+RC LsmTree::create(const string &fileName, unsigned pageSize)
+{
+    if (PagedFileManager::instance()->createFile(fileName + ".log", false, pageSize))
+        return IX_CREATE_FAILED;
+    return SUCCESS;
+}
+
+RC LsmTree::open()
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    void *page = malloc(pageSize);
+    if (page == NULL)
+        return IX_MALLOC_FAILED;
+
+    // The runs, from the meta page
+    FileHandle fileHandle;
+    if (pfm->openFile(fileName, fileHandle))
+    {
+        free(page);
+        return IX_OPEN_FAILED;
+    }
+    RC rc = fileHandle.readPage(0, page);
+    pfm->closeFile(fileHandle);
+    if (rc)
+    {
+        free(page);
+        return IX_READ_FAILED;
+    }
+    LsmMetaHeader header;
+    memcpy(&header, (char *)page + sizeof(MetaHeader), sizeof(LsmMetaHeader));
+    nextRunId = header.nextRunId;
+    const uint32_t *list = (const uint32_t *)((char *)page + sizeof(MetaHeader) + sizeof(LsmMetaHeader));
+    for (uint32_t i = 0; i < header.runsNumber && rc == SUCCESS; i++)
+    {
+        LsmRun *run;
+        rc = readRun(list[2 * i], list[2 * i + 1], run);
+        if (rc == SUCCESS)
+            runs.push_back(run);
+    }
+
+    // The changes since the last run was written, from the log
+    if (rc == SUCCESS && pfm->openFile(getLogFileName(), log))
+        rc = IX_OPEN_FAILED;
+    if (rc)
+    {
+        free(page);
+        return rc;
+    }
+    logPages = log.getNumberOfPages();
+    for (PageNum pageNum = 0; pageNum < logPages; pageNum++)
+    {
+        if (log.readPage(pageNum, page))
+        {
+            free(page);
+            return IX_READ_FAILED;
+        }
+        vector<LsmEntry> entries;
+        getEntries(page, entries);
+        for (const LsmEntry &entry : entries)
+        {
+            auto old = memtable.find(entry.sortKey);
+            if (old != memtable.end())
+                memtableSize -= getEntrySize(old->second);
+            memtable[entry.sortKey] = entry;
+            memtableSize += getEntrySize(entry);
+        }
+    }
+    // New changes go on the last page, while it has room
+    logPageNum = logPages == 0 ? 0 : logPages - 1;
+    if (logPages == 0)
+        initPage(page);
+    logPage = page;
+    return SUCCESS;
+}
+
+RC LsmTree::destroy()
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    pfm->closeFile(log);
+    RC rc = SUCCESS;
+    for (LsmRun *run : runs)
+        if (pfm->destroyFile(getRunFileName(run->id)))
+            rc = IX_DESTROY_FAILED;
+    if (pfm->destroyFile(getLogFileName()))
+        rc = IX_DESTROY_FAILED;
+    return rc;
+}
+
+RC LsmTree::insertEntry(IXFileHandle &ixfileHandle, const Attribute &attr, const void *key, const RID &rid,
+                        const void *included, unsigned includedSize)
+{
+    lock_guard<mutex> guard(lock);
+    LsmEntry entry;
+    entry.sortKey = IndexManager::getSortKey(attr, key, rid);
+    entry.tombstone = false;
+    entry.included = string((const char *)included, includedSize);
+    if (sizeof(LsmPageHeader) + getEntrySize(entry) > pageSize)
+        return IX_ENTRY_TOO_LARGE;
+    return apply(ixfileHandle, entry);
+}
+
+RC LsmTree::deleteEntry(IXFileHandle &ixfileHandle, const Attribute &attr, const void *key, const RID &rid)
+{
+    lock_guard<mutex> guard(lock);
+    LsmEntry entry;
+    entry.sortKey = IndexManager::getSortKey(attr, key, rid);
+    entry.tombstone = true;
+    bool live;
+    RC rc = isLive(ixfileHandle, entry.sortKey, live);
+    if (rc)
+        return rc;
+    if (!live)
+        return IX_RECORD_DN_EXIST;
+    return apply(ixfileHandle, entry);
+}
+
+RC LsmTree::isLive(IXFileHandle &ixfileHandle, const string &sortKey, bool &live)
+{
+    auto newest = memtable.find(sortKey);
+    if (newest != memtable.end())
+    {
+        live = !newest->second.tombstone;
+        return SUCCESS;
+    }
+    string normalizedKey = getNormalizedKey(sortKey);
+    for (LsmRun *run : runs)
+    {
+        if (!mayContain(*run, normalizedKey))
+            continue;
+        LsmCursor cursor;
+        RC rc = cursor.openRun(getRunFileName(run->id), *run, sortKey, ixfileHandle);
+        if (rc)
+            return rc;
+        if (cursor.valid() && cursor.entry().sortKey == sortKey)
+        {
+            live = !cursor.entry().tombstone;
+            return SUCCESS;
+        }
+    }
+    live = false;
+    return SUCCESS;
+}
+
+RC LsmTree::apply(IXFileHandle &ixfileHandle, const LsmEntry &entry)
+{
+    RC rc = appendToLog(ixfileHandle, entry);
+    if (rc)
+        return rc;
+    auto old = memtable.find(entry.sortKey);
+    if (old != memtable.end())
+        memtableSize -= getEntrySize(old->second);
+    memtable[entry.sortKey] = entry;
+    memtableSize += getEntrySize(entry);
+    if (memtableSize >= LSM_MEMTABLE_SIZE)
+        return flush(ixfileHandle);
+    return SUCCESS;
+}
+
+RC LsmTree::appendToLog(IXFileHandle &ixfileHandle, const LsmEntry &entry)
+{
+    if (addEntry(entry, logPage, pageSize) == IX_NO_FREE_SPACE)
+    {
+        logPageNum++;
+        initPage(logPage);
+        addEntry(entry, logPage, pageSize);
+    }
+    if (logPageNum < logPages)
+    {
+        if (log.writePage(logPageNum, logPage))
+            return IX_WRITE_FAILED;
+        ixfileHandle.ixWritePageCounter++;
+        return SUCCESS;
+    }
+    if (log.appendPage(logPage))
+        return IX_APPEND_FAILED;
+    ixfileHandle.ixAppendPageCounter++;
+    logPages++;
+    return SUCCESS;
+}
+
+RC LsmTree::flush(IXFileHandle &ixfileHandle)
+{
+    if (memtable.empty())
+        return SUCCESS;
+    vector<LsmEntry> entries;
+    entries.reserve(memtable.size());
+    for (auto &entry : memtable)
+        entries.push_back(entry.second);
+    unsigned entriesNumber = entries.size();
+    LsmCursor *cursor = new LsmCursor();
+    cursor->openEntries(entries);
+
+    // Deletes only need to be kept while there are older runs
+    LsmMergeIterator source;
+    source.open(vector<LsmCursor *>(1, cursor), !runs.empty());
+    LsmRun *run;
+    RC rc = writeRun(ixfileHandle, source, entriesNumber, 0, run);
+    if (rc)
+        return rc;
+    runs.insert(runs.begin(), run);
+    rc = writeMeta(ixfileHandle);
+    if (rc)
+        return rc;
+
+    // The run has the changes now, so the log starts over
+    PagedFileManager *pfm = PagedFileManager::instance();
+    memtable.clear();
+    memtableSize = 0;
+    pfm->closeFile(log);
+    if (pfm->destroyFile(getLogFileName()) || pfm->createFile(getLogFileName(), false, pageSize)
+        || pfm->openFile(getLogFileName(), log))
+        return IX_CREATE_FAILED;
+    logPageNum = 0;
+    logPages = 0;
+    initPage(logPage);
+    return compact(ixfileHandle);
+}
+
+RC LsmTree::compact(IXFileHandle &ixfileHandle)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    for (uint32_t level = 0;; level++)
+    {
+        vector<LsmRun *> inputs;
+        bool deeper = false;
+        for (LsmRun *run : runs)
+        {
+            if (run->level == level)
+                inputs.push_back(run);
+            deeper = deeper || run->level > level;
+        }
+        if (inputs.size() < LSM_RUNS_PER_LEVEL)
+        {
+            if (!deeper)
+                return SUCCESS;
+            continue;
+        }
+
+        // Merge the runs of the level, newest first, into one of the next
+        vector<LsmCursor *> cursors;
+        unsigned expectedEntries = 0;
+        LsmMergeIterator source;
+        RC rc = SUCCESS;
+        for (LsmRun *run : inputs)
+        {
+            LsmCursor *cursor = new LsmCursor();
+            cursors.push_back(cursor);
+            expectedEntries += run->entriesNumber;
+            rc = cursor->openRun(getRunFileName(run->id), *run, "", ixfileHandle);
+            if (rc)
+                break;
+        }
+        source.open(cursors, deeper);
+        if (rc)
+            return rc;
+        LsmRun *merged;
+        rc = writeRun(ixfileHandle, source, expectedEntries, level + 1, merged);
+        source.close();
+        if (rc)
+            return rc;
+
+        // The merged run takes the place of the newest of its inputs, which the levels above are newer than
+        runs.insert(find(runs.begin(), runs.end(), inputs[0]), merged);
+        for (LsmRun *run : inputs)
+            runs.erase(find(runs.begin(), runs.end(), run));
+        rc = writeMeta(ixfileHandle);
+        if (rc)
+            return rc;
+        for (LsmRun *run : inputs)
+        {
+            pfm->destroyFile(getRunFileName(run->id));
+            delete run;
+        }
+    }
+}
+
+RC LsmTree::writeRun(IXFileHandle &ixfileHandle, LsmMergeIterator &source, unsigned expectedEntries, uint32_t level,
+                     LsmRun *&run)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    uint32_t id = nextRunId++;
+    FileHandle fileHandle;
+    if (pfm->createFile(getRunFileName(id), false, pageSize) || pfm->openFile(getRunFileName(id), fileHandle))
+        return IX_CREATE_FAILED;
+    void *page = calloc(pageSize, 1);
+    if (page == NULL)
+    {
+        pfm->closeFile(fileHandle);
+        return IX_MALLOC_FAILED;
+    }
+    run = new LsmRun();
+    run->id = id;
+    run->level = level;
+    run->entriesNumber = 0;
+    run->dataPages = 0;
+    run->bloomBits = max(64u, expectedEntries * LSM_BLOOM_BITS_PER_KEY + CHAR_BIT - 1) / CHAR_BIT * CHAR_BIT;
+    run->bloom.assign(run->bloomBits / CHAR_BIT, 0);
+
+    // Page 0 is written last, when the header is known; the pages after it are appended in order
+    unsigned appended = 0;
+    RC rc = fileHandle.appendPage(page) ? IX_APPEND_FAILED : SUCCESS;
+    appended++;
+    initPage(page);
+    LsmEntry entry;
+    while (rc == SUCCESS && (rc = source.getNextEntry(entry)) == SUCCESS)
+    {
+        if (addEntry(entry, page, pageSize) == IX_NO_FREE_SPACE)
+        {
+            if (fileHandle.appendPage(page))
+                rc = IX_APPEND_FAILED;
+            appended++;
+            run->dataPages++;
+            initPage(page);
+            addEntry(entry, page, pageSize);
+        }
+        if (getPageHeader(page).entriesNumber == 1)
+            run->fences.push_back(entry.sortKey);
+        addToBloom(*run, getNormalizedKey(entry.sortKey));
+        run->entriesNumber++;
+    }
+    if (rc == IX_EOF)
+        rc = SUCCESS;
+    if (rc == SUCCESS && getPageHeader(page).entriesNumber > 0)
+    {
+        rc = fileHandle.appendPage(page) ? IX_APPEND_FAILED : SUCCESS;
+        appended++;
+        run->dataPages++;
+    }
+
+    // Then the fences
+    LsmRunHeader header;
+    header.fencePages = 0;
+    initPage(page);
+    for (unsigned i = 0; i < run->fences.size() && rc == SUCCESS; i++)
+    {
+        LsmPageHeader pageHeader = getPageHeader(page);
+        if (pageHeader.freeSpaceOffset + sizeof(uint32_t) + run->fences[i].size() > pageSize)
+        {
+            rc = fileHandle.appendPage(page) ? IX_APPEND_FAILED : SUCCESS;
+            appended++;
+            header.fencePages++;
+            initPage(page);
+            pageHeader = getPageHeader(page);
+        }
+        char *position = (char *)page + pageHeader.freeSpaceOffset;
+        putString(run->fences[i], position);
+        pageHeader.freeSpaceOffset = position - (char *)page;
+        pageHeader.entriesNumber++;
+        memcpy(page, &pageHeader, sizeof(LsmPageHeader));
+    }
+    if (rc == SUCCESS && getPageHeader(page).entriesNumber > 0)
+    {
+        rc = fileHandle.appendPage(page) ? IX_APPEND_FAILED : SUCCESS;
+        appended++;
+        header.fencePages++;
+    }
+
+    // And the filter
+    header.bloomPages = 0;
+    for (unsigned offset = 0; offset < run->bloom.size() && rc == SUCCESS; offset += pageSize)
+    {
+        memset(page, 0, pageSize);
+        memcpy(page, run->bloom.data() + offset, min((size_t)pageSize, run->bloom.size() - offset));
+        rc = fileHandle.appendPage(page) ? IX_APPEND_FAILED : SUCCESS;
+        appended++;
+        header.bloomPages++;
+    }
+
+    header.entriesNumber = run->entriesNumber;
+    header.dataPages = run->dataPages;
+    header.bloomBits = run->bloomBits;
+    memset(page, 0, pageSize);
+    memcpy(page, &header, sizeof(LsmRunHeader));
+    if (rc == SUCCESS && fileHandle.writePage(0, page))
+        rc = IX_WRITE_FAILED;
+    ixfileHandle.ixAppendPageCounter += appended;
+    ixfileHandle.ixWritePageCounter++;
+    pfm->closeFile(fileHandle);
+    free(page);
+    if (rc)
+    {
+        pfm->destroyFile(getRunFileName(id));
+        delete run;
+        run = NULL;
+    }
+    return rc;
+}
+
+RC LsmTree::readRun(uint32_t id, uint32_t level, LsmRun *&run)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    FileHandle fileHandle;
+    if (pfm->openFile(getRunFileName(id), fileHandle))
+        return IX_OPEN_FAILED;
+    void *page = malloc(pageSize);
+    if (page == NULL)
+    {
+        pfm->closeFile(fileHandle);
+        return IX_MALLOC_FAILED;
+    }
+    LsmRunHeader header;
+    RC rc = fileHandle.readPage(0, page) ? IX_READ_FAILED : SUCCESS;
+    memcpy(&header, page, sizeof(LsmRunHeader));
+
+    run = new LsmRun();
+    run->id = id;
+    run->level = level;
+    run->entriesNumber = header.entriesNumber;
+    run->dataPages = header.dataPages;
+    run->bloomBits = header.bloomBits;
+    PageNum pageNum = 1 + header.dataPages;
+    for (uint32_t i = 0; i < header.fencePages && rc == SUCCESS; i++, pageNum++)
+    {
+        if (fileHandle.readPage(pageNum, page))
+        {
+            rc = IX_READ_FAILED;
+            break;
+        }
+        LsmPageHeader pageHeader = getPageHeader(page);
+        const char *position = (const char *)page + sizeof(LsmPageHeader);
+        for (uint32_t j = 0; j < pageHeader.entriesNumber; j++)
+            run->fences.push_back(getString(position));
+    }
+    run->bloom.resize(header.bloomBits / CHAR_BIT);
+    for (uint32_t i = 0; i < header.bloomPages && rc == SUCCESS; i++, pageNum++)
+    {
+        if (fileHandle.readPage(pageNum, page))
+        {
+            rc = IX_READ_FAILED;
+            break;
+        }
+        unsigned offset = i * pageSize;
+        memcpy(run->bloom.data() + offset, page, min((size_t)pageSize, run->bloom.size() - offset));
+    }
+    pfm->closeFile(fileHandle);
+    free(page);
+    if (rc)
+    {
+        delete run;
+        run = NULL;
+    }
+    return rc;
+}
+
+RC LsmTree::writeMeta(IXFileHandle &ixfileHandle)
+{
+    void *page = calloc(pageSize, 1);
+    if (page == NULL)
+        return IX_MALLOC_FAILED;
+    MetaHeader meta;
+    meta.rootPage = 0;
+    meta.kind = LSM_INDEX;
+    memcpy(page, &meta, sizeof(MetaHeader));
+    LsmMetaHeader header;
+    header.nextRunId = nextRunId;
+    header.runsNumber = runs.size();
+    memcpy((char *)page + sizeof(MetaHeader), &header, sizeof(LsmMetaHeader));
+    uint32_t *list = (uint32_t *)((char *)page + sizeof(MetaHeader) + sizeof(LsmMetaHeader));
+    for (unsigned i = 0; i < runs.size(); i++)
+    {
+        list[2 * i] = runs[i]->id;
+        list[2 * i + 1] = runs[i]->level;
+    }
+    RC rc = ixfileHandle.writePage(0, page);
+    free(page);
+    return rc ? IX_WRITE_FAILED : SUCCESS;
+}
+
+RC LsmTree::scan(IXFileHandle &ixfileHandle, const Attribute &attr, const void *lowKey, const void *highKey,
+                 bool lowKeyInclusive, bool highKeyInclusive, LsmScanIterator &lsmScan)
+{
+    lock_guard<mutex> guard(lock);
+    lsmScan.fileHandle = &ixfileHandle;
+    lsmScan.attr = attr;
+    lsmScan.hasLowKey = lowKey != NULL;
+    lsmScan.hasHighKey = highKey != NULL;
+    lsmScan.lowKeyInclusive = lowKeyInclusive;
+    lsmScan.highKeyInclusive = highKeyInclusive;
+    RID rid = {0, 0};
+    if (lowKey != NULL)
+        lsmScan.lowKey = getNormalizedKey(IndexManager::getSortKey(attr, lowKey, rid));
+    if (highKey != NULL)
+        lsmScan.highKey = getNormalizedKey(IndexManager::getSortKey(attr, highKey, rid));
+
+    // The memtable entries in the range are copied, so that changes during the scan leave it be
+    vector<LsmEntry> entries;
+    auto entry = memtable.lower_bound(lsmScan.lowKey);
+    for (; entry != memtable.end(); entry++)
+    {
+        if (highKey != NULL && entry->first.compare(0, entry->first.size() - LSM_RID_SIZE, lsmScan.highKey) > 0)
+            break;
+        entries.push_back(entry->second);
+    }
+    vector<LsmCursor *> cursors(1, new LsmCursor());
+    cursors[0]->openEntries(entries);
+
+    // A lookup of one key only reads the runs whose filters may have it
+    bool lookup = lowKey != NULL && highKey != NULL && lsmScan.lowKey == lsmScan.highKey;
+    RC rc = SUCCESS;
+    for (LsmRun *run : runs)
+    {
+        if (lookup && !mayContain(*run, lsmScan.lowKey))
+            continue;
+        LsmCursor *cursor = new LsmCursor();
+        cursors.push_back(cursor);
+        rc = cursor->openRun(getRunFileName(run->id), *run, lsmScan.lowKey, ixfileHandle);
+        if (rc)
+            break;
+    }
+    lsmScan.entries.open(cursors, false);
+    return rc;
+}
+
+void LsmTree::print() const
+{
+    lock_guard<mutex> guard(lock);
+    cout << "{\"memtable\": " << memtable.size() << "," << endl << "\"runs\": [";
+    for (unsigned i = 0; i < runs.size(); i++)
+    {
+        if (i > 0)
+            cout << ",";
+        cout << endl
+             << "  {\"level\": " << runs[i]->level << ", \"entries\": " << runs[i]->entriesNumber
+             << ", \"pages\": " << runs[i]->dataPages << "}";
+    }
+    cout << "]}" << endl;
+}
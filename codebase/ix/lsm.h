@@ -0,0 +1,208 @@
+#ifndef _lsm_h_
+#define _lsm_h_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ix.h"
+
+// An LSM index takes its changes into a sorted memtable, logging each to the end of a log file
+// so that they survive the process. A full memtable is written out, in order and page after
+// page, as an immutable sorted run, and the log starts over. Runs are kept in levels: a new run
+// goes to level 0, and when a level has LSM_RUNS_PER_LEVEL runs they are merged into one run
+// of the next level (tiered compaction). A deleted entry is a tombstone that hides the entry in
+// older runs until a merge into the last level drops both.
+//
+// Files of an index named F: F itself, whose meta page lists the runs; F.log; and F.run<id>
+// for each run. A run file has a header page, the pages of its entries, the fence pages with the
+// first sort key of each entry page, and the pages of a Bloom filter on its keys.
+#define LSM_MEMTABLE_SIZE (256 * 1024) // Bytes of entries the memtable holds before it is written out
+#define LSM_RUNS_PER_LEVEL 4
+#define LSM_BLOOM_BITS_PER_KEY 10
+#define LSM_BLOOM_HASHES 7
+
+// Entries are ordered by their sort key (see IndexManager::getSortKey), whose last bytes are the rid
+#define LSM_RID_SIZE 8
+
+typedef struct LsmEntry
+{
+    string sortKey;
+    bool tombstone;
+    string included;    // The included values the entry was inserted with, if any
+} LsmEntry;
+
+// Follows the MetaHeader on the meta page; the id and level of each run follow it, as pairs
+// of uint32_t, newest run first
+typedef struct LsmMetaHeader
+{
+    uint32_t nextRunId;
+    uint32_t runsNumber;
+} LsmMetaHeader;
+
+// Header of page 0 of a run file
+typedef struct LsmRunHeader
+{
+    uint32_t entriesNumber;
+    uint32_t dataPages;     // Pages 1 to dataPages hold the entries, then come the fences and the filter
+    uint32_t fencePages;
+    uint32_t bloomPages;
+    uint32_t bloomBits;
+} LsmRunHeader;
+
+// Header of a page of entries, of fences or of the log. Entries are a uint32_t length and
+// the sort key, a byte that is 1 for a tombstone, and a uint32_t length and the included
+// values; fences are a uint32_t length and the sort key.
+typedef struct LsmPageHeader
+{
+    uint32_t freeSpaceOffset;
+    uint32_t entriesNumber;
+} LsmPageHeader;
+
+// A run as the index keeps it in memory, to find the page a key is on and to skip runs that
+// cannot have it
+typedef struct LsmRun
+{
+    uint32_t id;
+    uint32_t level;
+    uint32_t entriesNumber;
+    uint32_t dataPages;
+    vector<string> fences;  // The sort key of the first entry of each page of entries
+    vector<unsigned char> bloom;
+    uint32_t bloomBits;
+} LsmRun;
+
+// Reads the entries of a run from a sort key on, or of a copy of some memtable entries
+class LsmCursor
+{
+public:
+    LsmCursor();
+    ~LsmCursor();
+
+    RC openRun(const string &fileName, const LsmRun &run, const string &from, IXFileHandle &counter);
+    // Takes the entries, which must be in order, leaving the vector empty
+    void openEntries(vector<LsmEntry> &entries);
+
+    bool valid() const;
+    const LsmEntry &entry() const;
+    RC next();
+
+private:
+    vector<LsmEntry> entries;
+    unsigned position;
+
+    // For a run
+    bool isOpen;
+    FileHandle fileHandle;
+    PageNum pageNum;
+    PageNum lastPage;
+    void *page;
+    IXFileHandle *counter;
+
+    RC readEntries();
+};
+
+// Merges cursors into one stream in sort key order. Of entries with the same sort key only
+// the one of the first cursor is returned, so cursors are given newest first.
+class LsmMergeIterator
+{
+public:
+    LsmMergeIterator();
+    ~LsmMergeIterator();
+
+    // Takes the cursors, which it deletes; without keepTombstones they are skipped
+    void open(const vector<LsmCursor *> &cursors, bool keepTombstones);
+    RC getNextEntry(LsmEntry &entry);
+    void close();
+
+private:
+    vector<LsmCursor *> cursors;
+    bool keepTombstones;
+};
+
+class LsmScanIterator
+{
+public:
+    RC getNextEntry(RID &rid, void *key, void *included, unsigned &includedSize);
+
+    friend class LsmTree;
+
+private:
+    IXFileHandle *fileHandle;
+    Attribute attr;
+    string lowKey;      // Normalized
+    string highKey;
+    bool hasLowKey;
+    bool hasHighKey;
+    bool lowKeyInclusive;
+    bool highKeyInclusive;
+    LsmMergeIterator entries;
+};
+
+class LsmTree
+{
+public:
+    LsmTree(const string &fileName, unsigned pageSize);
+    ~LsmTree();
+
+    // Creates the log of a new index, whose meta page IndexManager has written
+    static RC create(const string &fileName, unsigned pageSize);
+    // Reads the runs of the index and replays its log into the memtable
+    RC open();
+    // Removes the files of the runs and the log
+    RC destroy();
+
+    // The page reads and writes are counted in the handle the change is made through
+    RC insertEntry(IXFileHandle &ixfileHandle, const Attribute &attr, const void *key, const RID &rid,
+                   const void *included, unsigned includedSize);
+    RC deleteEntry(IXFileHandle &ixfileHandle, const Attribute &attr, const void *key, const RID &rid);
+    RC scan(IXFileHandle &ixfileHandle, const Attribute &attr, const void *lowKey, const void *highKey,
+            bool lowKeyInclusive, bool highKeyInclusive, LsmScanIterator &lsmScan);
+
+    // Print the memtable and the runs of each level (in a JSON record format)
+    void print() const;
+
+private:
+    string fileName;
+    unsigned pageSize;
+
+    // Held by each change and scan, so that handles on several threads can share the tree
+    mutable mutex lock;
+
+    map<string, LsmEntry> memtable;
+    unsigned memtableSize;
+    vector<LsmRun *> runs;  // Newest first
+    uint32_t nextRunId;
+
+    // The last page of the log, which changes are added to
+    FileHandle log;
+    void *logPage;
+    PageNum logPageNum;
+    unsigned logPages;
+
+    string getRunFileName(uint32_t id) const;
+    string getLogFileName() const;
+
+    // Adds an entry to the memtable, after writing it to the log
+    RC apply(IXFileHandle &ixfileHandle, const LsmEntry &entry);
+    RC appendToLog(IXFileHandle &ixfileHandle, const LsmEntry &entry);
+    // Writes the memtable out as a run of level 0, and starts a new log
+    RC flush(IXFileHandle &ixfileHandle);
+    // Merges the runs of every level that has too many
+    RC compact(IXFileHandle &ixfileHandle);
+
+    // Writes the entries of source as a new run of the given level; expectedEntries sizes its filter
+    RC writeRun(IXFileHandle &ixfileHandle, LsmMergeIterator &source, unsigned expectedEntries, uint32_t level,
+                LsmRun *&run);
+    RC readRun(uint32_t id, uint32_t level, LsmRun *&run);
+    // Writes the list of runs to the meta page of the index
+    RC writeMeta(IXFileHandle &ixfileHandle);
+
+    // Whether the entry with sortKey, as the memtable and runs have it, is there and not deleted
+    RC isLive(IXFileHandle &ixfileHandle, const string &sortKey, bool &live);
+
+    static bool mayContain(const LsmRun &run, const string &normalizedKey);
+};
+
+#endif
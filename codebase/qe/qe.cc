@@ -2,7 +2,9 @@
 #include "qe.h"
 #include <string.h>
 #include <algorithm>
-#include <unordered_map>
+#include <cfloat>
+#include <functional>
+#include <thread>
 
 int Value::compare(const int key, const int value)
 {
@@ -34,31 +36,11 @@ int Value::compare(const void *key, const void *value, const AttrType attrType)
     switch (attrType)
     {
     case TypeInt:
-    {
-        int key_int = *(int *)key;
-        int value_int = *(int *)value;
-        return compare(key_int, value_int);
-    }
+        return Predicate::compareInt((const char *)key, (const char *)value);
     case TypeReal:
-    {
-        float key_float = *(float *)key;
-        float value_float = *(float *)value;
-        return compare(key_float, value_float);
-    }
+        return Predicate::compareReal((const char *)key, (const char *)value);
     case TypeVarChar:
-    {
-        uint32_t key_size = 0;
-        uint32_t value_size = 0;
-        memcpy(&key_size, key, sizeof(uint32_t));
-        memcpy(&value_size, value, sizeof(uint32_t));
-        char key_array[key_size + 1];
-        char value_array[value_size + 1];
-        memcpy(key_array, (char *)key + sizeof(uint32_t), key_size);
-        memcpy(value_array, (char *)value + sizeof(uint32_t), value_size);
-        key_array[key_size] = '\0';
-        value_array[value_size] = '\0';
-        return compare(key_array, value_array);
-    }
+        return Predicate::compareVarChar((const char *)key, (const char *)value);
     }
     throw "Attribute is malformed";
     return -2;
@@ -74,263 +56,1148 @@ int Value::compare(const Value *rhs)
 bool Value::compare(const Value *rhs, const CompOp op)
 {
     int result = compare(rhs);
+    if (op < EQ_OP || op > NO_OP)
+        throw "Comparison Operator is invalid";
+    return Predicate::satisfies(result, op);
+}
+// ... the rest of your implementations go here
+TupleLayout::TupleLayout(const vector<Attribute> &attrs)
+{
+    nullSize = RecordBasedFileManager::getNullIndicatorSize(attrs.size());
+    fixedWidth = true;
+    fixedSize = nullSize;
+    for (Attribute attr : attrs)
+    {
+        types.push_back(attr.type);
+        fixedOffsets.push_back(fixedSize);
+        if (attr.type == TypeVarChar)
+            fixedWidth = false;
+        fixedSize += attr.type == TypeVarChar ? VARCHAR_LENGTH_SIZE : INT_SIZE;
+    }
+}
+
+unsigned TupleLayout::bufferSize(const vector<Attribute> &attrs)
+{
+    return max((unsigned)PAGE_SIZE, RecordBasedFileManager::getMaxDataSize(attrs));
+}
+
+bool TupleLayout::hasNull(const void *tuple) const
+{
+    const char *nullIndicator = (const char *)tuple;
+    for (unsigned i = 0; i < nullSize; i++)
+    {
+        if (nullIndicator[i])
+            return true;
+    }
+    return false;
+}
+
+const int32_t *TupleLayout::locate(const void *tuple, int32_t *offsets) const
+{
+    // Every field sits at a known offset, nothing to compute
+    if (fixedWidth && !hasNull(tuple))
+        return fixedOffsets.data();
+
+    // Otherwise walk the tuple once, skipping NULL fields
+    char *nullIndicator = (char *)tuple;
+    int32_t offset = nullSize;
+    for (unsigned i = 0; i < types.size(); i++)
+    {
+        if (RecordBasedFileManager::fieldIsNull(nullIndicator, i))
+        {
+            offsets[i] = -1;
+            continue;
+        }
+        offsets[i] = offset;
+        offset += fieldSize(tuple, i, offset);
+    }
+    return offsets;
+}
+
+unsigned TupleLayout::fieldSize(const void *tuple, unsigned i, int32_t offset) const
+{
+    if (offset < 0)
+        return 0;
+    if (types[i] != TypeVarChar)
+        return INT_SIZE;
+    uint32_t varcharSize;
+    memcpy(&varcharSize, (const char *)tuple + offset, VARCHAR_LENGTH_SIZE);
+    return VARCHAR_LENGTH_SIZE + varcharSize;
+}
+
+unsigned TupleLayout::tupleSize(const void *tuple, const int32_t *offsets) const
+{
+    if (isFixed(offsets))
+        return fixedSize;
+    // The tuple ends where its last non-NULL field ends
+    for (unsigned i = types.size(); i > 0; i--)
+    {
+        if (offsets[i - 1] >= 0)
+            return offsets[i - 1] + fieldSize(tuple, i - 1, offsets[i - 1]);
+    }
+    return nullSize;
+}
+
+int Predicate::compareInt(const char *lhs, const char *rhs)
+{
+    int32_t l, r;
+    memcpy(&l, lhs, INT_SIZE);
+    memcpy(&r, rhs, INT_SIZE);
+    return (l > r) - (l < r);
+}
+
+int Predicate::compareReal(const char *lhs, const char *rhs)
+{
+    float l, r;
+    memcpy(&l, lhs, REAL_SIZE);
+    memcpy(&r, rhs, REAL_SIZE);
+    return (l > r) - (l < r);
+}
+
+// Compares the characters in place. A string sorts before any longer string it is a prefix of.
+int Predicate::compareVarChar(const char *lhs, const char *rhs)
+{
+    uint32_t lSize, rSize;
+    memcpy(&lSize, lhs, VARCHAR_LENGTH_SIZE);
+    memcpy(&rSize, rhs, VARCHAR_LENGTH_SIZE);
+    int cmp = memcmp(lhs + VARCHAR_LENGTH_SIZE, rhs + VARCHAR_LENGTH_SIZE, min(lSize, rSize));
+    if (cmp != 0)
+        return cmp;
+    return (lSize > rSize) - (lSize < rSize);
+}
+
+bool Predicate::satisfies(int cmp, CompOp op)
+{
     switch (op)
     {
+    case EQ_OP:
+        return cmp == 0;
     case LT_OP:
-        return result == -1;
-    case GT_OP:
-        return result == 1;
+        return cmp < 0;
     case LE_OP:
-        return result <= 0;
+        return cmp <= 0;
+    case GT_OP:
+        return cmp > 0;
     case GE_OP:
-        return result >= 0;
-    case EQ_OP:
-        return result == 0;
+        return cmp >= 0;
     case NE_OP:
-        return result != 0;
+        return cmp != 0;
     case NO_OP:
         return true;
-    default:
-        throw "Comparison Operator is invalid";
-        return false;
     }
+    return false;
 }
-// ... the rest of your implementations go here
-RC Filter::getNextTuple(void *data)
+
+RC Predicate::bindCondition(const Condition &condition, const vector<Attribute> &leftAttrs, const vector<Attribute> &rightAttrs, BoundCondition &bound)
 {
-    vector<Attribute> attrs;
-    iter_->getAttributes(attrs);
+    auto matchingAttrName_left = [&condition](const Attribute &a) { return a.name == condition.lhsAttr; };
+    auto iterPos_left = find_if(leftAttrs.begin(), leftAttrs.end(), matchingAttrName_left);
+    bound.lhsIndex = distance(leftAttrs.begin(), iterPos_left);
+    if (bound.lhsIndex == leftAttrs.size())
+        return QE_NO_SUCH_ATTR;
+    AttrType type = leftAttrs[bound.lhsIndex].type;
 
-    void *iter_tuple = calloc(PAGE_SIZE, sizeof(uint8_t));
-    if (iter_tuple == nullptr)
-        return -1;
+    bound.op = condition.op;
+    bound.bRhsIsAttr = condition.bRhsIsAttr;
+    bound.rhsIndex = 0;
+    bound.rhsValue = nullptr;
+    if (condition.bRhsIsAttr)
+    {
+        auto matchingAttrName_right = [&condition](const Attribute &a) { return a.name == condition.rhsAttr; };
+        auto iterPos_right = find_if(rightAttrs.begin(), rightAttrs.end(), matchingAttrName_right);
+        bound.rhsIndex = distance(rightAttrs.begin(), iterPos_right);
+        if (bound.rhsIndex == rightAttrs.size())
+            return QE_NO_SUCH_ATTR;
+        if (rightAttrs[bound.rhsIndex].type != type)
+            return QE_MISMATCHED_ATTR_TYPES;
+    }
+    else
+    {
+        if (condition.rhsValue.type != type)
+            return QE_MISMATCHED_ATTR_TYPES;
+        bound.rhsValue = (const char *)condition.rhsValue.data;
+    }
 
-    RC rc;
-    while ((rc = iter_->getNextTuple(iter_tuple)) == SUCCESS)
+    switch (type)
     {
+    case TypeInt:
+        bound.compare = compareInt;
+        break;
+    case TypeReal:
+        bound.compare = compareReal;
+        break;
+    case TypeVarChar:
+        bound.compare = compareVarChar;
+        break;
+    default:
+        return QE_NO_SUCH_ATTR_TYPE;
+    }
+    return SUCCESS;
+}
 
-        /* For simplified Filter, we only compare with:
-         *   - the tuple we just got, or
-         *   - some predefined value in condition.
-         */
-        bool result;
-        rc = evalPredicate(result, iter_tuple, cond_, iter_tuple, attrs, attrs);
-        if (rc != SUCCESS)
+RC Predicate::bind(const vector<vector<Condition>> &disjuncts, const vector<Attribute> &leftAttrs, const vector<Attribute> &rightAttrs)
+{
+    groups.clear();
+    rc = SUCCESS;
+    for (const vector<Condition> &conjunction : disjuncts)
+    {
+        vector<BoundCondition> group;
+        for (const Condition &condition : conjunction)
         {
-            free(iter_tuple);
-            return rc;
+            BoundCondition bound;
+            rc = bindCondition(condition, leftAttrs, rightAttrs, bound);
+            if (rc != SUCCESS)
+            {
+                groups.clear();
+                return rc;
+            }
+            group.push_back(bound);
         }
+        groups.push_back(group);
+    }
+    return SUCCESS;
+}
 
-        if (result)
+bool Predicate::eval(const void *leftTuple, const int32_t *leftOffsets, const void *rightTuple, const int32_t *rightOffsets) const
+{
+    for (const vector<BoundCondition> &group : groups)
+    {
+        bool holds = true;
+        for (const BoundCondition &cond : group)
         {
-            RelationManager *rm = RelationManager::instance();
-            memcpy(data, iter_tuple, rm->getTupleSize(attrs, iter_tuple));
-            free(iter_tuple);
-            return SUCCESS;
+            if (cond.op == NO_OP)
+                continue;
+            int32_t lhsOffset = leftOffsets[cond.lhsIndex];
+            const char *rhs = cond.rhsValue;
+            if (cond.bRhsIsAttr)
+            {
+                int32_t rhsOffset = rightOffsets[cond.rhsIndex];
+                rhs = rhsOffset < 0 ? nullptr : (const char *)rightTuple + rhsOffset;
+            }
+            if (lhsOffset < 0 || rhs == nullptr || !satisfies(cond.compare((const char *)leftTuple + lhsOffset, rhs), cond.op))
+            {
+                holds = false;
+                break;
+            }
         }
+        if (holds)
+            return true;
     }
+    return false;
+}
+
+Filter::Filter(Iterator *input, const Condition &condition) : iter_{input}
+{
+    init(vector<vector<Condition>>{vector<Condition>{condition}});
+}
+
+Filter::Filter(Iterator *input, const vector<Condition> &conditions) : iter_{input}
+{
+    init(vector<vector<Condition>>{conditions});
+}
+
+Filter::Filter(Iterator *input, const vector<vector<Condition>> &disjuncts) : iter_{input}
+{
+    init(disjuncts);
+}
+
+// Resolve the predicate against the input once, so getNextTuple only has to compare bytes
+void Filter::init(const vector<vector<Condition>> &disjuncts)
+{
+    iter_->getAttributes(attrs_);
+    layout_ = TupleLayout(attrs_);
+    offsets_.resize(attrs_.size());
+    predicate_.bind(disjuncts, attrs_, attrs_);
 
-    free(iter_tuple);
+    // A table scan checks what it can on the records themselves, before they become tuples
+    TableScan *scan = dynamic_cast<TableScan *>(iter_);
+    vector<vector<Condition>> rest;
+    if (predicate_.status() == SUCCESS && scan != nullptr && scan->pushDown(disjuncts, rest))
+    {
+        predicate_.bind(rest, attrs_, attrs_);
+        passThrough_ = rest.size() == 1 && rest[0].empty();
+    }
+}
+
+RC Filter::getNextTuple(void *data)
+{
+    if (predicate_.status() != SUCCESS)
+        return predicate_.status();
+    if (passThrough_)
+        return iter_->getNextTuple(data);
+
+    // Tuples are read straight into the caller's buffer; one that fails the predicate is
+    // simply overwritten by the next one
+    RC rc;
+    while ((rc = iter_->getNextTuple(data)) == SUCCESS)
+    {
+        const int32_t *offsets = layout_.locate(data, offsets_.data());
+        if (predicate_.eval(data, offsets, data, offsets))
+            return SUCCESS;
+    }
     return rc;
 }
 
 void Filter::getAttributes(vector<Attribute> &attrs) const
 {
-    iter_->getAttributes(attrs);
+    attrs = attrs_;
+}
+
+Project::Project(Iterator *input, const vector<string> &attrNames) : iter_{input}, attrNames_{attrNames}
+{
+    iter_->getAttributes(attrsBeforeProjection_);
+    for (auto aname : attrNames_)
+    {
+        auto matchingAttr = [aname](Attribute a) { return aname == a.name; };
+        auto match = std::find_if(attrsBeforeProjection_.begin(), attrsBeforeProjection_.end(), matchingAttr);
+        if (match != attrsBeforeProjection_.end())
+        {
+            attrs_.push_back(*match);
+            projection_.push_back(distance(attrsBeforeProjection_.begin(), match));
+        }
+    }
+
+    layout_ = TupleLayout(attrsBeforeProjection_);
+    offsets_.resize(attrsBeforeProjection_.size());
+    nullIndicatorSize_ = RecordBasedFileManager::getNullIndicatorSize(attrs_.size());
+
+    // With a fixed width input every field has a known place in both tuples. Fields that are
+    // adjacent in the input and the output are merged into a single copy.
+    if (layout_.isFixedWidth())
+    {
+        unsigned to = nullIndicatorSize_;
+        for (unsigned i : projection_)
+        {
+            unsigned from = layout_.fixedOffset(i);
+            if (!fixedRuns_.empty() && fixedRuns_.back().from + fixedRuns_.back().length == from)
+                fixedRuns_.back().length += INT_SIZE;
+            else
+                fixedRuns_.push_back(CopyRun{from, to, INT_SIZE});
+            to += INT_SIZE;
+        }
+    }
+
+    tuple_ = malloc(TupleLayout::bufferSize(attrsBeforeProjection_));
+}
+
+Project::~Project()
+{
+    free(tuple_);
 }
 
 RC Project::getNextTuple(void *data)
 {
-    RC rc;
+    if (tuple_ == nullptr)
+        return RBFM_MALLOC_FAILED;
 
-    void *dataBefore = malloc(PAGE_SIZE);
-    rc = iter_->getNextTuple(dataBefore);
+    RC rc = iter_->getNextTuple(tuple_);
     if (rc != SUCCESS)
-    {
-        free(dataBefore);
         return rc;
+
+    char *out = (char *)data;
+    memset(out, 0, nullIndicatorSize_);
+
+    const int32_t *offsets = layout_.locate(tuple_, offsets_.data());
+    if (layout_.isFixed(offsets))
+    {
+        for (const CopyRun &run : fixedRuns_)
+            memcpy(out + run.to, (char *)tuple_ + run.from, run.length);
+        return SUCCESS;
     }
 
-    int dataBefore_NullIndSize = RecordBasedFileManager::getNullIndicatorSize(attrsBeforeProjection_.size());
-    void *dataBefore_NullInd = dataBefore;
-    uint32_t dataBefore_Offset = dataBefore_NullIndSize;
+    // Go through in projected order and copy each field into the new tuple
+    unsigned offset = nullIndicatorSize_;
+    for (unsigned j = 0; j < projection_.size(); j++)
+    {
+        unsigned i = projection_[j];
+        if (offsets[i] < 0)
+        {
+            int indicatorIndex = j / CHAR_BIT;
+            char indicatorMask = 1 << (CHAR_BIT - 1 - (j % CHAR_BIT));
+            out[indicatorIndex] |= indicatorMask;
+            continue;
+        }
+        unsigned size = layout_.fieldSize(tuple_, i, offsets[i]);
+        memcpy(out + offset, (char *)tuple_ + offsets[i], size);
+        offset += size;
+    }
+
+    return SUCCESS;
+}
+
+void Project::getAttributes(vector<Attribute> &attrs) const
+{
+    attrs = attrs_;
+}
 
-    unordered_map<string, AttrData> projectedAttrData;
+bool TableScan::pushDown(const vector<vector<Condition>> &disjuncts, vector<vector<Condition>> &rest)
+{
+    rest = disjuncts;
+    unsigned orGroup = 0;
+    for (const ScanPredicate &predicate : predicates)
+        orGroup = max(orGroup, predicate.orGroup + 1);
 
-    int i = 0;
-    for (auto attr : attrsBeforeProjection_)
+    vector<ScanPredicate> pushed;
+    ScanPredicate predicate;
+    if (disjuncts.size() == 1)
     {
-        uint32_t attrSize;
-        if (RecordBasedFileManager::fieldIsNull((char *)dataBefore_NullInd, i))
+        // Each condition of the conjunction is a group of its own
+        rest[0].clear();
+        for (const Condition &condition : disjuncts[0])
         {
-            attrSize = 0;
+            if (toScanPredicate(condition, orGroup, predicate))
+            {
+                pushed.push_back(predicate);
+                orGroup++;
+            }
+            else
+                rest[0].push_back(condition);
         }
-        else
+    }
+    else
+    {
+        // A disjunction is taken only if it is one of single conditions, as one OR group
+        for (const vector<Condition> &conjunction : disjuncts)
         {
-            // Get size of attribute.
-            int varCharLength;
-            switch (attr.type)
+            if (conjunction.size() != 1 || !toScanPredicate(conjunction[0], orGroup, predicate))
             {
-            case TypeInt:
-            case TypeReal:
-                attrSize = sizeof(uint32_t);
-                break;
-            case TypeVarChar:
-                memcpy(&varCharLength, (char *)dataBefore + dataBefore_Offset, sizeof(uint32_t));
-                attrSize = sizeof(uint32_t) + varCharLength; // Word of length + length itself.
-                break;
-            default:
-                free(dataBefore);
-                for (auto it = projectedAttrData.begin(); it != projectedAttrData.end(); it++)
-                {
-                    AttrData ad = it->second;
-                    if (!ad.isNull)
-                        free(ad.data);
-                }
-                return QE_NO_SUCH_ATTR_TYPE;
+                rest = disjuncts;
+                return false;
             }
+            pushed.push_back(predicate);
+        }
+        rest = vector<vector<Condition>>(1);
+    }
+    if (pushed.empty())
+        return false;
+
+    predicates.insert(predicates.end(), pushed.begin(), pushed.end());
+    setIterator();
+    return true;
+}
+
+// Whether the condition compares an attribute of this scan with a value of its type, and if
+// so the predicate the scan checks in its place
+bool TableScan::toScanPredicate(const Condition &condition, unsigned orGroup, ScanPredicate &predicate) const
+{
+    string prefix = tableName + ".";
+    if (condition.bRhsIsAttr || condition.op == NO_OP || condition.rhsValue.data == NULL
+        || condition.lhsAttr.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    string name = condition.lhsAttr.substr(prefix.size());
+    auto matchingAttr = [&name](const Attribute &a) { return a.name == name; };
+    auto match = find_if(attrs.begin(), attrs.end(), matchingAttr);
+    if (match == attrs.end() || match->type != condition.rhsValue.type)
+        return false;
+
+    predicate.attribute = name;
+    predicate.compOp = condition.op;
+    predicate.value = condition.rhsValue.data;
+    predicate.orGroup = orGroup;
+    return true;
+}
+
+MorselDispenser::MorselDispenser(RelationManager &rm, const string &tableName, unsigned morselPages)
+    : nextPage(0), totalPages(0), morselPages(morselPages)
+{
+    // A table that cannot be opened has no morsels
+    if (rm.getNumberOfPages(tableName, totalPages) != SUCCESS)
+        totalPages = 0;
+}
+
+bool MorselDispenser::next(PageNum &startPage, PageNum &endPage)
+{
+    startPage = nextPage.fetch_add(morselPages);
+    if (startPage >= totalPages)
+        return false;
+    endPage = min(startPage + morselPages, totalPages);
+    return true;
+}
+
+HashPartition::HashPartition(Iterator *input, const string &attrName, unsigned partitionCount, unsigned partition)
+    : iter_{input}, attrIndex_(0), partitionCount_(partitionCount), partition_(partition), rc_(SUCCESS)
+{
+    iter_->getAttributes(attrs_);
+    layout_ = TupleLayout(attrs_);
+    offsets_.resize(attrs_.size());
+    auto matchingAttr = [&attrName](const Attribute &a) { return a.name == attrName; };
+    auto match = find_if(attrs_.begin(), attrs_.end(), matchingAttr);
+    if (match == attrs_.end() || partitionCount_ == 0)
+        rc_ = QE_NO_SUCH_ATTR;
+    else
+        attrIndex_ = distance(attrs_.begin(), match);
+}
+
+// FNV-1a
+uint32_t HashPartition::hash(const char *field, unsigned size)
+{
+    uint32_t h = 2166136261u;
+    for (unsigned i = 0; i < size; i++)
+    {
+        h ^= (unsigned char)field[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+RC HashPartition::getNextTuple(void *data)
+{
+    if (rc_ != SUCCESS)
+        return rc_;
+
+    RC rc;
+    while ((rc = iter_->getNextTuple(data)) == SUCCESS)
+    {
+        const int32_t *offsets = layout_.locate(data, offsets_.data());
+        int32_t offset = offsets[attrIndex_];
+        unsigned partition = 0;
+        if (offset >= 0)
+        {
+            const char *field = (const char *)data + offset;
+            partition = hash(field, layout_.fieldSize(data, attrIndex_, offset)) % partitionCount_;
+        }
+        if (partition == partition_)
+            return SUCCESS;
+    }
+    return rc;
+}
+
+void HashPartition::getAttributes(vector<Attribute> &attrs) const
+{
+    attrs = attrs_;
+}
+
+Exchange::Queue::Queue(unsigned capacity, unsigned batchSize)
+    : batches(capacity), head(0), tail(0), finished(false), rc(SUCCESS), readOffset(0), drained(false)
+{
+    for (Batch &batch : batches)
+    {
+        batch.bytes = (char *)malloc(batchSize);
+        batch.used = 0;
+    }
+}
+
+Exchange::Queue::~Queue()
+{
+    for (Batch &batch : batches)
+        free(batch.bytes);
+}
+
+Exchange::Exchange(const vector<Iterator *> &producers, unsigned queueBatches)
+    : producers_(producers), cancelled_(false), started_(false), next_(0), live_(producers.size())
+{
+    // All producers produce the same tuples, so the first one describes them all
+    if (!producers_.empty())
+        producers_[0]->getAttributes(attrs_);
+    layout_ = TupleLayout(attrs_);
+    // A batch holds at least one tuple of any size
+    tupleSize_ = TupleLayout::bufferSize(attrs_);
+    batchSize_ = max((unsigned)EXCHANGE_BATCH_SIZE, (unsigned)sizeof(uint32_t) + tupleSize_);
+    for (unsigned i = 0; i < producers_.size(); i++)
+        queues_.push_back(new Queue(max(queueBatches, 1u), batchSize_));
+}
+
+Exchange::~Exchange()
+{
+    // Producers still running are waiting for room in their queue; tell them to give up
+    cancelled_.store(true);
+    for (Queue *queue : queues_)
+        notify(queue->freed);
+    for (thread &t : threads_)
+        t.join();
+    for (Queue *queue : queues_)
+        delete queue;
+}
+
+void Exchange::produce(unsigned i)
+{
+    Iterator *producer = producers_[i];
+    Queue &queue = *queues_[i];
+    unsigned capacity = queue.batches.size();
+    int32_t offsets[layout_.fieldCount()];
+
+    RC rc = SUCCESS;
+    while (rc == SUCCESS)
+    {
+        // Wait until the consumer has freed a batch
+        unsigned tail = queue.tail.load(memory_order_relaxed);
+        if (tail - queue.head.load(memory_order_acquire) == capacity)
+        {
+            unique_lock<mutex> lock(waitLock_);
+            queue.freed.wait(lock, [&] {
+                return tail - queue.head.load(memory_order_acquire) != capacity || cancelled_.load();
+            });
+            if (cancelled_.load())
+                return;
         }
 
-        auto isProjectedAttr = [attr](string aname) { return aname == attr.name; };
-        if (find_if(attrNames_.begin(), attrNames_.end(), isProjectedAttr) != attrNames_.end())
+        // Tuples are read straight into the batch for as long as the largest possible one fits
+        Batch &batch = queue.batches[tail % capacity];
+        batch.used = 0;
+        if (batch.bytes == NULL)
+            rc = RBFM_MALLOC_FAILED;
+        while (rc == SUCCESS && batch.used + sizeof(uint32_t) + tupleSize_ <= batchSize_)
         {
-            AttrData ad;
-            ad.attr = attr;
-            ad.size = attrSize;
-            ad.isNull = attrSize == 0;
-            if (!ad.isNull)
+            char *tuple = batch.bytes + batch.used + sizeof(uint32_t);
+            rc = producer->getNextTuple(tuple);
+            if (rc != SUCCESS)
+                break;
+            uint32_t size = layout_.tupleSize(tuple, layout_.locate(tuple, offsets));
+            memcpy(batch.bytes + batch.used, &size, sizeof(uint32_t));
+            batch.used += sizeof(uint32_t) + size;
+        }
+
+        if (batch.used > 0)
+        {
+            queue.tail.store(tail + 1, memory_order_release);
+            notify(published_);
+        }
+    }
+
+    queue.rc = rc;
+    queue.finished.store(true, memory_order_release);
+    notify(published_);
+}
+
+bool Exchange::anyPublished()
+{
+    for (Queue *queue : queues_)
+    {
+        if (!queue->drained && (queue->finished.load(memory_order_acquire)
+                                || queue->head.load(memory_order_relaxed) != queue->tail.load(memory_order_acquire)))
+            return true;
+    }
+    return false;
+}
+
+void Exchange::notify(condition_variable &waiting)
+{
+    // The waiting side checks its condition with the lock held, so taking it here means the
+    // change just made is either seen by that check or followed by this notification
+    {
+        lock_guard<mutex> lock(waitLock_);
+    }
+    waiting.notify_one();
+}
+
+RC Exchange::getNextTuple(void *data)
+{
+    if (!started_)
+    {
+        started_ = true;
+        for (unsigned i = 0; i < producers_.size(); i++)
+            threads_.push_back(thread(&Exchange::produce, this, i));
+    }
+
+    // Visit the queues in turn, taking a whole batch from each before moving on
+    unsigned idle = 0;
+    while (live_ > 0)
+    {
+        Queue &queue = *queues_[next_];
+        if (!queue.drained)
+        {
+            // Read finished before tail: once the producer has finished, tail is final
+            bool finished = queue.finished.load(memory_order_acquire);
+            unsigned head = queue.head.load(memory_order_relaxed);
+            if (head != queue.tail.load(memory_order_acquire))
+            {
+                Batch &batch = queue.batches[head % queue.batches.size()];
+                uint32_t size;
+                memcpy(&size, batch.bytes + queue.readOffset, sizeof(uint32_t));
+                memcpy(data, batch.bytes + queue.readOffset + sizeof(uint32_t), size);
+                queue.readOffset += sizeof(uint32_t) + size;
+                if (queue.readOffset == batch.used)
+                {
+                    // Hand the batch back to the producer
+                    queue.readOffset = 0;
+                    queue.head.store(head + 1, memory_order_release);
+                    notify(queue.freed);
+                    next_ = (next_ + 1) % queues_.size();
+                }
+                return SUCCESS;
+            }
+            if (finished)
             {
-                ad.data = calloc(ad.size, sizeof(uint8_t));
-                memcpy(ad.data, (char *)dataBefore + dataBefore_Offset, ad.size);
+                queue.drained = true;
+                live_--;
+                if (queue.rc != QE_EOF)
+                    return queue.rc;
             }
+        }
 
-            projectedAttrData[attr.name] = ad;
+        next_ = (next_ + 1) % queues_.size();
+        // Every producer still running is behind the consumer
+        if (++idle == queues_.size() && live_ > 0)
+        {
+            idle = 0;
+            unique_lock<mutex> lock(waitLock_);
+            published_.wait(lock, [this] { return anyPublished(); });
         }
+    }
+    return QE_EOF;
+}
+
+void Exchange::getAttributes(vector<Attribute> &attrs) const
+{
+    attrs = attrs_;
+}
+
+Aggregate::Partial::Partial() : min(DBL_MAX), max(-DBL_MAX), sum(0), count(0), rc(SUCCESS)
+{
+}
+
+void Aggregate::Partial::add(double value)
+{
+    min = std::min(min, value);
+    max = std::max(max, value);
+    sum += value;
+    count++;
+}
+
+void Aggregate::Partial::merge(const Partial &other)
+{
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    sum += other.sum;
+    count += other.count;
+    if (rc == SUCCESS)
+        rc = other.rc;
+}
+
+Aggregate::Aggregate(Iterator *input, const Attribute &aggAttr, AggregateOp op)
+    : inputs_{input}, aggAttr_(aggAttr), op_(op)
+{
+    init();
+}
 
-        dataBefore_Offset += attrSize;
-        i++;
+Aggregate::Aggregate(const vector<Iterator *> &inputs, const Attribute &aggAttr, AggregateOp op)
+    : inputs_(inputs), aggAttr_(aggAttr), op_(op)
+{
+    init();
+}
+
+void Aggregate::init()
+{
+    rc_ = SUCCESS;
+    done_ = false;
+    attrIndex_ = 0;
+    if (inputs_.empty())
+    {
+        rc_ = QE_NO_SUCH_ATTR;
+        return;
     }
-    free(dataBefore);
 
-    int dataAfter_NullIndSize = RecordBasedFileManager::getNullIndicatorSize(attrNames_.size());
-    memset(data, 0, dataAfter_NullIndSize);
+    // All inputs produce the same tuples, so the first one describes them all
+    inputs_[0]->getAttributes(inputAttrs_);
+    layout_ = TupleLayout(inputAttrs_);
+    auto matchingAttr = [this](const Attribute &a) { return a.name == aggAttr_.name; };
+    auto match = find_if(inputAttrs_.begin(), inputAttrs_.end(), matchingAttr);
+    if (match == inputAttrs_.end())
+    {
+        rc_ = QE_NO_SUCH_ATTR;
+        return;
+    }
+    attrIndex_ = distance(inputAttrs_.begin(), match);
+    if (match->type == TypeVarChar)
+        rc_ = QE_MISMATCHED_ATTR_TYPES;
+}
 
-    uint32_t dataAfter_Offset = dataAfter_NullIndSize; // Start copying data after where the null indicator will be.
+void Aggregate::accumulate(Iterator *input, Partial &partial) const
+{
+    void *tuple = malloc(TupleLayout::bufferSize(inputAttrs_));
+    if (tuple == NULL)
+    {
+        partial.rc = RBFM_MALLOC_FAILED;
+        return;
+    }
+    int32_t offsets[layout_.fieldCount()];
 
-    int j = 0;
-    for (auto attrName : attrNames_) // Go through in projected order and copy into new tuple.
+    RC rc;
+    while ((rc = input->getNextTuple(tuple)) == SUCCESS)
     {
-        AttrData pa = projectedAttrData[attrName];
-        if (pa.isNull)
+        int32_t offset = layout_.locate(tuple, offsets)[attrIndex_];
+        // NULLs do not take part in any aggregate
+        if (offset < 0)
+            continue;
+        const char *field = (const char *)tuple + offset;
+        if (layout_.type(attrIndex_) == TypeInt)
         {
-            int indicatorIndex = j / CHAR_BIT;
-            char indicatorMask = 1 << (CHAR_BIT - 1 - (j % CHAR_BIT));
-            ((char *)data)[indicatorIndex] |= indicatorMask;
+            int32_t value;
+            memcpy(&value, field, INT_SIZE);
+            partial.add(value);
         }
         else
         {
-            memcpy((char *)data + dataAfter_Offset, pa.data, pa.size);
-            dataAfter_Offset += pa.size;
-            free(pa.data);
+            float value;
+            memcpy(&value, field, REAL_SIZE);
+            partial.add(value);
         }
-        j++;
     }
+    if (rc != QE_EOF)
+        partial.rc = rc;
+    free(tuple);
+}
 
+RC Aggregate::getNextTuple(void *data)
+{
+    if (rc_ != SUCCESS)
+        return rc_;
+    if (done_)
+        return QE_EOF;
+    done_ = true;
+
+    // Every input but the first gets a thread of its own; the first is drained on this one
+    vector<Partial> partials(inputs_.size());
+    vector<thread> workers;
+    for (unsigned i = 1; i < inputs_.size(); i++)
+        workers.push_back(thread(&Aggregate::accumulate, this, inputs_[i], ref(partials[i])));
+    accumulate(inputs_[0], partials[0]);
+
+    Partial total;
+    for (unsigned i = 0; i < inputs_.size(); i++)
+    {
+        if (i > 0)
+            workers[i - 1].join();
+        total.merge(partials[i]);
+    }
+    if (total.rc != SUCCESS)
+        return total.rc;
+
+    float result = 0;
+    bool isNull = false;
+    switch (op_)
+    {
+    case MIN:
+        result = total.min;
+        isNull = total.count == 0;
+        break;
+    case MAX:
+        result = total.max;
+        isNull = total.count == 0;
+        break;
+    case COUNT:
+        result = total.count;
+        break;
+    case SUM:
+        result = total.sum;
+        break;
+    case AVG:
+        result = total.count == 0 ? 0 : total.sum / total.count;
+        isNull = total.count == 0;
+        break;
+    }
+
+    char nullIndicator = isNull ? 1 << (CHAR_BIT - 1) : 0;
+    memcpy(data, &nullIndicator, 1);
+    if (!isNull)
+        memcpy((char *)data + 1, &result, REAL_SIZE);
     return SUCCESS;
 }
 
-void Project::getAttributes(vector<Attribute> &attrs) const
+void Aggregate::getAttributes(vector<Attribute> &attrs) const
+{
+    static const char *opNames[] = {"MIN", "MAX", "COUNT", "SUM", "AVG"};
+
+    Attribute attr;
+    attr.name = string(opNames[op_]) + "(" + aggAttr_.name + ")";
+    attr.type = TypeReal;
+    attr.length = REAL_SIZE;
+    attrs.clear();
+    attrs.push_back(attr);
+}
+
+Limit::Limit(Iterator *input, unsigned n, unsigned offset) : iter_{input}, n_(n), offset_(offset), returned_(0)
 {
-    attrs = attrs_;
 }
 
-RC evalPredicate(bool &result,
-                 const void *leftTuple, const Condition condition, const void *rightTuple,
-                 const vector<Attribute> leftAttrs,
-                 const vector<Attribute> rightAttrs)
+RC Limit::getNextTuple(void *data)
 {
+    if (returned_ >= n_)
+        return QE_EOF;
     RC rc;
+    for (; offset_ > 0; offset_--)
+    {
+        if ((rc = iter_->getNextTuple(data)) != SUCCESS)
+            return rc;
+    }
+    rc = iter_->getNextTuple(data);
+    if (rc == SUCCESS)
+        returned_++;
+    return rc;
+}
 
-    // Get leftValue.
-    auto matchingAttrName_left = [condition](Attribute a) { return a.name == condition.lhsAttr; };
-    auto iterPos_left = find_if(leftAttrs.begin(), leftAttrs.end(), matchingAttrName_left);
-    unsigned index_left = distance(leftAttrs.begin(), iterPos_left);
-    if (index_left == leftAttrs.size())
-        return QE_NO_SUCH_ATTR;
-    const Attribute leftAttr = leftAttrs[index_left];
+void Limit::getAttributes(vector<Attribute> &attrs) const
+{
+    iter_->getAttributes(attrs);
+}
 
-    void *leftKey;
-    rc = RecordBasedFileManager::getColumnFromTuple(leftTuple, leftAttrs, leftAttr.name, leftKey);
-    if (rc != SUCCESS)
+TopN::TopN(Iterator *input, const string &attrName, unsigned n, bool descending)
+    : iter_{input}, attrIndex_(0), n_(n), descending_(descending), indexOrder_(false), compare_(nullptr),
+      rc_(SUCCESS), filled_(false), returned_(0)
+{
+    iter_->getAttributes(attrs_);
+    layout_ = TupleLayout(attrs_);
+    offsets_.resize(attrs_.size());
+    auto matchingAttr = [&attrName](const Attribute &a) { return a.name == attrName; };
+    auto match = find_if(attrs_.begin(), attrs_.end(), matchingAttr);
+    if (match == attrs_.end())
+    {
+        rc_ = QE_NO_SUCH_ATTR;
+        return;
+    }
+    attrIndex_ = distance(attrs_.begin(), match);
+    compare_ = match->type == TypeInt    ? Predicate::compareInt
+               : match->type == TypeReal ? Predicate::compareReal
+                                         : Predicate::compareVarChar;
+
+    // An index ordered by the attribute first, scanned the same way, has the order wanted
+    IndexScan *scan = dynamic_cast<IndexScan *>(iter_);
+    indexOrder_ = scan != nullptr && !scan->isHeapOrder() && scan->isDescending() == descending_
+                  && attrName == scan->tableName + "." + RelationManager::splitIndexName(scan->attrName)[0];
+}
+
+bool TopN::before(const Entry &a, const Entry &b) const
+{
+    int cmp = compare_(a.tuple.data() + a.keyOffset, b.tuple.data() + b.keyOffset);
+    return descending_ ? cmp > 0 : cmp < 0;
+}
+
+RC TopN::fill()
+{
+    auto entryBefore = [this](const Entry &a, const Entry &b) { return before(a, b); };
+    vector<char> tuple(TupleLayout::bufferSize(attrs_));
+    RC rc;
+    while ((rc = iter_->getNextTuple(tuple.data())) == SUCCESS)
+    {
+        const int32_t *offsets = layout_.locate(tuple.data(), offsets_.data());
+        int32_t keyOffset = offsets[attrIndex_];
+        if (keyOffset < 0)
+            continue;
+        if (heap_.size() == n_)
+        {
+            // Only a tuple that comes before the last of the best n so far takes its place
+            const Entry &last = heap_.front();
+            int cmp = compare_(tuple.data() + keyOffset, last.tuple.data() + last.keyOffset);
+            if (descending_ ? cmp <= 0 : cmp >= 0)
+                continue;
+            pop_heap(heap_.begin(), heap_.end(), entryBefore);
+            heap_.pop_back();
+        }
+        heap_.push_back(Entry{string(tuple.data(), layout_.tupleSize(tuple.data(), offsets)), keyOffset});
+        push_heap(heap_.begin(), heap_.end(), entryBefore);
+    }
+    if (rc != QE_EOF)
         return rc;
+    sort_heap(heap_.begin(), heap_.end(), entryBefore);
+    return SUCCESS;
+}
 
-    Value leftValue = {leftAttr.type, leftKey};
+RC TopN::getNextTuple(void *data)
+{
+    if (rc_ != SUCCESS)
+        return rc_;
+    if (returned_ >= n_)
+        return QE_EOF;
 
-    // Get rightValue.
-    Value rightValue;
-    void *rightKey = nullptr;
-    if (condition.bRhsIsAttr)
+    // The input's own order: its first n tuples, and no more of it read
+    if (indexOrder_)
     {
-        auto matchingAttrName_right = [condition](Attribute a) { return a.name == condition.rhsAttr; };
-        auto iterPos_right = find_if(rightAttrs.begin(), rightAttrs.end(), matchingAttrName_right);
-        unsigned index_right = distance(rightAttrs.begin(), iterPos_right);
-        if (index_right == rightAttrs.size())
-            return QE_NO_SUCH_ATTR;
-        const Attribute rightAttr = rightAttrs[index_right];
+        RC rc = iter_->getNextTuple(data);
+        if (rc == SUCCESS)
+            returned_++;
+        return rc;
+    }
 
-        rc = RecordBasedFileManager::getColumnFromTuple(rightTuple, rightAttrs, rightAttr.name, rightKey);
-        if (rc != SUCCESS)
+    if (!filled_)
+    {
+        filled_ = true;
+        rc_ = fill();
+        if (rc_ != SUCCESS)
+            return rc_;
+    }
+    if (returned_ >= heap_.size())
+        return QE_EOF;
+    const string &tuple = heap_[returned_++].tuple;
+    memcpy(data, tuple.data(), tuple.size());
+    return SUCCESS;
+}
+
+void TopN::getAttributes(vector<Attribute> &attrs) const
+{
+    attrs = attrs_;
+}
+
+//Right has index so left is the outer and right is the inner
+
+INLJoin::INLJoin(Iterator *leftIn, IndexScan *rightIn, const Condition &condition)
+    : left(leftIn), right(rightIn), condition(condition), leftJoinIndex(0), rc(SUCCESS),
+      nextMatch(0), fetchedCount(0), nextFetched(0), leftDone(false), leftRc(QE_EOF)
+{
+    left->getAttributes(leftDescriptor);
+    right->getAttributes(rightDescriptor);
+    leftLayout = TupleLayout(leftDescriptor);
+    rc = QE_NO_SUCH_ATTR;
+    for (unsigned i = 0; i < leftDescriptor.size(); i++)
+    {
+        if (leftDescriptor[i].name.compare(condition.lhsAttr) == 0)
         {
-            free(leftKey);
-            return rc;
+            leftJoinAttr = leftDescriptor[i];
+            leftJoinIndex = i;
+            rc = SUCCESS;
+            break;
         }
-
-        rightValue = {rightAttr.type, rightKey};
     }
-    else
+    bool rightFound = false;
+    for (Attribute attr : rightDescriptor)
     {
-        rightValue = condition.rhsValue;
+        if (attr.name.compare(condition.rhsAttr) == 0)
+        {
+            rightJoinAttr = attr;
+            rightFound = true;
+            break;
+        }
     }
+    if (rc == SUCCESS && !rightFound)
+        rc = QE_NO_SUCH_ATTR;
+    if (rc == SUCCESS && leftJoinAttr.type != rightJoinAttr.type)
+        rc = QE_MISMATCHED_ATTR_TYPES;
 
-    result = leftValue.compare(&rightValue, condition.op);
+    // The index and the heap file stay open for the whole join rather than being reopened
+    // for every probe
+    IndexManager *im = IndexManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    if (rc == SUCCESS)
+        rc = im->openFile(RelationManager::getIndexFileName(right->tableName, right->attrName), indexFileHandle);
+    if (rc == SUCCESS)
+        rc = rbfm->openFile(RelationManager::getFileName(right->tableName), rightFileHandle);
 
-    free(leftKey);
-    if (rightKey != nullptr)
-        free(rightKey);
+    // A batch holds at least one outer tuple of any size
+    leftTupleSize = TupleLayout::bufferSize(leftDescriptor);
+    batchSize = max((unsigned)INLJOIN_BATCH_SIZE, leftTupleSize);
+    fetchedSize = TupleLayout::bufferSize(rightDescriptor);
+    batch = (char *)malloc(batchSize);
+    fetched = (char *)malloc(HEAP_FETCH_TUPLES * fetchedSize);
+    if (rc == SUCCESS && (batch == NULL || fetched == NULL))
+        rc = RBFM_MALLOC_FAILED;
+}
 
-    return SUCCESS;
+INLJoin::~INLJoin()
+{
+    IndexManager::instance()->closeFile(indexFileHandle);
+    RecordBasedFileManager::instance()->closeFile(rightFileHandle);
+    free(batch);
+    free(fetched);
 }
-//Right has index so left is the outer and right is the inner
 
 RC INLJoin::getNextTuple(void *data)
 {
-    RC rcRight;
-    RC rcLeft = SUCCESS;
-    void *rightTuple = malloc(PAGE_SIZE);
-    void *leftTuple = malloc(PAGE_SIZE);
-    void *leftValue;
-    while ((rcLeft = left->getNextTuple(leftTuple)) == SUCCESS)
-    {
-        RecordBasedFileManager::getColumnFromTuple(leftTuple, leftDescriptor, leftJoinAttr.name, leftValue);
-        //find exact match of leftValue in right
-        right->setIterator(leftValue, leftValue, true, true);
-        rcRight = right->getNextTuple(rightTuple);
-        free(leftValue);
-        if (rcRight == SUCCESS)
-        {
-            concat(leftTuple, rightTuple, data);
-            free(rightTuple);
-            free(leftTuple);
-            return SUCCESS;
+    if (rc != SUCCESS)
+        return rc;
+
+    if (nextFetched == fetchedCount)
+    {
+        while (nextMatch == matches.size())
+        {
+            if (leftDone)
+                return leftRc;
+            RC probeRc = probeBatch();
+            if (probeRc != SUCCESS)
+                return probeRc;
         }
 
-        memset(rightTuple, 0, PAGE_SIZE);
-        memset(leftTuple, 0, PAGE_SIZE);
+        // Fetch the inner tuples of the next few matches together
+        fetchedCount = min((unsigned)HEAP_FETCH_TUPLES, (unsigned)matches.size() - nextMatch);
+        nextFetched = 0;
+        vector<RID> rids;
+        void *buffers[fetchedCount];
+        for (unsigned i = 0; i < fetchedCount; i++)
+        {
+            rids.push_back(matches[nextMatch + i].rid);
+            buffers[i] = fetched + i * fetchedSize;
+        }
+        nextMatch += fetchedCount;
+        RC readRc = RecordBasedFileManager::instance()->readRecords(rightFileHandle, right->attrs, rids, buffers);
+        if (readRc != SUCCESS)
+            return readRc;
     }
-    free(rightTuple);
-    free(leftTuple);
-    return rcLeft;
+
+    unsigned i = nextFetched++;
+    const Match &match = matches[nextMatch - fetchedCount + i];
+    concat(batch + match.outer, fetched + i * fetchedSize, data);
+    return SUCCESS;
 }
+
+RC INLJoin::probeBatch()
+{
+    matches.clear();
+    nextMatch = 0;
+    fetchedCount = 0;
+    nextFetched = 0;
+
+    // Read outer tuples into the batch for as long as the largest possible one fits, noting
+    // where each one's join key is. Tuples with a NULL key match nothing.
+    vector<pair<unsigned, unsigned>> keys; // Offset in batch of each outer tuple and its key
+    int32_t offsets[leftDescriptor.size()];
+    unsigned used = 0;
+    while (used + leftTupleSize <= batchSize)
+    {
+        char *tuple = batch + used;
+        RC rcLeft = left->getNextTuple(tuple);
+        if (rcLeft != SUCCESS)
+        {
+            leftDone = true;
+            leftRc = rcLeft;
+            break;
+        }
+        const int32_t *located = leftLayout.locate(tuple, offsets);
+        if (located[leftJoinIndex] >= 0)
+            keys.push_back(make_pair(used, used + located[leftJoinIndex]));
+        used += leftLayout.tupleSize(tuple, located);
+    }
+
+    // Probe in key order, so equal keys are looked up once and the index is walked left to right
+    int (*compare)(const char *, const char *) = leftJoinAttr.type == TypeInt    ? Predicate::compareInt
+                                                 : leftJoinAttr.type == TypeReal ? Predicate::compareReal
+                                                                                 : Predicate::compareVarChar;
+    auto keyLess = [&](const pair<unsigned, unsigned> &a, const pair<unsigned, unsigned> &b) {
+        return compare(batch + a.second, batch + b.second) < 0;
+    };
+    sort(keys.begin(), keys.end(), keyLess);
+
+    IndexManager *im = IndexManager::instance();
+    IX_ScanIterator ixIter;
+    RID rid;
+    vector<char> key(right->keySize);
+    for (unsigned first = 0; first < keys.size();)
+    {
+        // Outer tuples [first, last) share a key
+        unsigned last = first + 1;
+        while (last < keys.size() && !keyLess(keys[first], keys[last]))
+            last++;
+
+        const char *value = batch + keys[first].second;
+        RC ixRc = im->scan(indexFileHandle, rightJoinAttr, value, value, true, true, ixIter);
+        if (ixRc != SUCCESS)
+            return ixRc;
+        while ((ixRc = ixIter.getNextEntry(rid, key.data())) == SUCCESS)
+        {
+            for (unsigned i = first; i < last; i++)
+                matches.push_back(Match{keys[i].first, rid});
+        }
+        ixIter.close();
+        if (ixRc != IX_EOF)
+            return ixRc;
+        first = last;
+    }
+
+    // Fetch the inner tuples in the order they are stored
+    auto ridLess = [](const Match &a, const Match &b) {
+        return a.rid.pageNum < b.rid.pageNum || (a.rid.pageNum == b.rid.pageNum && a.rid.slotNum < b.rid.slotNum);
+    };
+    sort(matches.begin(), matches.end(), ridLess);
+    return SUCCESS;
+}
+
 bool fieldIsNull(char *nullIndicator, int i)
 {
     int indicatorIndex = i / CHAR_BIT;
@@ -425,3 +1292,313 @@ void INLJoin::concat(const void *left, const void *right, void *data)
     offset += (leftSize - leftNullSize);
     memcpy((char *)data + offset, (char *)right + rightNullSize, rightSize - rightNullSize);
 }
+
+void IndexScan::setIterator(const void *lowKey, unsigned lowKeyLength, const void *highKey, unsigned highKeyLength,
+                            bool lowKeyInclusive, bool highKeyInclusive)
+{
+    iter->close();
+    delete iter;
+    iter = new RM_IndexScanIterator();
+    rm.indexScan(tableName, RelationManager::splitIndexName(attrName), lowKey, lowKeyLength, highKey, highKeyLength,
+                 lowKeyInclusive, highKeyInclusive, *iter, descending);
+    ridsCollected = false;
+}
+
+unsigned IndexScan::getKeySize(RelationManager &rm, const vector<Attribute> &attrs, const string &attrName)
+{
+    Attribute indexAttr;
+    vector<Attribute> keyAttrs;
+    if (rm.getIndexAttribute(attrs, attrName, indexAttr, keyAttrs) != SUCCESS)
+        return PAGE_SIZE;
+    return TupleLayout::bufferSize(vector<Attribute>(1, indexAttr));
+}
+
+// The size of the tuple prepareKeyTuple makes of the values
+static unsigned getKeyTupleSize(const vector<const Value *> &values)
+{
+    unsigned size = RecordBasedFileManager::getNullIndicatorSize(values.size());
+    for (const Value *value : values)
+        size += value->type == TypeVarChar ? VARCHAR_LENGTH_SIZE + *(int32_t *)value->data : INT_SIZE;
+    return size;
+}
+
+// A tuple of the values, none of them NULL
+static void prepareKeyTuple(const vector<const Value *> &values, char *tuple)
+{
+    int offset = RecordBasedFileManager::getNullIndicatorSize(values.size());
+    memset(tuple, 0, offset);
+    for (const Value *value : values)
+    {
+        unsigned size = value->type == TypeVarChar ? VARCHAR_LENGTH_SIZE + *(int32_t *)value->data : INT_SIZE;
+        memcpy(tuple + offset, value->data, size);
+        offset += size;
+    }
+}
+
+void IndexScan::setIterator(const vector<Condition> &conditions, vector<Condition> &rest)
+{
+    vector<string> keyNames = RelationManager::splitIndexName(attrName);
+    vector<bool> used(conditions.size(), false);
+
+    // The condition of conditions on the key attribute with the operator, if there is one
+    auto findCondition = [&](const Attribute &keyAttr, function<bool(CompOp)> isOp) -> int {
+        for (unsigned i = 0; i < conditions.size(); i++)
+        {
+            const Condition &condition = conditions[i];
+            if (used[i] || condition.bRhsIsAttr || !isOp(condition.op) || condition.rhsValue.type != keyAttr.type
+                || condition.lhsAttr.substr(condition.lhsAttr.find('.') + 1) != keyAttr.name)
+                continue;
+            used[i] = true;
+            return i;
+        }
+        return -1;
+    };
+
+    vector<const Value *> prefix;
+    const Value *low = NULL;
+    const Value *high = NULL;
+    bool lowKeyInclusive = true;
+    bool highKeyInclusive = true;
+    for (const string &name : keyNames)
+    {
+        auto keyAttr = find_if(attrs.begin(), attrs.end(), [&](const Attribute &a) { return a.name == name; });
+        if (keyAttr == attrs.end())
+            break;
+        int eq = findCondition(*keyAttr, [](CompOp op) { return op == EQ_OP; });
+        if (eq >= 0)
+        {
+            prefix.push_back(&conditions[eq].rhsValue);
+            continue;
+        }
+        // The range of the first attribute without an equality ends the key
+        int lower = findCondition(*keyAttr, [](CompOp op) { return op == GT_OP || op == GE_OP; });
+        if (lower >= 0)
+        {
+            low = &conditions[lower].rhsValue;
+            lowKeyInclusive = conditions[lower].op == GE_OP;
+        }
+        int upper = findCondition(*keyAttr, [](CompOp op) { return op == LT_OP || op == LE_OP; });
+        if (upper >= 0)
+        {
+            high = &conditions[upper].rhsValue;
+            highKeyInclusive = conditions[upper].op == LE_OP;
+        }
+        break;
+    }
+    rest.clear();
+    for (unsigned i = 0; i < conditions.size(); i++)
+        if (!used[i])
+            rest.push_back(conditions[i]);
+
+    vector<const Value *> lowValues = prefix;
+    vector<const Value *> highValues = prefix;
+    if (low != NULL)
+        lowValues.push_back(low);
+    if (high != NULL)
+        highValues.push_back(high);
+    char *lowKey = (char *)malloc(getKeyTupleSize(lowValues));
+    char *highKey = (char *)malloc(getKeyTupleSize(highValues));
+    prepareKeyTuple(lowValues, lowKey);
+    prepareKeyTuple(highValues, highKey);
+    setIterator(lowKey, lowValues.size(), highKey, highValues.size(), lowKeyInclusive, highKeyInclusive);
+    free(lowKey);
+    free(highKey);
+}
+
+RC IndexScan::getNextTupleInHeapOrder(void *data)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    // Build the bitmap: every RID of the key range, in heap order
+    if (!ridsCollected)
+    {
+        ridsCollected = true;
+        rids.clear();
+        nextRid = 0;
+        fetchedCount = 0;
+        nextFetched = 0;
+        while ((rc = iter->getNextEntry(rid, key)) == SUCCESS)
+            rids.push_back(rid);
+        if (rc != IX_EOF)
+            return rc;
+        auto ridLess = [](const RID &a, const RID &b) {
+            return a.pageNum < b.pageNum || (a.pageNum == b.pageNum && a.slotNum < b.slotNum);
+        };
+        sort(rids.begin(), rids.end(), ridLess);
+
+        if (!heapFileOpen)
+        {
+            rc = rbfm->openFile(RelationManager::getFileName(tableName), heapFileHandle);
+            if (rc != SUCCESS)
+                return rc;
+            heapFileOpen = true;
+        }
+        if (fetched == nullptr)
+        {
+            fetchedSize = TupleLayout::bufferSize(attrs);
+            fetched = (char *)malloc(HEAP_FETCH_TUPLES * fetchedSize);
+        }
+        if (fetched == nullptr)
+            return RBFM_MALLOC_FAILED;
+    }
+
+    if (nextFetched == fetchedCount)
+    {
+        if (nextRid == rids.size())
+            return QE_EOF;
+
+        fetchedCount = min((unsigned)HEAP_FETCH_TUPLES, (unsigned)rids.size() - nextRid);
+        nextFetched = 0;
+        vector<RID> chunk(rids.begin() + nextRid, rids.begin() + nextRid + fetchedCount);
+        void *buffers[fetchedCount];
+        for (unsigned i = 0; i < fetchedCount; i++)
+            buffers[i] = fetched + i * fetchedSize;
+        nextRid += fetchedCount;
+        rc = rbfm->readRecords(heapFileHandle, attrs, chunk, buffers);
+        if (rc != SUCCESS)
+            return rc;
+    }
+
+    unsigned i = nextFetched++;
+    const char *tuple = fetched + i * fetchedSize;
+    memcpy(data, tuple, getRecordSize(attrs, tuple));
+    rid = rids[nextRid - fetchedCount + i];
+    return SUCCESS;
+}
+
+IndexOnlyScan::IndexOnlyScan(RelationManager &rm, const string &tableName, const string &attrName, const char *alias)
+    : rm(rm), tableName(tableName), attrName(attrName), alias(alias ? alias : tableName)
+{
+    vector<Attribute> tableAttrs;
+    rm.getAttributes(tableName, tableAttrs);
+    for (const string &name : RelationManager::splitIndexName(attrName))
+        for (const Attribute &attr : tableAttrs)
+            if (attr.name == name)
+                attrs.push_back(attr);
+    keyCount = attrs.size();
+
+    vector<string> indexes;
+    vector<vector<string>> includedAttributes;
+    rm.getIndexes(tableName, indexes, includedAttributes);
+    for (unsigned i = 0; i < indexes.size(); i++)
+    {
+        if (indexes[i] != attrName)
+            continue;
+        for (const string &name : includedAttributes[i])
+            for (const Attribute &attr : tableAttrs)
+                if (attr.name == name)
+                    attrs.push_back(attr);
+    }
+    unsigned includedSize = RecordBasedFileManager::getNullIndicatorSize(attrs.size());
+    for (const Attribute &attr : attrs)
+        includedSize += attr.length + (attr.type == TypeVarChar ? VARCHAR_LENGTH_SIZE : 0);
+    included = (char *)malloc(includedSize);
+    keyValues = (char *)malloc(includedSize);
+    key = (char *)malloc(IndexScan::getKeySize(rm, tableAttrs, attrName));
+
+    iter = new RM_IndexScanIterator();
+    rm.indexScan(tableName, attrName, NULL, NULL, true, true, *iter);
+}
+
+IndexOnlyScan::~IndexOnlyScan()
+{
+    iter->close();
+    delete iter;
+    free(included);
+    free(keyValues);
+    free(key);
+}
+
+void IndexOnlyScan::setIterator(void *lowKey, void *highKey, bool lowKeyInclusive, bool highKeyInclusive)
+{
+    iter->close();
+    delete iter;
+    iter = new RM_IndexScanIterator();
+    rm.indexScan(tableName, attrName, lowKey, highKey, lowKeyInclusive, highKeyInclusive, *iter);
+}
+
+void IndexOnlyScan::setIterator(const void *lowKey, unsigned lowKeyLength, const void *highKey, unsigned highKeyLength,
+                                bool lowKeyInclusive, bool highKeyInclusive)
+{
+    iter->close();
+    delete iter;
+    iter = new RM_IndexScanIterator();
+    rm.indexScan(tableName, RelationManager::splitIndexName(attrName), lowKey, lowKeyLength, highKey, highKeyLength,
+                 lowKeyInclusive, highKeyInclusive, *iter);
+}
+
+RC IndexOnlyScan::getNextTuple(void *data)
+{
+    unsigned includedSize;
+    RC rc = iter->getNextEntry(rid, key, included, includedSize);
+    if (rc == IX_EOF)
+        return QE_EOF;
+    if (rc != SUCCESS)
+        return rc;
+
+    // The values of the key attributes as a tuple; the key of an index on one is never NULL
+    vector<Attribute> keyAttrs(attrs.begin(), attrs.begin() + keyCount);
+    if (keyCount == 1)
+    {
+        unsigned keySize = INT_SIZE;
+        if (attrs[0].type == TypeVarChar)
+            keySize += *(int32_t *)key;
+        keyValues[0] = 0;
+        memcpy(keyValues + 1, key, keySize);
+    }
+    else
+        IndexManager::decodeCompositeKey(keyAttrs, key, keyValues);
+
+    // The key attributes and the included ones keep their null bits
+    unsigned includedCount = attrs.size() - keyCount;
+    int nullSize = RecordBasedFileManager::getNullIndicatorSize(attrs.size());
+    int keyNullSize = RecordBasedFileManager::getNullIndicatorSize(keyCount);
+    int includedNullSize = RecordBasedFileManager::getNullIndicatorSize(includedCount);
+    memset(data, 0, nullSize);
+    for (unsigned i = 0; i < keyCount; i++)
+    {
+        if (fieldIsNull(keyValues, i))
+            setNull((char *)data, i);
+    }
+    for (unsigned i = 0; i < includedCount; i++)
+    {
+        if (includedSize == 0 || fieldIsNull(included, i))
+            setNull((char *)data, keyCount + i);
+    }
+
+    unsigned keySize = getRecordSize(keyAttrs, keyValues) - keyNullSize;
+    memcpy((char *)data + nullSize, keyValues + keyNullSize, keySize);
+    if (includedSize > 0)
+        memcpy((char *)data + nullSize + keySize, included + includedNullSize, includedSize - includedNullSize);
+    return SUCCESS;
+}
+
+void IndexOnlyScan::getAttributes(vector<Attribute> &attrs) const
+{
+    attrs = this->attrs;
+    for (Attribute &attr : attrs)
+        attr.name = alias + "." + attr.name;
+}
+
+bool IndexOnlyScan::covers(RelationManager &rm, const string &tableName, const string &attrName,
+                           const vector<string> &attrNames)
+{
+    vector<string> indexes;
+    vector<vector<string>> includedAttributes;
+    if (rm.getIndexes(tableName, indexes, includedAttributes))
+        return false;
+    auto index = find(indexes.begin(), indexes.end(), attrName);
+    if (index == indexes.end())
+        return false;
+    const vector<string> &included = includedAttributes[index - indexes.begin()];
+    vector<string> keyNames = RelationManager::splitIndexName(attrName);
+    for (const string &name : attrNames)
+    {
+        string attr = name.substr(name.find('.') + 1);
+        if (find(keyNames.begin(), keyNames.end(), attr) == keyNames.end()
+            && find(included.begin(), included.end(), attr) == included.end())
+            return false;
+    }
+    return true;
+}
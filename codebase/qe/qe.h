@@ -2,6 +2,10 @@
 #define _qe_h_
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "../rbf/rbfm.h"
@@ -12,6 +16,20 @@
 #define QE_MISMATCHED_ATTR_TYPES (-3)
 #define QE_NO_SUCH_ATTR_TYPE (-4)
 
+// Pages handed to a scan thread at a time by a MorselDispenser
+#define MORSEL_PAGES 16
+
+// Tuples an index scan in heap order, or an INLJoin, fetches from the heap file at a time
+#define HEAP_FETCH_TUPLES 64
+
+// Bytes of outer tuples an INLJoin probes the index with at a time
+#define INLJOIN_BATCH_SIZE (64 * PAGE_SIZE)
+
+// Bytes of tuples an Exchange producer passes to the consumer at a time
+#define EXCHANGE_BATCH_SIZE (16 * PAGE_SIZE)
+// Batches an Exchange producer may fill ahead of the consumer
+#define EXCHANGE_QUEUE_BATCHES 4
+
 using namespace std;
 
 typedef enum
@@ -58,6 +76,83 @@ struct Condition
     Value rhsValue;  // right-hand side value if bRhsIsAttr = FALSE
 };
 
+// Locates the fields of tuples in the format above without copying them.
+// A field's offset is its distance from the start of the tuple, or -1 if the field is NULL.
+class TupleLayout
+{
+public:
+    TupleLayout(){};
+    TupleLayout(const vector<Attribute> &attrs);
+
+    // Returns the offsets of every field in tuple. If the schema is fixed width and no field
+    // is NULL the precomputed offsets are returned, otherwise they are written into offsets.
+    const int32_t *locate(const void *tuple, int32_t *offsets) const;
+    // Number of bytes taken by field i, including the length word of a varchar
+    unsigned fieldSize(const void *tuple, unsigned i, int32_t offset) const;
+    // Number of bytes taken by the whole tuple, given the offsets returned by locate
+    unsigned tupleSize(const void *tuple, const int32_t *offsets) const;
+    // Number of bytes a buffer needs for any tuple of attrs. With its long varchars moved to
+    // overflow pages a tuple can be larger than a page; no buffer is smaller than one.
+    static unsigned bufferSize(const vector<Attribute> &attrs);
+
+    unsigned fieldCount() const { return types.size(); };
+    unsigned nullIndicatorSize() const { return nullSize; };
+    bool isFixedWidth() const { return fixedWidth; };
+    AttrType type(unsigned i) const { return types[i]; };
+    int32_t fixedOffset(unsigned i) const { return fixedOffsets[i]; };
+    // True if offsets are the precomputed ones, i.e. the tuple is fixed width with no NULL field
+    bool isFixed(const int32_t *offsets) const { return offsets == fixedOffsets.data(); };
+
+private:
+    vector<AttrType> types;
+    vector<int32_t> fixedOffsets; // Offsets of each field when the schema is fixed width and nothing is NULL
+    unsigned nullSize;
+    unsigned fixedSize;
+    bool fixedWidth;
+
+    bool hasNull(const void *tuple) const;
+};
+
+// A Condition resolved against the attributes of its input(s): column positions are looked
+// up once and the comparator is picked for the attribute type.
+struct BoundCondition
+{
+    CompOp op;
+    unsigned lhsIndex;
+    bool bRhsIsAttr;
+    unsigned rhsIndex;    // Position in the right input if bRhsIsAttr
+    const char *rhsValue; // Points at the condition's value if !bRhsIsAttr
+    int (*compare)(const char *lhs, const char *rhs);
+};
+
+// A selection predicate in disjunctive normal form: the predicate holds if every condition
+// of at least one group holds. A comparison against NULL never holds.
+class Predicate
+{
+public:
+    Predicate() : rc(SUCCESS){};
+
+    // Resolve the conditions against the left and right input attributes
+    RC bind(const vector<vector<Condition>> &disjuncts, const vector<Attribute> &leftAttrs, const vector<Attribute> &rightAttrs);
+
+    // Evaluate on tuples whose fields were located by TupleLayout::locate
+    bool eval(const void *leftTuple, const int32_t *leftOffsets, const void *rightTuple, const int32_t *rightOffsets) const;
+
+    // Result of the last bind
+    RC status() const { return rc; };
+
+    static int compareInt(const char *lhs, const char *rhs);
+    static int compareReal(const char *lhs, const char *rhs);
+    static int compareVarChar(const char *lhs, const char *rhs);
+    static bool satisfies(int cmp, CompOp op);
+
+private:
+    vector<vector<BoundCondition>> groups;
+    RC rc;
+
+    static RC bindCondition(const Condition &condition, const vector<Attribute> &leftAttrs, const vector<Attribute> &rightAttrs, BoundCondition &bound);
+};
+
 class Iterator
 {
     // All the relational operators and access methods are iterators.
@@ -74,6 +169,7 @@ public:
     RelationManager &rm;
     RM_ScanIterator *iter = nullptr;
     string tableName;
+    string relationName; // The table scanned; tableName is its alias if it has one
     vector<Attribute> attrs;
     vector<string> attrNames;
     RID rid;
@@ -82,6 +178,7 @@ public:
     {
         //Set members
         this->tableName = tableName;
+        relationName = tableName;
 
         // Get Attributes from RM
         rm.getAttributes(tableName, attrs);
@@ -103,15 +200,22 @@ public:
             this->tableName = alias;
     };
 
-    // Start a new iterator given the new compOp and value
+    // Start a new iterator, with the predicates pushed down so far
     void setIterator()
     {
         iter->close();
         delete iter;
         iter = new RM_ScanIterator();
-        rm.scan(tableName, "", NO_OP, NULL, attrNames, *iter);
+        rm.scan(relationName, predicates, attrNames, *iter, 0, endPage);
     };
 
+    // Takes over the conditions of a Filter on this scan (in disjunctive normal form, as
+    // Filter has them) that compare an attribute with a value, so that they are checked on the
+    // records where they are stored. All such conditions of a single conjunction are taken, or
+    // a disjunction of such conditions as a whole. Returns false if none were taken; the
+    // conditions the Filter still has to check are left in rest.
+    bool pushDown(const vector<vector<Condition>> &disjuncts, vector<vector<Condition>> &rest);
+
     RC getNextTuple(void *data)
     {
         return iter->getNextTuple(rid, data);
@@ -141,6 +245,63 @@ public:
             delete iter;
         }
     };
+
+protected:
+    vector<ScanPredicate> predicates;
+    // The page setIterator stops the scan before
+    PageNum endPage = SCAN_TO_END;
+
+    bool toScanPredicate(const Condition &condition, unsigned orGroup, ScanPredicate &predicate) const;
+};
+
+// Hands out consecutive page ranges ("morsels") of a table to scans running on any number of
+// threads. A thread that finishes its morsel early simply claims the next one, so work stays
+// balanced however the tuples are spread over the pages.
+class MorselDispenser
+{
+public:
+    MorselDispenser(RelationManager &rm, const string &tableName, unsigned morselPages = MORSEL_PAGES);
+
+    // Claims the next unscanned morsel; returns false once the whole table has been handed out
+    bool next(PageNum &startPage, PageNum &endPage);
+
+private:
+    atomic<unsigned> nextPage;
+    unsigned totalPages;
+    unsigned morselPages;
+};
+
+class MorselScan : public TableScan
+{
+    // A TableScan over the morsels it claims from a shared MorselDispenser. The MorselScans of
+    // one dispenser together return every tuple of the table exactly once, and each may be
+    // driven by its own thread: every scan reads through its own FileHandle.
+public:
+    MorselScan(RelationManager &rm, const string &tableName, MorselDispenser &morsels, const char *alias = NULL)
+        : TableScan(rm, tableName, alias), morsels(morsels)
+    {
+        // Nothing is scanned until the first morsel is claimed
+        endPage = 0;
+        iter->setPageRange(0, 0);
+    };
+
+    RC getNextTuple(void *data)
+    {
+        RC rc;
+        while ((rc = iter->getNextTuple(rid, data)) == RM_EOF)
+        {
+            PageNum startPage, endPage;
+            if (!morsels.next(startPage, endPage))
+                return QE_EOF;
+            rc = iter->setPageRange(startPage, endPage);
+            if (rc != SUCCESS)
+                return rc;
+        }
+        return rc;
+    };
+
+private:
+    MorselDispenser &morsels;
 };
 
 class IndexScan : public Iterator
@@ -152,7 +313,8 @@ public:
     string tableName;
     string attrName;
     vector<Attribute> attrs;
-    char key[PAGE_SIZE];
+    char *key = nullptr;
+    unsigned keySize;
     RID rid;
 
     IndexScan(RelationManager &rm, const string &tableName, const string &attrName, const char *alias = NULL) : rm(rm)
@@ -163,6 +325,8 @@ public:
 
         // Get Attributes from RM
         rm.getAttributes(tableName, attrs);
+        keySize = getKeySize(rm, attrs, attrName);
+        key = (char *)malloc(keySize);
 
         // Call rm indexScan to get iterator
         iter = new RM_IndexScanIterator();
@@ -173,6 +337,10 @@ public:
             this->tableName = alias;
     };
 
+    // A scan of the composite index on attrNames
+    IndexScan(RelationManager &rm, const string &tableName, const vector<string> &attrNames, const char *alias = NULL)
+        : IndexScan(rm, tableName, RelationManager::getIndexName(attrNames), alias){};
+
     // Start a new iterator given the new key range
     void setIterator(void *lowKey,
                      void *highKey,
@@ -183,11 +351,53 @@ public:
         delete iter;
         iter = new RM_IndexScanIterator();
         rm.indexScan(tableName, attrName, lowKey, highKey, lowKeyInclusive,
-                     highKeyInclusive, *iter);
+                     highKeyInclusive, *iter, descending);
+        ridsCollected = false;
+    };
+
+    // Start a new iterator on a key range of a composite index, with bounds on a prefix of its
+    // attributes; see RelationManager::indexScan
+    void setIterator(const void *lowKey, unsigned lowKeyLength, const void *highKey, unsigned highKeyLength,
+                     bool lowKeyInclusive, bool highKeyInclusive);
+
+    // Start a new iterator on the key range that conditions comparing key attributes with
+    // values give: equalities on the first attributes of the key, then at most a range of the
+    // next one. The conditions it could not use are left in rest, for a Filter on top.
+    void setIterator(const vector<Condition> &conditions, vector<Condition> &rest);
+
+    // Bitmap heap scan: rather than fetching the tuple of every index entry in key order, collect
+    // the RIDs of the whole key range first and fetch the tuples in the order they are stored,
+    // reading each heap page once. Set it before the first getNextTuple of a key range.
+    void setHeapOrder(bool heapOrder)
+    {
+        this->heapOrder = heapOrder;
+    };
+
+    // Descending scan: the tuples of each key range from its high key down, so that the last
+    // ones cost no more to read than the first. Starts a scan of the whole index over; set it
+    // before setIterator.
+    void setDescending(bool descending)
+    {
+        this->descending = descending;
+        setIterator(NULL, NULL, true, true);
     };
+    bool isDescending() const
+    {
+        return descending;
+    };
+    bool isHeapOrder() const
+    {
+        return heapOrder;
+    };
+
+    // Number of bytes a buffer needs for any key of the index on attrName of a table with attrs
+    static unsigned getKeySize(RelationManager &rm, const vector<Attribute> &attrs, const string &attrName);
 
     RC getNextTuple(void *data)
     {
+        if (heapOrder)
+            return getNextTupleInHeapOrder(data);
+
         int rc = iter->getNextEntry(rid, key);
         if (rc == 0)
         {
@@ -219,7 +429,65 @@ public:
             iter->close();
             delete iter;
         }
+        if (heapFileOpen)
+            RecordBasedFileManager::instance()->closeFile(heapFileHandle);
+        free(fetched);
+        free(key);
     };
+
+private:
+    bool heapOrder = false;
+    bool descending = false;
+    bool ridsCollected = false;
+    vector<RID> rids;         // Of the whole key range, sorted
+    unsigned nextRid = 0;     // First RID not fetched yet
+    char *fetched = nullptr;  // Tuples of the current chunk, fetchedSize apart
+    unsigned fetchedSize = 0;
+    unsigned fetchedCount = 0;
+    unsigned nextFetched = 0;
+    bool heapFileOpen = false;
+    FileHandle heapFileHandle;
+
+    RC getNextTupleInHeapOrder(void *data);
+};
+
+// Index-only scan: an index that includes every attribute a query needs, see
+// RelationManager::createIndex, answers it from its entries alone without reading the table.
+// Its tuples have the key attributes followed by the included attributes; attrName names a
+// composite index as RelationManager::getIndexName does.
+class IndexOnlyScan : public Iterator
+{
+public:
+    IndexOnlyScan(RelationManager &rm, const string &tableName, const string &attrName, const char *alias = NULL);
+    ~IndexOnlyScan();
+
+    // Start a new iterator given the new key range
+    void setIterator(void *lowKey, void *highKey, bool lowKeyInclusive, bool highKeyInclusive);
+    // Or a key range of a composite index, see IndexScan::setIterator
+    void setIterator(const void *lowKey, unsigned lowKeyLength, const void *highKey, unsigned highKeyLength,
+                     bool lowKeyInclusive, bool highKeyInclusive);
+
+    RC getNextTuple(void *data);
+    void getAttributes(vector<Attribute> &attrs) const;
+
+    // Whether the index on attrName has every attribute of attrNames, named attr or table.attr,
+    // so that an IndexOnlyScan can stand in for an IndexScan
+    static bool covers(RelationManager &rm, const string &tableName, const string &attrName,
+                       const vector<string> &attrNames);
+
+    RID rid;
+
+private:
+    RelationManager &rm;
+    RM_IndexScanIterator *iter = nullptr;
+    string tableName;
+    string attrName;
+    string alias;
+    vector<Attribute> attrs;    // The key attributes, then the included ones
+    unsigned keyCount;
+    char *key = nullptr;
+    char *keyValues = nullptr;  // Values of the key attributes of the current entry
+    char *included = nullptr;   // Values of the included attributes of the current entry
 };
 
 class Filter : public Iterator
@@ -228,7 +496,11 @@ class Filter : public Iterator
 public:
     Filter(Iterator *input,           // Iterator of input R
            const Condition &condition // Selection condition
-           ) : iter_{input}, cond_{condition} {};
+    );
+    // Conjunction of conditions
+    Filter(Iterator *input, const vector<Condition> &conditions);
+    // Disjunction of conjunctions of conditions
+    Filter(Iterator *input, const vector<vector<Condition>> &disjuncts);
     ~Filter(){};
 
     RC getNextTuple(void *data);
@@ -237,7 +509,14 @@ public:
 
 private:
     Iterator *iter_;
-    const Condition cond_;
+    vector<Attribute> attrs_;
+    TupleLayout layout_;
+    Predicate predicate_;
+    vector<int32_t> offsets_;
+    // Whether the input checks the whole predicate itself
+    bool passThrough_ = false;
+
+    void init(const vector<vector<Condition>> &disjuncts);
 };
 
 class Project : public Iterator
@@ -246,61 +525,50 @@ class Project : public Iterator
 public:
     // Assumes that attrNames to project are all valid attributes of tuples from the underlying input Iterator.
     Project(Iterator *input,
-            const vector<string> &attrNames) : iter_{input}, attrNames_{attrNames}
-    {
-        iter_->getAttributes(attrsBeforeProjection_);
-        for (auto aname : attrNames_)
-        {
-            auto matchingAttr = [aname](Attribute a) { return aname == a.name; };
-            auto match = std::find_if(attrsBeforeProjection_.begin(), attrsBeforeProjection_.end(), matchingAttr);
-            if (match != attrsBeforeProjection_.end())
-            {
-                attrs_.push_back(*match);
-            }
-        }
-    };
-    ~Project(){};
+            const vector<string> &attrNames);
+    ~Project();
 
     RC getNextTuple(void *data);
     // For attribute in vector<Attribute>, name it as rel.attr
     void getAttributes(vector<Attribute> &attrs) const;
 
 private:
+    // A run of bytes copied from the input tuple into the output tuple
+    struct CopyRun
+    {
+        unsigned from;
+        unsigned to;
+        unsigned length;
+    };
+
     Iterator *iter_;
     vector<Attribute> attrsBeforeProjection_;
     vector<Attribute> attrs_;
     vector<string> attrNames_;
+
+    // Position in the input tuple of each projected attribute
+    vector<unsigned> projection_;
+    TupleLayout layout_;
+    vector<int32_t> offsets_;
+    unsigned nullIndicatorSize_;
+    // For fixed width inputs with no NULL fields, the whole projection is this list of copies
+    vector<CopyRun> fixedRuns_;
+    void *tuple_;
 };
 
 class INLJoin : public Iterator
 {
     // Index nested-loop join operator
+    // Outer tuples are read in batches. The batch is probed against the index in key order,
+    // each distinct key once, and the matching inner tuples are then fetched in RID order so
+    // that the heap file is read sequentially. Every match of every outer tuple is returned,
+    // though not in the order of the outer input.
 public:
     INLJoin(Iterator *leftIn,          // Iterator of input R
             IndexScan *rightIn,        // IndexScan Iterator of input S
             const Condition &condition // Join condition
-            ) : left(leftIn), right(rightIn), condition(condition)
-    {
-        left->getAttributes(leftDescriptor);
-        right->getAttributes(rightDescriptor);
-        for (Attribute attr : leftDescriptor)
-        {
-            if (attr.name.compare(condition.lhsAttr) == 0)
-            {
-                leftJoinAttr = attr;
-                break;
-            }
-        }
-        for (Attribute attr : rightDescriptor)
-        {
-            if (attr.name.compare(condition.rhsAttr) == 0)
-            {
-                rightJoinAttr = attr;
-                break;
-            }
-        }
-    };
-    ~INLJoin(){};
+    );
+    ~INLJoin();
 
     RC getNextTuple(void *data);
     // For attribute in vector<Attribute>, name it as rel.attr
@@ -315,6 +583,13 @@ public:
     };
 
 private:
+    // An outer tuple and the RID of one inner tuple that joins with it
+    struct Match
+    {
+        unsigned outer; // Offset of the outer tuple in the batch
+        RID rid;
+    };
+
     Iterator *left;
     IndexScan *right;
     vector<Attribute> leftDescriptor;
@@ -323,11 +598,234 @@ private:
     Attribute rightJoinAttr;
     const Condition condition;
     void concat(const void *left, const void *right, void *data);
+
+    TupleLayout leftLayout;
+    unsigned leftJoinIndex;
+    IXFileHandle indexFileHandle;
+    FileHandle rightFileHandle;
+    RC rc;
+
+    char *batch;           // Outer tuples of the current batch, back to back
+    unsigned batchSize;
+    unsigned leftTupleSize; // Room for the largest outer tuple
+    vector<Match> matches; // Sorted by RID
+    unsigned nextMatch;    // First match whose inner tuple is not fetched yet
+    char *fetched;         // Inner tuples of matches [nextMatch - fetchedCount, nextMatch), fetchedSize apart
+    unsigned fetchedSize;
+    unsigned fetchedCount;
+    unsigned nextFetched;
+    bool leftDone;
+    RC leftRc;
+
+    // Read the next batch of outer tuples and find all their matches
+    RC probeBatch();
 };
 
-RC evalPredicate(bool &result,
-                 const void *leftTuple, Condition condition, const void *rightTuple,
-                 const vector<Attribute> leftAttrs,
-                 const vector<Attribute> rightAttrs);
+class HashPartition : public Iterator
+{
+    // Passes on only the tuples of input whose attribute hashes to the given one of
+    // partitionCount partitions; NULLs all go to partition 0. Equal values land in the same
+    // partition on both inputs of a join, so each join partition can run independently.
+public:
+    HashPartition(Iterator *input, const string &attrName, unsigned partitionCount, unsigned partition);
+    ~HashPartition(){};
+
+    RC getNextTuple(void *data);
+    // For attribute in vector<Attribute>, name it as rel.attr
+    void getAttributes(vector<Attribute> &attrs) const;
+
+    static uint32_t hash(const char *field, unsigned size);
+
+private:
+    Iterator *iter_;
+    vector<Attribute> attrs_;
+    TupleLayout layout_;
+    vector<int32_t> offsets_;
+    unsigned attrIndex_;
+    unsigned partitionCount_;
+    unsigned partition_;
+    RC rc_;
+};
+
+class Exchange : public Iterator
+{
+    // Gathers the tuples of several producer subtrees, each run on its own thread, into one
+    // stream. The producers must cover disjoint partitions of the data: MorselScans sharing a
+    // dispenser, IndexScans over disjoint key ranges, or HashPartitions of one input.
+    // Producers may set index scans and run INLJoins on their own threads, as the index layer
+    // guards the pinned pages, filters and LSM trees its handles share, but each needs
+    // IndexScans of its own: no iterator may be shared between producers.
+    // Every producer passes batches of tuples to the consumer through its own bounded
+    // single-producer single-consumer queue. A consumer that finds every producer behind, and
+    // a producer that gets too far ahead, sleep on a condition variable until a batch is
+    // published or handed back. Tuples of different producers come out in no particular order.
+public:
+    Exchange(const vector<Iterator *> &producers, unsigned queueBatches = EXCHANGE_QUEUE_BATCHES);
+    ~Exchange();
+
+    RC getNextTuple(void *data);
+    // For attribute in vector<Attribute>, name it as rel.attr
+    void getAttributes(vector<Attribute> &attrs) const;
+
+private:
+    // Tuples packed back to back, each preceded by its size
+    struct Batch
+    {
+        char *bytes;
+        unsigned used;
+    };
+
+    // Ring of batches between one producer and the consumer. The producer only moves tail and
+    // the consumer only moves head; a batch between head and tail belongs to the consumer.
+    struct Queue
+    {
+        vector<Batch> batches;
+        atomic<unsigned> head;
+        atomic<unsigned> tail;
+        atomic<bool> finished; // The producer has published its last batch
+        RC rc;                 // Why the producer stopped, valid once finished
+        unsigned readOffset;   // Consumer position in the batch at head
+        bool drained;          // The consumer has taken everything
+        condition_variable freed; // The consumer handed a batch back
+
+        Queue(unsigned capacity, unsigned batchSize);
+        ~Queue();
+    };
+
+    vector<Iterator *> producers_;
+    vector<Attribute> attrs_;
+    TupleLayout layout_;
+    unsigned tupleSize_; // Room for the largest tuple
+    unsigned batchSize_;
+    vector<Queue *> queues_;
+    vector<thread> threads_;
+    atomic<bool> cancelled_;
+    bool started_;
+    unsigned next_;
+    unsigned live_;
+    // Taken only to sleep and to wake a side that may be asleep, once per batch
+    mutex waitLock_;
+    condition_variable published_; // A producer published a batch or finished
+
+    void produce(unsigned i);
+    // Whether some producer has a batch for the consumer or has finished
+    bool anyPublished();
+    void notify(condition_variable &waiting);
+};
+
+class Aggregate : public Iterator
+{
+    // Aggregation operator
+public:
+    // Aggregate aggAttr over every tuple of input
+    Aggregate(Iterator *input,          // Iterator of input R
+              const Attribute &aggAttr, // The attribute over which we are computing an aggregate
+              AggregateOp op            // Aggregate operation
+    );
+    // Parallel aggregation: each input is drained by its own thread into a partial aggregate,
+    // and the partials are merged into the result. The inputs are usually identical pipelines
+    // over MorselScans sharing one MorselDispenser.
+    Aggregate(const vector<Iterator *> &inputs, const Attribute &aggAttr, AggregateOp op);
+    ~Aggregate(){};
+
+    // The result is a single tuple holding a REAL, or NULL for the MIN, MAX or AVG of no tuples
+    RC getNextTuple(void *data);
+    // Please name the output attribute as aggregateOp(aggAttr)
+    // E.g. Relation=rel, attribute=attr, aggregateOp=MAX
+    // output attrname = "MAX(rel.attr)"
+    void getAttributes(vector<Attribute> &attrs) const;
+
+private:
+    // Running aggregate over part of the input
+    struct Partial
+    {
+        double min;
+        double max;
+        double sum;
+        unsigned count;
+        RC rc;
+
+        Partial();
+        void add(double value);
+        void merge(const Partial &other);
+    };
+
+    vector<Iterator *> inputs_;
+    Attribute aggAttr_;
+    AggregateOp op_;
+    vector<Attribute> inputAttrs_;
+    TupleLayout layout_;
+    unsigned attrIndex_;
+    RC rc_;
+    bool done_;
+
+    void init();
+    // Drain input into partial; run by one thread per input
+    void accumulate(Iterator *input, Partial &partial) const;
+};
+
+class Limit : public Iterator
+{
+    // Passes on the n tuples of input after its first offset ones, then stops pulling from it
+public:
+    Limit(Iterator *input, unsigned n, unsigned offset = 0);
+    ~Limit(){};
+
+    RC getNextTuple(void *data);
+    void getAttributes(vector<Attribute> &attrs) const;
+
+private:
+    Iterator *iter_;
+    unsigned n_;
+    unsigned offset_;
+    unsigned returned_;
+};
+
+class TopN : public Iterator
+{
+    // The n tuples of input with the least values of attrName, or with descending the greatest,
+    // in that order; tuples whose value is NULL are left out, as an index leaves them out.
+    // Keeps the best n seen in a heap rather than sorting the whole input. An IndexScan of an
+    // index whose first key attribute is attrName, scanned in the same direction (see
+    // IndexScan::setDescending), gives its tuples in order already: the first n of them are
+    // taken and the rest of its range is never read.
+public:
+    TopN(Iterator *input, const string &attrName, unsigned n, bool descending = false);
+    ~TopN(){};
+
+    RC getNextTuple(void *data);
+    void getAttributes(vector<Attribute> &attrs) const;
+
+    // Whether the input gives the tuples in order, so that no heap is kept
+    bool usesIndexOrder() const { return indexOrder_; };
+
+private:
+    // A tuple kept, and where its value of attrName is in it
+    struct Entry
+    {
+        string tuple;
+        int32_t keyOffset;
+    };
+
+    Iterator *iter_;
+    vector<Attribute> attrs_;
+    TupleLayout layout_;
+    vector<int32_t> offsets_;
+    unsigned attrIndex_;
+    unsigned n_;
+    bool descending_;
+    bool indexOrder_;
+    int (*compare_)(const char *, const char *);
+    RC rc_;
+
+    vector<Entry> heap_;    // Ordered by before, the last of the best n on top
+    bool filled_;
+    unsigned returned_;
+
+    // Whether a comes before b in the output
+    bool before(const Entry &a, const Entry &b) const;
+    // Drain the input into the heap, then sort it
+    RC fill();
+};
 
 #endif
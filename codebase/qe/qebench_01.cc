@@ -0,0 +1,119 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+// Scaling of a morsel-driven full-table aggregation with the number of threads.
+// Usage: qebench_01 [tupleCount]
+
+const char *benchTable = "benchscan";
+const unsigned threadCounts[] = {1, 2, 4, 8, 16};
+const int repetitions = 3;
+
+RC createBenchTable(int tupleCount) {
+	vector<Attribute> attrs;
+	Attribute attr;
+	attr.name = "A";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+	attr.name = "B";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+	attr.name = "C";
+	attr.type = TypeReal;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	// The catalog is only created if no test has done so yet
+	rm->deleteTable(benchTable);
+	if (rm->createTable(benchTable, attrs) != success) {
+		rm->createCatalog();
+		if (rm->createTable(benchTable, attrs) != success)
+			return fail;
+	}
+
+	unsigned char nullsIndicator = 0;
+	char buf[bufSize];
+	RID rid;
+	for (int i = 0; i < tupleCount; ++i) {
+		prepareLeftTuple(attrs.size(), &nullsIndicator, i, i % 1000, (float)i, buf);
+		if (rm->insertTuple(benchTable, buf, rid) != success)
+			return fail;
+	}
+	return success;
+}
+
+// Seconds taken by SELECT SUM(B) FROM benchscan WHERE C >= 0 on threadCount threads
+double runAggregate(unsigned threadCount, float &result) {
+	float zero = 0;
+	Condition cond;
+	cond.lhsAttr = string(benchTable) + ".C";
+	cond.op = GE_OP;
+	cond.bRhsIsAttr = false;
+	cond.rhsValue.type = TypeReal;
+	cond.rhsValue.data = &zero;
+
+	Attribute aggAttr;
+	aggAttr.name = string(benchTable) + ".B";
+	aggAttr.type = TypeInt;
+	aggAttr.length = 4;
+
+	auto start = chrono::steady_clock::now();
+
+	MorselDispenser morsels(*rm, benchTable);
+	vector<MorselScan *> scans;
+	vector<Iterator *> pipelines;
+	for (unsigned t = 0; t < threadCount; t++) {
+		scans.push_back(new MorselScan(*rm, benchTable, morsels));
+		pipelines.push_back(new Filter(scans.back(), cond));
+	}
+	Aggregate agg(pipelines, aggAttr, SUM);
+	char data[bufSize];
+	agg.getNextTuple(data);
+	result = *(float *)(data + 1);
+
+	auto end = chrono::steady_clock::now();
+	for (unsigned t = 0; t < threadCount; t++) {
+		delete pipelines[t];
+		delete scans[t];
+	}
+	return chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char **argv) {
+	int tupleCount = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	cerr << "Loading " << tupleCount << " tuples..." << endl;
+	if (createBenchTable(tupleCount) != success) {
+		cerr << "***** Creating the benchmark table failed. *****" << endl;
+		return fail;
+	}
+	unsigned pageCount = 0;
+	rm->getNumberOfPages(benchTable, pageCount);
+	cerr << pageCount << " pages, " << MORSEL_PAGES << " pages per morsel" << endl;
+
+	double baseline = 0;
+	for (unsigned threadCount : threadCounts) {
+		// Best of a few runs, so the page cache is warm for all of them
+		double best = 0;
+		float result = 0;
+		for (int r = 0; r < repetitions; r++) {
+			double seconds = runAggregate(threadCount, result);
+			if (r == 0 || seconds < best)
+				best = seconds;
+		}
+		if (threadCount == 1)
+			baseline = best;
+		cerr << threadCount << " threads: " << best * 1000 << " ms, "
+			 << tupleCount / best / 1e6 << " Mtuples/s, speedup " << baseline / best
+			 << " (SUM = " << result << ")" << endl;
+	}
+
+	rm->deleteTable(benchTable);
+	return success;
+}
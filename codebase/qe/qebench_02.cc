@@ -0,0 +1,126 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+// One-to-many index nested-loop join: every outer tuple matches fanout inner tuples.
+// Compares INLJoin with probing the index once per outer tuple and reading each match
+// with readTuple.
+// Usage: qebench_02 [outerCount] [innerKeys] [fanout]
+
+const char *outerTable = "benchouter";
+const char *innerTable = "benchinner";
+
+RC createTable(const char *tableName) {
+	vector<Attribute> attrs;
+	Attribute attr;
+	attr.name = "A";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+	attr.name = "B";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+	attr.name = "C";
+	attr.type = TypeReal;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	// The catalog is only created if no test has done so yet
+	rm->deleteTable(tableName);
+	if (rm->createTable(tableName, attrs) == success)
+		return success;
+	rm->createCatalog();
+	return rm->createTable(tableName, attrs);
+}
+
+RC loadTables(int outerCount, int innerKeys, int fanout) {
+	if (createTable(outerTable) != success || createTable(innerTable) != success)
+		return fail;
+	if (rm->createIndex(innerTable, "B") != success)
+		return fail;
+
+	unsigned char nullsIndicator = 0;
+	char buf[bufSize];
+	RID rid;
+	// Outer: A = i, B = key to join on
+	for (int i = 0; i < outerCount; ++i) {
+		prepareLeftTuple(3, &nullsIndicator, i, (int)(((unsigned)i * 2654435761u) % innerKeys), (float)i, buf);
+		if (rm->insertTuple(outerTable, buf, rid) != success)
+			return fail;
+	}
+	// Inner: fanout tuples for every key, inserted key by key
+	for (int i = 0; i < innerKeys * fanout; ++i) {
+		prepareLeftTuple(3, &nullsIndicator, i, i % innerKeys, (float)i, buf);
+		if (rm->insertTuple(innerTable, buf, rid) != success)
+			return fail;
+	}
+	return success;
+}
+
+Condition joinCondition() {
+	Condition cond;
+	cond.lhsAttr = string(outerTable) + ".B";
+	cond.op = EQ_OP;
+	cond.bRhsIsAttr = true;
+	cond.rhsAttr = string(innerTable) + ".B";
+	return cond;
+}
+
+double runINLJoin(long &results) {
+	auto start = chrono::steady_clock::now();
+	TableScan outer(*rm, outerTable);
+	IndexScan inner(*rm, innerTable, "B");
+	INLJoin join(&outer, &inner, joinCondition());
+	char data[bufSize];
+	results = 0;
+	while (join.getNextTuple(data) == success)
+		results++;
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// The join as done before batching: one index scan and one readTuple per match
+double runTupleAtATime(long &results) {
+	auto start = chrono::steady_clock::now();
+	TableScan outer(*rm, outerTable);
+	IndexScan inner(*rm, innerTable, "B");
+	char outerTuple[bufSize];
+	char innerTuple[bufSize];
+	results = 0;
+	while (outer.getNextTuple(outerTuple) == success) {
+		int key = *(int *)(outerTuple + 5);
+		inner.setIterator(&key, &key, true, true);
+		while (inner.getNextTuple(innerTuple) == success)
+			results++;
+	}
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+	int outerCount = argc > 1 ? atoi(argv[1]) : 1000000;
+	int innerKeys = argc > 2 ? atoi(argv[2]) : 10000;
+	int fanout = argc > 3 ? atoi(argv[3]) : 4;
+
+	cerr << "Loading " << outerCount << " outer tuples, " << innerKeys << " inner keys x " << fanout << "..." << endl;
+	if (loadTables(outerCount, innerKeys, fanout) != success) {
+		cerr << "***** Creating the benchmark tables failed. *****" << endl;
+		return fail;
+	}
+
+	long results;
+	double seconds = runINLJoin(results);
+	cerr << "INLJoin: " << seconds * 1000 << " ms, " << results << " results, "
+		 << results / seconds / 1e6 << " Mtuples/s" << endl;
+	double baseline = runTupleAtATime(results);
+	cerr << "Probe per outer tuple: " << baseline * 1000 << " ms, " << results << " results, "
+		 << results / baseline / 1e6 << " Mtuples/s" << endl;
+	cerr << "Speedup " << baseline / seconds << endl;
+
+	rm->deleteTable(outerTable);
+	rm->deleteTable(innerTable);
+	return success;
+}
@@ -0,0 +1,202 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+// Filter throughput: SELECT * FROM benchfilter WHERE B < 100, with the predicate bound once
+// and evaluated on the raw tuple bytes, against evaluating it the way Filter did before, by
+// looking up and copying out the attribute of every tuple. The tuples are read into memory
+// first so that the scan does not hide the cost of the predicate; the filters over a table
+// scan are timed as well.
+// Usage: qebench_03 [tupleCount]
+
+const char *benchTable = "benchfilter";
+const int repetitions = 3;
+
+RC createBenchTable(int tupleCount) {
+	vector<Attribute> attrs;
+	Attribute attr;
+	attr.name = "A";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+	attr.name = "B";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+	attr.name = "C";
+	attr.type = TypeReal;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	// The catalog is only created if no test has done so yet
+	rm->deleteTable(benchTable);
+	if (rm->createTable(benchTable, attrs) != success) {
+		rm->createCatalog();
+		if (rm->createTable(benchTable, attrs) != success)
+			return fail;
+	}
+
+	unsigned char nullsIndicator = 0;
+	char buf[bufSize];
+	RID rid;
+	for (int i = 0; i < tupleCount; ++i) {
+		prepareLeftTuple(attrs.size(), &nullsIndicator, i, (int)(((unsigned)i * 2654435761u) % 1000), (float)i, buf);
+		if (rm->insertTuple(benchTable, buf, rid) != success)
+			return fail;
+	}
+	return success;
+}
+
+// Returns the tuples of a table scan, read once into memory
+class MemoryScan : public Iterator {
+public:
+	MemoryScan(Iterator *input) : next(0) {
+		input->getAttributes(attrs);
+		char data[bufSize];
+		while (input->getNextTuple(data) == success)
+			tuples.push_back(string(data, rm->getTupleSize(attrs, data)));
+	};
+	RC getNextTuple(void *data) {
+		if (next == tuples.size())
+			return QE_EOF;
+		memcpy(data, tuples[next].data(), tuples[next].size());
+		next++;
+		return success;
+	};
+	void getAttributes(vector<Attribute> &attrs) const {
+		attrs = this->attrs;
+	};
+	void reset() {
+		next = 0;
+	};
+
+	vector<Attribute> attrs;
+	vector<string> tuples;
+	unsigned next;
+};
+
+// The filter as it was before its predicate was bound: the attributes are fetched, the
+// condition attribute looked up by name and copied out, and a buffer allocated, per tuple
+class TupleAtATimeFilter : public Iterator {
+public:
+	TupleAtATimeFilter(Iterator *input, const Condition &condition) : input(input), condition(condition) {};
+	RC getNextTuple(void *data) {
+		vector<Attribute> attrs;
+		input->getAttributes(attrs);
+		void *tuple = calloc(PAGE_SIZE, 1);
+		RC rc;
+		while ((rc = input->getNextTuple(tuple)) == success) {
+			bool result;
+			rc = evalCondition(result, tuple, attrs);
+			if (rc != success)
+				break;
+			if (result) {
+				memcpy(data, tuple, rm->getTupleSize(attrs, tuple));
+				break;
+			}
+		}
+		free(tuple);
+		return rc;
+	};
+	void getAttributes(vector<Attribute> &attrs) const {
+		input->getAttributes(attrs);
+	};
+
+	Iterator *input;
+	Condition condition;
+
+private:
+	RC evalCondition(bool &result, const void *tuple, const vector<Attribute> &attrs) {
+		string name = condition.lhsAttr;
+		auto attr = find_if(attrs.begin(), attrs.end(), [name](const Attribute &a) { return a.name == name; });
+		if (attr == attrs.end())
+			return QE_NO_SUCH_ATTR;
+		void *key;
+		RC rc = RecordBasedFileManager::getColumnFromTuple(tuple, attrs, attr->name, key);
+		if (rc != success)
+			return rc;
+		Value value = {attr->type, key};
+		result = value.compare(&condition.rhsValue, condition.op);
+		free(key);
+		return success;
+	};
+};
+
+Condition benchCondition(int *bound) {
+	Condition cond;
+	cond.lhsAttr = string(benchTable) + ".B";
+	cond.op = LT_OP;
+	cond.bRhsIsAttr = false;
+	cond.rhsValue.type = TypeInt;
+	cond.rhsValue.data = bound;
+	return cond;
+}
+
+// Seconds taken to drain filter
+double drain(Iterator *filter, long &results) {
+	char data[bufSize];
+	auto start = chrono::steady_clock::now();
+	results = 0;
+	while (filter->getNextTuple(data) == success)
+		results++;
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Best of the repetitions of draining filter over the tuples in memory
+double drainMemory(Iterator *filter, MemoryScan &memory, long &results) {
+	double best = 0;
+	for (int r = 0; r < repetitions; r++) {
+		memory.reset();
+		double seconds = drain(filter, results);
+		if (r == 0 || seconds < best)
+			best = seconds;
+	}
+	return best;
+}
+
+void report(const char *name, double seconds, long results, int tupleCount) {
+	cerr << name << ": " << seconds * 1000 << " ms, " << results << " results, "
+		 << tupleCount / seconds / 1e6 << " Mtuples/s" << endl;
+}
+
+int main(int argc, char **argv) {
+	int tupleCount = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	cerr << "Loading " << tupleCount << " tuples..." << endl;
+	if (createBenchTable(tupleCount) != success) {
+		cerr << "***** Creating the benchmark table failed. *****" << endl;
+		return fail;
+	}
+	int bound = 100;
+	Condition cond = benchCondition(&bound);
+	long results;
+
+	TableScan loader(*rm, benchTable);
+	MemoryScan memory(&loader);
+	Filter filter(&memory, cond);
+	double seconds = drainMemory(&filter, memory, results);
+	report("Filter, in memory", seconds, results, tupleCount);
+	TupleAtATimeFilter oldFilter(&memory, cond);
+	double baseline = drainMemory(&oldFilter, memory, results);
+	report("Tuple at a time, in memory", baseline, results, tupleCount);
+	cerr << "Speedup " << baseline / seconds << endl;
+
+	TableScan scan(*rm, benchTable);
+	Filter scanFilter(&scan, cond);
+	seconds = drain(&scanFilter, results);
+	report("Filter over a table scan", seconds, results, tupleCount);
+	TableScan oldScan(*rm, benchTable);
+	TupleAtATimeFilter oldScanFilter(&oldScan, cond);
+	baseline = drain(&oldScanFilter, results);
+	report("Tuple at a time over a table scan", baseline, results, tupleCount);
+	cerr << "Speedup " << baseline / seconds << endl;
+
+	rm->deleteTable(benchTable);
+	return success;
+}
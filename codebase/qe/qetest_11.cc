@@ -0,0 +1,105 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+
+RC testCase_11() {
+	// Filter -- TableScan as input, on a disjunction of conjunctions
+	// SELECT * FROM LEFT WHERE (B >= 20 AND B < 40) OR A = 90
+	cerr << endl << "***** In QE Test Case 11 *****" << endl;
+	RC rc = success;
+
+	TableScan *ts = new TableScan(*rm, "left");
+	int lowVal = 20;
+	int highVal = 40;
+	int eqVal = 90;
+
+	// Set up conditions
+	Condition condLow;
+	condLow.lhsAttr = "left.B";
+	condLow.op = GE_OP;
+	condLow.bRhsIsAttr = false;
+	condLow.rhsValue.type = TypeInt;
+	condLow.rhsValue.data = &lowVal;
+
+	Condition condHigh;
+	condHigh.lhsAttr = "left.B";
+	condHigh.op = LT_OP;
+	condHigh.bRhsIsAttr = false;
+	condHigh.rhsValue.type = TypeInt;
+	condHigh.rhsValue.data = &highVal;
+
+	Condition condEq;
+	condEq.lhsAttr = "left.A";
+	condEq.op = EQ_OP;
+	condEq.bRhsIsAttr = false;
+	condEq.rhsValue.type = TypeInt;
+	condEq.rhsValue.data = &eqVal;
+
+	vector<vector<Condition>> disjuncts(2);
+	disjuncts[0].push_back(condLow);
+	disjuncts[0].push_back(condHigh);
+	disjuncts[1].push_back(condEq);
+
+	int expectedResultCnt = 21;  // A 10~29 and A 90
+	int actualResultCnt = 0;
+
+	// Create Filter
+	Filter *filter = new Filter(ts, disjuncts);
+
+	// Go over the data through iterator
+	void *data = malloc(bufSize);
+	int valueA = 0;
+	int valueB = 0;
+
+	while (filter->getNextTuple(data) != QE_EOF) {
+		// No attribute of left is NULL
+		if (*(unsigned char *)data != 0) {
+			cerr << endl << "***** A returned value is not correct. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		valueA = *(int *)((char *)data + 1);
+		valueB = *(int *)((char *)data + 1 + sizeof(int));
+		cerr << "left.A " << valueA << "  left.B " << valueB << endl;
+
+		if (!((valueB >= lowVal && valueB < highVal) || valueA == eqVal)) {
+			cerr << endl << "***** A returned value is not correct. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+
+		memset(data, 0, bufSize);
+		actualResultCnt++;
+	}
+
+	if (expectedResultCnt != actualResultCnt) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+
+clean_up:
+	delete filter;
+	delete ts;
+	free(data);
+	return rc;
+}
+
+
+int main() {
+	// Tables created: none
+	// Indexes created: none
+
+	if (testCase_11() != success) {
+		cerr << "***** [FAIL] QE Test Case 11 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 11 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
@@ -0,0 +1,154 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#include "qe_test_util.h"
+
+// Compare an aggregate result against the exact answer, allowing for REAL rounding
+bool closeEnough(float actual, double expected) {
+	return fabs(actual - expected) <= fabs(expected) * 1e-6;
+}
+
+RC checkAggregate(Aggregate *agg, double expected) {
+	char data[bufSize];
+	if (agg->getNextTuple(data) != success || *(unsigned char *)data != 0) {
+		cerr << "***** The aggregate did not return a value. *****" << endl;
+		return fail;
+	}
+	float result = *(float *)(data + 1);
+	vector<Attribute> attrs;
+	agg->getAttributes(attrs);
+	cerr << attrs[0].name << " " << result << endl;
+	if (!closeEnough(result, expected)) {
+		cerr << "***** A returned value is not correct. *****" << endl;
+		return fail;
+	}
+	if (agg->getNextTuple(data) != QE_EOF) {
+		cerr << "***** The aggregate returned more than one tuple. *****" << endl;
+		return fail;
+	}
+	return success;
+}
+
+RC testCase_12() {
+	// Morsel-driven parallel aggregation
+	// SELECT MIN(B), MAX(B), COUNT(B), SUM(B), AVG(B) FROM LARGELEFT WHERE A < 25000
+	cerr << endl << "***** In QE Test Case 12 *****" << endl;
+	RC rc = success;
+
+	const unsigned threadCount = 4;
+	const int bound = 25000;
+
+	Attribute aggAttr;
+	aggAttr.name = "largeleft.B";
+	aggAttr.type = TypeInt;
+	aggAttr.length = 4;
+
+	Condition cond;
+	cond.lhsAttr = "largeleft.A";
+	cond.op = LT_OP;
+	cond.bRhsIsAttr = false;
+	cond.rhsValue.type = TypeInt;
+	cond.rhsValue.data = (void *)&bound;
+
+	// B = A + 10
+	double count = bound;
+	double sum = count * (count - 1) / 2 + 10 * count;
+	AggregateOp ops[] = {MIN, MAX, COUNT, SUM, AVG};
+	double expected[] = {10, bound + 9, count, sum, sum / count};
+
+	// Serial aggregation for reference
+	{
+		TableScan ts(*rm, "largeleft");
+		Filter filter(&ts, cond);
+		Aggregate agg(&filter, aggAttr, MAX);
+		if (checkAggregate(&agg, expected[1]) != success)
+			return fail;
+	}
+
+	for (unsigned i = 0; i < sizeof(ops) / sizeof(ops[0]) && rc == success; i++) {
+		// One scan -> filter pipeline per thread, all drawing morsels from one dispenser
+		MorselDispenser morsels(*rm, "largeleft", 4);
+		vector<MorselScan *> scans;
+		vector<Iterator *> pipelines;
+		for (unsigned t = 0; t < threadCount; t++) {
+			scans.push_back(new MorselScan(*rm, "largeleft", morsels));
+			pipelines.push_back(new Filter(scans.back(), cond));
+		}
+
+		Aggregate *agg = new Aggregate(pipelines, aggAttr, ops[i]);
+		rc = checkAggregate(agg, expected[i]);
+
+		delete agg;
+		for (unsigned t = 0; t < threadCount; t++) {
+			delete pipelines[t];
+			delete scans[t];
+		}
+	}
+	if (rc != success)
+		return rc;
+
+	// MorselScans over one dispenser return every tuple exactly once between them
+	MorselDispenser morsels(*rm, "largeleft", 3);
+	vector<MorselScan *> scans;
+	for (unsigned t = 0; t < 3; t++)
+		scans.push_back(new MorselScan(*rm, "largeleft", morsels));
+	vector<bool> seen(largeTupleCount, false);
+	int actualResultCnt = 0;
+	char data[bufSize];
+	bool more = true;
+	while (more && rc == success) {
+		more = false;
+		for (unsigned t = 0; t < scans.size(); t++) {
+			if (scans[t]->getNextTuple(data) != success)
+				continue;
+			more = true;
+			int valueA = *(int *)(data + 1);
+			if (valueA < 0 || valueA >= largeTupleCount || seen[valueA]) {
+				cerr << "***** A returned value is not correct. *****" << endl;
+				rc = fail;
+				break;
+			}
+			seen[valueA] = true;
+			actualResultCnt++;
+		}
+	}
+	if (rc == success && actualResultCnt != largeTupleCount) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+
+	for (unsigned t = 0; t < scans.size(); t++)
+		delete scans[t];
+	return rc;
+}
+
+
+int main() {
+	// Tables created: largeleft
+	// Indexes created: none
+
+	if (createLargeLeftTable() != success) {
+		cerr << "***** createLargeLeftTable() failed. *****" << endl;
+		cerr << "***** [FAIL] QE Test Case 12 failed. *****" << endl;
+		return fail;
+	}
+
+	if (populateLargeLeftTable() != success) {
+		cerr << "***** populateLargeLeftTable() failed. *****" << endl;
+		cerr << "***** [FAIL] QE Test Case 12 failed. *****" << endl;
+		return fail;
+	}
+
+	if (testCase_12() != success) {
+		cerr << "***** [FAIL] QE Test Case 12 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 12 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
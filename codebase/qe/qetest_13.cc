@@ -0,0 +1,211 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+// Drain exchange and check that it returns the tuples whose A is in [0, count), each once.
+// left and largeleft both have A as their first attribute and no NULLs.
+RC checkExchange(Exchange *exchange, int count) {
+	vector<bool> seen(count, false);
+	int actualResultCnt = 0;
+	char data[bufSize];
+	RC rc;
+	while ((rc = exchange->getNextTuple(data)) == success) {
+		int valueA = *(int *)(data + 1);
+		if (*(unsigned char *)data != 0 || valueA < 0 || valueA >= count || seen[valueA]) {
+			cerr << "***** A returned value is not correct. *****" << endl;
+			return fail;
+		}
+		seen[valueA] = true;
+		actualResultCnt++;
+	}
+	if (rc != QE_EOF || actualResultCnt != count) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		return fail;
+	}
+	return success;
+}
+
+// An index scan of a key range that only sets its iterator on the first tuple asked for, so on
+// the thread of the Exchange producer running it
+class KeyRangeScan : public Iterator {
+public:
+	KeyRangeScan(IndexScan *scan, int *low, int *high) : scan(scan), low(low), high(high), started(false) {};
+	RC getNextTuple(void *data) {
+		if (!started) {
+			scan->setIterator(low, high, true, false);
+			started = true;
+		}
+		return scan->getNextTuple(data);
+	};
+	void getAttributes(vector<Attribute> &attrs) const {
+		scan->getAttributes(attrs);
+	};
+
+	IndexScan *scan;
+	int *low;
+	int *high;
+	bool started;
+};
+
+RC testCase_13() {
+	// Exchange over page, key and hash partitions, and over producers that each descend into
+	// the same index on their own thread
+	cerr << endl << "***** In QE Test Case 13 *****" << endl;
+	RC rc = success;
+
+	// 1. Page ranges: morsel scans of largeleft, with queues of a single batch so that the
+	// producers keep running into the consumer
+	{
+		MorselDispenser morsels(*rm, "largeleft");
+		vector<MorselScan *> scans;
+		vector<Iterator *> producers;
+		for (unsigned t = 0; t < 4; t++) {
+			scans.push_back(new MorselScan(*rm, "largeleft", morsels));
+			producers.push_back(scans.back());
+		}
+		Exchange *exchange = new Exchange(producers, 1);
+		rc = checkExchange(exchange, largeTupleCount);
+		delete exchange;
+		for (unsigned t = 0; t < scans.size(); t++)
+			delete scans[t];
+		if (rc != success)
+			return rc;
+	}
+
+	// 2. Key ranges: index scans of left.B over [10, 40), [40, 70) and [70, +inf)
+	{
+		int bounds[] = {10, 40, 70};
+		vector<IndexScan *> scans;
+		vector<Iterator *> producers;
+		for (unsigned t = 0; t < 3; t++) {
+			scans.push_back(new IndexScan(*rm, "left", "B"));
+			scans.back()->setIterator(&bounds[t], t + 1 < 3 ? &bounds[t + 1] : NULL, true, false);
+			producers.push_back(scans.back());
+		}
+		Exchange *exchange = new Exchange(producers);
+		rc = checkExchange(exchange, tupleCount);
+		delete exchange;
+		for (unsigned t = 0; t < scans.size(); t++)
+			delete scans[t];
+		if (rc != success)
+			return rc;
+	}
+
+	// 3. Hash partitions of left on A
+	{
+		vector<TableScan *> scans;
+		vector<Iterator *> producers;
+		for (unsigned t = 0; t < 3; t++) {
+			scans.push_back(new TableScan(*rm, "left"));
+			producers.push_back(new HashPartition(scans.back(), "left.A", 3, t));
+		}
+		Exchange *exchange = new Exchange(producers);
+		rc = checkExchange(exchange, tupleCount);
+		delete exchange;
+		for (unsigned t = 0; t < scans.size(); t++) {
+			delete producers[t];
+			delete scans[t];
+		}
+		if (rc != success)
+			return rc;
+	}
+
+	// 4. A consumer that stops early must not leave the producers waiting for it
+	{
+		MorselDispenser morsels(*rm, "largeleft");
+		MorselScan *scan1 = new MorselScan(*rm, "largeleft", morsels);
+		MorselScan *scan2 = new MorselScan(*rm, "largeleft", morsels);
+		vector<Iterator *> producers = {scan1, scan2};
+		Exchange *exchange = new Exchange(producers, 1);
+		char data[bufSize];
+		for (int i = 0; i < 10; i++) {
+			if (exchange->getNextTuple(data) != success) {
+				cerr << "***** The number of returned tuple is not correct. *****" << endl;
+				rc = fail;
+				break;
+			}
+		}
+		delete exchange;
+		delete scan1;
+		delete scan2;
+		if (rc != success)
+			return rc;
+	}
+
+	// The producers below descend into one index at once, each through its own IndexScan: an
+	// index on largeleft.B is deep enough that the first descents pin its upper levels
+	if (rm->createIndex("largeleft", "B") != success) {
+		cerr << "***** createIndex() failed. *****" << endl;
+		return fail;
+	}
+
+	// 5. INLJoins of morsel scans of largeleft with largeleft on B, each probing the index
+	// on its producer thread
+	{
+		Condition cond;
+		cond.lhsAttr = "largeleft.B";
+		cond.op = EQ_OP;
+		cond.bRhsIsAttr = true;
+		cond.rhsAttr = "largeleft.B";
+		MorselDispenser morsels(*rm, "largeleft");
+		vector<MorselScan *> scans;
+		vector<IndexScan *> indexScans;
+		vector<Iterator *> producers;
+		for (unsigned t = 0; t < 4; t++) {
+			scans.push_back(new MorselScan(*rm, "largeleft", morsels));
+			indexScans.push_back(new IndexScan(*rm, "largeleft", "B"));
+			producers.push_back(new INLJoin(scans.back(), indexScans.back(), cond));
+		}
+		Exchange *exchange = new Exchange(producers);
+		rc = checkExchange(exchange, largeTupleCount);
+		delete exchange;
+		for (unsigned t = 0; t < scans.size(); t++) {
+			delete producers[t];
+			delete indexScans[t];
+			delete scans[t];
+		}
+	}
+
+	// 6. Key ranges of largeleft.B, each set by its producer on its own thread
+	if (rc == success) {
+		int bounds[] = {10, 12000, 25000, 37000, largeTupleCount + 10};
+		vector<IndexScan *> indexScans;
+		vector<Iterator *> producers;
+		for (unsigned t = 0; t < 4; t++) {
+			indexScans.push_back(new IndexScan(*rm, "largeleft", "B"));
+			producers.push_back(new KeyRangeScan(indexScans.back(), &bounds[t], &bounds[t + 1]));
+		}
+		Exchange *exchange = new Exchange(producers);
+		rc = checkExchange(exchange, largeTupleCount);
+		delete exchange;
+		for (unsigned t = 0; t < producers.size(); t++) {
+			delete producers[t];
+			delete indexScans[t];
+		}
+	}
+
+	if (rm->destroyIndex("largeleft", "B") != success) {
+		cerr << "***** destroyIndex() failed. *****" << endl;
+		return fail;
+	}
+	return rc;
+}
+
+
+int main() {
+	// Tables created: none
+	// Indexes created: largeleft on B, dropped again
+
+	if (testCase_13() != success) {
+		cerr << "***** [FAIL] QE Test Case 13 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 13 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
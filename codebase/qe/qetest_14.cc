@@ -0,0 +1,105 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+RC testCase_14() {
+	// INLJoin where every outer tuple has several matches
+	// SELECT * FROM left, group WHERE left.A = group.B
+	cerr << endl << "***** In QE Test Case 14 *****" << endl;
+	RC rc = success;
+
+	TableScan *leftIn = new TableScan(*rm, "left");
+	IndexScan *rightIn = new IndexScan(*rm, "group", "B");
+
+	Condition cond;
+	cond.lhsAttr = "left.A";
+	cond.op = EQ_OP;
+	cond.bRhsIsAttr = true;
+	cond.rhsAttr = "group.B";
+
+	INLJoin *join = new INLJoin(leftIn, rightIn, cond);
+
+	// left.A 1~5 each match the 20 tuples of group with that B
+	int expectedResultCnt = 100;
+	int actualResultCnt = 0;
+	vector<vector<bool>> seen(6, vector<bool>(tupleCount, false));
+
+	void *data = malloc(bufSize);
+	while (join->getNextTuple(data) != QE_EOF) {
+		// left.A, left.B, left.C, group.A, group.B, group.C; nothing is NULL
+		int leftA = *(int *)((char *)data + 1);
+		int leftB = *(int *)((char *)data + 5);
+		int groupA = *(int *)((char *)data + 13);
+		int groupB = *(int *)((char *)data + 17);
+		float groupC = *(float *)((char *)data + 21);
+		cerr << "left.A " << leftA << "  group.B " << groupB << "  group.C " << groupC << endl;
+
+		int groupIndex = (int)groupC - 50;
+		if (*(unsigned char *)data != 0 || leftA != groupB || leftB != leftA + 10 || groupA != groupB
+			|| leftA < 1 || leftA > 5 || groupIndex < 0 || groupIndex >= tupleCount || seen[leftA][groupIndex]) {
+			cerr << endl << "***** A returned value is not correct. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		seen[leftA][groupIndex] = true;
+		actualResultCnt++;
+	}
+
+	if (expectedResultCnt != actualResultCnt) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+
+	// A join on an attribute the inner side does not have returns nothing
+	{
+		Condition missing = cond;
+		missing.rhsAttr = "group.D";
+		IndexScan *missingIn = new IndexScan(*rm, "group", "B");
+		INLJoin *missingJoin = new INLJoin(leftIn, missingIn, missing);
+		if (missingJoin->getNextTuple(data) != QE_NO_SUCH_ATTR) {
+			cerr << "***** The join on a missing attribute did not fail. *****" << endl;
+			rc = fail;
+		}
+		delete missingJoin;
+		delete missingIn;
+	}
+
+clean_up:
+	delete join;
+	delete leftIn;
+	delete rightIn;
+	free(data);
+	return rc;
+}
+
+
+int main() {
+	// Tables created: group
+	// Indexes created: group.B
+
+	if (createGroupTable() != success) {
+		cerr << "***** createGroupTable() failed. *****" << endl;
+		cerr << "***** [FAIL] QE Test Case 14 failed. *****" << endl;
+		return fail;
+	}
+
+	if (rm->createIndex("group", "B") != success || populateGroupTable() != success) {
+		cerr << "***** populateGroupTable() failed. *****" << endl;
+		cerr << "***** [FAIL] QE Test Case 14 failed. *****" << endl;
+		return fail;
+	}
+
+	if (testCase_14() != success) {
+		cerr << "***** [FAIL] QE Test Case 14 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 14 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
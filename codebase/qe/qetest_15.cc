@@ -0,0 +1,78 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+RC testCase_15() {
+	// IndexScan in heap order (bitmap heap scan)
+	// SELECT * FROM left WHERE 20 <= B < 60
+	cerr << endl << "***** In QE Test Case 15 *****" << endl;
+	RC rc = success;
+
+	int lowVal = 20;
+	int highVal = 60;
+	IndexScan *is = new IndexScan(*rm, "left", "B");
+	is->setHeapOrder(true);
+	is->setIterator(&lowVal, &highVal, true, false);
+
+	int expectedResultCnt = 40;
+	int actualResultCnt = 0;
+	vector<bool> seen(tupleCount, false);
+	RID prevRid;
+	prevRid.pageNum = 0;
+	prevRid.slotNum = 0;
+
+	void *data = malloc(bufSize);
+	while (is->getNextTuple(data) != QE_EOF) {
+		int valueA = *(int *)((char *)data + 1);
+		int valueB = *(int *)((char *)data + 5);
+		float valueC = *(float *)((char *)data + 9);
+		cerr << "left.A " << valueA << "  left.B " << valueB << "  left.C " << valueC << endl;
+
+		if (*(unsigned char *)data != 0 || valueB < lowVal || valueB >= highVal || valueB != valueA + 10
+			|| valueC != valueA + 50 || seen[valueA]) {
+			cerr << endl << "***** A returned value is not correct. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		seen[valueA] = true;
+
+		// Tuples come in the order they are stored
+		if (actualResultCnt > 0 && (is->rid.pageNum < prevRid.pageNum
+				|| (is->rid.pageNum == prevRid.pageNum && is->rid.slotNum <= prevRid.slotNum))) {
+			cerr << endl << "***** The tuples are not in heap order. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		prevRid = is->rid;
+		actualResultCnt++;
+	}
+
+	if (expectedResultCnt != actualResultCnt) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+
+clean_up:
+	delete is;
+	free(data);
+	return rc;
+}
+
+
+int main() {
+	// Tables created: none
+	// Indexes created: none
+
+	if (testCase_15() != success) {
+		cerr << "***** [FAIL] QE Test Case 15 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 15 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
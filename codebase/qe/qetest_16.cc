@@ -0,0 +1,220 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+const int coveredTupleCount = 1000;
+
+// Tuple i of the covered table is (A = i, B = i % 100, C = i / 2.0, D = "name" + i), with C
+// NULL for every seventh tuple
+bool coveredCIsNull(int i) { return i % 7 == 0; }
+
+int prepareCoveredTuple(int i, int b, const string &d, void *buf) {
+	int offset = 1;
+	*(unsigned char *)buf = coveredCIsNull(i) ? 0x20 : 0;
+	memcpy((char *)buf + offset, &i, sizeof(int));
+	offset += sizeof(int);
+	memcpy((char *)buf + offset, &b, sizeof(int));
+	offset += sizeof(int);
+	if (!coveredCIsNull(i)) {
+		float c = i / 2.0;
+		memcpy((char *)buf + offset, &c, sizeof(float));
+		offset += sizeof(float);
+	}
+	int length = d.length();
+	memcpy((char *)buf + offset, &length, sizeof(int));
+	offset += sizeof(int);
+	memcpy((char *)buf + offset, d.c_str(), length);
+	return offset + length;
+}
+
+int createCoveredTable() {
+	vector<Attribute> attrs;
+	Attribute attr;
+	attr.name = "A";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	attr.name = "B";
+	attrs.push_back(attr);
+
+	attr.name = "C";
+	attr.type = TypeReal;
+	attrs.push_back(attr);
+
+	attr.name = "D";
+	attr.type = TypeVarChar;
+	attr.length = 30;
+	attrs.push_back(attr);
+
+	return rm->createTable("covered", attrs);
+}
+
+RC testCase_16() {
+	// Index-only scan with a covering index
+	// SELECT B, C, D FROM covered WHERE 20 <= B < 40
+	cerr << endl << "***** In QE Test Case 16 *****" << endl;
+	RC rc = success;
+
+	rm->deleteTable("covered");
+	if (createCoveredTable() != success) {
+		cerr << "***** createCoveredTable() failed. *****" << endl;
+		return fail;
+	}
+
+	void *buf = malloc(bufSize);
+	void *data = malloc(bufSize);
+	vector<RID> rids(coveredTupleCount);
+	vector<int> bs(coveredTupleCount);
+	vector<string> ds(coveredTupleCount);
+	vector<bool> live(coveredTupleCount, true);
+	vector<bool> seen(coveredTupleCount, false);
+	vector<string> included;
+	vector<string> projection;
+	IndexOnlyScan *ios = NULL;
+	vector<Attribute> attrs;
+	int lowVal = 20;
+	int highVal = 40;
+	int expectedResultCnt = 0;
+	int actualResultCnt = 0;
+
+	for (int i = 0; i < coveredTupleCount; i++) {
+		bs[i] = i % 100;
+		ds[i] = "name" + to_string(i);
+		prepareCoveredTuple(i, bs[i], ds[i], buf);
+		if (rm->insertTuple("covered", buf, rids[i]) != success) {
+			cerr << "***** insertTuple() failed. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+	}
+
+	// An index can only include attributes of the table
+	included.push_back("E");
+	if (rm->createIndex("covered", "B", included) == success) {
+		cerr << "***** An index including an attribute that does not exist was created. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	included.clear();
+	included.push_back("C");
+	included.push_back("D");
+	if (rm->createIndex("covered", "B", included) != success) {
+		cerr << "***** createIndex() failed. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+
+	// The index is kept up to date by inserts, updates and deletes
+	for (int i = coveredTupleCount / 2; i < coveredTupleCount; i += 3) {
+		bs[i] = (i + 50) % 100;
+		ds[i] = "renamed" + to_string(i * 7);
+		prepareCoveredTuple(i, bs[i], ds[i], buf);
+		if (rm->updateTuple("covered", buf, rids[i]) != success) {
+			cerr << "***** updateTuple() failed. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+	}
+	for (int i = 0; i < coveredTupleCount; i += 5) {
+		if (rm->deleteTuple("covered", rids[i]) != success) {
+			cerr << "***** deleteTuple() failed. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		live[i] = false;
+	}
+
+	projection.push_back("covered.B");
+	projection.push_back("covered.D");
+	if (!IndexOnlyScan::covers(*rm, "covered", "B", projection)) {
+		cerr << "***** The index on B does not cover B and D. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	projection.push_back("covered.A");
+	if (IndexOnlyScan::covers(*rm, "covered", "B", projection)) {
+		cerr << "***** The index on B covers A. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+
+	ios = new IndexOnlyScan(*rm, "covered", "B");
+	ios->getAttributes(attrs);
+	if (attrs.size() != 3 || attrs[0].name != "covered.B" || attrs[1].name != "covered.C" || attrs[2].name != "covered.D") {
+		cerr << "***** The attributes of the scan are not correct. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	ios->setIterator(&lowVal, &highVal, true, false);
+	for (int i = 0; i < coveredTupleCount; i++)
+		expectedResultCnt += live[i] && bs[i] >= lowVal && bs[i] < highVal;
+
+	while (ios->getNextTuple(data) != QE_EOF) {
+		// The index has no A, so use the rid to tell the tuples apart
+		int i;
+		for (i = 0; i < coveredTupleCount; i++)
+			if (rids[i].pageNum == ios->rid.pageNum && rids[i].slotNum == ios->rid.slotNum)
+				break;
+		if (i == coveredTupleCount || !live[i] || seen[i]) {
+			cerr << endl << "***** The scan returned a wrong rid. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		seen[i] = true;
+
+		unsigned char nulls = *(unsigned char *)data;
+		int offset = 1;
+		int valueB = *(int *)((char *)data + offset);
+		offset += sizeof(int);
+		bool cIsNull = (nulls & 0x40) != 0;
+		float valueC = 0;
+		if (!cIsNull) {
+			valueC = *(float *)((char *)data + offset);
+			offset += sizeof(float);
+		}
+		int length = *(int *)((char *)data + offset);
+		string valueD((char *)data + offset + sizeof(int), length);
+		cerr << "covered.B " << valueB << "  covered.C " << (cIsNull ? "NULL" : to_string(valueC)) << "  covered.D "
+			 << valueD << endl;
+
+		if (valueB != bs[i] || cIsNull != coveredCIsNull(i) || (!cIsNull && valueC != (float)(i / 2.0))
+				|| valueD != ds[i] || (nulls & 0xA0) != 0) {
+			cerr << endl << "***** A returned value is not correct. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		actualResultCnt++;
+	}
+
+	if (expectedResultCnt != actualResultCnt) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+
+clean_up:
+	delete ios;
+	free(buf);
+	free(data);
+	rm->deleteTable("covered");
+	return rc;
+}
+
+
+int main() {
+	// Tables created: covered, dropped again
+	// Indexes created: covered.B, including C and D
+
+	if (testCase_16() != success) {
+		cerr << "***** [FAIL] QE Test Case 16 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 16 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
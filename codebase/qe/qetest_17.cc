@@ -0,0 +1,342 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+#include "qe_test_util.h"
+
+const int eventCount = 2000;
+
+// Event i of the events table; its amount is NULL when amountIsNull
+typedef struct Event {
+	int tenant;
+	int created;
+	string kind;
+	float amount;
+	bool amountIsNull;
+	bool live;
+} Event;
+
+int prepareEventTuple(int id, const Event &event, void *buf) {
+	int offset = 1;
+	*(unsigned char *)buf = event.amountIsNull ? 0x08 : 0;
+	memcpy((char *)buf + offset, &id, sizeof(int));
+	offset += sizeof(int);
+	memcpy((char *)buf + offset, &event.tenant, sizeof(int));
+	offset += sizeof(int);
+	memcpy((char *)buf + offset, &event.created, sizeof(int));
+	offset += sizeof(int);
+	int length = event.kind.length();
+	memcpy((char *)buf + offset, &length, sizeof(int));
+	offset += sizeof(int);
+	memcpy((char *)buf + offset, event.kind.c_str(), length);
+	offset += length;
+	if (!event.amountIsNull) {
+		memcpy((char *)buf + offset, &event.amount, sizeof(float));
+		offset += sizeof(float);
+	}
+	return offset;
+}
+
+int createEventsTable() {
+	vector<Attribute> attrs;
+	Attribute attr;
+	attr.type = TypeInt;
+	attr.length = 4;
+	attr.name = "id";
+	attrs.push_back(attr);
+	attr.name = "tenant";
+	attrs.push_back(attr);
+	attr.name = "created";
+	attrs.push_back(attr);
+
+	attr.name = "kind";
+	attr.type = TypeVarChar;
+	attr.length = 20;
+	attrs.push_back(attr);
+
+	attr.name = "amount";
+	attr.type = TypeReal;
+	attr.length = 4;
+	attrs.push_back(attr);
+
+	return rm->createTable("events", attrs);
+}
+
+Condition makeCondition(const string &attr, CompOp op, AttrType type, void *value) {
+	Condition condition;
+	condition.lhsAttr = "events." + attr;
+	condition.op = op;
+	condition.bRhsIsAttr = false;
+	condition.rhsValue.type = type;
+	condition.rhsValue.data = value;
+	return condition;
+}
+
+// Scans the index with the conditions, and checks that it returns exactly the live events that
+// match, ordered by the attributes of the index, and that restCount conditions are left over
+int checkIndexScan(const vector<string> &keyNames, const vector<Condition> &conditions, unsigned restCount,
+		function<bool(const Event &)> matches, const vector<Event> &events) {
+	IndexScan *is = new IndexScan(*rm, "events", keyNames);
+	vector<Condition> rest;
+	is->setIterator(conditions, rest);
+
+	void *data = malloc(bufSize);
+	vector<bool> seen(eventCount, false);
+	int count = 0;
+	int expected = 0;
+	int previous = -1;
+	int rc = success;
+	if (rest.size() != restCount) {
+		cerr << "***** " << rest.size() << " conditions were left instead of " << restCount << ". *****" << endl;
+		rc = fail;
+	}
+	while (rc == success && is->getNextTuple(data) != QE_EOF) {
+		int id = *(int *)((char *)data + 1);
+		if (id < 0 || id >= eventCount || !events[id].live || seen[id]) {
+			cerr << "***** The scan returned a wrong tuple. *****" << endl;
+			rc = fail;
+			break;
+		}
+		seen[id] = true;
+		// The tuples the rest of the conditions would filter out come too
+		if (!matches(events[id]) && restCount == 0) {
+			cerr << "***** The scan returned event " << id << ", which does not match. *****" << endl;
+			rc = fail;
+			break;
+		}
+		// In the order of the index
+		if (previous >= 0) {
+			const Event &a = events[previous];
+			const Event &b = events[id];
+			bool ordered;
+			if (keyNames[0] == "tenant")
+				ordered = a.tenant < b.tenant || (a.tenant == b.tenant && a.created <= b.created);
+			else
+				ordered = a.kind < b.kind || (a.kind == b.kind && (a.amountIsNull || (!b.amountIsNull && a.amount <= b.amount)));
+			if (!ordered) {
+				cerr << "***** Event " << id << " came after event " << previous << ". *****" << endl;
+				rc = fail;
+				break;
+			}
+		}
+		previous = id;
+		count += matches(events[id]);
+	}
+	for (int i = 0; i < eventCount; i++)
+		expected += events[i].live && matches(events[i]);
+	cerr << "  " << count << " events match, " << expected << " expected" << endl;
+	if (rc == success && count != expected) {
+		cerr << "***** The number of returned tuple is not correct. *****" << endl;
+		rc = fail;
+	}
+	delete is;
+	free(data);
+	return rc;
+}
+
+int checkScans(const vector<Event> &events) {
+	vector<string> tenantCreated = {"tenant", "created"};
+	vector<string> kindAmount = {"kind", "amount"};
+	int tenant3 = 3, created100 = 100, createdMinus200 = -200, created0 = 0;
+	float amount25 = 2.5;
+	char kindB[20];
+	int length = 5;
+	memcpy(kindB, &length, sizeof(int));
+	memcpy(kindB + sizeof(int), "kindB", length);
+
+	cerr << "tenant = 3 AND 100 <= created" << endl;
+	if (checkIndexScan(tenantCreated,
+			{makeCondition("tenant", EQ_OP, TypeInt, &tenant3), makeCondition("created", GE_OP, TypeInt, &created100)}, 0,
+			[](const Event &e) { return e.tenant == 3 && e.created >= 100; }, events) != success)
+		return fail;
+
+	cerr << "tenant = 3 AND -200 < created < 0 AND amount > 2.5" << endl;
+	if (checkIndexScan(tenantCreated,
+			{makeCondition("created", GT_OP, TypeInt, &createdMinus200), makeCondition("amount", GT_OP, TypeReal, &amount25),
+			 makeCondition("tenant", EQ_OP, TypeInt, &tenant3), makeCondition("created", LT_OP, TypeInt, &created0)}, 1,
+			[](const Event &e) { return e.tenant == 3 && e.created > -200 && e.created < 0; }, events) != success)
+		return fail;
+
+	cerr << "tenant = 3" << endl;
+	if (checkIndexScan(tenantCreated, {makeCondition("tenant", EQ_OP, TypeInt, &tenant3)}, 0,
+			[](const Event &e) { return e.tenant == 3; }, events) != success)
+		return fail;
+
+	cerr << "tenant <= 3" << endl;
+	if (checkIndexScan(tenantCreated, {makeCondition("tenant", LE_OP, TypeInt, &tenant3)}, 0,
+			[](const Event &e) { return e.tenant <= 3; }, events) != success)
+		return fail;
+
+	cerr << "created = 100, which is not a prefix" << endl;
+	if (checkIndexScan(tenantCreated, {makeCondition("created", EQ_OP, TypeInt, &created100)}, 1,
+			[](const Event &e) { return true; }, events) != success)
+		return fail;
+
+	cerr << "kind = kindB AND amount > 2.5" << endl;
+	if (checkIndexScan(kindAmount,
+			{makeCondition("kind", EQ_OP, TypeVarChar, kindB), makeCondition("amount", GT_OP, TypeReal, &amount25)}, 0,
+			[](const Event &e) { return e.kind == "kindB" && !e.amountIsNull && e.amount > 2.5; }, events) != success)
+		return fail;
+
+	cerr << "kind > kindB" << endl;
+	if (checkIndexScan(kindAmount, {makeCondition("kind", GT_OP, TypeVarChar, kindB)}, 0,
+			[](const Event &e) { return e.kind > "kindB"; }, events) != success)
+		return fail;
+	return success;
+}
+
+RC testCase_17() {
+	// Composite indexes, scanned on a prefix of their key
+	// SELECT * FROM events WHERE tenant = 3 AND created >= 100, and others
+	cerr << endl << "***** In QE Test Case 17 *****" << endl;
+	RC rc = success;
+
+	rm->deleteTable("events");
+	if (createEventsTable() != success) {
+		cerr << "***** createEventsTable() failed. *****" << endl;
+		return fail;
+	}
+
+	// Kinds that start one another and have a 0 byte, and negative values, to test the order
+	const string kinds[] = {"kindB", "kind", "kindBB", string("kind\0B", 6), "kindA", "kindC"};
+	void *buf = malloc(bufSize);
+	void *data = malloc(bufSize);
+	vector<RID> rids(eventCount);
+	vector<Event> events(eventCount);
+	vector<string> tenantCreated = {"tenant", "created"};
+	vector<string> included = {"amount"};
+	vector<Attribute> attrs;
+	IndexOnlyScan *ios = NULL;
+	int tenant3 = 3;
+	char lowKey[20];
+	int onlyCount = 0;
+	vector<string> indexes;
+
+	for (int i = 0; i < eventCount; i++) {
+		events[i] = {i % 7, (i * 37) % 1000 - 500, kinds[i % 6], (float)((i * 13) % 20) - 7.5f, i % 11 == 0, true};
+		prepareEventTuple(i, events[i], buf);
+		if (rm->insertTuple("events", buf, rids[i]) != success) {
+			cerr << "***** insertTuple() failed. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+	}
+
+	if (rm->createIndex("events", tenantCreated, included) != success
+			|| rm->createIndex("events", vector<string>{"kind", "amount"}) != success) {
+		cerr << "***** createIndex() failed. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	if (rm->createIndex("events", vector<string>{"tenant", "updated"}) == success) {
+		cerr << "***** An index on an attribute that does not exist was created. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	rm->getIndexes("events", indexes);
+	if (indexes.size() != 2 || indexes[0] != "tenant,created" || indexes[1] != "kind,amount") {
+		cerr << "***** The indexes of the table are not correct. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	rc = checkScans(events);
+	if (rc != success)
+		goto clean_up;
+
+	// The indexes are kept up to date by updates and deletes
+	for (int i = 0; i < eventCount; i += 3) {
+		events[i].tenant = (events[i].tenant + 1) % 7;
+		events[i].created = -events[i].created;
+		events[i].amount = -events[i].amount;
+		events[i].amountIsNull = i % 33 == 0;
+		prepareEventTuple(i, events[i], buf);
+		if (rm->updateTuple("events", buf, rids[i]) != success) {
+			cerr << "***** updateTuple() failed. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+	}
+	for (int i = 0; i < eventCount; i += 4) {
+		if (rm->deleteTuple("events", rids[i]) != success) {
+			cerr << "***** deleteTuple() failed. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		events[i].live = false;
+	}
+	cerr << "After updates and deletes" << endl;
+	rc = checkScans(events);
+	if (rc != success)
+		goto clean_up;
+
+	// The index on tenant and created includes amount, so it answers for all three
+	if (!IndexOnlyScan::covers(*rm, "events", "tenant,created", vector<string>{"events.amount", "events.created"})) {
+		cerr << "***** The index on tenant and created does not cover amount. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	ios = new IndexOnlyScan(*rm, "events", "tenant,created");
+	ios->getAttributes(attrs);
+	if (attrs.size() != 3 || attrs[0].name != "events.tenant" || attrs[1].name != "events.created"
+			|| attrs[2].name != "events.amount") {
+		cerr << "***** The attributes of the index-only scan are not correct. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	lowKey[0] = 0;
+	memcpy(lowKey + 1, &tenant3, sizeof(int));
+	ios->setIterator(lowKey, 1, lowKey, 1, true, true);
+	while (ios->getNextTuple(data) != QE_EOF) {
+		int i;
+		for (i = 0; i < eventCount; i++)
+			if (rids[i].pageNum == ios->rid.pageNum && rids[i].slotNum == ios->rid.slotNum)
+				break;
+		unsigned char nulls = *(unsigned char *)data;
+		bool amountIsNull = (nulls & 0x20) != 0;
+		if (i == eventCount || !events[i].live || (nulls & 0xC0) != 0 || *(int *)((char *)data + 1) != events[i].tenant
+				|| *(int *)((char *)data + 5) != events[i].created || amountIsNull != events[i].amountIsNull
+				|| (!amountIsNull && *(float *)((char *)data + 9) != events[i].amount)) {
+			cerr << "***** The index-only scan returned a wrong tuple. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		onlyCount++;
+	}
+	for (int i = 0; i < eventCount; i++)
+		onlyCount -= events[i].live && events[i].tenant == 3;
+	if (onlyCount != 0) {
+		cerr << "***** The index-only scan did not return every tuple of tenant 3. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+
+	if (rm->destroyIndex("events", tenantCreated) != success) {
+		cerr << "***** destroyIndex() failed. *****" << endl;
+		rc = fail;
+	}
+
+clean_up:
+	delete ios;
+	free(buf);
+	free(data);
+	rm->deleteTable("events");
+	return rc;
+}
+
+
+int main() {
+	// Tables created: events, dropped again
+	// Indexes created: events on (tenant, created) including amount, on (kind, amount)
+
+	if (testCase_17() != success) {
+		cerr << "***** [FAIL] QE Test Case 17 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 17 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
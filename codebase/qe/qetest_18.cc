@@ -0,0 +1,268 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+const int scoreCount = 3000;
+
+// Score i: its score repeats every 1000 ids, in a scattered order; its bonus is NULL every 7th
+int scoreOf(int id) {
+	return (id * 7919) % 1000;
+}
+
+float bonusOf(int id) {
+	return (float)((id * 104729) % 5000) / 4;
+}
+
+bool bonusIsNull(int id) {
+	return id % 7 == 0;
+}
+
+int createScoresTable() {
+	vector<Attribute> attrs;
+	Attribute attr;
+	attr.type = TypeInt;
+	attr.length = 4;
+	attr.name = "id";
+	attrs.push_back(attr);
+	attr.name = "score";
+	attrs.push_back(attr);
+	attr.name = "bonus";
+	attr.type = TypeReal;
+	attrs.push_back(attr);
+	return rm->createTable("scores", attrs);
+}
+
+int populateScoresTable() {
+	void *buf = malloc(bufSize);
+	RID rid;
+	for (int id = 0; id < scoreCount; id++) {
+		int score = scoreOf(id);
+		float bonus = bonusOf(id);
+		*(unsigned char *)buf = bonusIsNull(id) ? 0x20 : 0;
+		memcpy((char *)buf + 1, &id, sizeof(int));
+		memcpy((char *)buf + 5, &score, sizeof(int));
+		memcpy((char *)buf + 9, &bonus, sizeof(float));
+		if (rm->insertTuple("scores", buf, rid) != success) {
+			free(buf);
+			return fail;
+		}
+	}
+	free(buf);
+	return success;
+}
+
+// Passes on the tuples of its input, counting them
+class CountingIterator : public Iterator {
+public:
+	CountingIterator(Iterator *input) : input(input), pulled(0) {};
+	RC getNextTuple(void *data) {
+		RC rc = input->getNextTuple(data);
+		pulled += rc == success;
+		return rc;
+	};
+	void getAttributes(vector<Attribute> &attrs) const {
+		input->getAttributes(attrs);
+	};
+
+	Iterator *input;
+	int pulled;
+};
+
+// The ids of the tuples of it
+vector<int> collectIds(Iterator *it) {
+	vector<int> ids;
+	char data[bufSize];
+	while (it->getNextTuple(data) != QE_EOF)
+		ids.push_back(*(int *)(data + 1));
+	return ids;
+}
+
+// Whether ids are those of the n first scores, by score, or by bonus when byBonus, in the order
+// given
+bool checkTop(const vector<int> &ids, unsigned n, bool byBonus, bool descending) {
+	vector<pair<float, int>> expected;
+	for (int id = 0; id < scoreCount; id++) {
+		if (byBonus && bonusIsNull(id))
+			continue;
+		expected.push_back(make_pair(byBonus ? bonusOf(id) : (float)scoreOf(id), id));
+	}
+	sort(expected.begin(), expected.end());
+	if (descending)
+		reverse(expected.begin(), expected.end());
+	if (ids.size() != min((size_t)n, expected.size())) {
+		cerr << "***** " << ids.size() << " tuples instead of " << n << ". *****" << endl;
+		return false;
+	}
+	// Ties may come in any order, so only the values are compared
+	for (unsigned i = 0; i < ids.size(); i++) {
+		float value = byBonus ? bonusOf(ids[i]) : (float)scoreOf(ids[i]);
+		if (value != expected[i].first || (byBonus && bonusIsNull(ids[i]))) {
+			cerr << "***** Tuple " << i << " has value " << value << " instead of " << expected[i].first << ". *****" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int testCase_18() {
+	// Limit and TopN: a Limit stops pulling from its input once it has its tuples; a TopN
+	// keeps only the best tuples of its input, or over an index scanned in its order just takes
+	// the first ones. Descending index scans give the greatest keys first.
+	//
+	// Functions Tested
+	// 1. Limit, with and without an offset **
+	// 2. TopN over a table scan, ascending and descending **
+	// 3. Descending IndexScan **
+	// 4. TopN over an IndexScan in the order it wants **
+	cerr << endl << "***** In QE Test Case 18 *****" << endl;
+
+	RC rc = success;
+	TableScan *ts = NULL;
+	IndexScan *is = NULL;
+	CountingIterator *counted = NULL;
+	Limit *limit = NULL;
+	TopN *topN = NULL;
+	vector<int> all;
+	vector<int> ids;
+	char data[bufSize];
+	int previous;
+
+	if (createScoresTable() != success || populateScoresTable() != success
+			|| rm->createIndex("scores", "score") != success) {
+		cerr << "***** Creating the scores table failed. *****" << endl;
+		return fail;
+	}
+
+	// Limit: tuples 10 to 34 of the table scan, having pulled no more than those
+	ts = new TableScan(*rm, "scores");
+	all = collectIds(ts);
+	delete ts;
+	ts = new TableScan(*rm, "scores");
+	counted = new CountingIterator(ts);
+	limit = new Limit(counted, 25, 10);
+	ids = collectIds(limit);
+	if (ids != vector<int>(all.begin() + 10, all.begin() + 35) || counted->pulled != 35) {
+		cerr << "***** The limit returned " << ids.size() << " tuples, having pulled " << counted->pulled << ". *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	delete limit;
+	delete counted;
+	delete ts;
+	limit = NULL;
+	counted = NULL;
+	ts = new TableScan(*rm, "scores");
+	limit = new Limit(ts, scoreCount, scoreCount - 5);
+	if (collectIds(limit).size() != 5) {
+		cerr << "***** The limit past the end of its input returned the wrong tuples. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	delete limit;
+	delete ts;
+	limit = NULL;
+	ts = NULL;
+
+	// TopN with a heap, over a table scan
+	ts = new TableScan(*rm, "scores");
+	topN = new TopN(ts, "scores.score", 20);
+	if (topN->usesIndexOrder() || !checkTop(collectIds(topN), 20, false, false)) {
+		rc = fail;
+		goto clean_up;
+	}
+	delete topN;
+	delete ts;
+	ts = new TableScan(*rm, "scores");
+	topN = new TopN(ts, "scores.bonus", 15, true);
+	if (!checkTop(collectIds(topN), 15, true, true)) {
+		rc = fail;
+		goto clean_up;
+	}
+	delete topN;
+	delete ts;
+	topN = NULL;
+	ts = NULL;
+
+	// A descending index scan gives every tuple, greatest score first
+	is = new IndexScan(*rm, "scores", "score");
+	is->setDescending(true);
+	ids.clear();
+	previous = 1000;
+	while (is->getNextTuple(data) != QE_EOF) {
+		int score = *(int *)(data + 5);
+		if (score > previous) {
+			cerr << "***** Score " << score << " came after " << previous << ". *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		previous = score;
+		ids.push_back(*(int *)(data + 1));
+	}
+	if (ids.size() != (size_t)scoreCount) {
+		cerr << "***** The descending index scan returned " << ids.size() << " tuples. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+
+	// TopN over the index scanned in its order takes the first tuples of the scan
+	is->setDescending(true);
+	topN = new TopN(is, "scores.score", 12, true);
+	if (!topN->usesIndexOrder() || !checkTop(collectIds(topN), 12, false, true)) {
+		cerr << "***** The top 12 scores from the index are not correct. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	delete topN;
+	topN = NULL;
+
+	// The index scanned the other way needs the heap; a key range of it scanned its way does not
+	is->setDescending(false);
+	topN = new TopN(is, "scores.score", 30, true);
+	if (topN->usesIndexOrder() || !checkTop(collectIds(topN), 30, false, true)) {
+		cerr << "***** The top 30 scores over an ascending scan are not correct. *****" << endl;
+		rc = fail;
+		goto clean_up;
+	}
+	delete topN;
+	topN = NULL;
+	{
+		int low = 100;
+		int high = 200;
+		is->setIterator(&low, &high, true, false);
+		topN = new TopN(is, "scores.score", 7);
+		ids = collectIds(topN);
+		if (!topN->usesIndexOrder() || ids.size() != 7 || scoreOf(ids[0]) != 100 || scoreOf(ids[6]) != 102) {
+			cerr << "***** The least 7 scores from 100 are not correct. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+	}
+
+clean_up:
+	delete topN;
+	delete limit;
+	delete counted;
+	delete ts;
+	delete is;
+	rm->deleteTable("scores");
+	return rc;
+}
+
+int main() {
+	// Tables created: scores, dropped again
+	// Indexes created: scores on score
+
+	if (testCase_18() != success) {
+		cerr << "***** [FAIL] QE Test Case 18 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 18 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
@@ -0,0 +1,289 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "qe_test_util.h"
+
+const int documentCount = 60;
+const int maxBodyLength = 16000;
+
+// Document i: its body is longer than a page for most i, so it is kept on overflow pages
+int bodyLengthOf(int id) {
+	return (id * 997) % 12000 + 100;
+}
+
+char bodyCharOf(int id, int i) {
+	return 'a' + (id + i) % 26;
+}
+
+string titleOf(int id) {
+	return "doc" + to_string(id);
+}
+
+vector<Attribute> documentAttrs() {
+	vector<Attribute> attrs;
+	Attribute attr;
+	attr.name = "id";
+	attr.type = TypeInt;
+	attr.length = 4;
+	attrs.push_back(attr);
+	attr.name = "title";
+	attr.type = TypeVarChar;
+	attr.length = 50;
+	attrs.push_back(attr);
+	attr.name = "body";
+	attr.type = TypeVarChar;
+	attr.length = maxBodyLength;
+	attrs.push_back(attr);
+	return attrs;
+}
+
+int createDocumentsTable() {
+	vector<Attribute> attrs = documentAttrs();
+	if (rm->createTable("documents", attrs) != success || rm->createIndex("documents", "id") != success)
+		return fail;
+
+	vector<char> buf(RecordBasedFileManager::getMaxDataSize(attrs));
+	RID rid;
+	for (int id = 0; id < documentCount; id++) {
+		char *tuple = buf.data();
+		int offset = 1;
+		tuple[0] = 0;
+		memcpy(tuple + offset, &id, sizeof(int));
+		offset += sizeof(int);
+		string title = titleOf(id);
+		int length = title.size();
+		memcpy(tuple + offset, &length, sizeof(int));
+		memcpy(tuple + offset + sizeof(int), title.data(), length);
+		offset += sizeof(int) + length;
+		length = bodyLengthOf(id);
+		memcpy(tuple + offset, &length, sizeof(int));
+		for (int i = 0; i < length; i++)
+			tuple[offset + sizeof(int) + i] = bodyCharOf(id, i);
+		if (rm->insertTuple("documents", tuple, rid) != success)
+			return fail;
+	}
+	return success;
+}
+
+// Reads the fields of a document from field, which it moves past them, checking that the title,
+// if withTitle, and the body are those of its id
+bool readDocument(const char *&field, bool withTitle, int &id) {
+	memcpy(&id, field, sizeof(int));
+	field += sizeof(int);
+	if (id < 0 || id >= documentCount)
+		return false;
+	int length;
+	if (withTitle) {
+		memcpy(&length, field, sizeof(int));
+		if (string(field + sizeof(int), length) != titleOf(id))
+			return false;
+		field += sizeof(int) + length;
+	}
+	memcpy(&length, field, sizeof(int));
+	if (length != bodyLengthOf(id))
+		return false;
+	for (int i = 0; i < length; i++)
+		if (field[sizeof(int) + i] != bodyCharOf(id, i))
+			return false;
+	field += sizeof(int) + length;
+	return true;
+}
+
+// Drains it, checking that it returns each document of ids once, in the order given if ordered
+bool checkDocuments(Iterator *it, const vector<int> &ids, bool withTitle, bool ordered) {
+	vector<char> data(RecordBasedFileManager::getMaxDataSize(documentAttrs()));
+	vector<int> returned;
+	while (it->getNextTuple(data.data()) == success) {
+		const char *field = data.data() + 1;
+		int id;
+		if (data[0] != 0 || !readDocument(field, withTitle, id)) {
+			cerr << "***** Document " << id << " is not correct. *****" << endl;
+			return false;
+		}
+		returned.push_back(id);
+	}
+	if (!ordered)
+		sort(returned.begin(), returned.end());
+	if (returned != ids) {
+		cerr << "***** " << returned.size() << " documents were returned instead of " << ids.size() << ". *****" << endl;
+		return false;
+	}
+	return true;
+}
+
+int testCase_19() {
+	// Tuples larger than a page: the operators size their buffers from the schema, so documents
+	// whose bodies are kept on overflow pages pass through scans, joins and the rest intact.
+	//
+	// Functions Tested
+	// 1. TableScan, Project and Filter over tuples larger than a page **
+	// 2. Aggregate and TopN over tuples larger than a page **
+	// 3. IndexScan in heap order over tuples larger than a page **
+	// 4. INLJoin of tuples larger than a page **
+	// 5. Exchange of tuples larger than a page **
+	cerr << endl << "***** In QE Test Case 19 *****" << endl;
+
+	RC rc = success;
+	vector<int> all;
+	for (int id = 0; id < documentCount; id++)
+		all.push_back(id);
+	vector<char> data(2 * RecordBasedFileManager::getMaxDataSize(documentAttrs()));
+	int bound = documentCount / 2;
+	float max;
+
+	TableScan *ts = new TableScan(*rm, "documents");
+	IndexScan *is = NULL;
+	Iterator *op = NULL;
+	INLJoin *join = NULL;
+	Exchange *exchange = NULL;
+	MorselDispenser *morsels = NULL;
+	vector<Iterator *> scans;
+	int joined = 0;
+
+	if (!checkDocuments(ts, all, true, false)) {
+		rc = fail;
+		goto clean_up;
+	}
+	delete ts;
+
+	// Project the id and the body
+	ts = new TableScan(*rm, "documents");
+	op = new Project(ts, vector<string>{"documents.id", "documents.body"});
+	if (!checkDocuments(op, all, false, false)) {
+		rc = fail;
+		goto clean_up;
+	}
+	delete op;
+	delete ts;
+
+	// Filter on the id
+	{
+		Condition cond;
+		cond.lhsAttr = "documents.id";
+		cond.op = LT_OP;
+		cond.bRhsIsAttr = false;
+		cond.rhsValue.type = TypeInt;
+		cond.rhsValue.data = &bound;
+		ts = new TableScan(*rm, "documents");
+		op = new Filter(ts, cond);
+		if (!checkDocuments(op, vector<int>(all.begin(), all.begin() + bound), true, false)) {
+			rc = fail;
+			goto clean_up;
+		}
+		delete op;
+		delete ts;
+	}
+
+	// The greatest id
+	{
+		Attribute aggAttr;
+		aggAttr.name = "documents.id";
+		aggAttr.type = TypeInt;
+		aggAttr.length = 4;
+		ts = new TableScan(*rm, "documents");
+		op = new Aggregate(ts, aggAttr, MAX);
+		if (op->getNextTuple(data.data()) != success || (memcpy(&max, data.data() + 1, sizeof(float)), max) != documentCount - 1) {
+			cerr << "***** The greatest id is not correct. *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+		delete op;
+		delete ts;
+	}
+
+	// The 5 greatest ids, greatest first
+	ts = new TableScan(*rm, "documents");
+	op = new TopN(ts, "documents.id", 5, true);
+	if (!checkDocuments(op, vector<int>{59, 58, 57, 56, 55}, true, true)) {
+		rc = fail;
+		goto clean_up;
+	}
+	delete op;
+	delete ts;
+	op = NULL;
+
+	// Every document through the index, in the order of the heap
+	is = new IndexScan(*rm, "documents", "id");
+	is->setHeapOrder(true);
+	is->setIterator(NULL, NULL, true, true);
+	if (!checkDocuments(is, all, true, false)) {
+		rc = fail;
+		goto clean_up;
+	}
+	delete is;
+
+	// Each document joined with itself through the index on id
+	{
+		Condition cond;
+		cond.lhsAttr = "documents.id";
+		cond.op = EQ_OP;
+		cond.bRhsIsAttr = true;
+		cond.rhsAttr = "documents.id";
+		ts = new TableScan(*rm, "documents");
+		is = new IndexScan(*rm, "documents", "id");
+		join = new INLJoin(ts, is, cond);
+		while (join->getNextTuple(data.data()) == success) {
+			const char *field = data.data() + 1;
+			int leftId;
+			int rightId;
+			if (data[0] != 0 || !readDocument(field, true, leftId) || !readDocument(field, true, rightId)
+					|| leftId != rightId) {
+				cerr << "***** A joined document is not correct. *****" << endl;
+				rc = fail;
+				goto clean_up;
+			}
+			joined++;
+		}
+		if (joined != documentCount) {
+			cerr << "***** " << joined << " documents were joined instead of " << documentCount << ". *****" << endl;
+			rc = fail;
+			goto clean_up;
+		}
+	}
+
+	// Gathered from morsel scans on two threads
+	morsels = new MorselDispenser(*rm, "documents", 1);
+	scans.push_back(new MorselScan(*rm, "documents", *morsels));
+	scans.push_back(new MorselScan(*rm, "documents", *morsels));
+	exchange = new Exchange(scans, 1);
+	if (!checkDocuments(exchange, all, true, false))
+		rc = fail;
+
+clean_up:
+	delete exchange;
+	for (Iterator *scan : scans)
+		delete scan;
+	delete morsels;
+	delete join;
+	delete op;
+	delete is;
+	delete ts;
+	return rc;
+}
+
+int main() {
+	// Tables created: documents, dropped again
+	// Indexes created: documents on id
+
+	rm->deleteTable("documents");
+	if (createDocumentsTable() != success) {
+		cerr << "***** Creating the documents table failed. *****" << endl;
+		cerr << "***** [FAIL] QE Test Case 19 failed. *****" << endl;
+		return fail;
+	}
+
+	RC rc = testCase_19();
+	rm->deleteTable("documents");
+	if (rc != success) {
+		cerr << "***** [FAIL] QE Test Case 19 failed. *****" << endl;
+		return fail;
+	} else {
+		cerr << "***** QE Test Case 19 finished. The result will be examined. *****" << endl;
+		return success;
+	}
+}
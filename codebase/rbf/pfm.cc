@@ -1,4 +1,6 @@
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
 #include <sys/stat.h>
@@ -8,6 +10,136 @@
 
 PagedFileManager* PagedFileManager::_pf_manager = NULL;
 
+// Page compression: a byte-oriented LZ77 coder in the style of LZ4. The image is a sequence of
+// a token (literal count in the high 4 bits, match length - LZ_MIN_MATCH in the low 4), any
+// further count bytes for a field of 15 (255 meaning more follow), the literals, then the match
+// as a 2 byte offset back and further length bytes. The last sequence has literals only.
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+
+// Writes a count that did not fit in its token nibble; false if out is full
+static bool putCount(unsigned count, char *out, unsigned &op, unsigned outCapacity)
+{
+    for (; count >= 255; count -= 255)
+    {
+        if (op >= outCapacity)
+            return false;
+        out[op++] = (char)255;
+    }
+    if (op >= outCapacity)
+        return false;
+    out[op++] = (char)count;
+    return true;
+}
+
+static bool putSequence(const char *literals, unsigned literalCount, unsigned offset, unsigned matchLength,
+                        char *out, unsigned &op, unsigned outCapacity)
+{
+    unsigned matchCount = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+    if (op >= outCapacity)
+        return false;
+    out[op++] = (char)((min(literalCount, 15u) << 4) | min(matchCount, 15u));
+    if (literalCount >= 15 && !putCount(literalCount - 15, out, op, outCapacity))
+        return false;
+    if (op + literalCount > outCapacity)
+        return false;
+    memcpy(out + op, literals, literalCount);
+    op += literalCount;
+    if (matchLength == 0)
+        return true;
+    if (op + 2 > outCapacity)
+        return false;
+    out[op++] = (char)(offset & 0xff);
+    out[op++] = (char)(offset >> 8);
+    return matchCount < 15 || putCount(matchCount - 15, out, op, outCapacity);
+}
+
+// Returns the length of the image, or 0 if it would not fit in outCapacity bytes
+static unsigned compressPage(const char *in, unsigned size, char *out, unsigned outCapacity)
+{
+    int table[1 << LZ_HASH_BITS];
+    memset(table, -1, sizeof(table));
+    unsigned ip = 0, anchor = 0, op = 0;
+    while (ip + LZ_MIN_MATCH <= size)
+    {
+        uint32_t sequence;
+        memcpy(&sequence, in + ip, sizeof(uint32_t));
+        unsigned hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        int ref = table[hash];
+        table[hash] = ip;
+        if (ref < 0 || memcmp(in + ref, in + ip, LZ_MIN_MATCH) != 0)
+        {
+            ip++;
+            continue;
+        }
+
+        unsigned matchLength = LZ_MIN_MATCH;
+        while (ip + matchLength < size && in[ref + matchLength] == in[ip + matchLength])
+            matchLength++;
+        if (!putSequence(in + anchor, ip - anchor, ip - ref, matchLength, out, op, outCapacity))
+            return 0;
+        ip += matchLength;
+        anchor = ip;
+    }
+    if (!putSequence(in + anchor, size - anchor, 0, 0, out, op, outCapacity))
+        return 0;
+    return op;
+}
+
+// Reads a count continued past its token nibble; false if the image ends first
+static bool getCount(const unsigned char *in, unsigned size, unsigned &ip, unsigned &count)
+{
+    unsigned char byte;
+    do
+    {
+        if (ip >= size)
+            return false;
+        byte = in[ip++];
+        count += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Returns the number of bytes decompressed, or -1 if the image is corrupt
+static int decompressPage(const char *image, unsigned size, char *out, unsigned outSize)
+{
+    const unsigned char *in = (const unsigned char *)image;
+    unsigned ip = 0, op = 0;
+    while (ip < size)
+    {
+        unsigned token = in[ip++];
+        unsigned literalCount = token >> 4;
+        if (literalCount == 15 && !getCount(in, size, ip, literalCount))
+            return -1;
+        if (ip + literalCount > size || op + literalCount > outSize)
+            return -1;
+        memcpy(out + op, in + ip, literalCount);
+        ip += literalCount;
+        op += literalCount;
+        if (ip == size)
+            break;
+
+        if (ip + 2 > size)
+            return -1;
+        unsigned offset = in[ip] | (in[ip + 1] << 8);
+        ip += 2;
+        unsigned matchLength = token & 15;
+        if (matchLength == 15 && !getCount(in, size, ip, matchLength))
+            return -1;
+        matchLength += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || op + matchLength > outSize)
+            return -1;
+        // The match may overlap the bytes it produces
+        if (offset >= matchLength)
+            memcpy(out + op, out + op - offset, matchLength);
+        else
+            for (unsigned i = 0; i < matchLength; i++)
+                out[op + i] = out[op + i - offset];
+        op += matchLength;
+    }
+    return op;
+}
+
 PagedFileManager* PagedFileManager::instance()
 {
     if(!_pf_manager)
@@ -27,8 +159,11 @@ PagedFileManager::~PagedFileManager()
 }
 
 
-RC PagedFileManager::createFile(const string &fileName)
+RC PagedFileManager::createFile(const string &fileName, bool compressed, unsigned pageSize)
 {
+    if (pageSize < MIN_PAGE_SIZE || pageSize > MAX_PAGE_SIZE || (pageSize & (pageSize - 1)) != 0)
+        return PFM_BAD_PAGE_SIZE;
+
     // If the file already exists, error
     if (fileExists(fileName))
         return PFM_FILE_EXISTS;
@@ -39,6 +174,24 @@ RC PagedFileManager::createFile(const string &fileName)
     if (pFile == NULL)
         return PFM_OPEN_FAILED;
 
+    // The file starts out with just its header page
+    char *headerPage = (char *)calloc(pageSize, 1);
+    FileHeader header;
+    memcpy(header.magic, PFM_FILE_MAGIC, sizeof(header.magic));
+    header.pageSize = pageSize;
+    header.flags = compressed ? PFM_FILE_COMPRESSED : 0;
+    header.numPages = 0;
+    header.numMapBlocks = 0;
+    memcpy(headerPage, &header, sizeof(header));
+    bool written = fwrite(headerPage, 1, pageSize, pFile) == pageSize;
+    free(headerPage);
+    if (!written)
+    {
+        fclose(pFile);
+        remove(fileName.c_str());
+        return PFM_OPEN_FAILED;
+    }
+
     fclose (pFile);
     return SUCCESS;
 }
@@ -71,7 +224,18 @@ RC PagedFileManager::openFile(const string &fileName, FileHandle &fileHandle)
     if (pFile == NULL)
         return PFM_OPEN_FAILED;
 
+    // A file without the magic of the header page is in the old format
+    FileHeader header;
+    if (fread(&header, 1, sizeof(header), pFile) != sizeof(header)
+        || memcmp(header.magic, PFM_FILE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        fclose(pFile);
+        return PFM_OLD_FORMAT;
+    }
+
     fileHandle.setfd(pFile);
+    fileHandle.pageSize = header.pageSize;
+    fileHandle.compressed = header.flags & PFM_FILE_COMPRESSED;
 
     return SUCCESS;
 }
@@ -89,10 +253,58 @@ RC PagedFileManager::closeFile(FileHandle &fileHandle)
     fclose(pFile);
 
     fileHandle.setfd(NULL);
+    fileHandle.compressed = false;
+    fileHandle.pageSize = PAGE_SIZE;
 
     return SUCCESS;
 }
 
+RC PagedFileManager::compressFile(const string &fileName)
+{
+    FileHandle source;
+    RC rc = openFile(fileName, source);
+    if (rc)
+        return rc;
+    if (source.isCompressed())
+        return closeFile(source);
+    if (source.getNumberOfPages() > PFM_MAX_COMPRESSED_PAGES(source.getPageSize()))
+    {
+        closeFile(source);
+        return PFM_FILE_TOO_LARGE;
+    }
+
+    // Copy every page into a compressed file, which then takes the place of the original
+    string compressedFileName = fileName + ".compressing";
+    remove(compressedFileName.c_str());
+    FileHandle target;
+    rc = createFile(compressedFileName, true, source.getPageSize());
+    if (rc == SUCCESS)
+        rc = openFile(compressedFileName, target);
+    if (rc)
+    {
+        closeFile(source);
+        return PFM_COMPRESS_FAILED;
+    }
+
+    char *page = (char *)malloc(source.getPageSize());
+    unsigned numPages = source.getNumberOfPages();
+    for (PageNum pageNum = 0; pageNum < numPages && rc == SUCCESS; pageNum++)
+    {
+        rc = source.readPage(pageNum, page);
+        if (rc == SUCCESS)
+            rc = target.appendPage(page);
+    }
+    free(page);
+    closeFile(source);
+    closeFile(target);
+    if (rc || rename(compressedFileName.c_str(), fileName.c_str()) != 0)
+    {
+        remove(compressedFileName.c_str());
+        return PFM_COMPRESS_FAILED;
+    }
+    return SUCCESS;
+}
+
 // Check if a file already exists
 bool PagedFileManager::fileExists(const string &fileName)
 {
@@ -109,6 +321,8 @@ FileHandle::FileHandle()
     appendPageCounter = 0;
 
     _fd = NULL;
+    compressed = false;
+    pageSize = PAGE_SIZE;
 }
 
 
@@ -121,16 +335,18 @@ RC FileHandle::readPage(PageNum pageNum, void *data)
 {
     if (_fd == NULL)
         return -1;
+    if (compressed)
+        return readCompressedPage(pageNum, data);
     // If pageNum doesn't exist, error
     if (getNumberOfPages() < pageNum)
         return FH_PAGE_DN_EXIST;
 
-    // Try to seek to the specified page
-    if (fseek(_fd, PAGE_SIZE * pageNum, SEEK_SET))
+    // Try to seek to the specified page, which is after the header page
+    if (fseek(_fd, (uint64_t)pageSize * (pageNum + 1), SEEK_SET))
         return FH_SEEK_FAILED;
 
     // Try to read the specified page
-    if (fread(data, 1, PAGE_SIZE, _fd) != PAGE_SIZE)
+    if (fread(data, 1, pageSize, _fd) != pageSize)
         return FH_READ_FAILED;
 
     readPageCounter++;
@@ -142,16 +358,18 @@ RC FileHandle::writePage(PageNum pageNum, const void *data)
 {
     if (_fd == NULL)
         return -1;
+    if (compressed)
+        return writeCompressedPage(pageNum, data);
     // Check if the page exists
     if (getNumberOfPages() < pageNum)
         return FH_PAGE_DN_EXIST;
 
     // Seek to the start of the page
-    if (fseek(_fd, PAGE_SIZE * pageNum, SEEK_SET))
+    if (fseek(_fd, (uint64_t)pageSize * (pageNum + 1), SEEK_SET))
         return FH_SEEK_FAILED;
 
     // Write the page
-    if (fwrite(data, 1, PAGE_SIZE, _fd) == PAGE_SIZE)
+    if (fwrite(data, 1, pageSize, _fd) == pageSize)
     {
         // Immediately commit changes to disk
         fflush(_fd);
@@ -167,12 +385,14 @@ RC FileHandle::appendPage(const void *data)
 {
     if (_fd == NULL)
         return -1;
+    if (compressed)
+        return appendCompressedPage(data);
     // Seek to the end of the file
     if (fseek(_fd, 0, SEEK_END))
         return FH_SEEK_FAILED;
 
     // Write the new page
-    if (fwrite(data, 1, PAGE_SIZE, _fd) == PAGE_SIZE)
+    if (fwrite(data, 1, pageSize, _fd) == pageSize)
     {
         fflush(_fd);
         appendPageCounter++;
@@ -186,13 +406,20 @@ unsigned FileHandle::getNumberOfPages()
 {
     if (_fd == NULL)
         return 0;
+    if (compressed)
+    {
+        FileHeader header;
+        if (readAt(0, &header, sizeof(header)))
+            return 0;
+        return header.numPages;
+    }
     // Use stat to get the file size
     struct stat sb;
     if (fstat(fileno(_fd), &sb) != 0)
         // On error, return 0
         return 0;
-    // Filesize is always PAGE_SIZE * number of pages
-    return sb.st_size / PAGE_SIZE;
+    // Filesize is always the page size * number of pages, plus the header page
+    return sb.st_size / pageSize - 1;
 }
 
 
@@ -212,4 +439,177 @@ void FileHandle::setfd(FILE *fd)
 FILE *FileHandle::getfd()
 {
     return _fd;
-}
\ No newline at end of file
+}
+
+bool FileHandle::isCompressed() const
+{
+    return compressed;
+}
+
+unsigned FileHandle::getPageSize() const
+{
+    return pageSize;
+}
+
+const void *FileHandle::getFileId() const
+{
+    return _fd;
+}
+
+RC FileHandle::readAt(uint64_t offset, void *data, unsigned size)
+{
+    if (fseek(_fd, offset, SEEK_SET))
+        return FH_SEEK_FAILED;
+    if (fread(data, 1, size, _fd) != size)
+        return FH_READ_FAILED;
+    return SUCCESS;
+}
+
+RC FileHandle::writeAt(uint64_t offset, const void *data, unsigned size)
+{
+    if (fseek(_fd, offset, SEEK_SET))
+        return FH_SEEK_FAILED;
+    if (fwrite(data, 1, size, _fd) != size)
+        return FH_WRITE_FAILED;
+    return SUCCESS;
+}
+
+// Finds the map entry of pageNum, and where in the file it is
+RC FileHandle::getExtent(PageNum pageNum, uint64_t &entryOffset, ExtentMapEntry &entry)
+{
+    FileHeader header;
+    if (readAt(0, &header, sizeof(header)))
+        return FH_READ_FAILED;
+    if (pageNum >= header.numPages)
+        return FH_PAGE_DN_EXIST;
+
+    uint64_t mapBlockOffset;
+    if (readAt(sizeof(header) + (pageNum / PFM_MAP_ENTRIES) * sizeof(uint64_t), &mapBlockOffset, sizeof(uint64_t)))
+        return FH_READ_FAILED;
+    entryOffset = mapBlockOffset + (pageNum % PFM_MAP_ENTRIES) * sizeof(ExtentMapEntry);
+    if (readAt(entryOffset, &entry, sizeof(entry)))
+        return FH_READ_FAILED;
+    return SUCCESS;
+}
+
+// Compresses the page into the extent of the map entry at entryOffset, giving it a new extent at
+// the end of the file if the image has outgrown the one it has
+RC FileHandle::writeExtent(uint64_t entryOffset, ExtentMapEntry &entry, const void *data)
+{
+    char *image = (char *)malloc(pageSize);
+    unsigned length = compressPage((const char *)data, pageSize, image, pageSize - 1);
+    const char *source = image;
+    // Pages that do not compress are stored as they are
+    if (length == 0)
+    {
+        length = pageSize;
+        source = (const char *)data;
+    }
+
+    if (length > entry.capacity)
+    {
+        if (fseek(_fd, 0, SEEK_END))
+        {
+            free(image);
+            return FH_SEEK_FAILED;
+        }
+        entry.offset = ftell(_fd);
+        entry.capacity = min((length + PFM_EXTENT_ALIGN - 1) / PFM_EXTENT_ALIGN * PFM_EXTENT_ALIGN, pageSize);
+    }
+    entry.length = length;
+
+    // The extent is written out in full so that the next one starts after it
+    char *extent = (char *)calloc(entry.capacity, 1);
+    memcpy(extent, source, length);
+    RC rc = SUCCESS;
+    if (writeAt(entry.offset, extent, entry.capacity) || writeAt(entryOffset, &entry, sizeof(entry)))
+        rc = FH_WRITE_FAILED;
+    free(extent);
+    free(image);
+    return rc;
+}
+
+RC FileHandle::readCompressedPage(PageNum pageNum, void *data)
+{
+    uint64_t entryOffset;
+    ExtentMapEntry entry;
+    RC rc = getExtent(pageNum, entryOffset, entry);
+    if (rc)
+        return rc;
+
+    if (entry.length == pageSize)
+    {
+        if (readAt(entry.offset, data, pageSize))
+            return FH_READ_FAILED;
+    }
+    else
+    {
+        if (entry.length > pageSize)
+            return FH_READ_FAILED;
+        char *image = (char *)malloc(entry.length);
+        bool failed = readAt(entry.offset, image, entry.length)
+                      || decompressPage(image, entry.length, (char *)data, pageSize) != (int)pageSize;
+        free(image);
+        if (failed)
+            return FH_READ_FAILED;
+    }
+
+    readPageCounter++;
+    return SUCCESS;
+}
+
+RC FileHandle::writeCompressedPage(PageNum pageNum, const void *data)
+{
+    uint64_t entryOffset;
+    ExtentMapEntry entry;
+    RC rc = getExtent(pageNum, entryOffset, entry);
+    if (rc)
+        return rc;
+    rc = writeExtent(entryOffset, entry, data);
+    if (rc)
+        return rc;
+
+    fflush(_fd);
+    writePageCounter++;
+    return SUCCESS;
+}
+
+RC FileHandle::appendCompressedPage(const void *data)
+{
+    FileHeader header;
+    if (readAt(0, &header, sizeof(header)))
+        return FH_READ_FAILED;
+
+    // The first page of each map block adds the block to the end of the file
+    PageNum pageNum = header.numPages;
+    if (pageNum % PFM_MAP_ENTRIES == 0)
+    {
+        if (pageNum >= PFM_MAX_COMPRESSED_PAGES(pageSize))
+            return FH_FILE_FULL;
+        char mapBlock[PFM_MAP_ENTRIES * sizeof(ExtentMapEntry)];
+        memset(mapBlock, 0, sizeof(mapBlock));
+        if (fseek(_fd, 0, SEEK_END))
+            return FH_SEEK_FAILED;
+        uint64_t mapBlockOffset = ftell(_fd);
+        if (writeAt(mapBlockOffset, mapBlock, sizeof(mapBlock))
+            || writeAt(sizeof(header) + header.numMapBlocks * sizeof(uint64_t), &mapBlockOffset, sizeof(uint64_t)))
+            return FH_WRITE_FAILED;
+        header.numMapBlocks++;
+    }
+    header.numPages++;
+    if (writeAt(0, &header, sizeof(header)))
+        return FH_WRITE_FAILED;
+
+    uint64_t entryOffset;
+    ExtentMapEntry entry;
+    RC rc = getExtent(pageNum, entryOffset, entry);
+    if (rc)
+        return rc;
+    rc = writeExtent(entryOffset, entry, data);
+    if (rc)
+        return rc;
+
+    fflush(_fd);
+    appendPageCounter++;
+    return SUCCESS;
+}
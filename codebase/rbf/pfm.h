@@ -9,21 +9,73 @@
 #define PFM_HANDLE_IN_USE 4
 #define PFM_FILE_DN_EXIST 5
 #define PFM_FILE_NOT_OPEN 6
+#define PFM_COMPRESS_FAILED 7
+#define PFM_BAD_PAGE_SIZE 8
+#define PFM_FILE_TOO_LARGE 9
+#define PFM_OLD_FORMAT    10
 
 #define FH_PAGE_DN_EXIST  1
 #define FH_SEEK_FAILED    2
 #define FH_READ_FAILED    3
 #define FH_WRITE_FAILED   4
+#define FH_FILE_FULL      5
 
 typedef unsigned PageNum;
 typedef int RC;
 typedef char byte;
 
+// The default page size. Each file has its own page size, a power of two from MIN_PAGE_SIZE
+// to MAX_PAGE_SIZE chosen when it is created.
 #define PAGE_SIZE 4096
+#define MIN_PAGE_SIZE 4096
+#define MAX_PAGE_SIZE 65536
 #include <string>
 #include <climits>
+#include <cstdint>
 using namespace std;
 
+// Every file starts with a header page giving its page size and whether it is compressed.
+// Files written before pages had a size of their own have no header and lay out their RBF and
+// index pages differently, so openFile refuses them with PFM_OLD_FORMAT rather than misread them.
+#define PFM_FILE_MAGIC "PFMFILE1"
+#define PFM_FILE_COMPRESSED 0x1
+
+typedef struct FileHeader
+{
+    char magic[8];
+    uint32_t pageSize;
+    uint32_t flags;
+    // Compressed files only
+    uint32_t numPages;
+    uint32_t numMapBlocks;
+    // Followed by the offset of each map block, in compressed files
+} FileHeader;
+
+// Compressed files hold each page as a variable-size extent with its compressed image. The
+// header page gives the number of pages and the offsets of the map blocks, each of which holds
+// the extents of PFM_MAP_ENTRIES consecutive pages. A page rewritten into an image larger than
+// its extent gets a new extent at the end of the file and its old one is left unused, so the
+// mode suits files that are rarely updated. Compression is transparent to the layers above:
+// FileHandle reads and writes uncompressed pages either way.
+//
+// The header page has room for the offsets of (pageSize - sizeof(FileHeader)) / 8 map blocks,
+// so a compressed file holds at most PFM_MAX_COMPRESSED_PAGES pages: 130,304 pages (about
+// 509MB) at 4KB, and proportionally more with larger pages. Appending past that fails with
+// FH_FILE_FULL, and compressFile refuses larger files with PFM_FILE_TOO_LARGE.
+#define PFM_MAP_ENTRIES 256
+#define PFM_MAX_COMPRESSED_PAGES(pageSize) \
+    ((unsigned)(((pageSize) - sizeof(FileHeader)) / sizeof(uint64_t) * PFM_MAP_ENTRIES))
+#define PFM_EXTENT_ALIGN 64
+
+typedef struct ExtentMapEntry
+{
+    uint64_t offset;
+    // Length of the compressed image; the page size if the page is stored uncompressed
+    uint32_t length;
+    // Bytes reserved for the image at offset
+    uint32_t capacity;
+} ExtentMapEntry;
+
 class FileHandle;
 
 class PagedFileManager
@@ -31,11 +83,16 @@ class PagedFileManager
 public:
     static PagedFileManager* instance();                                // Access to the _pf_manager instance
 
-    RC createFile    (const string &fileName);                          // Create a new file
+    RC createFile    (const string &fileName, bool compressed = false,  // Create a new file
+                      unsigned pageSize = PAGE_SIZE);
     RC destroyFile   (const string &fileName);                          // Destroy a file
     RC openFile      (const string &fileName, FileHandle &fileHandle);  // Open a file
     RC closeFile     (FileHandle &fileHandle);                          // Close a file
 
+    // Rewrite an existing file in the compressed mode; a file that already is compressed is left as is,
+    // and one of more than PFM_MAX_COMPRESSED_PAGES pages is refused
+    RC compressFile  (const string &fileName);
+
 protected:
     PagedFileManager();                                                 // Constructor
     ~PagedFileManager();                                                // Destructor
@@ -55,6 +112,7 @@ public:
     unsigned readPageCounter;
     unsigned writePageCounter;
     unsigned appendPageCounter;
+
     
     FileHandle();                                                       // Default constructor
     ~FileHandle();                                                      // Destructor
@@ -63,6 +121,10 @@ public:
     RC writePage(PageNum pageNum, const void *data);                    // Write a specific page
     RC appendPage(const void *data);                                    // Append a specific page
     unsigned getNumberOfPages();                                        // Get the number of pages in the file
+    bool isCompressed() const;
+    unsigned getPageSize() const;
+    // Identifies the open file: copies of a handle share it, and it is NULL while none is open
+    const void *getFileId() const;
     RC collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount);  // Put the current counter values into variables
 
     // Let PagedFileManager access our private helper methods
@@ -70,10 +132,21 @@ public:
 
 private:
     FILE *_fd;
+    bool compressed;
+    unsigned pageSize;
 
     // Private helper methods
     void setfd(FILE *fd);
     FILE *getfd();
+
+    // Compressed files
+    RC readAt(uint64_t offset, void *data, unsigned size);
+    RC writeAt(uint64_t offset, const void *data, unsigned size);
+    RC getExtent(PageNum pageNum, uint64_t &entryOffset, ExtentMapEntry &entry);
+    RC writeExtent(uint64_t entryOffset, ExtentMapEntry &entry, const void *data);
+    RC readCompressedPage(PageNum pageNum, void *data);
+    RC writeCompressedPage(PageNum pageNum, const void *data);
+    RC appendCompressedPage(const void *data);
 }; 
 
 #endif
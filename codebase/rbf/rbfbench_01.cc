@@ -0,0 +1,84 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Selective scans with zone maps: a condition on an attribute that follows the insertion
+// order skips almost every page, the same selectivity on a shuffled attribute skips none.
+// Usage: rbfbench_01 [numRecords] [selectivity in percent]
+
+const char *fileName = "bench01";
+
+double runScan(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+               const string &attrName, int value, long &results, unsigned &pagesRead, unsigned &pagesSkipped)
+{
+    auto start = chrono::steady_clock::now();
+    vector<string> attributeNames;
+    attributeNames.push_back("Age");
+    attributeNames.push_back("Salary");
+
+    RBFM_ScanIterator iter;
+    rbfm->scan(fileHandle, recordDescriptor, attrName, LT_OP, &value, attributeNames, iter);
+    RID rid;
+    char data[PAGE_SIZE];
+    results = 0;
+    while (iter.getNextRecord(rid, data) != RBFM_EOF)
+        results++;
+    iter.getScanStats(pagesRead, pagesSkipped);
+    iter.close();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    int numRecords = argc > 1 ? atoi(argv[1]) : 10000000;
+    double selectivity = argc > 2 ? atof(argv[2]) : 0.1;
+
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    rbfm->destroyFile(fileName);
+    if (rbfm->createFile(fileName) != success) {
+        cout << "Creating the file failed." << endl;
+        return -1;
+    }
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    unsigned char nullsIndicator = 0;
+    int recordSize = 0;
+    char record[100];
+    RID rid;
+
+    cout << "Loading " << numRecords << " records..." << endl;
+    for (int i = 0; i < numRecords; i++) {
+        prepareRecord(recordDescriptor.size(), &nullsIndicator, 8, "Employee", i, (float)i,
+                      (int)(((unsigned)i * 2654435761u) % numRecords), record, &recordSize);
+        if (rbfm->insertRecord(fileHandle, recordDescriptor, record, rid) != success) {
+            cout << "Inserting a record failed." << endl;
+            return -1;
+        }
+    }
+
+    int value = (int)(numRecords * selectivity / 100);
+    long results;
+    unsigned pagesRead, pagesSkipped;
+    double seconds = runScan(rbfm, fileHandle, recordDescriptor, "Age", value, results, pagesRead, pagesSkipped);
+    cout << "Age < " << value << " (sorted): " << seconds * 1000 << " ms, " << results << " results, "
+         << pagesRead << " pages read, " << pagesSkipped << " skipped" << endl;
+    double baseline = runScan(rbfm, fileHandle, recordDescriptor, "Salary", value, results, pagesRead, pagesSkipped);
+    cout << "Salary < " << value << " (shuffled): " << baseline * 1000 << " ms, " << results << " results, "
+         << pagesRead << " pages read, " << pagesSkipped << " skipped" << endl;
+    cout << "Speedup " << baseline / seconds << endl;
+
+    rbfm->closeFile(fileHandle);
+    rbfm->destroyFile(fileName);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Single-column aggregate over a wide table: SUM of one int attribute out of twenty, scanned
+// from a ROW_LAYOUT file and from a PAX_LAYOUT file holding the same records.
+// Usage: rbfbench_02 [numRecords]
+
+const int numColumns = 20;
+
+RC loadFile(RecordBasedFileManager *rbfm, const char *fileName, PageLayout layout,
+            const vector<Attribute> &recordDescriptor, int numRecords)
+{
+    rbfm->destroyFile(fileName);
+    if (rbfm->createFile(fileName, layout) != success)
+        return -1;
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+
+    char record[PAGE_SIZE];
+    int nullIndicatorSize = getActualByteForNullsIndicator(numColumns);
+    memset(record, 0, nullIndicatorSize);
+    RID rid;
+    for (int i = 0; i < numRecords; i++) {
+        for (int j = 0; j < numColumns; j++) {
+            int value = i * numColumns + j;
+            memcpy(record + nullIndicatorSize + j * sizeof(int), &value, sizeof(int));
+        }
+        if (rbfm->insertRecord(fileHandle, recordDescriptor, record, rid) != success)
+            return -1;
+    }
+    rbfm->closeFile(fileHandle);
+    return success;
+}
+
+double sumColumn(RecordBasedFileManager *rbfm, const char *fileName, const vector<Attribute> &recordDescriptor,
+                 long long &sum, unsigned &pages)
+{
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+    pages = fileHandle.getNumberOfPages();
+
+    auto start = chrono::steady_clock::now();
+    vector<string> attributeNames;
+    attributeNames.push_back(recordDescriptor[numColumns / 2].name);
+    RBFM_ScanIterator iter;
+    rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, iter);
+    RID rid;
+    char data[PAGE_SIZE];
+    sum = 0;
+    while (iter.getNextRecord(rid, data) != RBFM_EOF)
+        sum += *(int *)(data + 1);
+    iter.close();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    rbfm->closeFile(fileHandle);
+    return seconds;
+}
+
+int main(int argc, char **argv) {
+    int numRecords = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> recordDescriptor;
+    for (int j = 0; j < numColumns; j++) {
+        Attribute attr;
+        attr.name = "col" + to_string(j);
+        attr.type = TypeInt;
+        attr.length = 4;
+        recordDescriptor.push_back(attr);
+    }
+
+    cout << "Loading " << numRecords << " records of " << numColumns << " ints in each layout..." << endl;
+    if (loadFile(rbfm, "bench02row", ROW_LAYOUT, recordDescriptor, numRecords) != success
+        || loadFile(rbfm, "bench02pax", PAX_LAYOUT, recordDescriptor, numRecords) != success) {
+        cout << "Loading the files failed." << endl;
+        return -1;
+    }
+
+    long long sum;
+    unsigned pages;
+    double row = sumColumn(rbfm, "bench02row", recordDescriptor, sum, pages);
+    cout << "Row layout: " << row * 1000 << " ms, " << pages << " pages, sum " << sum << endl;
+    double pax = sumColumn(rbfm, "bench02pax", recordDescriptor, sum, pages);
+    cout << "PAX layout: " << pax * 1000 << " ms, " << pages << " pages, sum " << sum << endl;
+    cout << "Speedup " << row / pax << endl;
+
+    rbfm->destroyFile("bench02row");
+    rbfm->destroyFile("bench02pax");
+    return 0;
+}
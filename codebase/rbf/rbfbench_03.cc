@@ -0,0 +1,99 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Dictionary encoding of a low-cardinality varchar: file size, and the time of an equality
+// filter on it, for a plain file and for one where EmpName is dictionary-encoded.
+// Usage: rbfbench_03 [numRecords] [distinct names]
+
+RC loadFile(RecordBasedFileManager *rbfm, const char *fileName, const vector<string> &dictionaryAttributes,
+            const vector<Attribute> &recordDescriptor, int numRecords, int numNames)
+{
+    rbfm->destroyFile(fileName);
+    if (rbfm->createFile(fileName, ROW_LAYOUT, dictionaryAttributes) != success)
+        return -1;
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+
+    unsigned char nullsIndicator = 0;
+    int recordSize = 0;
+    char record[100];
+    RID rid;
+    for (int i = 0; i < numRecords; i++) {
+        string name = "Department number " + to_string((i * 7919) % numNames);
+        prepareRecord(recordDescriptor.size(), &nullsIndicator, name.size(), name, i, (float)i, i, record, &recordSize);
+        if (rbfm->insertRecord(fileHandle, recordDescriptor, record, rid) != success)
+            return -1;
+    }
+    rbfm->closeFile(fileHandle);
+    return success;
+}
+
+double runFilter(RecordBasedFileManager *rbfm, const char *fileName, const vector<Attribute> &recordDescriptor,
+                 long &results, unsigned &pages)
+{
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+    pages = fileHandle.getNumberOfPages();
+
+    auto start = chrono::steady_clock::now();
+    string name = "Department number 1";
+    char value[100];
+    int nameLength = name.size();
+    memcpy(value, &nameLength, sizeof(int));
+    memcpy(value + sizeof(int), name.data(), nameLength);
+    vector<string> attributeNames;
+    attributeNames.push_back("Age");
+
+    RBFM_ScanIterator iter;
+    rbfm->scan(fileHandle, recordDescriptor, "EmpName", EQ_OP, value, attributeNames, iter);
+    RID rid;
+    char data[PAGE_SIZE];
+    results = 0;
+    while (iter.getNextRecord(rid, data) != RBFM_EOF)
+        results++;
+    iter.close();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    rbfm->closeFile(fileHandle);
+    return seconds;
+}
+
+int main(int argc, char **argv) {
+    int numRecords = argc > 1 ? atoi(argv[1]) : 1000000;
+    int numNames = argc > 2 ? atoi(argv[2]) : 50;
+
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    vector<string> dictionaryAttributes;
+    dictionaryAttributes.push_back("EmpName");
+
+    cout << "Loading " << numRecords << " records with " << numNames << " distinct names..." << endl;
+    if (loadFile(rbfm, "bench03plain", vector<string>(), recordDescriptor, numRecords, numNames) != success
+        || loadFile(rbfm, "bench03dict", dictionaryAttributes, recordDescriptor, numRecords, numNames) != success) {
+        cout << "Loading the files failed." << endl;
+        return -1;
+    }
+
+    long results;
+    unsigned pages;
+    double plain = runFilter(rbfm, "bench03plain", recordDescriptor, results, pages);
+    cout << "Plain: " << plain * 1000 << " ms, " << pages << " pages, " << results << " results" << endl;
+    double dict = runFilter(rbfm, "bench03dict", recordDescriptor, results, pages);
+    cout << "Dictionary-encoded: " << dict * 1000 << " ms, " << pages << " pages, " << results << " results" << endl;
+    cout << "Speedup " << plain / dict << endl;
+
+    rbfm->destroyFile("bench03plain");
+    rbfm->destroyFile("bench03dict");
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Page compression: the employee sample in codebase/data repeated up to the number of records
+// wanted, loaded into a plain file and into one that is then compressed. Reports the file
+// sizes and the throughput of a full scan of each.
+// Usage: rbfbench_04 [numRecords] [sample file]
+
+typedef struct Employee
+{
+    string name;
+    int age;
+    float height;
+    int salary;
+} Employee;
+
+RC loadSample(const char *sampleFileName, vector<Employee> &employees)
+{
+    ifstream sample(sampleFileName);
+    string line;
+    while (getline(sample, line)) {
+        Employee employee;
+        stringstream fields(line);
+        string age, height, salary;
+        if (getline(fields, employee.name, ',') && getline(fields, age, ',') && getline(fields, height, ',')
+            && getline(fields, salary, ',')) {
+            employee.age = atoi(age.c_str());
+            employee.height = atof(height.c_str());
+            employee.salary = atoi(salary.c_str());
+            employees.push_back(employee);
+        }
+    }
+    return employees.empty() ? -1 : success;
+}
+
+RC loadFile(RecordBasedFileManager *rbfm, const char *fileName, const vector<Attribute> &recordDescriptor,
+            const vector<Employee> &employees, int numRecords)
+{
+    rbfm->destroyFile(fileName);
+    if (rbfm->createFile(fileName) != success)
+        return -1;
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+
+    unsigned char nullsIndicator = 0;
+    int recordSize = 0;
+    char record[PAGE_SIZE];
+    RID rid;
+    for (int i = 0; i < numRecords; i++) {
+        const Employee &employee = employees[i % employees.size()];
+        prepareRecord(recordDescriptor.size(), &nullsIndicator, employee.name.size(), employee.name, employee.age,
+                      employee.height, employee.salary + i / employees.size(), record, &recordSize);
+        if (rbfm->insertRecord(fileHandle, recordDescriptor, record, rid) != success)
+            return -1;
+    }
+    rbfm->closeFile(fileHandle);
+    return success;
+}
+
+double scanFile(RecordBasedFileManager *rbfm, const char *fileName, const vector<Attribute> &recordDescriptor,
+                long long &sum, unsigned &pages)
+{
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+    pages = fileHandle.getNumberOfPages();
+
+    auto start = chrono::steady_clock::now();
+    vector<string> attributeNames;
+    attributeNames.push_back("Salary");
+    RBFM_ScanIterator iter;
+    rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, iter);
+    RID rid;
+    char data[PAGE_SIZE];
+    sum = 0;
+    while (iter.getNextRecord(rid, data) != RBFM_EOF)
+        sum += *(int *)(data + 1);
+    iter.close();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    rbfm->closeFile(fileHandle);
+    return seconds;
+}
+
+long getFileSize(const string &fileName)
+{
+    struct stat sb;
+    return stat(fileName.c_str(), &sb) == 0 ? sb.st_size : -1;
+}
+
+int main(int argc, char **argv) {
+    int numRecords = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char *sampleFileName = argc > 2 ? argv[2] : "../data/employee_50";
+
+    vector<Employee> employees;
+    if (loadSample(sampleFileName, employees) != success) {
+        cout << "Reading " << sampleFileName << " failed." << endl;
+        return -1;
+    }
+
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    cout << "Loading " << numRecords << " records from " << employees.size() << " sample rows..." << endl;
+    if (loadFile(rbfm, "bench04plain", recordDescriptor, employees, numRecords) != success
+        || loadFile(rbfm, "bench04compressed", recordDescriptor, employees, numRecords) != success
+        || rbfm->compressFile("bench04compressed") != success) {
+        cout << "Loading the files failed." << endl;
+        return -1;
+    }
+
+    long plainSize = getFileSize("bench04plain");
+    long compressedSize = getFileSize("bench04compressed");
+    cout << "Plain: " << plainSize << " bytes, compressed: " << compressedSize << " bytes, ratio "
+         << (double)plainSize / compressedSize << endl;
+
+    long long sum;
+    unsigned pages;
+    double plain = scanFile(rbfm, "bench04plain", recordDescriptor, sum, pages);
+    cout << "Plain scan: " << plain * 1000 << " ms, " << pages * (double)PAGE_SIZE / plain / 1e6 << " MB/s of pages, sum "
+         << sum << endl;
+    double compressed = scanFile(rbfm, "bench04compressed", recordDescriptor, sum, pages);
+    cout << "Compressed scan: " << compressed * 1000 << " ms, " << pages * (double)PAGE_SIZE / compressed / 1e6
+         << " MB/s of pages, sum " << sum << endl;
+
+    rbfm->destroyFile("bench04plain");
+    rbfm->destroyFile("bench04compressed");
+    return 0;
+}
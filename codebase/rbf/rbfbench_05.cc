@@ -0,0 +1,135 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Overflow pages: documents with a long body, stored once with the bodies in overflow pages
+// and once with them in the records, as in a file that has no overflow file. Reports the time
+// and pages read of a scan of the short attributes and of a scan of the bodies.
+// Usage: rbfbench_05 [numRecords] [body length]
+
+void createDocumentDescriptor(vector<Attribute> &recordDescriptor, int bodyLength)
+{
+    Attribute attr;
+    attr.name = "Id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "Body";
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)bodyLength;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "Score";
+    attr.type = TypeReal;
+    attr.length = (AttrLength)4;
+    recordDescriptor.push_back(attr);
+}
+
+RC loadFile(RecordBasedFileManager *rbfm, const char *fileName, bool overflow, const vector<Attribute> &recordDescriptor,
+            int numRecords, int bodyLength)
+{
+    rbfm->destroyFile(fileName);
+    if (rbfm->createFile(fileName) != success)
+        return -1;
+    if (!overflow)
+        PagedFileManager::instance()->destroyFile(string(fileName) + OVERFLOW_EXTENSION);
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+
+    char *record = (char *)malloc(bodyLength + 100);
+    RID rid;
+    for (int i = 0; i < numRecords; i++) {
+        int offset = 1;
+        record[0] = 0;
+        memcpy(record + offset, &i, sizeof(int));
+        offset += sizeof(int);
+        memcpy(record + offset, &bodyLength, sizeof(int));
+        memset(record + offset + sizeof(int), 'a' + i % 26, bodyLength);
+        offset += sizeof(int) + bodyLength;
+        float score = i % 100;
+        memcpy(record + offset, &score, sizeof(float));
+        if (rbfm->insertRecord(fileHandle, recordDescriptor, record, rid) != success) {
+            free(record);
+            return -1;
+        }
+    }
+    free(record);
+    rbfm->closeFile(fileHandle);
+    return success;
+}
+
+double runScan(RecordBasedFileManager *rbfm, const char *fileName, const vector<Attribute> &recordDescriptor,
+               const string &attributeName, long long &sum, unsigned &pagesRead)
+{
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+    char *data = (char *)malloc(recordDescriptor[1].length + 100);
+
+    auto start = chrono::steady_clock::now();
+    vector<string> attributeNames;
+    attributeNames.push_back(attributeName);
+    float value = 50;
+    RBFM_ScanIterator iter;
+    rbfm->scan(fileHandle, recordDescriptor, "Score", GE_OP, &value, attributeNames, iter);
+    RID rid;
+    sum = 0;
+    while (iter.getNextRecord(rid, data) != RBFM_EOF)
+        sum += *(int *)(data + 1);
+    unsigned pagesSkipped;
+    iter.getScanStats(pagesRead, pagesSkipped);
+    iter.close();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // The overflow file's handle is shared with the scan
+    unsigned writePageCount, appendPageCount;
+    if (rbfm->getOverflowFile(fileHandle) != NULL) {
+        unsigned overflowReads;
+        rbfm->getOverflowFile(fileHandle)->collectCounterValues(overflowReads, writePageCount, appendPageCount);
+        pagesRead += overflowReads;
+    }
+    free(data);
+    rbfm->closeFile(fileHandle);
+    return seconds;
+}
+
+int main(int argc, char **argv) {
+    int numRecords = argc > 1 ? atoi(argv[1]) : 5000;
+    int bodyLength = argc > 2 ? atoi(argv[2]) : 3000;
+
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> recordDescriptor;
+    createDocumentDescriptor(recordDescriptor, bodyLength);
+
+    cout << "Loading " << numRecords << " documents with " << bodyLength << " byte bodies..." << endl;
+    if (loadFile(rbfm, "bench05inline", false, recordDescriptor, numRecords, bodyLength) != success
+        || loadFile(rbfm, "bench05overflow", true, recordDescriptor, numRecords, bodyLength) != success) {
+        cout << "Loading the files failed." << endl;
+        return -1;
+    }
+
+    const char *fileNames[] = {"bench05inline", "bench05overflow"};
+    const char *attributeNames[] = {"Id", "Body"};
+    for (const char *fileName : fileNames) {
+        for (const char *attributeName : attributeNames) {
+            long long sum;
+            unsigned pagesRead;
+            double seconds = runScan(rbfm, fileName, recordDescriptor, attributeName, sum, pagesRead);
+            cout << fileName << ", scan of " << attributeName << ": " << seconds * 1000 << " ms, " << pagesRead
+                 << " pages read, checksum " << sum << endl;
+        }
+    }
+
+    rbfm->destroyFile("bench05inline");
+    rbfm->destroyFile("bench05overflow");
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Scan selectivity: the same employee records in a row layout file and in a PAX layout file,
+// with Age spread over the file so that the zone map cannot skip pages. Reports the time of
+// scans with a condition on Age that 1%, 10% and 100% of the records satisfy, and of one
+// without a condition.
+// Usage: rbfbench_06 [numRecords] [repetitions]
+
+RC loadFile(RecordBasedFileManager *rbfm, const char *fileName, PageLayout layout, const vector<Attribute> &recordDescriptor,
+            int numRecords)
+{
+    rbfm->destroyFile(fileName);
+    if (rbfm->createFile(fileName, layout) != success)
+        return -1;
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+
+    char record[100];
+    int recordSize;
+    RID rid;
+    for (int i = 0; i < numRecords; i++) {
+        int age = (int)(((long long)i * 7919) % numRecords);
+        unsigned char nullsIndicator = 0;
+        string name = "Employee" + to_string(i % 1000);
+        prepareRecord(recordDescriptor.size(), &nullsIndicator, name.size(), name, age, (float)i / 3, i % 5000, record,
+                      &recordSize);
+        if (rbfm->insertRecord(fileHandle, recordDescriptor, record, rid) != success)
+            return -1;
+    }
+    rbfm->closeFile(fileHandle);
+    return success;
+}
+
+double runScan(RecordBasedFileManager *rbfm, const char *fileName, const vector<Attribute> &recordDescriptor, CompOp compOp,
+               int bound, int repetitions, int &count)
+{
+    FileHandle fileHandle;
+    rbfm->openFile(fileName, fileHandle);
+    vector<string> attributeNames;
+    attributeNames.push_back("Salary");
+    char data[100];
+
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; r++) {
+        RBFM_ScanIterator iter;
+        rbfm->scan(fileHandle, recordDescriptor, "Age", compOp, compOp == NO_OP ? NULL : &bound, attributeNames, iter);
+        RID rid;
+        count = 0;
+        while (iter.getNextRecord(rid, data) != RBFM_EOF)
+            count++;
+        iter.close();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    rbfm->closeFile(fileHandle);
+    return seconds / repetitions;
+}
+
+int main(int argc, char **argv) {
+    int numRecords = argc > 1 ? atoi(argv[1]) : 100000;
+    int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    cout << "Loading " << numRecords << " records..." << endl;
+    if (loadFile(rbfm, "bench06row", ROW_LAYOUT, recordDescriptor, numRecords) != success
+        || loadFile(rbfm, "bench06pax", PAX_LAYOUT, recordDescriptor, numRecords) != success) {
+        cout << "Loading the files failed." << endl;
+        return -1;
+    }
+
+    const char *fileNames[] = {"bench06row", "bench06pax"};
+    int percentages[] = {1, 10, 100};
+    for (const char *fileName : fileNames) {
+        for (int percentage : percentages) {
+            int count;
+            double seconds = runScan(rbfm, fileName, recordDescriptor, LT_OP, numRecords / 100 * percentage, repetitions, count);
+            cout << fileName << ", Age < " << percentage << "%: " << seconds * 1000 << " ms, " << count << " records" << endl;
+        }
+        int count;
+        double seconds = runScan(rbfm, fileName, recordDescriptor, NO_OP, 0, repetitions, count);
+        cout << fileName << ", no condition: " << seconds * 1000 << " ms, " << count << " records" << endl;
+    }
+
+    rbfm->destroyFile("bench06row");
+    rbfm->destroyFile("bench06pax");
+    return 0;
+}
@@ -5,6 +5,8 @@
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
 
 #include "rbfm.h"
@@ -30,17 +32,36 @@ RecordBasedFileManager::~RecordBasedFileManager()
 {
 }
 
-RC RecordBasedFileManager::createFile(const string &fileName)
+RC RecordBasedFileManager::createFile(const string &fileName, PageLayout layout, const vector<string> &dictionaryAttributes,
+                                      unsigned pageSize)
 {
     // Creating a new paged file.
-    if (_pf_manager->createFile(fileName))
+    if (_pf_manager->createFile(fileName, false, pageSize))
+        return RBFM_CREATE_FAILED;
+
+    // And its zone map, replacing any left behind by a file of the same name
+    string zoneMapFileName = getZoneMapFileName(fileName);
+    _pf_manager->destroyFile(zoneMapFileName);
+    if (_pf_manager->createFile(zoneMapFileName, false, pageSize))
+        return RBFM_CREATE_FAILED;
+
+    // And its dictionary, if it has dictionary-encoded attributes
+    string dictionaryFileName = getDictionaryFileName(fileName);
+    _pf_manager->destroyFile(dictionaryFileName);
+    if (!dictionaryAttributes.empty() && VarCharDictionary::createFile(dictionaryFileName, dictionaryAttributes))
+        return RBFM_CREATE_FAILED;
+
+    // And its overflow file; records of PAX_LAYOUT files must fit on a page
+    string overflowFileName = getOverflowFileName(fileName);
+    _pf_manager->destroyFile(overflowFileName);
+    if (layout == ROW_LAYOUT && createOverflowFile(overflowFileName, pageSize))
         return RBFM_CREATE_FAILED;
 
     // Setting up the first page.
-    void *firstPageData = calloc(PAGE_SIZE, 1);
+    void *firstPageData = calloc(pageSize, 1);
     if (firstPageData == NULL)
         return RBFM_MALLOC_FAILED;
-    newRecordBasedPage(firstPageData);
+    newRecordBasedPage(firstPageData, layout, pageSize);
 
     // Adds the first record based page.
     FileHandle handle;
@@ -57,100 +78,253 @@ RC RecordBasedFileManager::createFile(const string &fileName)
 
 RC RecordBasedFileManager::destroyFile(const string &fileName)
 {
+    // Files created before zone maps existed have none, and only some files have a dictionary
+    // or an overflow file
+    _pf_manager->destroyFile(getZoneMapFileName(fileName));
+    _pf_manager->destroyFile(getDictionaryFileName(fileName));
+    _pf_manager->destroyFile(getOverflowFileName(fileName));
     return _pf_manager->destroyFile(fileName);
 }
 
+RC RecordBasedFileManager::compressFile(const string &fileName)
+{
+    RC rc = _pf_manager->compressFile(fileName);
+    if (rc)
+        return rc;
+    // Not every file has a zone map, a dictionary or an overflow file
+    rc = _pf_manager->compressFile(getZoneMapFileName(fileName));
+    if (rc && rc != PFM_FILE_DN_EXIST)
+        return rc;
+    rc = _pf_manager->compressFile(getDictionaryFileName(fileName));
+    if (rc && rc != PFM_FILE_DN_EXIST)
+        return rc;
+    rc = _pf_manager->compressFile(getOverflowFileName(fileName));
+    if (rc && rc != PFM_FILE_DN_EXIST)
+        return rc;
+    return SUCCESS;
+}
+
 RC RecordBasedFileManager::openFile(const string &fileName, FileHandle &fileHandle)
 {
-    return _pf_manager->openFile(fileName.c_str(), fileHandle);
+    RC rc = _pf_manager->openFile(fileName.c_str(), fileHandle);
+    if (rc)
+        return rc;
+
+    CompanionFiles files = {NULL, NULL, NULL};
+
+    // Without its zone map a file is still usable; its pages are just never skipped
+    FileHandle *zoneMap = new FileHandle();
+    if (_pf_manager->openFile(getZoneMapFileName(fileName), *zoneMap) == SUCCESS)
+        files.zoneMap = zoneMap;
+    else
+        delete zoneMap;
+
+    // Without its dictionary, a file with dictionary-encoded attributes is not
+    FileHandle *dictionaryFile = new FileHandle();
+    if (_pf_manager->openFile(getDictionaryFileName(fileName), *dictionaryFile) == SUCCESS)
+        files.dictionary = new VarCharDictionary(dictionaryFile);
+    else
+        delete dictionaryFile;
+
+    // Without its overflow file, a file just cannot take records with long values
+    FileHandle *overflow = new FileHandle();
+    if (_pf_manager->openFile(getOverflowFileName(fileName), *overflow) == SUCCESS)
+        files.overflow = overflow;
+    else
+        delete overflow;
+
+    {
+        lock_guard<mutex> lock(companionFilesMutex);
+        companionFiles[fileHandle.getFileId()] = files;
+    }
+    if (files.dictionary != NULL && files.dictionary->load())
+    {
+        closeFile(fileHandle);
+        return RBFM_DICT_FAILED;
+    }
+    return SUCCESS;
 }
 
 RC RecordBasedFileManager::closeFile(FileHandle &fileHandle)
 {
+    CompanionFiles files = {NULL, NULL, NULL};
+    {
+        lock_guard<mutex> lock(companionFilesMutex);
+        auto it = companionFiles.find(fileHandle.getFileId());
+        if (it != companionFiles.end())
+        {
+            files = it->second;
+            companionFiles.erase(it);
+        }
+    }
+    if (files.zoneMap != NULL)
+    {
+        _pf_manager->closeFile(*files.zoneMap);
+        delete files.zoneMap;
+    }
+    delete files.dictionary;
+    if (files.overflow != NULL)
+    {
+        _pf_manager->closeFile(*files.overflow);
+        delete files.overflow;
+    }
     return _pf_manager->closeFile(fileHandle);
 }
 
+CompanionFiles RecordBasedFileManager::getCompanions(const FileHandle &fileHandle)
+{
+    lock_guard<mutex> lock(companionFilesMutex);
+    auto it = companionFiles.find(fileHandle.getFileId());
+    if (it == companionFiles.end())
+        return CompanionFiles{NULL, NULL, NULL};
+    return it->second;
+}
+
+FileHandle *RecordBasedFileManager::getOverflowFile(const FileHandle &fileHandle)
+{
+    return getCompanions(fileHandle).overflow;
+}
+
 RC RecordBasedFileManager::insertRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid)
+{
+    if (getCompanions(fileHandle).dictionary == NULL)
+        return storeRecord(fileHandle, recordDescriptor, data, rid);
+
+    // A stored record is never larger than the record it encodes
+    vector<Attribute> storedDescriptor;
+    getStoredDescriptor(fileHandle, recordDescriptor, storedDescriptor);
+    void *stored = malloc(getDataSize(recordDescriptor, data));
+    if (stored == NULL)
+        return RBFM_MALLOC_FAILED;
+    RC rc = encodeRecord(fileHandle, recordDescriptor, data, stored);
+    if (rc == SUCCESS)
+        rc = storeRecord(fileHandle, storedDescriptor, stored, rid);
+    free(stored);
+    return rc;
+}
+
+// insertRecord of a record with its dictionary-encoded attributes already encoded
+RC RecordBasedFileManager::storeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid)
+{
+    void *inlined;
+    vector<bool> overflowed;
+    RC rc = storeOverflowValues(fileHandle, recordDescriptor, data, inlined, overflowed);
+    if (rc)
+        return rc;
+    rc = placeRecord(fileHandle, recordDescriptor, inlined == NULL ? data : inlined, overflowed, rid);
+    free(inlined);
+    return rc;
+}
+
+RC RecordBasedFileManager::placeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data,
+                                       const vector<bool> &overflowed, RID &rid)
 {
     // Gets the size of the record.
     unsigned recordSize = getRecordSize(recordDescriptor, data);
 
     // Cycles through pages looking for enough free space for the new entry.
-    void *pageData = malloc(PAGE_SIZE);
+    // The last page is tried first: while a table is being loaded it is the only one with room.
+    void *pageData = malloc(fileHandle.getPageSize());
     if (pageData == NULL)
         return RBFM_MALLOC_FAILED;
     bool pageFound = false;
     unsigned i;
     unsigned numPages = fileHandle.getNumberOfPages();
-    for (i = 0; i < numPages; i++)
+    for (unsigned j = 0; j < numPages; j++)
     {
+        i = (j == 0) ? numPages - 1 : j - 1;
         if (fileHandle.readPage(i, pageData))
+        {
+            free(pageData);
             return RBFM_READ_FAILED;
+        }
 
-        // When we find a page with enough space (accounting also for the size that will be added to the slot directory), we stop the loop.
-        if (getPageFreeSpaceSize(pageData) >= sizeof(SlotDirectoryRecordEntry) + recordSize)
+        // When we find a page with enough space, we stop the loop.
+        if (recordFitsOnPage(pageData, recordDescriptor, data, recordSize))
         {
             pageFound = true;
             break;
         }
     }
 
-    // If we can't find a page with enough space, we create a new one
+    // If we can't find a page with enough space, we create a new one with the layout of the others
     if (!pageFound)
     {
-        newRecordBasedPage(pageData);
+        i = numPages;
+        newRecordBasedPage(pageData, (PageLayout)getSlotDirectoryHeader(pageData).layout, fileHandle.getPageSize());
+        if (getSlotDirectoryHeader(pageData).layout == PAX_LAYOUT)
+            setupPaxPage(pageData, recordDescriptor);
+        if (!recordFitsOnPage(pageData, recordDescriptor, data, recordSize))
+        {
+            free(pageData);
+            return RBFM_RECORD_TOO_LARGE;
+        }
     }
 
-    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
-
     // Setting the return RID.
     rid.pageNum = i;
     rid.slotNum = getOpenSlot(pageData);
-
-    // Adding the new record reference in the slot directory.
-    SlotDirectoryRecordEntry newRecordEntry;
-    newRecordEntry.length = recordSize;
-    newRecordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
-    setSlotDirectoryRecordEntry(pageData, rid.slotNum, newRecordEntry);
-
-    // Updating the slot directory header.
-    slotHeader.freeSpaceOffset = newRecordEntry.offset;
-    if (rid.slotNum == slotHeader.recordEntriesNumber)
-        slotHeader.recordEntriesNumber += 1;
-    setSlotDirectoryHeader(pageData, slotHeader);
-
-    // Adding the record data.
-    setRecordAtOffset(pageData, newRecordEntry.offset, recordDescriptor, data);
+    setRecordInSlot(pageData, rid.slotNum, recordDescriptor, data, overflowed);
 
     // Writing the page to disk.
+    RC rc = SUCCESS;
     if (pageFound)
     {
-        if (fileHandle.writePage(i, pageData))
-            return RBFM_WRITE_FAILED;
+        if (writeDataPage(fileHandle, recordDescriptor, i, pageData))
+            rc = RBFM_WRITE_FAILED;
     }
     else
     {
-        if (fileHandle.appendPage(pageData))
-            return RBFM_APPEND_FAILED;
+        if (appendDataPage(fileHandle, recordDescriptor, pageData))
+            rc = RBFM_APPEND_FAILED;
     }
 
     free(pageData);
-    return SUCCESS;
+    return rc;
 }
 
 RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data)
+{
+    if (getCompanions(fileHandle).dictionary == NULL)
+        return readStoredRecord(fileHandle, recordDescriptor, rid, data);
+
+    // A stored record is never larger than the record it decodes to, so it is read into data
+    // and decoded from a copy
+    vector<Attribute> storedDescriptor;
+    getStoredDescriptor(fileHandle, recordDescriptor, storedDescriptor);
+    RC rc = readStoredRecord(fileHandle, storedDescriptor, rid, data);
+    if (rc)
+        return rc;
+    unsigned size = getDataSize(storedDescriptor, data);
+    void *stored = malloc(size);
+    if (stored == NULL)
+        return RBFM_MALLOC_FAILED;
+    memcpy(stored, data, size);
+    rc = decodeRecord(fileHandle, recordDescriptor, stored, data);
+    free(stored);
+    return rc;
+}
+
+// readRecord without decoding the dictionary-encoded attributes
+RC RecordBasedFileManager::readStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data)
 {
     // Retrieve the specific page
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = malloc(fileHandle.getPageSize());
     if (pageData == NULL)
         return RBFM_MALLOC_FAILED;
     if (fileHandle.readPage(rid.pageNum, pageData))
+    {
+        free(pageData);
         return RBFM_READ_FAILED;
+    }
 
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if (slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        free(pageData);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -168,29 +342,137 @@ RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attri
         RID newRid;
         newRid.pageNum = recordEntry.length;
         newRid.slotNum = -recordEntry.offset;
-        return readRecord(fileHandle, recordDescriptor, newRid, data);
+        return readStoredRecord(fileHandle, recordDescriptor, newRid, data);
     // Retrieve the actual entry data
     case VALID:
-        int32_t offset = recordEntry.offset;
-        getRecordAtOffset(pageData, offset, recordDescriptor, data);
+    {
+        RC rc = getRecordInSlot(fileHandle, pageData, rid.slotNum, recordDescriptor, data);
         free(pageData);
-        return SUCCESS;
+        return rc;
+    }
     }
     // Not possible to reach this point, but compiler doesn't know that
     return -1;
 }
 
-RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid)
+RC RecordBasedFileManager::readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids, void *data[])
+{
+    if (getCompanions(fileHandle).dictionary == NULL)
+        return readStoredRecords(fileHandle, recordDescriptor, rids, data);
+
+    // A stored record is never larger than the record it decodes to, so each is decoded in place
+    vector<Attribute> storedDescriptor;
+    getStoredDescriptor(fileHandle, recordDescriptor, storedDescriptor);
+    RC rc = readStoredRecords(fileHandle, storedDescriptor, rids, data);
+    for (unsigned i = 0; i < rids.size() && rc == SUCCESS; i++)
+    {
+        unsigned size = getDataSize(storedDescriptor, data[i]);
+        void *stored = malloc(size);
+        if (stored == NULL)
+            return RBFM_MALLOC_FAILED;
+        memcpy(stored, data[i], size);
+        rc = decodeRecord(fileHandle, recordDescriptor, stored, data[i]);
+        free(stored);
+    }
+    return rc;
+}
+
+RC RecordBasedFileManager::readStoredRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids, void *data[])
+{
+    // Where each wanted record is looked for next, with the position of its rid
+    vector<pair<RID, unsigned>> pending;
+    for (unsigned i = 0; i < rids.size(); i++)
+        pending.push_back(make_pair(rids[i], i));
+
+    void *pageData = malloc(fileHandle.getPageSize());
+    if (pageData == NULL)
+        return RBFM_MALLOC_FAILED;
+
+    auto ridLess = [](const pair<RID, unsigned> &a, const pair<RID, unsigned> &b) {
+        return a.first.pageNum < b.first.pageNum || (a.first.pageNum == b.first.pageNum && a.first.slotNum < b.first.slotNum);
+    };
+
+    // Every round reads the pages of the pending records in order; records found to be moved
+    // are looked for at their forwarding address in the next round
+    while (!pending.empty())
+    {
+        sort(pending.begin(), pending.end(), ridLess);
+        vector<pair<RID, unsigned>> forwarded;
+        bool havePage = false;
+        PageNum pageNum = 0;
+        for (const pair<RID, unsigned> &entry : pending)
+        {
+            const RID &rid = entry.first;
+            if (!havePage || rid.pageNum != pageNum)
+            {
+                pageNum = rid.pageNum;
+                havePage = true;
+                if (fileHandle.readPage(pageNum, pageData))
+                {
+                    free(pageData);
+                    return RBFM_READ_FAILED;
+                }
+            }
+
+            SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+            if (slotHeader.recordEntriesNumber <= rid.slotNum)
+            {
+                free(pageData);
+                return RBFM_SLOT_DN_EXIST;
+            }
+
+            SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
+            switch (getSlotStatus(recordEntry))
+            {
+            case DEAD:
+                free(pageData);
+                return RBFM_READ_AFTER_DEL;
+            case MOVED:
+                RID newRid;
+                newRid.pageNum = recordEntry.length;
+                newRid.slotNum = -recordEntry.offset;
+                forwarded.push_back(make_pair(newRid, entry.second));
+                break;
+            case VALID:
+            {
+                RC rc = getRecordInSlot(fileHandle, pageData, rid.slotNum, recordDescriptor, data[entry.second]);
+                if (rc)
+                {
+                    free(pageData);
+                    return rc;
+                }
+                break;
+            }
+            }
+        }
+        pending.swap(forwarded);
+    }
+
+    free(pageData);
+    return SUCCESS;
+}
+
+RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Attribute> &descriptor, const RID &rid)
 {
+    // The descriptor of the stored records, for the zone map
+    vector<Attribute> recordDescriptor;
+    getStoredDescriptor(fileHandle, descriptor, recordDescriptor);
+
     // Get page
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = malloc(fileHandle.getPageSize());
     if (fileHandle.readPage(rid.pageNum, pageData) != SUCCESS)
+    {
+        free(pageData);
         return RBFM_READ_FAILED;
+    }
 
     // Get page header
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if (slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        free(pageData);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Get slot record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -217,12 +499,24 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
     }
     else if (status == VALID)
     {
+        if (slotHeader.layout != PAX_LAYOUT)
+        {
+            RC rc = freeOverflowValues(fileHandle, pageData, recordEntry.offset);
+            if (rc != SUCCESS)
+            {
+                free(pageData);
+                return rc;
+            }
+        }
         markSlotDeleted(pageData, rid.slotNum);
-        reorganizePage(pageData);
+        if (slotHeader.layout == PAX_LAYOUT)
+            reorganizePaxPage(pageData, recordDescriptor);
+        else
+            reorganizePage(pageData);
     }
 
     // Once we've deleted the page(s), write changes to disk
-    RC rc = fileHandle.writePage(rid.pageNum, pageData);
+    RC rc = writeDataPage(fileHandle, recordDescriptor, rid.pageNum, pageData);
     free(pageData);
     return rc;
 }
@@ -293,9 +587,26 @@ RC RecordBasedFileManager::getColumnFromTuple(const void *tuple, const vector<At
 // Larger dnf: remove, reorganize, insert into new page and update slot info
 // same: do nothing
 RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid)
+{
+    if (getCompanions(fileHandle).dictionary == NULL)
+        return updateStoredRecord(fileHandle, recordDescriptor, data, rid);
+
+    vector<Attribute> storedDescriptor;
+    getStoredDescriptor(fileHandle, recordDescriptor, storedDescriptor);
+    void *stored = malloc(getDataSize(recordDescriptor, data));
+    if (stored == NULL)
+        return RBFM_MALLOC_FAILED;
+    RC rc = encodeRecord(fileHandle, recordDescriptor, data, stored);
+    if (rc == SUCCESS)
+        rc = updateStoredRecord(fileHandle, storedDescriptor, stored, rid);
+    free(stored);
+    return rc;
+}
+
+RC RecordBasedFileManager::updateStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid)
 {
     // Retrieve the specific page
-    void *pageData = malloc(PAGE_SIZE);
+    void *pageData = malloc(fileHandle.getPageSize());
     if (fileHandle.readPage(rid.pageNum, pageData))
     {
         free(pageData);
@@ -313,120 +624,319 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
 
-    SlotStatus status = getSlotStatus(recordEntry);
-    switch (status)
-    {
     // Error to update a deleted record
-    case DEAD:
+    if (getSlotStatus(recordEntry) == DEAD)
+    {
         free(pageData);
         return RBFM_READ_AFTER_DEL;
-    // Get the forwarding address from the record entry and recurse
-    case MOVED:
-        free(pageData);
-        RID newRid;
-        newRid.pageNum = recordEntry.length;
-        newRid.slotNum = -recordEntry.offset;
-        return updateRecord(fileHandle, recordDescriptor, data, newRid);
-    default:
-        break;
     }
-    // Do actual work
-    // Gets the size of the updated record
-    unsigned recordSize = getRecordSize(recordDescriptor, data);
-    if (recordSize == recordEntry.length)
+
+    // A moved record is updated where it is. Files written before slots always forwarded
+    // straight to their record may have longer chains, whose other slots are freed here.
+    RID recordRid = rid;
+    void *recordPage = pageData;
+    vector<RID> hops;
+    if (getSlotStatus(recordEntry) == MOVED)
     {
-        setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
-        RC rc = fileHandle.writePage(rid.pageNum, pageData);
-        free(pageData);
-        return rc;
+        recordPage = malloc(fileHandle.getPageSize());
+        RC rc = findForwardedRecord(fileHandle, recordEntry, recordPage, recordRid, hops);
+        if (rc != SUCCESS)
+        {
+            free(recordPage);
+            free(pageData);
+            return rc;
+        }
+        // A record that ended up back on its own page simply takes its slot back
+        if (recordRid.pageNum == rid.pageNum)
+        {
+            setSlotDirectoryRecordEntry(pageData, rid.slotNum, getSlotDirectoryRecordEntry(pageData, recordRid.slotNum));
+            markSlotDeleted(pageData, recordRid.slotNum);
+            free(recordPage);
+            recordPage = pageData;
+            recordRid = rid;
+        }
     }
-    else if (recordSize < recordEntry.length)
+
+    // The new record's long values get overflow pages, and those of the old values are freed
+    void *inlined = NULL;
+    vector<bool> overflowed;
+    RC rc = SUCCESS;
+    if (getSlotDirectoryHeader(recordPage).layout != PAX_LAYOUT)
     {
-        setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
-        recordEntry.length = recordSize;
-        setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
-        reorganizePage(pageData);
-        RC rc = fileHandle.writePage(rid.pageNum, pageData);
-        free(pageData);
-        return rc;
+        rc = storeOverflowValues(fileHandle, recordDescriptor, data, inlined, overflowed);
+        if (rc == SUCCESS)
+            rc = freeOverflowValues(fileHandle, recordPage, getSlotDirectoryRecordEntry(recordPage, recordRid.slotNum).offset);
+        if (inlined != NULL)
+            data = inlined;
     }
-    else if (recordSize > recordEntry.length)
+
+    if (rc == SUCCESS && rewriteRecordInSlot(recordPage, recordRid.slotNum, recordDescriptor, data, overflowed))
+        rc = writeDataPage(fileHandle, recordDescriptor, recordRid.pageNum, recordPage);
+    else if (rc == SUCCESS)
     {
-        unsigned space = getPageFreeSpaceSize(pageData) + recordEntry.length;
-        if (recordSize > space)
+        // The record has to leave its page. A moved record goes back to its own page if that
+        // now has room; the slot it leaves is freed, so that its rid forwards at most once.
+        // Neither page on disk has room for it, so placeRecord chooses neither.
+        if (recordPage != pageData && recordFitsInSlot(pageData, rid.slotNum, recordDescriptor, data))
+            setRecordInSlot(pageData, rid.slotNum, recordDescriptor, data, overflowed);
+        else
         {
-            // Need to insert then set forward address then reorganize
             RID newRid;
-            RC rc = insertRecord(fileHandle, recordDescriptor, data, newRid);
+            rc = placeRecord(fileHandle, recordDescriptor, data, overflowed, newRid);
+            recordEntry.length = newRid.pageNum;
+            recordEntry.offset = -newRid.slotNum;
+            setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
+        }
+        if (rc == SUCCESS && recordPage != pageData)
+            rc = writeDataPage(fileHandle, recordDescriptor, recordRid.pageNum, recordPage);
+        if (rc == SUCCESS)
+            rc = writeDataPage(fileHandle, recordDescriptor, rid.pageNum, pageData);
+    }
+    for (unsigned i = 0; i < hops.size() && rc == SUCCESS; i++)
+        rc = freeSlot(fileHandle, recordDescriptor, hops[i]);
+
+    free(inlined);
+    if (recordPage != pageData)
+        free(recordPage);
+    free(pageData);
+    return rc;
+}
+
+RC RecordBasedFileManager::vacuumFile(FileHandle &fileHandle, const vector<Attribute> &descriptor)
+{
+    vector<Attribute> recordDescriptor;
+    getStoredDescriptor(fileHandle, descriptor, recordDescriptor);
+
+    void *pageData = malloc(fileHandle.getPageSize());
+    if (pageData == NULL)
+        return RBFM_MALLOC_FAILED;
+    for (PageNum pageNum = 0; pageNum < fileHandle.getNumberOfPages(); pageNum++)
+    {
+        if (fileHandle.readPage(pageNum, pageData))
+        {
+            free(pageData);
+            return RBFM_READ_FAILED;
+        }
+
+        // Each forwarding slot is dealt with on disk, as its record's page may be any other
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+        vector<unsigned> forwarding;
+        for (unsigned i = 0; i < slotHeader.recordEntriesNumber; i++)
+            if (getSlotStatus(getSlotDirectoryRecordEntry(pageData, i)) == MOVED)
+                forwarding.push_back(i);
+        for (unsigned slot : forwarding)
+        {
+            RID rid;
+            rid.pageNum = pageNum;
+            rid.slotNum = slot;
+            RC rc = collapseForwarding(fileHandle, recordDescriptor, rid);
             if (rc != SUCCESS)
             {
                 free(pageData);
                 return rc;
             }
-            recordEntry.length = newRid.pageNum;
-            recordEntry.offset = -newRid.slotNum;
-            setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
-            reorganizePage(pageData);
         }
-        else
+        if (!forwarding.empty() && fileHandle.readPage(pageNum, pageData))
         {
-            // Need to set header to DEAD and reorganize to consolidate free space
-            recordEntry.length = 0;
-            recordEntry.offset = 0;
-            setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
-            reorganizePage(pageData);
-
-            // Get updated slotHeader with new free space pointer
-            slotHeader = getSlotDirectoryHeader(pageData);
-            // Update record length and offset
-            recordEntry.length = recordSize;
-            recordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
-            setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
-
-            // Update header with new free space pointer
-            slotHeader.freeSpaceOffset = recordEntry.offset;
-            setSlotDirectoryHeader(pageData, slotHeader);
+            free(pageData);
+            return RBFM_READ_FAILED;
+        }
 
-            // Add new record data
-            setRecordAtOffset(pageData, recordEntry.offset, recordDescriptor, data);
+        // The DEAD slots at the end of the slot directory go
+        slotHeader = getSlotDirectoryHeader(pageData);
+        unsigned entries = slotHeader.recordEntriesNumber;
+        while (slotHeader.recordEntriesNumber > 0
+               && getSlotStatus(getSlotDirectoryRecordEntry(pageData, slotHeader.recordEntriesNumber - 1)) == DEAD)
+            slotHeader.recordEntriesNumber--;
+        if (slotHeader.recordEntriesNumber == entries)
+            continue;
+        setSlotDirectoryHeader(pageData, slotHeader);
+        if (slotHeader.layout == PAX_LAYOUT)
+            reorganizePaxPage(pageData, recordDescriptor);
+        else
+            reorganizePage(pageData);
+        RC rc = writeDataPage(fileHandle, recordDescriptor, pageNum, pageData);
+        if (rc != SUCCESS)
+        {
+            free(pageData);
+            return rc;
         }
     }
-    RC rc = fileHandle.writePage(rid.pageNum, pageData);
     free(pageData);
-    return rc;
+    return SUCCESS;
 }
 
-RC RecordBasedFileManager::printRecord(const vector<Attribute> &recordDescriptor, const void *data)
+RC RecordBasedFileManager::collapseForwarding(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid)
 {
-    // Parse the null indicator into an array
-    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
-    char nullIndicator[nullIndicatorSize];
-    memset(nullIndicator, 0, nullIndicatorSize);
-    memcpy(nullIndicator, data, nullIndicatorSize);
-
-    // We've read in the null indicator, so we can skip past it now
-    unsigned offset = nullIndicatorSize;
+    unsigned pageSize = fileHandle.getPageSize();
+    void *pageData = malloc(pageSize);
+    void *recordPage = malloc(pageSize);
+    if (pageData == NULL || recordPage == NULL)
+    {
+        free(pageData);
+        free(recordPage);
+        return RBFM_MALLOC_FAILED;
+    }
+    if (fileHandle.readPage(rid.pageNum, pageData))
+    {
+        free(pageData);
+        free(recordPage);
+        return RBFM_READ_FAILED;
+    }
 
-    cout << "----" << endl;
-    for (unsigned i = 0; i < (unsigned)recordDescriptor.size(); i++)
+    RID recordRid;
+    vector<RID> hops;
+    RC rc = findForwardedRecord(fileHandle, getSlotDirectoryRecordEntry(pageData, rid.slotNum), recordPage, recordRid, hops);
+    if (rc == SUCCESS)
     {
-        cout << setw(10) << left << recordDescriptor[i].name << ": ";
-        // If the field is null, don't print it
-        bool isNull = fieldIsNull(nullIndicator, i);
-        if (isNull)
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(recordPage, recordRid.slotNum);
+        bool rehomed = true;
+        if (recordRid.pageNum == rid.pageNum)
         {
-            cout << "NULL" << endl;
-            continue;
+            // Already back on this page: the slot takes the record's entry
+            setSlotDirectoryRecordEntry(pageData, rid.slotNum, getSlotDirectoryRecordEntry(pageData, recordRid.slotNum));
+            markSlotDeleted(pageData, recordRid.slotNum);
         }
-        switch (recordDescriptor[i].type)
+        else if (getSlotDirectoryHeader(recordPage).layout != PAX_LAYOUT)
         {
-        case TypeInt:
-            uint32_t data_integer;
-            memcpy(&data_integer, ((char *)data + offset), INT_SIZE);
-            offset += INT_SIZE;
-
-            cout << "" << data_integer << endl;
-            break;
+            // The stored record is copied as it is, pointers to its overflow pages included
+            rehomed = getPageFreeSpaceSize(pageData) >= recordEntry.length;
+            if (rehomed)
+            {
+                SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+                slotHeader.freeSpaceOffset -= recordEntry.length;
+                memcpy((char *)pageData + slotHeader.freeSpaceOffset, (char *)recordPage + recordEntry.offset, recordEntry.length);
+                recordEntry.offset = slotHeader.freeSpaceOffset;
+                setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
+                setSlotDirectoryHeader(pageData, slotHeader);
+            }
+        }
+        else
+        {
+            void *data = malloc(getMaxDataSize(recordDescriptor));
+            rc = getRecordInSlot(fileHandle, recordPage, recordRid.slotNum, recordDescriptor, data);
+            rehomed = rc == SUCCESS && recordFitsInSlot(pageData, rid.slotNum, recordDescriptor, data);
+            if (rehomed)
+                setRecordInSlot(pageData, rid.slotNum, recordDescriptor, data, vector<bool>());
+            free(data);
+        }
+
+        if (rc == SUCCESS && rehomed && recordRid.pageNum != rid.pageNum)
+        {
+            rc = writeDataPage(fileHandle, recordDescriptor, rid.pageNum, pageData);
+            if (rc == SUCCESS)
+                rc = freeSlot(fileHandle, recordDescriptor, recordRid);
+        }
+        else if (rc == SUCCESS && (rehomed || !hops.empty()))
+        {
+            if (!rehomed)
+            {
+                recordEntry.length = recordRid.pageNum;
+                recordEntry.offset = -recordRid.slotNum;
+                setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
+            }
+            rc = writeDataPage(fileHandle, recordDescriptor, rid.pageNum, pageData);
+        }
+    }
+    for (unsigned i = 0; i < hops.size() && rc == SUCCESS; i++)
+        rc = freeSlot(fileHandle, recordDescriptor, hops[i]);
+
+    free(pageData);
+    free(recordPage);
+    return rc;
+}
+
+RC RecordBasedFileManager::getFileStats(FileHandle &fileHandle, RecordFileStats &stats)
+{
+    memset(&stats, 0, sizeof(RecordFileStats));
+    void *pageData = malloc(fileHandle.getPageSize());
+    if (pageData == NULL)
+        return RBFM_MALLOC_FAILED;
+
+    // Every forwarding slot, by where it forwards to
+    map<pair<PageNum, unsigned>, RID> forwards;
+    set<pair<PageNum, unsigned>> forwardedTo;
+    for (PageNum pageNum = 0; pageNum < fileHandle.getNumberOfPages(); pageNum++)
+    {
+        if (fileHandle.readPage(pageNum, pageData))
+        {
+            free(pageData);
+            return RBFM_READ_FAILED;
+        }
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
+        for (unsigned i = 0; i < slotHeader.recordEntriesNumber; i++)
+        {
+            SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, i);
+            switch (getSlotStatus(recordEntry))
+            {
+            case VALID:
+                stats.records++;
+                break;
+            case DEAD:
+                stats.deadSlots++;
+                break;
+            case MOVED:
+            {
+                RID to = getForwardingAddress(recordEntry);
+                forwards[make_pair(pageNum, i)] = to;
+                forwardedTo.insert(make_pair(to.pageNum, to.slotNum));
+                break;
+            }
+            }
+        }
+    }
+    free(pageData);
+
+    // A chain starts at a forwarding slot that no other forwards to
+    stats.forwardingSlots = forwards.size();
+    for (auto &forward : forwards)
+    {
+        if (forwardedTo.count(forward.first))
+            continue;
+        stats.forwardedRecords++;
+        unsigned length = 1;
+        auto next = forwards.find(make_pair(forward.second.pageNum, forward.second.slotNum));
+        while (next != forwards.end() && length <= forwards.size())
+        {
+            length++;
+            next = forwards.find(make_pair(next->second.pageNum, next->second.slotNum));
+        }
+        stats.longestChain = max(stats.longestChain, length);
+    }
+    return SUCCESS;
+}
+
+RC RecordBasedFileManager::printRecord(const vector<Attribute> &recordDescriptor, const void *data)
+{
+    // Parse the null indicator into an array
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char nullIndicator[nullIndicatorSize];
+    memset(nullIndicator, 0, nullIndicatorSize);
+    memcpy(nullIndicator, data, nullIndicatorSize);
+
+    // We've read in the null indicator, so we can skip past it now
+    unsigned offset = nullIndicatorSize;
+
+    cout << "----" << endl;
+    for (unsigned i = 0; i < (unsigned)recordDescriptor.size(); i++)
+    {
+        cout << setw(10) << left << recordDescriptor[i].name << ": ";
+        // If the field is null, don't print it
+        bool isNull = fieldIsNull(nullIndicator, i);
+        if (isNull)
+        {
+            cout << "NULL" << endl;
+            continue;
+        }
+        switch (recordDescriptor[i].type)
+        {
+        case TypeInt:
+            uint32_t data_integer;
+            memcpy(&data_integer, ((char *)data + offset), INT_SIZE);
+            offset += INT_SIZE;
+
+            cout << "" << data_integer << endl;
+            break;
         case TypeReal:
             float data_real;
             memcpy(&data_real, ((char *)data + offset), REAL_SIZE);
@@ -462,7 +972,35 @@ RC RecordBasedFileManager::printRecord(const vector<Attribute> &recordDescriptor
 
 RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, const string &attributeName, void *data)
 {
-    char *pageData = (char *)malloc(PAGE_SIZE);
+    VarCharDictionary *dictionary = getCompanions(fileHandle).dictionary;
+    if (dictionary == NULL || !dictionary->isEncoded(attributeName))
+        return readStoredAttribute(fileHandle, recordDescriptor, rid, attributeName, data);
+
+    // Read the code, then put the value in its place
+    vector<Attribute> storedDescriptor;
+    getStoredDescriptor(fileHandle, recordDescriptor, storedDescriptor);
+    char stored[1 + INT_SIZE];
+    RC rc = readStoredAttribute(fileHandle, storedDescriptor, rid, attributeName, stored);
+    if (rc)
+        return rc;
+    memcpy(data, stored, 1);
+    if (stored[0])
+        return SUCCESS;
+    uint32_t code;
+    memcpy(&code, stored + 1, INT_SIZE);
+    string value;
+    rc = dictionary->getValue(code, value);
+    if (rc)
+        return rc;
+    uint32_t length = value.size();
+    memcpy((char *)data + 1, &length, VARCHAR_LENGTH_SIZE);
+    memcpy((char *)data + 1 + VARCHAR_LENGTH_SIZE, value.data(), length);
+    return SUCCESS;
+}
+
+RC RecordBasedFileManager::readStoredAttribute(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, const string &attributeName, void *data)
+{
+    char *pageData = (char *)malloc(fileHandle.getPageSize());
     if (pageData == NULL)
         return RBFM_MALLOC_FAILED;
     if (fileHandle.readPage(rid.pageNum, pageData) != SUCCESS)
@@ -473,8 +1011,11 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
     // Get record header, recurse if forwarded
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
-    if (slotHeader.recordEntriesNumber < rid.slotNum)
+    if (slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        free(pageData);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -492,24 +1033,21 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
         RID newRid;
         newRid.pageNum = recordEntry.length;
         newRid.slotNum = -recordEntry.offset;
-        return readAttribute(fileHandle, recordDescriptor, newRid, attributeName, data);
+        return readStoredAttribute(fileHandle, recordDescriptor, newRid, attributeName, data);
     default:
         break;
     }
 
-    // Get offset to record
-    unsigned offset = recordEntry.offset;
-    // Get index and type of attribute
+    // Get index of attribute
     auto pred = [&](Attribute a) { return a.name == attributeName; };
     auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
     unsigned index = distance(recordDescriptor.begin(), iterPos);
     if (index == recordDescriptor.size())
         return RBFM_NO_SUCH_ATTR;
-    AttrType type = recordDescriptor[index].type;
     // Write attribute to data
-    getAttributeFromRecord(pageData, offset, index, type, data);
+    RC rc = getAttributeInSlot(fileHandle, pageData, rid.slotNum, recordDescriptor, index, data);
     free(pageData);
-    return SUCCESS;
+    return rc;
 }
 
 // Scan returns an iterator to allow the caller to go through the results one by one.
@@ -519,13 +1057,112 @@ RC RecordBasedFileManager::scan(FileHandle &fileHandle,
                                 const CompOp compOp,                  // comparision type such as "<" and "="
                                 const void *value,                    // used in the comparison
                                 const vector<string> &attributeNames, // a list of projected attributes
-                                RBFM_ScanIterator &rbfm_ScanIterator)
+                                RBFM_ScanIterator &rbfm_ScanIterator,
+                                PageNum startPage,
+                                PageNum endPage)
+{
+    vector<ScanPredicate> predicates;
+    if (compOp != NO_OP)
+        predicates.push_back({conditionAttribute, compOp, value, 0});
+    return rbfm_ScanIterator.scanInit(fileHandle, recordDescriptor, predicates, attributeNames, startPage, endPage);
+}
+
+RC RecordBasedFileManager::scan(FileHandle &fileHandle,
+                                const vector<Attribute> &recordDescriptor,
+                                const vector<ScanPredicate> &predicates,
+                                const vector<string> &attributeNames,
+                                RBFM_ScanIterator &rbfm_ScanIterator,
+                                PageNum startPage,
+                                PageNum endPage)
+{
+    return rbfm_ScanIterator.scanInit(fileHandle, recordDescriptor, predicates, attributeNames, startPage, endPage);
+}
+
+RC RecordBasedFileManager::getPageRanges(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, unsigned count,
+                                         SplitMode mode, vector<PageRange> &ranges)
 {
-    return rbfm_ScanIterator.scanInit(fileHandle, recordDescriptor, conditionAttribute, compOp, value, attributeNames);
+    ranges.clear();
+    unsigned numPages = fileHandle.getNumberOfPages();
+    if (numPages == 0 || count == 0)
+        return SUCCESS;
+    count = min(count, numPages);
+
+    // Records on each page as the zone map counts them, -1 where it has no summary
+    vector<int64_t> weights(numPages, -1);
+    FileHandle *zoneMapFile = getCompanions(fileHandle).zoneMap;
+    unsigned perPage = 0;
+    if (zoneMapFile != NULL)
+        perPage = getZoneMapEntriesPerPage(recordDescriptor.size(), zoneMapFile->getPageSize());
+    if (perPage > 0)
+    {
+        FileHandle &zoneMap = *zoneMapFile;
+        void *zonePage = malloc(zoneMap.getPageSize());
+        if (zonePage == NULL)
+            return RBFM_MALLOC_FAILED;
+        unsigned zoneMapPages = min(zoneMap.getNumberOfPages(), (numPages + perPage - 1) / perPage);
+        for (PageNum zoneMapPageNum = 0; zoneMapPageNum < zoneMapPages; zoneMapPageNum++)
+        {
+            if (zoneMap.readPage(zoneMapPageNum, zonePage))
+            {
+                free(zonePage);
+                return RBFM_READ_FAILED;
+            }
+            for (unsigned i = 0; i < perPage && zoneMapPageNum * perPage + i < numPages; i++)
+            {
+                ZoneMapEntry entry;
+                memcpy(&entry, (char *)zonePage + i * recordDescriptor.size() * sizeof(ZoneMapEntry), sizeof(ZoneMapEntry));
+                if (entry.flags & ZONE_SUMMARIZED)
+                    weights[zoneMapPageNum * perPage + i] = entry.recordCount;
+            }
+        }
+        free(zonePage);
+    }
+
+    int64_t summarized = 0, summarizedRecords = 0;
+    for (int64_t weight : weights)
+        if (weight >= 0)
+        {
+            summarized++;
+            summarizedRecords += weight;
+        }
+    int64_t average = summarized > 0 ? (summarizedRecords + summarized / 2) / summarized : 1;
+    int64_t total = 0;
+    for (int64_t &weight : weights)
+    {
+        if (weight < 0)
+            weight = average;
+        total += weight;
+    }
+
+    // By pages, range i gets pages [i * numPages / count, (i + 1) * numPages / count). By
+    // records, a range ends at the first page that takes it to its share of the total, leaving
+    // at least one page for each of the ranges after it.
+    PageRange range = {0, 0, 0};
+    int64_t cumulative = 0;
+    for (unsigned i = 0; i < count; i++)
+    {
+        range.startPage = range.endPage;
+        range.records = 0;
+        if (mode == SPLIT_BY_PAGES || i == count - 1)
+            range.endPage = (uint64_t)(i + 1) * numPages / count;
+        else
+        {
+            int64_t target = total * (i + 1) / count;
+            range.endPage = range.startPage + 1;
+            cumulative += weights[range.startPage];
+            while (range.endPage < numPages - (count - 1 - i) && cumulative + weights[range.endPage] / 2 < target)
+                cumulative += weights[range.endPage++];
+        }
+        for (PageNum pageNum = range.startPage; pageNum < range.endPage; pageNum++)
+            range.records += weights[pageNum];
+        ranges.push_back(range);
+    }
+    return SUCCESS;
 }
 
 RBFM_ScanIterator::RBFM_ScanIterator()
-    : currPage(0), currSlot(0), totalPage(0), totalSlot(0)
+    : currPage(0), currSlot(0), totalPage(0), selectionSize(0), selected(0), endPage(0), zonePage(NULL), zonePageNum(-1),
+      pagesRead(0), pagesSkipped(0), companions(), storedData(NULL)
 {
     rbfm = RecordBasedFileManager::instance();
 }
@@ -533,61 +1170,123 @@ RBFM_ScanIterator::RBFM_ScanIterator()
 RC RBFM_ScanIterator::close()
 {
     free(pageData);
+    free(zonePage);
+    zonePage = NULL;
+    free(storedData);
+    storedData = NULL;
     return SUCCESS;
 }
 
 // Initialize the scanIterator with all necessary state
 RC RBFM_ScanIterator::scanInit(FileHandle &fh,
                                const vector<Attribute> rd,
-                               const string &ca,
-                               const CompOp co,
-                               const void *v,
-                               const vector<string> &an)
+                               const vector<ScanPredicate> &predicates,
+                               const vector<string> &an,
+                               PageNum startPage,
+                               PageNum endPage)
 {
     // Start at page 0 slot 0
     currPage = 0;
     currSlot = 0;
     totalPage = 0;
-    totalSlot = 0;
-    // Keep a buffer to hold the current page
-    pageData = malloc(PAGE_SIZE);
+    selectionSize = 0;
+    selected = 0;
+    this->endPage = 0;
+    zonePageNum = -1;
+    pagesRead = 0;
+    pagesSkipped = 0;
+    // Keep a buffer to hold the current page, and one for the zone map page that summarizes it
+    pageData = malloc(fh.getPageSize());
+    zonePage = malloc(fh.getPageSize());
 
     // Store the variables passed in to
     fileHandle = fh;
-    conditionAttribute = ca;
-    recordDescriptor = rd;
-    compOp = co;
-    value = v;
+    companions = rbfm->getCompanions(fh);
+    rbfm->getStoredDescriptor(fh, rd, recordDescriptor);
     attributeNames = an;
 
-    skipList.clear();
-
-    // Get total number of pages
-    totalPage = fh.getNumberOfPages();
-    if (totalPage > 0)
+    // Resolve the projected attributes to their positions in the record once for the whole scan
+    projection.clear();
+    for (const string &name : attributeNames)
     {
-        if (fh.readPage(0, pageData))
-            return RBFM_READ_FAILED;
+        auto pred = [&](const Attribute &a) { return a.name == name; };
+        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
+        unsigned index = distance(recordDescriptor.begin(), iterPos);
+        if (index == recordDescriptor.size())
+            return RBFM_NO_SUCH_ATTR;
+        projection.push_back(index);
+    }
+    projectedAttributes.clear();
+    if (companions.dictionary != NULL)
+    {
+        vector<Attribute> storedAttributes;
+        for (unsigned index : projection)
+        {
+            projectedAttributes.push_back(rd[index]);
+            storedAttributes.push_back(recordDescriptor[index]);
+        }
+        storedData = malloc(RecordBasedFileManager::getMaxDataSize(storedAttributes));
     }
-    else
-        return SUCCESS;
-
-    // Get number of slots on first page
-    SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
-    totalSlot = header.recordEntriesNumber;
 
-    // If we don't need to do any comparisons, we can ignore the condition attribute
-    if (co == NO_OP)
-        return SUCCESS;
+    // Find each condition attribute's index in the record descriptor, and put the conditions
+    // in their groups
+    conditions.clear();
+    vector<unsigned> orGroups;
+    vector<bool> alwaysHolds;
+    for (const ScanPredicate &predicate : predicates)
+    {
+        auto pred = [&](const Attribute &a) { return a.name == predicate.attribute; };
+        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
+        ScanCondition condition;
+        condition.attrIndex = distance(recordDescriptor.begin(), iterPos);
+        if (condition.attrIndex == recordDescriptor.size())
+            return RBFM_NO_SUCH_ATTR;
+        condition.compOp = predicate.compOp;
+        condition.value = predicate.value;
+        condition.byCode = false;
+        condition.code = 0;
+        condition.onValues = false;
+
+        // Equality on an encoded attribute compares codes; a value not in the dictionary has
+        // no code, and no record has it
+        unsigned index = condition.attrIndex;
+        if (rd[index].type != recordDescriptor[index].type && predicate.value != NULL && predicate.compOp != NO_OP)
+        {
+            if (predicate.compOp == EQ_OP || predicate.compOp == NE_OP)
+            {
+                uint32_t varcharSize;
+                memcpy(&varcharSize, predicate.value, VARCHAR_LENGTH_SIZE);
+                string v((char *)predicate.value + VARCHAR_LENGTH_SIZE, varcharSize);
+                RC rc = companions.dictionary->getCode(v, false, condition.code);
+                if (rc)
+                    return rc;
+                condition.byCode = true;
+            }
+            else
+                condition.onValues = true;
+        }
 
-    // Else, we need to find the condition attribute's index in the record descriptor
-    auto pred = [&](Attribute a) { return a.name == conditionAttribute; };
-    auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
-    attrIndex = distance(recordDescriptor.begin(), iterPos);
-    if (attrIndex == recordDescriptor.size())
-        return RBFM_NO_SUCH_ATTR;
+        unsigned group = find(orGroups.begin(), orGroups.end(), predicate.orGroup) - orGroups.begin();
+        if (group == orGroups.size())
+        {
+            orGroups.push_back(predicate.orGroup);
+            conditions.push_back(vector<ScanCondition>());
+            alwaysHolds.push_back(false);
+        }
+        conditions[group].push_back(condition);
+        // A group with a condition that always holds does too
+        if (predicate.compOp == NO_OP)
+            alwaysHolds[group] = true;
+    }
+    for (unsigned group = conditions.size(); group-- > 0;)
+        if (alwaysHolds[group])
+            conditions.erase(conditions.begin() + group);
+    if (conditions.size() > 1 || (conditions.size() == 1 && conditions[0].size() > 1))
+        orderConditions();
 
-    return SUCCESS;
+    // Get total number of pages, and the first one of the range unless the zone map rules it out
+    totalPage = fh.getNumberOfPages();
+    return setPageRange(startPage, endPage);
 }
 
 RC RBFM_ScanIterator::getNextRecord(RID &rid, void *data)
@@ -600,181 +1299,521 @@ RC RBFM_ScanIterator::getNextRecord(RID &rid, void *data)
     if (attributeNames.size() == 0)
     {
         rid.pageNum = currPage;
-        rid.slotNum = currSlot++;
+        rid.slotNum = currSlot;
+        selected++;
         return SUCCESS;
     }
 
-    // Prepare null indicator
-    unsigned nullIndicatorSize = rbfm->getNullIndicatorSize(attributeNames.size());
-    char nullIndicator[nullIndicatorSize];
-    memset(nullIndicator, 0, nullIndicatorSize);
-
-    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
-
-    // Unsure how large each attribute will be, set to size of page to be safe
-    void *buffer = malloc(PAGE_SIZE);
-    if (buffer == NULL)
-        return RBFM_MALLOC_FAILED;
-
-    // Keep track of offset into data
-    unsigned dataOffset = nullIndicatorSize;
-
-    for (unsigned i = 0; i < attributeNames.size(); i++)
+    // Copy the projected attributes straight out of the page, decoding any encoded ones
+    if (storedData == NULL)
+        rc = rbfm->getProjectedRecordInSlot(fileHandle, pageData, currSlot, recordDescriptor, projection, data);
+    else
     {
-        // Get index and type of attribute in record
-        auto pred = [&](Attribute a) { return a.name == attributeNames[i]; };
-        auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
-        unsigned index = distance(recordDescriptor.begin(), iterPos);
-        if (index == recordDescriptor.size())
-            return RBFM_NO_SUCH_ATTR;
-        AttrType type = recordDescriptor[index].type;
-
-        // Read attribute into buffer
-        rbfm->getAttributeFromRecord(pageData, recordEntry.offset, index, type, buffer);
-        // Determine if null
-        char null;
-        memcpy(&null, buffer, 1);
-        if (null)
-        {
-            int indicatorIndex = i / CHAR_BIT;
-            char indicatorMask = 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
-            nullIndicator[indicatorIndex] |= indicatorMask;
-        }
-        // Read from buffer into data
-        else if (type == TypeInt)
-        {
-            memcpy((char *)data + dataOffset, (char *)buffer + 1, INT_SIZE);
-            dataOffset += INT_SIZE;
-        }
-        else if (type == TypeReal)
-        {
-            memcpy((char *)data + dataOffset, (char *)buffer + 1, REAL_SIZE);
-            dataOffset += REAL_SIZE;
-        }
-        else if (type == TypeVarChar)
-        {
-            uint32_t varcharSize;
-            memcpy(&varcharSize, (char *)buffer + 1, VARCHAR_LENGTH_SIZE);
-            memcpy((char *)data + dataOffset, &varcharSize, VARCHAR_LENGTH_SIZE);
-            dataOffset += VARCHAR_LENGTH_SIZE;
-            memcpy((char *)data + dataOffset, (char *)buffer + 1 + VARCHAR_LENGTH_SIZE, varcharSize);
-            dataOffset += varcharSize;
-        }
+        rc = rbfm->getProjectedRecordInSlot(fileHandle, pageData, currSlot, recordDescriptor, projection, storedData);
+        if (rc == SUCCESS)
+            rc = rbfm->decodeRecord(fileHandle, projectedAttributes, storedData, data);
     }
-    // Finally set null indicator of data, clean up and return
-    memcpy((char *)data, nullIndicator, nullIndicatorSize);
+    if (rc)
+        return rc;
 
-    free(buffer);
     rid.pageNum = currPage;
-    rid.slotNum = currSlot++;
+    rid.slotNum = currSlot;
+    selected++;
     return SUCCESS;
 }
 
-// Private helper methods ///////////////////////////////////////////////////////////////////
+RC RBFM_ScanIterator::setPageRange(PageNum startPage, PageNum endPage)
+{
+    currPage = startPage;
+    currSlot = 0;
+    selectionSize = 0;
+    selected = 0;
+    this->endPage = min(endPage, totalPage);
 
-RC RBFM_ScanIterator::getNextSlot()
+    // Nothing to scan in an empty range; the next getNextRecord returns EOF
+    if (currPage >= this->endPage)
+        return SUCCESS;
+    return getNextPage();
+}
+
+void RBFM_ScanIterator::getScanStats(unsigned &pagesRead, unsigned &pagesSkipped) const
 {
-    // If we're done with the current page, or we've read the last page
-    if (currSlot >= totalSlot || currPage >= totalPage)
-    {
-        // Reinitialize the current slot and increment page number
-        currSlot = 0;
-        currPage++;
-        // If we're done with last page, return EOF
-        if (currPage >= totalPage)
-            return RBFM_EOF;
-        // Otherwise get next page ready
-        RC rc = getNextPage();
-        if (rc)
-            return rc;
-    }
+    pagesRead = this->pagesRead;
+    pagesSkipped = this->pagesSkipped;
+}
 
-    // Get slot header, check to see if valid and meets scan condition
-    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
+// Private helper methods ///////////////////////////////////////////////////////////////////
 
-    if (rbfm->getSlotStatus(recordEntry) != VALID || !checkScanCondition())
+RC RBFM_ScanIterator::getNextSlot()
+{
+    while (true)
     {
-        // If not, try next slot
-        currSlot++;
-        return getNextSlot();
+        // If we're done with the current page, or we've read the last page
+        if (selected >= selectionSize || currPage >= endPage)
+        {
+            // Increment page number
+            currPage++;
+            // If we're done with last page, return EOF
+            if (currPage >= endPage)
+                return RBFM_EOF;
+            // Otherwise get next page ready
+            RC rc = getNextPage();
+            if (rc)
+                return rc;
+            continue;
+        }
+
+        currSlot = selection[selected];
+        return SUCCESS;
     }
-    return SUCCESS;
 }
 
 RC RBFM_ScanIterator::getNextPage()
 {
+    selectionSize = 0;
+    selected = 0;
+
+    // A page the zone map rules out is treated as having no slots
+    if (canSkipPage(currPage))
+    {
+        pagesSkipped++;
+        return SUCCESS;
+    }
+
     // Read in page
     if (fileHandle.readPage(currPage, pageData))
         return RBFM_READ_FAILED;
+    pagesRead++;
 
-    // Update slot total
-    SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
-    totalSlot = header.recordEntriesNumber;
+    selectSlots();
     return SUCCESS;
 }
 
-bool RBFM_ScanIterator::checkScanCondition()
+// Fills the selection with the live slots of the page that satisfy the conditions. Each group
+// only looks at the slots every group before it left, and each condition of an OR group only
+// at those no condition before it matched.
+void RBFM_ScanIterator::selectSlots()
 {
-    if (compOp == NO_OP)
-        return true;
-    if (value == NULL)
-        return false;
-    Attribute attr = recordDescriptor[attrIndex];
-    // Allocate enough memory to hold attribute and 1 byte null indicator
-    void *data = malloc(1 + attr.length);
-    // Get record entry to get offset
-    SlotDirectoryRecordEntry recordEntry = rbfm->getSlotDirectoryRecordEntry(pageData, currSlot);
-    // Grab the given attribute and store it in data
-    rbfm->getAttributeFromRecord(pageData, recordEntry.offset, attrIndex, attr.type, data);
-
-    char null;
-    memcpy(&null, data, 1);
-
-    bool result = false;
-    if (null)
+    SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
+    unsigned n = header.recordEntriesNumber;
+    if (selection.size() < n)
     {
-        result = false;
+        selection.resize(n);
+        matches.resize(n);
+        candidates.resize(n);
+        groupMatches.resize(n);
     }
-    // Checkscan condition on record data and scan value
-    else if (attr.type == TypeInt)
+
+    // The VALID slots, as getSlotStatus tells them; the directory follows the header at an
+    // aligned offset
+    const SlotDirectoryRecordEntry *entry = (const SlotDirectoryRecordEntry *)((char *)pageData + sizeof(SlotDirectoryHeader));
+    char *match = matches.data();
+    unsigned live = 0;
+    for (unsigned i = 0; i < n; i++)
     {
-        int32_t recordInt;
-        memcpy(&recordInt, (char *)data + 1, INT_SIZE);
-        result = checkScanCondition(recordInt, compOp, value);
+        match[i] = entry[i].offset > 0;
+        live += match[i];
     }
-    else if (attr.type == TypeReal)
+
+    for (unsigned group = 0; group < conditions.size() && live > 0; group++)
     {
-        float recordReal;
-        memcpy(&recordReal, (char *)data + 1, REAL_SIZE);
-        result = checkScanCondition(recordReal, compOp, value);
+        if (conditions[group].size() == 1)
+            filterSlots(conditions[group][0], match, n);
+        else
+        {
+            char *candidate = candidates.data();
+            char *groupMatch = groupMatches.data();
+            memset(groupMatch, 0, n);
+            for (const ScanCondition &condition : conditions[group])
+            {
+                for (unsigned i = 0; i < n; i++)
+                    candidate[i] = match[i] & !groupMatch[i];
+                filterSlots(condition, candidate, n);
+                for (unsigned i = 0; i < n; i++)
+                    groupMatch[i] |= candidate[i];
+            }
+            memcpy(match, groupMatch, n);
+        }
+        live = 0;
+        for (unsigned i = 0; i < n; i++)
+            live += match[i];
     }
-    else if (attr.type == TypeVarChar)
-    {
-        uint32_t varcharSize;
-        memcpy(&varcharSize, (char *)data + 1, VARCHAR_LENGTH_SIZE);
-        char recordString[varcharSize + 1];
-        memcpy(recordString, (char *)data + 1 + VARCHAR_LENGTH_SIZE, varcharSize);
-        recordString[varcharSize] = '\0';
 
-        result = checkScanCondition(recordString, compOp, value);
+    // Every slot is written, and only those matching are kept
+    uint16_t *slots = selection.data();
+    unsigned count = 0;
+    for (unsigned i = 0; i < n; i++)
+    {
+        slots[count] = i;
+        count += match[i];
     }
-    free(data);
-    return result;
+    selectionSize = count;
 }
 
-bool RBFM_ScanIterator::checkScanCondition(int recordInt, CompOp compOp, const void *value)
+// Clears match for the slots that fail the condition. A condition on an int or real is
+// evaluated over the whole page at once by filterColumn; others are checked record by record.
+void RBFM_ScanIterator::filterSlots(const ScanCondition &condition, char *match, unsigned n)
 {
-    int32_t intValue;
-    memcpy(&intValue, value, INT_SIZE);
-
-    switch (compOp)
+    if (condition.value == NULL)
+        memset(match, 0, n);
+    else if (condition.onValues || recordDescriptor[condition.attrIndex].type == TypeVarChar)
     {
-    case EQ_OP:
-        return recordInt == intValue;
-    case LT_OP:
-        return recordInt < intValue;
-    case GT_OP:
-        return recordInt > intValue;
+        for (unsigned i = 0; i < n; i++)
+        {
+            if (!match[i])
+                continue;
+            currSlot = i;
+            match[i] = checkScanCondition(condition);
+        }
+    }
+    else if (recordDescriptor[condition.attrIndex].type == TypeInt)
+        filterColumn<int32_t>(condition, match, n);
+    else
+        filterColumn<float>(condition, match, n);
+}
+
+// Clears match for the slots whose value of the condition attribute is NULL or fails the
+// condition. The values are gathered into an array, on a PAX page with a single copy out of
+// the minipage, and compared in a loop without branches for each operator.
+template <typename T>
+void RBFM_ScanIterator::filterColumn(const ScanCondition &condition, char *match, unsigned n)
+{
+    if (columnValues.size() < n * sizeof(T))
+        columnValues.resize(n * sizeof(T));
+    T *values = (T *)columnValues.data();
+    SlotDirectoryHeader header = rbfm->getSlotDirectoryHeader(pageData);
+    if (header.layout == PAX_LAYOUT)
+    {
+        unsigned bitmapSize = ((header.capacity + 31) / 32) * 4;
+        char *minipage = rbfm->getPaxMinipage(pageData, condition.attrIndex);
+        memcpy(values, minipage + bitmapSize, n * sizeof(T));
+        for (unsigned i = 0; i < n; i++)
+            if (minipage[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - (i % CHAR_BIT))))
+                match[i] = 0;
+    }
+    else
+    {
+        char attribute[1 + sizeof(T)];
+        for (unsigned i = 0; i < n; i++)
+        {
+            if (!match[i])
+                continue;
+            if (rbfm->getAttributeInSlot(fileHandle, pageData, i, recordDescriptor, condition.attrIndex, attribute) || attribute[0])
+                match[i] = 0;
+            else
+                memcpy(&values[i], attribute + 1, sizeof(T));
+        }
+    }
+
+    T constant;
+    memcpy(&constant, getConditionValue(condition), sizeof(T));
+    char *result = match;
+    switch (condition.compOp)
+    {
+    case EQ_OP:
+        for (unsigned i = 0; i < n; i++)
+            result[i] &= values[i] == constant;
+        break;
+    case LT_OP:
+        for (unsigned i = 0; i < n; i++)
+            result[i] &= values[i] < constant;
+        break;
+    case GT_OP:
+        for (unsigned i = 0; i < n; i++)
+            result[i] &= values[i] > constant;
+        break;
+    case LE_OP:
+        for (unsigned i = 0; i < n; i++)
+            result[i] &= values[i] <= constant;
+        break;
+    case GE_OP:
+        for (unsigned i = 0; i < n; i++)
+            result[i] &= values[i] >= constant;
+        break;
+    case NE_OP:
+        for (unsigned i = 0; i < n; i++)
+            result[i] &= values[i] != constant;
+        break;
+    default:
+        break;
+    }
+}
+
+// The value a condition compares the stored values with
+const void *RBFM_ScanIterator::getConditionValue(const ScanCondition &condition)
+{
+    return condition.byCode ? &condition.code : condition.value;
+}
+
+// Orders the groups so that those that reject the most records for what they cost to check
+// come first, and in each OR group the conditions that accept the most for their cost. The
+// selectivity of a condition on an int or real is estimated from the zone map, assuming the
+// values of a page are spread evenly between its minimum and maximum; otherwise System R's
+// defaults are used. Conditions on varchars cost more to check than those on numbers.
+void RBFM_ScanIterator::orderConditions()
+{
+    for (vector<ScanCondition> &group : conditions)
+        for (ScanCondition &condition : group)
+        {
+            AttrType type = recordDescriptor[condition.attrIndex].type;
+            bool numeric = type != TypeVarChar && !condition.onValues;
+            condition.cost = numeric ? 1 : 4;
+            switch (condition.compOp)
+            {
+            case EQ_OP:
+                condition.selectivity = 0.1;
+                break;
+            case NE_OP:
+                condition.selectivity = 0.9;
+                break;
+            default:
+                condition.selectivity = 1.0 / 3;
+                break;
+            }
+            if (condition.value == NULL)
+                condition.selectivity = 0;
+        }
+
+    // Records each condition matches, summed over the pages the zone map summarizes
+    double records = 0;
+    unsigned perPage = 0;
+    if (companions.zoneMap != NULL)
+        perPage = RecordBasedFileManager::getZoneMapEntriesPerPage(recordDescriptor.size(), companions.zoneMap->getPageSize());
+    unsigned numPages = fileHandle.getNumberOfPages();
+    vector<double> matching;
+    for (const vector<ScanCondition> &group : conditions)
+        matching.insert(matching.end(), group.size(), 0);
+    for (PageNum zoneMapPageNum = 0; perPage > 0 && zoneMapPageNum * perPage < numPages; zoneMapPageNum++)
+    {
+        if (!readZoneMapPage(zoneMapPageNum))
+            break;
+        for (unsigned i = 0; i < perPage && zoneMapPageNum * perPage + i < numPages; i++)
+        {
+            const char *summary = (char *)zonePage + i * recordDescriptor.size() * sizeof(ZoneMapEntry);
+            ZoneMapEntry entry;
+            memcpy(&entry, summary, sizeof(ZoneMapEntry));
+            if (!(entry.flags & ZONE_SUMMARIZED))
+                continue;
+            records += entry.recordCount;
+
+            unsigned k = 0;
+            for (const vector<ScanCondition> &group : conditions)
+                for (const ScanCondition &condition : group)
+                {
+                    AttrType type = recordDescriptor[condition.attrIndex].type;
+                    memcpy(&entry, summary + condition.attrIndex * sizeof(ZoneMapEntry), sizeof(ZoneMapEntry));
+                    const void *value = getConditionValue(condition);
+                    if (type == TypeVarChar || condition.onValues || value == NULL)
+                        matching[k] += entry.recordCount * condition.selectivity;
+                    else if (RecordBasedFileManager::zoneMayMatch(entry, type, condition.compOp, value))
+                    {
+                        double low, high, constant;
+                        if (type == TypeInt)
+                        {
+                            int32_t intValue;
+                            memcpy(&intValue, value, INT_SIZE);
+                            low = entry.min.intValue;
+                            high = entry.max.intValue + 1;
+                            constant = intValue;
+                        }
+                        else
+                        {
+                            float realValue;
+                            memcpy(&realValue, value, REAL_SIZE);
+                            low = entry.min.realValue;
+                            high = entry.max.realValue;
+                            constant = realValue;
+                        }
+                        double fraction = condition.selectivity;
+                        if (high > low)
+                        {
+                            double equal = type == TypeInt ? 1 / (high - low) : condition.selectivity;
+                            switch (condition.compOp)
+                            {
+                            case EQ_OP:
+                                fraction = equal;
+                                break;
+                            case NE_OP:
+                                fraction = 1 - equal;
+                                break;
+                            case LT_OP:
+                            case LE_OP:
+                                fraction = (constant - low) / (high - low);
+                                break;
+                            default:
+                                fraction = (high - constant) / (high - low);
+                                break;
+                            }
+                            fraction = min(1.0, max(0.0, fraction));
+                        }
+                        matching[k] += (entry.recordCount - entry.nullCount) * fraction;
+                    }
+                    k++;
+                }
+        }
+    }
+
+    unsigned k = 0;
+    for (vector<ScanCondition> &group : conditions)
+        for (ScanCondition &condition : group)
+        {
+            if (records > 0)
+                condition.selectivity = matching[k] / records;
+            k++;
+        }
+
+    // Most likely to hold for its cost first within a group, so fewer slots are left for the
+    // others to check
+    auto accepts = [](const ScanCondition &a, const ScanCondition &b) {
+        return a.selectivity / a.cost > b.selectivity / b.cost;
+    };
+    for (vector<ScanCondition> &group : conditions)
+        stable_sort(group.begin(), group.end(), accepts);
+
+    // A group holds unless all its conditions fail, and may have all of them checked
+    auto rejects = [](const vector<ScanCondition> &group) {
+        double fails = 1, cost = 0;
+        for (const ScanCondition &condition : group)
+        {
+            fails *= 1 - condition.selectivity;
+            cost += condition.cost;
+        }
+        return fails / cost;
+    };
+    stable_sort(conditions.begin(), conditions.end(),
+                [&](const vector<ScanCondition> &a, const vector<ScanCondition> &b) { return rejects(a) > rejects(b); });
+}
+
+// Reads a page of the zone map into zonePage, unless it is already there
+bool RBFM_ScanIterator::readZoneMapPage(PageNum zoneMapPageNum)
+{
+    if ((int64_t)zoneMapPageNum == zonePageNum)
+        return true;
+    FileHandle &zoneMap = *companions.zoneMap;
+    if (zoneMapPageNum >= zoneMap.getNumberOfPages() || zoneMap.readPage(zoneMapPageNum, zonePage))
+        return false;
+    zonePageNum = zoneMapPageNum;
+    return true;
+}
+
+// A page can be skipped if the zone map rules out every condition of a group
+bool RBFM_ScanIterator::canSkipPage(PageNum pageNum)
+{
+    if (conditions.empty() || companions.zoneMap == NULL)
+        return false;
+    unsigned perPage = RecordBasedFileManager::getZoneMapEntriesPerPage(recordDescriptor.size(), companions.zoneMap->getPageSize());
+    if (perPage == 0 || !readZoneMapPage(pageNum / perPage))
+        return false;
+
+    const char *summary = (char *)zonePage + (pageNum % perPage) * recordDescriptor.size() * sizeof(ZoneMapEntry);
+    for (const vector<ScanCondition> &group : conditions)
+    {
+        bool ruledOut = true;
+        for (const ScanCondition &condition : group)
+        {
+            // A comparison with NULL holds nowhere
+            if (condition.value == NULL)
+                continue;
+            AttrType type = recordDescriptor[condition.attrIndex].type;
+            ZoneMapEntry entry;
+            memcpy(&entry, summary + condition.attrIndex * sizeof(ZoneMapEntry), sizeof(ZoneMapEntry));
+            if (condition.onValues || type == TypeVarChar || !(entry.flags & ZONE_SUMMARIZED)
+                || RecordBasedFileManager::zoneMayMatch(entry, type, condition.compOp, getConditionValue(condition)))
+            {
+                ruledOut = false;
+                break;
+            }
+        }
+        if (ruledOut)
+            return true;
+    }
+    return false;
+}
+
+bool RBFM_ScanIterator::checkScanCondition(const ScanCondition &condition)
+{
+    if (condition.compOp == NO_OP)
+        return true;
+    if (condition.value == NULL)
+        return false;
+    unsigned attrIndex = condition.attrIndex;
+    Attribute attr = recordDescriptor[attrIndex];
+    CompOp compOp = condition.compOp;
+    const void *value = getConditionValue(condition);
+
+    // A value in overflow pages is only read if its prefix does not decide the condition
+    OverflowPointer pointer;
+    pointer.length = 0;
+    const char *prefix;
+    bool result = false;
+    if (attr.type == TypeVarChar && rbfm->getOverflowPrefix(pageData, currSlot, attrIndex, pointer, prefix)
+        && checkPrefixCondition(condition, pointer, prefix, result))
+        return result;
+
+    // Allocate enough memory to hold attribute, its length if a varchar, and 1 byte null indicator
+    void *data = malloc(1 + VARCHAR_LENGTH_SIZE + max(attr.length, pointer.length));
+    // Grab the given attribute and store it in data
+    if (rbfm->getAttributeInSlot(fileHandle, pageData, currSlot, recordDescriptor, attrIndex, data))
+    {
+        free(data);
+        return false;
+    }
+
+    char null;
+    memcpy(&null, data, 1);
+
+    if (null)
+    {
+        result = false;
+    }
+    // Checkscan condition on record data and scan value
+    else if (condition.onValues)
+    {
+        uint32_t code;
+        memcpy(&code, (char *)data + 1, INT_SIZE);
+        string recordString;
+        if (companions.dictionary->getValue(code, recordString) == SUCCESS)
+            result = checkScanCondition((char *)recordString.c_str(), compOp, value);
+    }
+    else if (attr.type == TypeInt)
+    {
+        int32_t recordInt;
+        memcpy(&recordInt, (char *)data + 1, INT_SIZE);
+        result = checkScanCondition(recordInt, compOp, value);
+    }
+    else if (attr.type == TypeReal)
+    {
+        float recordReal;
+        memcpy(&recordReal, (char *)data + 1, REAL_SIZE);
+        result = checkScanCondition(recordReal, compOp, value);
+    }
+    else if (attr.type == TypeVarChar)
+    {
+        uint32_t varcharSize;
+        memcpy(&varcharSize, (char *)data + 1, VARCHAR_LENGTH_SIZE);
+        char recordString[varcharSize + 1];
+        memcpy(recordString, (char *)data + 1 + VARCHAR_LENGTH_SIZE, varcharSize);
+        recordString[varcharSize] = '\0';
+
+        result = checkScanCondition(recordString, compOp, value);
+    }
+    free(data);
+    return result;
+}
+
+bool RBFM_ScanIterator::checkScanCondition(int recordInt, CompOp compOp, const void *value)
+{
+    int32_t intValue;
+    memcpy(&intValue, value, INT_SIZE);
+
+    switch (compOp)
+    {
+    case EQ_OP:
+        return recordInt == intValue;
+    case LT_OP:
+        return recordInt < intValue;
+    case GT_OP:
+        return recordInt > intValue;
     case LE_OP:
         return recordInt <= intValue;
     case GE_OP:
@@ -827,7 +1866,35 @@ bool RBFM_ScanIterator::checkScanCondition(char *recordString, CompOp compOp, co
     valueStr[valueSize] = '\0';
     memcpy(valueStr, (char *)value + VARCHAR_LENGTH_SIZE, valueSize);
 
-    int cmp = strcmp(recordString, valueStr);
+    return compareResult(strcmp(recordString, valueStr), compOp);
+}
+
+// Decides the condition on a varchar kept in overflow pages from the prefix in its record,
+// unless the prefix is also the start of the value compared with
+bool RBFM_ScanIterator::checkPrefixCondition(const ScanCondition &condition, const OverflowPointer &pointer,
+                                             const char *prefix, bool &result)
+{
+    CompOp compOp = condition.compOp;
+    const void *value = condition.value;
+    if (compOp == NO_OP)
+        return false;
+
+    uint32_t valueSize;
+    memcpy(&valueSize, value, VARCHAR_LENGTH_SIZE);
+    int cmp = memcmp(prefix, (char *)value + VARCHAR_LENGTH_SIZE, min(valueSize, (uint32_t)OVERFLOW_PREFIX_SIZE));
+    if (cmp == 0)
+    {
+        if (valueSize >= pointer.length || valueSize > OVERFLOW_PREFIX_SIZE)
+            return false;
+        // The value compared with is a prefix of the record's, which is longer
+        cmp = 1;
+    }
+    result = compareResult(cmp, compOp);
+    return true;
+}
+
+bool RBFM_ScanIterator::compareResult(int cmp, CompOp compOp)
+{
     switch (compOp)
     {
     case EQ_OP:
@@ -848,17 +1915,45 @@ bool RBFM_ScanIterator::checkScanCondition(char *recordString, CompOp compOp, co
     }
 }
 
-// Configures a new record based page, and puts it in "page".
-void RecordBasedFileManager::newRecordBasedPage(void *page)
+// Configures a new record based page, and puts it in "page". The minipages of a PAX_LAYOUT
+// page are only laid out by setupPaxPage, once the record descriptor is known.
+void RecordBasedFileManager::newRecordBasedPage(void *page, PageLayout layout, unsigned pageSize)
 {
-    memset(page, 0, PAGE_SIZE);
+    memset(page, 0, pageSize);
     // Writes the slot directory header.
     SlotDirectoryHeader slotHeader;
-    slotHeader.freeSpaceOffset = PAGE_SIZE;
+    slotHeader.freeSpaceOffset = pageSize;
     slotHeader.recordEntriesNumber = 0;
+    slotHeader.layout = layout;
+    slotHeader.capacity = 0;
+    slotHeader.pageSizeKB = pageSize / 1024;
     setSlotDirectoryHeader(page, slotHeader);
 }
 
+unsigned RecordBasedFileManager::getPageSize(void *page)
+{
+    return getSlotDirectoryHeader(page).pageSizeKB * 1024;
+}
+
+// Whether a record of recordSize bytes on disk (in ROW_LAYOUT) can be inserted into the page
+bool RecordBasedFileManager::recordFitsOnPage(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned recordSize)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    // Accounting also for the size that will be added to the slot directory
+    if (slotHeader.layout != PAX_LAYOUT)
+        return getPageFreeSpaceSize(page) >= sizeof(SlotDirectoryRecordEntry) + recordSize;
+
+    // The first page of a file is created before the record descriptor is known
+    if (slotHeader.capacity == 0)
+    {
+        setupPaxPage(page, recordDescriptor);
+        slotHeader = getSlotDirectoryHeader(page);
+    }
+    if (getOpenSlot(page) >= slotHeader.capacity)
+        return false;
+    return slotHeader.freeSpaceOffset - getPaxHeapStart(page, recordDescriptor.size()) >= getPaxVarCharSize(recordDescriptor, data);
+}
+
 SlotDirectoryHeader RecordBasedFileManager::getSlotDirectoryHeader(void *page)
 {
     // Getting the slot directory header.
@@ -955,7 +2050,24 @@ bool RecordBasedFileManager::fieldIsNull(char *nullIndicator, int i)
     return (nullIndicator[indicatorIndex] & indicatorMask) != 0;
 }
 
-void RecordBasedFileManager::setRecordAtOffset(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data)
+// The end of column i of a record, from the directory of column offsets that follows its null
+// indicator, and whether the column's value is in overflow pages
+static ColumnOffset getColumnEnd(const char *directory, unsigned i, bool &overflowed)
+{
+    ColumnOffset end;
+    memcpy(&end, directory + i * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    overflowed = (end & OVERFLOW_COLUMN) != 0;
+    return end & ~OVERFLOW_COLUMN;
+}
+
+static ColumnOffset getColumnEnd(const char *directory, unsigned i)
+{
+    bool overflowed;
+    return getColumnEnd(directory, i, overflowed);
+}
+
+void RecordBasedFileManager::setRecordAtOffset(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data,
+                                               const vector<bool> &overflowed)
 {
     // Read in the null indicator
     int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
@@ -1016,12 +2128,15 @@ void RecordBasedFileManager::setRecordAtOffset(void *page, unsigned offset, cons
         }
         // Copy offset into record header
         // Offset is relative to the start of the record and points to END of field
-        memcpy(start + header_offset, &rec_offset, sizeof(ColumnOffset));
+        ColumnOffset end = rec_offset;
+        if (i < overflowed.size() && overflowed[i])
+            end |= OVERFLOW_COLUMN;
+        memcpy(start + header_offset, &end, sizeof(ColumnOffset));
         header_offset += sizeof(ColumnOffset);
     }
 }
 
-void RecordBasedFileManager::getRecordAtOffset(void *page, int32_t offset, const vector<Attribute> &recordDescriptor, void *data)
+RC RecordBasedFileManager::getRecordAtOffset(FileHandle &fileHandle, void *page, int32_t offset, const vector<Attribute> &recordDescriptor, void *data)
 {
     // Pointer to start of record
     char *start = (char *)page + offset;
@@ -1064,12 +2179,25 @@ void RecordBasedFileManager::getRecordAtOffset(void *page, int32_t offset, const
             continue;
 
         // Grab pointer to end of this column
-        ColumnOffset endPointer;
-        memcpy(&endPointer, directory_base + i * sizeof(ColumnOffset), sizeof(ColumnOffset));
+        bool overflowed;
+        ColumnOffset endPointer = getColumnEnd(directory_base, i, overflowed);
 
         // rec_offset keeps track of start of column, so end-start = total size
         uint32_t fieldSize = endPointer - rec_offset;
 
+        // A value in overflow pages is read from there
+        if (overflowed)
+        {
+            uint32_t length;
+            RC rc = readOverflowValue(fileHandle, start + rec_offset, (char *)data + data_offset + VARCHAR_LENGTH_SIZE, length);
+            if (rc)
+                return rc;
+            memcpy((char *)data + data_offset, &length, VARCHAR_LENGTH_SIZE);
+            data_offset += VARCHAR_LENGTH_SIZE + length;
+            rec_offset += fieldSize;
+            continue;
+        }
+
         // Special case for varchar, we must give data the size of varchar first
         if (recordDescriptor[i].type == TypeVarChar)
         {
@@ -1081,63 +2209,480 @@ void RecordBasedFileManager::getRecordAtOffset(void *page, int32_t offset, const
         rec_offset += fieldSize;
         data_offset += fieldSize;
     }
+    return SUCCESS;
 }
 
-SlotStatus RecordBasedFileManager::getSlotStatus(SlotDirectoryRecordEntry slot)
+RC RecordBasedFileManager::getProjectedRecordAtOffset(FileHandle &fileHandle, void *page, int32_t offset, const vector<Attribute> &recordDescriptor, const vector<unsigned> &projection, void *data)
 {
-    if (slot.length == 0 && slot.offset == 0)
-        return DEAD;
-    if (slot.offset <= 0)
-        return MOVED;
-    return VALID;
+    // Pointer to start of record
+    char *start = (char *)page + offset;
+
+    // Get number of columns and the null indicator of this record
+    RecordLength len = 0;
+    memcpy(&len, start, sizeof(RecordLength));
+    char *recordNullIndicator = start + sizeof(RecordLength);
+    int recordNullIndicatorSize = getNullIndicatorSize(len);
+
+    // directory_base: points to the start of our directory of indices
+    char *directory_base = start + sizeof(RecordLength) + recordNullIndicatorSize;
+    // Start of the first field's data
+    ColumnOffset data_start = sizeof(RecordLength) + recordNullIndicatorSize + len * sizeof(ColumnOffset);
+
+    int nullIndicatorSize = getNullIndicatorSize(projection.size());
+    char *nullIndicator = (char *)data;
+    memset(nullIndicator, 0, nullIndicatorSize);
+    unsigned data_offset = nullIndicatorSize;
+
+    for (unsigned i = 0; i < projection.size(); i++)
+    {
+        unsigned attrIndex = projection[i];
+        // Fields added to the table after this record was written are null
+        if (attrIndex >= len || fieldIsNull(recordNullIndicator, attrIndex))
+        {
+            nullIndicator[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+            continue;
+        }
+
+        // The directory points to the end of each field; a field starts where the previous one ends
+        bool overflowed;
+        ColumnOffset attrEnd = getColumnEnd(directory_base, attrIndex, overflowed);
+        ColumnOffset attrStart = attrIndex > 0 ? getColumnEnd(directory_base, attrIndex - 1) : data_start;
+        uint32_t fieldSize = attrEnd - attrStart;
+
+        if (overflowed)
+        {
+            uint32_t length;
+            RC rc = readOverflowValue(fileHandle, start + attrStart, (char *)data + data_offset + VARCHAR_LENGTH_SIZE, length);
+            if (rc)
+                return rc;
+            memcpy((char *)data + data_offset, &length, VARCHAR_LENGTH_SIZE);
+            data_offset += VARCHAR_LENGTH_SIZE + length;
+            continue;
+        }
+
+        if (recordDescriptor[attrIndex].type == TypeVarChar)
+        {
+            memcpy((char *)data + data_offset, &fieldSize, VARCHAR_LENGTH_SIZE);
+            data_offset += VARCHAR_LENGTH_SIZE;
+        }
+        memcpy((char *)data + data_offset, start + attrStart, fieldSize);
+        data_offset += fieldSize;
+    }
+    return SUCCESS;
 }
 
-// Get first unused slot in page. Slot is considered unused if dead
-// If not dead slots returns recordEntriesNumber
-unsigned RecordBasedFileManager::getOpenSlot(void *page)
+RC RecordBasedFileManager::getRecordInSlot(FileHandle &fileHandle, void *page, unsigned slot, const vector<Attribute> &recordDescriptor, void *data)
 {
-    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
-    unsigned i;
-    for (i = 0; i < header.recordEntriesNumber; i++)
+    if (getSlotDirectoryHeader(page).layout != PAX_LAYOUT)
+        return getRecordAtOffset(fileHandle, page, getSlotDirectoryRecordEntry(page, slot).offset, recordDescriptor, data);
+
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char *nullIndicator = (char *)data;
+    memset(nullIndicator, 0, nullIndicatorSize);
+    char *out = (char *)data + nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
     {
-        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, i);
-        SlotStatus status = getSlotStatus(recordEntry);
-        if (status == DEAD)
-            return i;
+        unsigned size = getPaxValue(page, slot, i, recordDescriptor[i].type, out);
+        if (size == 0)
+            nullIndicator[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+        out += size;
     }
-    return i;
+    return SUCCESS;
 }
 
-// Mark slot header as dead (all 0s)
-void RecordBasedFileManager::markSlotDeleted(void *page, unsigned i)
+RC RecordBasedFileManager::getProjectedRecordInSlot(FileHandle &fileHandle, void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const vector<unsigned> &projection, void *data)
 {
-    memset(
-        ((char *)page + sizeof(SlotDirectoryHeader) + i * sizeof(SlotDirectoryRecordEntry)),
-        0,
-        sizeof(SlotDirectoryRecordEntry));
+    if (getSlotDirectoryHeader(page).layout != PAX_LAYOUT)
+        return getProjectedRecordAtOffset(fileHandle, page, getSlotDirectoryRecordEntry(page, slot).offset, recordDescriptor, projection, data);
+
+    // Only the minipages of the projected attributes are touched
+    int nullIndicatorSize = getNullIndicatorSize(projection.size());
+    char *nullIndicator = (char *)data;
+    memset(nullIndicator, 0, nullIndicatorSize);
+    char *out = (char *)data + nullIndicatorSize;
+    for (unsigned i = 0; i < projection.size(); i++)
+    {
+        unsigned size = getPaxValue(page, slot, projection[i], recordDescriptor[projection[i]].type, out);
+        if (size == 0)
+            nullIndicator[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
+        out += size;
+    }
+    return SUCCESS;
 }
 
-// Consolidates free space in center of page
-void RecordBasedFileManager::reorganizePage(void *page)
+// Writes the attribute with a one byte null indicator, as getAttributeFromRecord does
+RC RecordBasedFileManager::getAttributeInSlot(FileHandle &fileHandle, void *page, unsigned slot, const vector<Attribute> &recordDescriptor, unsigned attrIndex, void *data)
 {
-    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    if (getSlotDirectoryHeader(page).layout != PAX_LAYOUT)
+        return getAttributeFromRecord(fileHandle, page, getSlotDirectoryRecordEntry(page, slot).offset, attrIndex, recordDescriptor[attrIndex].type, data);
 
-    // Add all live records to vector, keeping track of slot numbers
-    vector<IndexedRecordEntry> liveRecords;
-    for (unsigned i = 0; i < header.recordEntriesNumber; i++)
+    char nullIndicator = 0;
+    if (getPaxValue(page, slot, attrIndex, recordDescriptor[attrIndex].type, (char *)data + 1) == 0)
+        nullIndicator |= 1 << (CHAR_BIT - 1);
+    memcpy(data, &nullIndicator, 1);
+    return SUCCESS;
+}
+
+// Slots of a PAX_LAYOUT page such that the minipages, and a heap large enough for varchars
+// half as long as they may be, fit in a page
+unsigned RecordBasedFileManager::getPaxCapacity(const vector<Attribute> &recordDescriptor, unsigned pageSize)
+{
+    unsigned rowSize = sizeof(SlotDirectoryRecordEntry);
+    for (const Attribute &attr : recordDescriptor)
     {
-        IndexedRecordEntry entry;
-        entry.slotNum = i;
-        entry.recordEntry = getSlotDirectoryRecordEntry(page, i);
-        if (getSlotStatus(entry.recordEntry) == VALID)
-            liveRecords.push_back(entry);
+        // A value or a PaxVarCharEntry, and a bit of the null bitmap rounded up below
+        rowSize += INT_SIZE;
+        if (attr.type == TypeVarChar)
+            rowSize += attr.length / 2;
     }
-    // Sort records by offset, descending
+    unsigned capacity = (pageSize - sizeof(SlotDirectoryHeader)) / rowSize;
+    // Each null bitmap is a whole number of 32 bit words
+    while (capacity > 1
+           && sizeof(SlotDirectoryHeader) + capacity * rowSize + recordDescriptor.size() * ((capacity + 31) / 32) * 4 > pageSize)
+        capacity--;
+    return max(capacity, 1u);
+}
+
+void RecordBasedFileManager::setupPaxPage(void *page, const vector<Attribute> &recordDescriptor)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    slotHeader.capacity = getPaxCapacity(recordDescriptor, getPageSize(page));
+    setSlotDirectoryHeader(page, slotHeader);
+}
+
+// Column i's minipage: its null bitmap, then a value or PaxVarCharEntry for every slot. The
+// minipages follow the slot directory, which has room for every slot.
+char *RecordBasedFileManager::getPaxMinipage(void *page, unsigned column)
+{
+    unsigned capacity = getSlotDirectoryHeader(page).capacity;
+    unsigned minipageSize = ((capacity + 31) / 32) * 4 + capacity * INT_SIZE;
+    return (char *)page + sizeof(SlotDirectoryHeader) + capacity * sizeof(SlotDirectoryRecordEntry) + column * minipageSize;
+}
+
+unsigned RecordBasedFileManager::getPaxHeapStart(void *page, unsigned fieldCount)
+{
+    return getPaxMinipage(page, fieldCount) - (char *)page;
+}
+
+// Bytes of varchar values the record puts in the heap of a PAX_LAYOUT page
+unsigned RecordBasedFileManager::getPaxVarCharSize(const vector<Attribute> &recordDescriptor, const void *data)
+{
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char *nullIndicator = (char *)data;
+    unsigned offset = nullIndicatorSize;
+    unsigned size = 0;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t varcharSize;
+            memcpy(&varcharSize, (char *)data + offset, VARCHAR_LENGTH_SIZE);
+            size += varcharSize;
+            offset += VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+        else
+            offset += INT_SIZE;
+    }
+    return size;
+}
+
+// Stores the record's values in the slot's place of every minipage; the caller made sure its
+// varchars fit in the heap
+void RecordBasedFileManager::setPaxRecord(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    unsigned bitmapSize = ((slotHeader.capacity + 31) / 32) * 4;
+    char *nullIndicator = (char *)data;
+    unsigned offset = getNullIndicatorSize(recordDescriptor.size());
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        char *minipage = getPaxMinipage(page, i);
+        char *value = minipage + bitmapSize + slot * INT_SIZE;
+        unsigned char mask = 1 << (CHAR_BIT - 1 - (slot % CHAR_BIT));
+        if (fieldIsNull(nullIndicator, i))
+        {
+            minipage[slot / CHAR_BIT] |= mask;
+            memset(value, 0, INT_SIZE);
+            continue;
+        }
+        minipage[slot / CHAR_BIT] &= ~mask;
+
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t varcharSize;
+            memcpy(&varcharSize, (char *)data + offset, VARCHAR_LENGTH_SIZE);
+            PaxVarCharEntry entry;
+            entry.length = varcharSize;
+            entry.offset = slotHeader.freeSpaceOffset - varcharSize;
+            memcpy((char *)page + entry.offset, (char *)data + offset + VARCHAR_LENGTH_SIZE, varcharSize);
+            memcpy(value, &entry, sizeof(PaxVarCharEntry));
+            slotHeader.freeSpaceOffset = entry.offset;
+            offset += VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+        else
+        {
+            memcpy(value, (char *)data + offset, INT_SIZE);
+            offset += INT_SIZE;
+        }
+    }
+    setSlotDirectoryHeader(page, slotHeader);
+}
+
+unsigned RecordBasedFileManager::getPaxValue(void *page, unsigned slot, unsigned column, AttrType type, void *data)
+{
+    char *minipage = getPaxMinipage(page, column);
+    if (minipage[slot / CHAR_BIT] & (1 << (CHAR_BIT - 1 - (slot % CHAR_BIT))))
+        return 0;
+    unsigned bitmapSize = ((getSlotDirectoryHeader(page).capacity + 31) / 32) * 4;
+    char *value = minipage + bitmapSize + slot * INT_SIZE;
+    if (type != TypeVarChar)
+    {
+        memcpy(data, value, INT_SIZE);
+        return INT_SIZE;
+    }
+
+    PaxVarCharEntry entry;
+    memcpy(&entry, value, sizeof(PaxVarCharEntry));
+    uint32_t varcharSize = entry.length;
+    memcpy(data, &varcharSize, VARCHAR_LENGTH_SIZE);
+    memcpy((char *)data + VARCHAR_LENGTH_SIZE, (char *)page + entry.offset, varcharSize);
+    return VARCHAR_LENGTH_SIZE + varcharSize;
+}
+
+// Compacts the varchar heap of a PAX_LAYOUT page, dropping the values of slots no longer live
+void RecordBasedFileManager::reorganizePaxPage(void *page, const vector<Attribute> &recordDescriptor)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    unsigned bitmapSize = ((slotHeader.capacity + 31) / 32) * 4;
+
+    // Every live varchar value, by where its entry is
+    vector<pair<PaxVarCharEntry, char *>> values;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (recordDescriptor[i].type != TypeVarChar)
+            continue;
+        char *minipage = getPaxMinipage(page, i);
+        for (unsigned slot = 0; slot < slotHeader.recordEntriesNumber; slot++)
+        {
+            char *value = minipage + bitmapSize + slot * INT_SIZE;
+            if (getSlotStatus(getSlotDirectoryRecordEntry(page, slot)) != VALID)
+            {
+                memset(value, 0, sizeof(PaxVarCharEntry));
+                continue;
+            }
+            if (minipage[slot / CHAR_BIT] & (1 << (CHAR_BIT - 1 - (slot % CHAR_BIT))))
+                continue;
+            PaxVarCharEntry entry;
+            memcpy(&entry, value, sizeof(PaxVarCharEntry));
+            values.push_back(make_pair(entry, value));
+        }
+    }
+
+    // Move each value back filling in any gap preceding it, as reorganizePage does for records
+    auto comp = [](const pair<PaxVarCharEntry, char *> &first, const pair<PaxVarCharEntry, char *> &second) {
+        return first.first.offset > second.first.offset;
+    };
+    sort(values.begin(), values.end(), comp);
+    unsigned pageOffset = getPageSize(page);
+    for (auto &value : values)
+    {
+        PaxVarCharEntry &entry = value.first;
+        pageOffset -= entry.length;
+        memmove((char *)page + pageOffset, (char *)page + entry.offset, entry.length);
+        entry.offset = pageOffset;
+        memcpy(value.second, &entry, sizeof(PaxVarCharEntry));
+    }
+    slotHeader.freeSpaceOffset = pageOffset;
+    setSlotDirectoryHeader(page, slotHeader);
+}
+
+// updateRecord for a live record of a PAX_LAYOUT page, which the caller read into pageData
+bool RecordBasedFileManager::recordFitsInSlot(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    if (slotHeader.layout == PAX_LAYOUT)
+        return slot < slotHeader.capacity
+               && slotHeader.freeSpaceOffset - getPaxHeapStart(page, recordDescriptor.size()) >= getPaxVarCharSize(recordDescriptor, data);
+
+    unsigned needed = getRecordSize(recordDescriptor, data);
+    if (slot == slotHeader.recordEntriesNumber)
+        needed += sizeof(SlotDirectoryRecordEntry);
+    return getPageFreeSpaceSize(page) >= needed;
+}
+
+void RecordBasedFileManager::setRecordInSlot(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data,
+                                             const vector<bool> &overflowed)
+{
+    SlotDirectoryRecordEntry recordEntry;
+    if (getSlotDirectoryHeader(page).layout == PAX_LAYOUT)
+    {
+        // The values go to the minipages; the slot only records that the slot is live
+        setPaxRecord(page, slot, recordDescriptor, data);
+        recordEntry.length = 0;
+        recordEntry.offset = PAX_LIVE_SLOT;
+    }
+    else
+    {
+        SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+        recordEntry.length = getRecordSize(recordDescriptor, data);
+        recordEntry.offset = slotHeader.freeSpaceOffset - recordEntry.length;
+        slotHeader.freeSpaceOffset = recordEntry.offset;
+        setSlotDirectoryHeader(page, slotHeader);
+        setRecordAtOffset(page, recordEntry.offset, recordDescriptor, data, overflowed);
+    }
+    setSlotDirectoryRecordEntry(page, slot, recordEntry);
+
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    if (slot == slotHeader.recordEntriesNumber)
+    {
+        slotHeader.recordEntriesNumber += 1;
+        setSlotDirectoryHeader(page, slotHeader);
+    }
+}
+
+bool RecordBasedFileManager::rewriteRecordInSlot(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data,
+                                                 const vector<bool> &overflowed)
+{
+    SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, slot);
+    bool pax = getSlotDirectoryHeader(page).layout == PAX_LAYOUT;
+    if (!pax)
+    {
+        unsigned recordSize = getRecordSize(recordDescriptor, data);
+        if (recordSize <= recordEntry.length)
+        {
+            setRecordAtOffset(page, recordEntry.offset, recordDescriptor, data, overflowed);
+            if (recordSize < recordEntry.length)
+            {
+                recordEntry.length = recordSize;
+                setSlotDirectoryRecordEntry(page, slot, recordEntry);
+                reorganizePage(page);
+            }
+            return true;
+        }
+    }
+
+    // Drop the old record, and its varchar values on a PAX page, to make room for the new one
+    markSlotDeleted(page, slot);
+    if (pax)
+        reorganizePaxPage(page, recordDescriptor);
+    else
+        reorganizePage(page);
+    if (!recordFitsInSlot(page, slot, recordDescriptor, data))
+        return false;
+    setRecordInSlot(page, slot, recordDescriptor, data, overflowed);
+    return true;
+}
+
+SlotStatus RecordBasedFileManager::getSlotStatus(SlotDirectoryRecordEntry slot)
+{
+    if (slot.length == 0 && slot.offset == 0)
+        return DEAD;
+    if (slot.offset <= 0)
+        return MOVED;
+    return VALID;
+}
+
+// Get first unused slot in page. Slot is considered unused if dead
+// If not dead slots returns recordEntriesNumber
+RID RecordBasedFileManager::getForwardingAddress(SlotDirectoryRecordEntry slot)
+{
+    RID rid;
+    rid.pageNum = slot.length;
+    rid.slotNum = -slot.offset;
+    return rid;
+}
+
+unsigned RecordBasedFileManager::getOpenSlot(void *page)
+{
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+    unsigned i;
+    for (i = 0; i < header.recordEntriesNumber; i++)
+    {
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(page, i);
+        SlotStatus status = getSlotStatus(recordEntry);
+        if (status == DEAD)
+            return i;
+    }
+    return i;
+}
+
+// Mark slot header as dead (all 0s)
+void RecordBasedFileManager::markSlotDeleted(void *page, unsigned i)
+{
+    memset(
+        ((char *)page + sizeof(SlotDirectoryHeader) + i * sizeof(SlotDirectoryRecordEntry)),
+        0,
+        sizeof(SlotDirectoryRecordEntry));
+}
+
+RC RecordBasedFileManager::freeSlot(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid)
+{
+    void *pageData = malloc(fileHandle.getPageSize());
+    if (pageData == NULL)
+        return RBFM_MALLOC_FAILED;
+    if (fileHandle.readPage(rid.pageNum, pageData))
+    {
+        free(pageData);
+        return RBFM_READ_FAILED;
+    }
+    markSlotDeleted(pageData, rid.slotNum);
+    if (getSlotDirectoryHeader(pageData).layout == PAX_LAYOUT)
+        reorganizePaxPage(pageData, recordDescriptor);
+    else
+        reorganizePage(pageData);
+    RC rc = writeDataPage(fileHandle, recordDescriptor, rid.pageNum, pageData);
+    free(pageData);
+    return rc;
+}
+
+RC RecordBasedFileManager::findForwardedRecord(FileHandle &fileHandle, SlotDirectoryRecordEntry recordEntry, void *recordPage, RID &rid,
+                                               vector<RID> &hops)
+{
+    rid = getForwardingAddress(recordEntry);
+    while (true)
+    {
+        if (fileHandle.readPage(rid.pageNum, recordPage))
+            return RBFM_READ_FAILED;
+        if (getSlotDirectoryHeader(recordPage).recordEntriesNumber <= rid.slotNum)
+            return RBFM_SLOT_DN_EXIST;
+        recordEntry = getSlotDirectoryRecordEntry(recordPage, rid.slotNum);
+        switch (getSlotStatus(recordEntry))
+        {
+        case VALID:
+            return SUCCESS;
+        case DEAD:
+            return RBFM_READ_AFTER_DEL;
+        case MOVED:
+            hops.push_back(rid);
+            rid = getForwardingAddress(recordEntry);
+            break;
+        }
+    }
+}
+
+// Consolidates free space in center of page
+void RecordBasedFileManager::reorganizePage(void *page)
+{
+    SlotDirectoryHeader header = getSlotDirectoryHeader(page);
+
+    // Add all live records to vector, keeping track of slot numbers
+    vector<IndexedRecordEntry> liveRecords;
+    for (unsigned i = 0; i < header.recordEntriesNumber; i++)
+    {
+        IndexedRecordEntry entry;
+        entry.slotNum = i;
+        entry.recordEntry = getSlotDirectoryRecordEntry(page, i);
+        if (getSlotStatus(entry.recordEntry) == VALID)
+            liveRecords.push_back(entry);
+    }
+    // Sort records by offset, descending
     auto comp = [](IndexedRecordEntry first, IndexedRecordEntry second) { return first.recordEntry.offset > second.recordEntry.offset; };
     sort(liveRecords.begin(), liveRecords.end(), comp);
 
     // Move each record back filling in any gap preceding the record
-    uint16_t pageOffset = PAGE_SIZE;
+    unsigned pageOffset = getPageSize(page);
     SlotDirectoryRecordEntry current;
     for (unsigned i = 0; i < liveRecords.size(); i++)
     {
@@ -1153,7 +2698,7 @@ void RecordBasedFileManager::reorganizePage(void *page)
     setSlotDirectoryHeader(page, header);
 }
 
-void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type, void *data)
+RC RecordBasedFileManager::getAttributeFromRecord(FileHandle &fileHandle, void *page, unsigned offset, unsigned attrIndex, AttrType type, void *data)
 {
     char *start = (char *)page + offset;
     unsigned data_offset = 0;
@@ -1174,21 +2719,34 @@ void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset,
     memcpy(data, &resultNullIndicator, 1);
     data_offset += 1;
     if (resultNullIndicator)
-        return;
+        return SUCCESS;
 
     // Now we know the result isn't null, so we grab it
     unsigned header_offset = sizeof(RecordLength) + recordNullIndicatorSize;
     // attrEnd points to end of attribute, attrStart points to the beginning
     // Our directory at the beginning of each record contains pointers to the ends of each attribute,
     // so we can pull attrEnd from that
-    ColumnOffset attrEnd, attrStart;
-    memcpy(&attrEnd, (char *)start + header_offset + attrIndex * sizeof(ColumnOffset), sizeof(ColumnOffset));
+    bool overflowed;
+    ColumnOffset attrEnd = getColumnEnd(start + header_offset, attrIndex, overflowed);
     // The start is either the end of the previous attribute, or the start of the data section of the
     // record if we are after the 0th attribute
+    ColumnOffset attrStart;
     if (attrIndex > 0)
-        memcpy(&attrStart, (char *)start + header_offset + (attrIndex - 1) * sizeof(ColumnOffset), sizeof(ColumnOffset));
+        attrStart = getColumnEnd(start + header_offset, attrIndex - 1);
     else
         attrStart = header_offset + n * sizeof(ColumnOffset);
+
+    // A value in overflow pages is read from there
+    if (overflowed)
+    {
+        uint32_t len;
+        RC rc = readOverflowValue(fileHandle, start + attrStart, (char *)data + data_offset + VARCHAR_LENGTH_SIZE, len);
+        if (rc)
+            return rc;
+        memcpy((char *)data + data_offset, &len, VARCHAR_LENGTH_SIZE);
+        return SUCCESS;
+    }
+
     // The length of any attribute is just the difference between its start and end
     uint32_t len = attrEnd - attrStart;
     if (type == TypeVarChar)
@@ -1199,4 +2757,866 @@ void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset,
     }
     // For all types, we then copy the data into the result
     memcpy((char *)data + data_offset, (char *)start + attrStart, len);
+    return SUCCESS;
+}
+
+string RecordBasedFileManager::getZoneMapFileName(const string &fileName)
+{
+    return fileName + ZONE_MAP_EXTENSION;
+}
+
+// Number of data pages a zone map page summarizes; 0 if a single page's summary does not fit
+unsigned RecordBasedFileManager::getZoneMapEntriesPerPage(unsigned fieldCount, unsigned pageSize)
+{
+    if (fieldCount == 0)
+        return 0;
+    return pageSize / (fieldCount * sizeof(ZoneMapEntry));
+}
+
+RC RecordBasedFileManager::writeDataPage(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *pageData)
+{
+    RC rc = fileHandle.writePage(pageNum, pageData);
+    if (rc)
+        return rc;
+    return updateZoneMap(fileHandle, recordDescriptor, pageNum, pageData);
+}
+
+RC RecordBasedFileManager::appendDataPage(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, void *pageData)
+{
+    RC rc = fileHandle.appendPage(pageData);
+    if (rc)
+        return rc;
+    return updateZoneMap(fileHandle, recordDescriptor, fileHandle.getNumberOfPages() - 1, pageData);
+}
+
+// Recomputes the summary of a data page from its records and stores it if it changed. Since
+// the whole page is summarized again, the summary stays exact when records are deleted.
+RC RecordBasedFileManager::updateZoneMap(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *pageData)
+{
+    FileHandle *zoneMapFile = getCompanions(fileHandle).zoneMap;
+    if (zoneMapFile == NULL)
+        return SUCCESS;
+    FileHandle &zoneMap = *zoneMapFile;
+    unsigned perPage = getZoneMapEntriesPerPage(recordDescriptor.size(), zoneMap.getPageSize());
+    if (perPage == 0)
+        return SUCCESS;
+
+    unsigned summarySize = recordDescriptor.size() * sizeof(ZoneMapEntry);
+    ZoneMapEntry summary[recordDescriptor.size()];
+    summarizePage(recordDescriptor, pageData, summary);
+
+    PageNum zoneMapPageNum = pageNum / perPage;
+    unsigned summaryOffset = (pageNum % perPage) * summarySize;
+    void *zonePage = malloc(zoneMap.getPageSize());
+    if (zonePage == NULL)
+        return RBFM_MALLOC_FAILED;
+
+    RC rc = SUCCESS;
+    unsigned zoneMapPages = zoneMap.getNumberOfPages();
+    if (zoneMapPageNum < zoneMapPages)
+    {
+        if (zoneMap.readPage(zoneMapPageNum, zonePage))
+            rc = RBFM_READ_FAILED;
+        else if (memcmp((char *)zonePage + summaryOffset, summary, summarySize) != 0)
+        {
+            memcpy((char *)zonePage + summaryOffset, summary, summarySize);
+            if (zoneMap.writePage(zoneMapPageNum, zonePage))
+                rc = RBFM_WRITE_FAILED;
+        }
+    }
+    else
+    {
+        // Pages in between, if any, summarize nothing yet
+        memset(zonePage, 0, zoneMap.getPageSize());
+        for (; zoneMapPages < zoneMapPageNum && rc == SUCCESS; zoneMapPages++)
+            if (zoneMap.appendPage(zonePage))
+                rc = RBFM_APPEND_FAILED;
+        memcpy((char *)zonePage + summaryOffset, summary, summarySize);
+        if (rc == SUCCESS && zoneMap.appendPage(zonePage))
+            rc = RBFM_APPEND_FAILED;
+    }
+    free(zonePage);
+    return rc;
+}
+
+void RecordBasedFileManager::summarizePage(const vector<Attribute> &recordDescriptor, void *pageData, ZoneMapEntry *entries)
+{
+    unsigned fieldCount = recordDescriptor.size();
+    memset(entries, 0, fieldCount * sizeof(ZoneMapEntry));
+    for (unsigned i = 0; i < fieldCount; i++)
+        entries[i].flags = ZONE_SUMMARIZED;
+
+    SlotDirectoryHeader header = getSlotDirectoryHeader(pageData);
+    uint16_t recordCount = 0;
+    for (unsigned slot = 0; slot < header.recordEntriesNumber; slot++)
+        if (getSlotStatus(getSlotDirectoryRecordEntry(pageData, slot)) == VALID)
+            recordCount++;
+    for (unsigned i = 0; i < fieldCount; i++)
+        entries[i].recordCount = recordCount;
+
+    if (header.layout == PAX_LAYOUT)
+    {
+        summarizePaxPage(recordDescriptor, pageData, entries);
+        return;
+    }
+    for (unsigned slot = 0; slot < header.recordEntriesNumber; slot++)
+    {
+        SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, slot);
+        if (getSlotStatus(recordEntry) != VALID)
+            continue;
+
+        char *start = (char *)pageData + recordEntry.offset;
+        RecordLength n;
+        memcpy(&n, start, sizeof(RecordLength));
+        char *nullIndicator = start + sizeof(RecordLength);
+        unsigned headerOffset = sizeof(RecordLength) + getNullIndicatorSize(n);
+
+        for (unsigned i = 0; i < fieldCount; i++)
+        {
+            // Fields past the end of the record count as NULL
+            if (i >= n || fieldIsNull(nullIndicator, i))
+            {
+                entries[i].nullCount++;
+                continue;
+            }
+            if (recordDescriptor[i].type == TypeVarChar)
+                continue;
+
+            ColumnOffset attrStart;
+            if (i > 0)
+                attrStart = getColumnEnd(start + headerOffset, i - 1);
+            else
+                attrStart = headerOffset + n * sizeof(ColumnOffset);
+
+            addToZoneMapEntry(entries[i], recordDescriptor[i].type, start + attrStart);
+        }
+    }
+}
+
+// summarizePage for a PAX_LAYOUT page, one minipage at a time
+void RecordBasedFileManager::summarizePaxPage(const vector<Attribute> &recordDescriptor, void *pageData, ZoneMapEntry *entries)
+{
+    SlotDirectoryHeader header = getSlotDirectoryHeader(pageData);
+    unsigned bitmapSize = ((header.capacity + 31) / 32) * 4;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        char *minipage = getPaxMinipage(pageData, i);
+        for (unsigned slot = 0; slot < header.recordEntriesNumber; slot++)
+        {
+            if (getSlotStatus(getSlotDirectoryRecordEntry(pageData, slot)) != VALID)
+                continue;
+            if (minipage[slot / CHAR_BIT] & (1 << (CHAR_BIT - 1 - (slot % CHAR_BIT))))
+                entries[i].nullCount++;
+            else if (recordDescriptor[i].type != TypeVarChar)
+                addToZoneMapEntry(entries[i], recordDescriptor[i].type, minipage + bitmapSize + slot * INT_SIZE);
+        }
+    }
+}
+
+// Widens the summary of an int or real column to include value
+void RecordBasedFileManager::addToZoneMapEntry(ZoneMapEntry &entry, AttrType type, const void *value)
+{
+    bool first = !(entry.flags & ZONE_HAS_VALUES);
+    entry.flags |= ZONE_HAS_VALUES;
+    if (type == TypeInt)
+    {
+        int32_t intValue;
+        memcpy(&intValue, value, INT_SIZE);
+        if (first || intValue < entry.min.intValue)
+            entry.min.intValue = intValue;
+        if (first || intValue > entry.max.intValue)
+            entry.max.intValue = intValue;
+    }
+    else
+    {
+        float realValue;
+        memcpy(&realValue, value, REAL_SIZE);
+        if (first || realValue < entry.min.realValue)
+            entry.min.realValue = realValue;
+        if (first || realValue > entry.max.realValue)
+            entry.max.realValue = realValue;
+    }
+}
+
+// Whether some value in [min, max] may satisfy "value compOp v"
+template <typename T>
+static bool rangeMayMatch(T min, T max, CompOp compOp, T v)
+{
+    switch (compOp)
+    {
+    case EQ_OP:
+        return min <= v && v <= max;
+    case LT_OP:
+        return min < v;
+    case LE_OP:
+        return min <= v;
+    case GT_OP:
+        return max > v;
+    case GE_OP:
+        return max >= v;
+    case NE_OP:
+        return !(min == v && max == v);
+    default:
+        return true;
+    }
+}
+
+bool RecordBasedFileManager::zoneMayMatch(const ZoneMapEntry &entry, AttrType type, CompOp compOp, const void *value)
+{
+    // Only NULLs on the page, which no comparison accepts
+    if (!(entry.flags & ZONE_HAS_VALUES))
+        return false;
+    if (type == TypeInt)
+    {
+        int32_t intValue;
+        memcpy(&intValue, value, INT_SIZE);
+        return rangeMayMatch(entry.min.intValue, entry.max.intValue, compOp, intValue);
+    }
+    if (type == TypeReal)
+    {
+        float realValue;
+        memcpy(&realValue, value, REAL_SIZE);
+        return rangeMayMatch(entry.min.realValue, entry.max.realValue, compOp, realValue);
+    }
+    return true;
+}
+
+string RecordBasedFileManager::getDictionaryFileName(const string &fileName)
+{
+    return fileName + DICTIONARY_EXTENSION;
+}
+
+void RecordBasedFileManager::getStoredDescriptor(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, vector<Attribute> &storedDescriptor)
+{
+    storedDescriptor = recordDescriptor;
+    VarCharDictionary *dictionary = getCompanions(fileHandle).dictionary;
+    if (dictionary == NULL)
+        return;
+    for (Attribute &attr : storedDescriptor)
+    {
+        if (attr.type == TypeVarChar && dictionary->isEncoded(attr.name))
+        {
+            attr.type = TypeInt;
+            attr.length = INT_SIZE;
+        }
+    }
+}
+
+RC RecordBasedFileManager::encodeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, void *stored)
+{
+    VarCharDictionary *dictionary = getCompanions(fileHandle).dictionary;
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char *nullIndicator = (char *)data;
+    memcpy(stored, data, nullIndicatorSize);
+    const char *in = (char *)data + nullIndicatorSize;
+    char *out = (char *)stored + nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        if (recordDescriptor[i].type != TypeVarChar)
+        {
+            memcpy(out, in, INT_SIZE);
+            in += INT_SIZE;
+            out += INT_SIZE;
+            continue;
+        }
+
+        uint32_t varcharSize;
+        memcpy(&varcharSize, in, VARCHAR_LENGTH_SIZE);
+        if (dictionary->isEncoded(recordDescriptor[i].name))
+        {
+            uint32_t code;
+            RC rc = dictionary->getCode(string(in + VARCHAR_LENGTH_SIZE, varcharSize), true, code);
+            if (rc)
+                return rc;
+            memcpy(out, &code, INT_SIZE);
+            out += INT_SIZE;
+        }
+        else
+        {
+            memcpy(out, in, VARCHAR_LENGTH_SIZE + varcharSize);
+            out += VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+        in += VARCHAR_LENGTH_SIZE + varcharSize;
+    }
+    return SUCCESS;
+}
+
+RC RecordBasedFileManager::decodeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *stored, void *data)
+{
+    VarCharDictionary *dictionary = getCompanions(fileHandle).dictionary;
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char *nullIndicator = (char *)stored;
+    memcpy(data, stored, nullIndicatorSize);
+    const char *in = (char *)stored + nullIndicatorSize;
+    char *out = (char *)data + nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        if (recordDescriptor[i].type != TypeVarChar)
+        {
+            memcpy(out, in, INT_SIZE);
+            in += INT_SIZE;
+            out += INT_SIZE;
+            continue;
+        }
+
+        if (dictionary->isEncoded(recordDescriptor[i].name))
+        {
+            uint32_t code;
+            memcpy(&code, in, INT_SIZE);
+            in += INT_SIZE;
+            string value;
+            RC rc = dictionary->getValue(code, value);
+            if (rc)
+                return rc;
+            uint32_t varcharSize = value.size();
+            memcpy(out, &varcharSize, VARCHAR_LENGTH_SIZE);
+            memcpy(out + VARCHAR_LENGTH_SIZE, value.data(), varcharSize);
+            out += VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+        else
+        {
+            uint32_t varcharSize;
+            memcpy(&varcharSize, in, VARCHAR_LENGTH_SIZE);
+            memcpy(out, in, VARCHAR_LENGTH_SIZE + varcharSize);
+            in += VARCHAR_LENGTH_SIZE + varcharSize;
+            out += VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+    }
+    return SUCCESS;
+}
+
+unsigned RecordBasedFileManager::getDataSize(const vector<Attribute> &recordDescriptor, const void *data)
+{
+    int nullIndicatorSize = getNullIndicatorSize(recordDescriptor.size());
+    char *nullIndicator = (char *)data;
+    unsigned size = nullIndicatorSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t varcharSize;
+            memcpy(&varcharSize, (char *)data + size, VARCHAR_LENGTH_SIZE);
+            size += VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+        else
+            size += INT_SIZE;
+    }
+    return size;
+}
+
+unsigned RecordBasedFileManager::getMaxDataSize(const vector<Attribute> &recordDescriptor)
+{
+    unsigned size = getNullIndicatorSize(recordDescriptor.size());
+    for (const Attribute &attr : recordDescriptor)
+        size += attr.type == TypeVarChar ? VARCHAR_LENGTH_SIZE + attr.length : INT_SIZE;
+    return size;
+}
+
+string RecordBasedFileManager::getOverflowFileName(const string &fileName)
+{
+    return fileName + OVERFLOW_EXTENSION;
+}
+
+RC RecordBasedFileManager::createOverflowFile(const string &fileName, unsigned pageSize)
+{
+    if (_pf_manager->createFile(fileName, false, pageSize))
+        return RBFM_CREATE_FAILED;
+
+    // Page 0, with an empty list of free pages
+    void *page = calloc(pageSize, 1);
+    if (page == NULL)
+        return RBFM_MALLOC_FAILED;
+    OverflowPageHeader freeList;
+    freeList.nextPage = OVERFLOW_NO_PAGE;
+    freeList.length = 0;
+    memcpy(page, &freeList, sizeof(OverflowPageHeader));
+
+    FileHandle handle;
+    RC rc = _pf_manager->openFile(fileName, handle) ? RBFM_OPEN_FAILED : SUCCESS;
+    if (rc == SUCCESS)
+    {
+        if (handle.appendPage(page))
+            rc = RBFM_APPEND_FAILED;
+        _pf_manager->closeFile(handle);
+    }
+    free(page);
+    return rc;
+}
+
+RC RecordBasedFileManager::storeOverflowValues(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data,
+                                               void *&inlined, vector<bool> &overflowed)
+{
+    inlined = NULL;
+    overflowed.clear();
+    unsigned pageSize = fileHandle.getPageSize();
+    unsigned recordSize = getRecordSize(recordDescriptor, data);
+    FileHandle *overflowFile = getCompanions(fileHandle).overflow;
+    if (overflowFile == NULL || recordSize <= pageSize / 4)
+        return SUCCESS;
+
+    // The varchar values that take more room than a pointer and prefix would, longest first
+    const unsigned inlineSize = sizeof(OverflowPointer) + OVERFLOW_PREFIX_SIZE;
+    char *nullIndicator = (char *)data;
+    unsigned offset = getNullIndicatorSize(recordDescriptor.size());
+    vector<pair<uint32_t, unsigned>> candidates;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        if (recordDescriptor[i].type != TypeVarChar)
+        {
+            offset += INT_SIZE;
+            continue;
+        }
+        uint32_t varcharSize;
+        memcpy(&varcharSize, (char *)data + offset, VARCHAR_LENGTH_SIZE);
+        if (varcharSize > inlineSize)
+            candidates.push_back(make_pair(varcharSize, i));
+        offset += VARCHAR_LENGTH_SIZE + varcharSize;
+    }
+    sort(candidates.begin(), candidates.end(), greater<pair<uint32_t, unsigned>>());
+
+    unsigned moved = 0;
+    for (; moved < candidates.size() && recordSize > pageSize / 4; moved++)
+        recordSize -= candidates[moved].first - inlineSize;
+    // Whether a record that moves nothing fits is up to placeRecord; one that does must also
+    // keep its column offsets below OVERFLOW_COLUMN
+    if (moved == 0)
+        return SUCCESS;
+    if (recordSize + sizeof(SlotDirectoryHeader) + sizeof(SlotDirectoryRecordEntry) > pageSize || recordSize >= OVERFLOW_COLUMN)
+        return RBFM_RECORD_TOO_LARGE;
+    overflowed.assign(recordDescriptor.size(), false);
+    for (unsigned i = 0; i < moved; i++)
+        overflowed[candidates[i].second] = true;
+
+    // Copy the record, writing out each long value and keeping its pointer and prefix
+    inlined = malloc(getDataSize(recordDescriptor, data));
+    if (inlined == NULL)
+        return RBFM_MALLOC_FAILED;
+    offset = getNullIndicatorSize(recordDescriptor.size());
+    memcpy(inlined, data, offset);
+    unsigned inlinedOffset = offset;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        if (fieldIsNull(nullIndicator, i))
+            continue;
+        unsigned size = INT_SIZE;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t varcharSize;
+            memcpy(&varcharSize, (char *)data + offset, VARCHAR_LENGTH_SIZE);
+            size = VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+        if (!overflowed[i])
+        {
+            memcpy((char *)inlined + inlinedOffset, (char *)data + offset, size);
+            inlinedOffset += size;
+            offset += size;
+            continue;
+        }
+
+        const char *value = (char *)data + offset + VARCHAR_LENGTH_SIZE;
+        OverflowPointer pointer;
+        pointer.length = size - VARCHAR_LENGTH_SIZE;
+        RC rc = writeOverflowChain(*overflowFile, value + OVERFLOW_PREFIX_SIZE, pointer.length - OVERFLOW_PREFIX_SIZE,
+                                   pointer.firstPage);
+        if (rc)
+        {
+            free(inlined);
+            inlined = NULL;
+            overflowed.clear();
+            return rc;
+        }
+        char *out = (char *)inlined + inlinedOffset;
+        uint32_t varcharSize = inlineSize;
+        memcpy(out, &varcharSize, VARCHAR_LENGTH_SIZE);
+        memcpy(out + VARCHAR_LENGTH_SIZE, &pointer, sizeof(OverflowPointer));
+        memcpy(out + VARCHAR_LENGTH_SIZE + sizeof(OverflowPointer), value, OVERFLOW_PREFIX_SIZE);
+        inlinedOffset += VARCHAR_LENGTH_SIZE + inlineSize;
+        offset += size;
+    }
+    return SUCCESS;
+}
+
+// Writes length bytes to a new chain of pages, taking free pages before adding new ones
+RC RecordBasedFileManager::writeOverflowChain(FileHandle &overflow, const char *bytes, uint32_t length, PageNum &firstPage)
+{
+    unsigned pageSize = overflow.getPageSize();
+    unsigned perPage = pageSize - sizeof(OverflowPageHeader);
+    unsigned numPages = (length + perPage - 1) / perPage;
+    char *page = (char *)malloc(pageSize);
+    if (page == NULL)
+        return RBFM_MALLOC_FAILED;
+    if (overflow.readPage(0, page))
+    {
+        free(page);
+        return RBFM_READ_FAILED;
+    }
+    OverflowPageHeader freeList;
+    memcpy(&freeList, page, sizeof(OverflowPageHeader));
+
+    // Free pages come first in the chain, so the new ones are appended in order
+    PageNum firstNewPage = overflow.getNumberOfPages();
+    vector<PageNum> pages;
+    while (pages.size() < numPages && freeList.nextPage != OVERFLOW_NO_PAGE)
+    {
+        pages.push_back(freeList.nextPage);
+        OverflowPageHeader header;
+        if (overflow.readPage(freeList.nextPage, page))
+        {
+            free(page);
+            return RBFM_READ_FAILED;
+        }
+        memcpy(&header, page, sizeof(OverflowPageHeader));
+        freeList.nextPage = header.nextPage;
+    }
+    if (!pages.empty())
+    {
+        memset(page, 0, pageSize);
+        memcpy(page, &freeList, sizeof(OverflowPageHeader));
+        if (overflow.writePage(0, page))
+        {
+            free(page);
+            return RBFM_WRITE_FAILED;
+        }
+    }
+    for (PageNum pageNum = firstNewPage; pages.size() < numPages; pageNum++)
+        pages.push_back(pageNum);
+
+    for (unsigned i = 0; i < numPages; i++)
+    {
+        OverflowPageHeader header;
+        header.nextPage = i + 1 < numPages ? pages[i + 1] : OVERFLOW_NO_PAGE;
+        header.length = min(perPage, length - i * perPage);
+        memset(page, 0, pageSize);
+        memcpy(page, &header, sizeof(OverflowPageHeader));
+        memcpy(page + sizeof(OverflowPageHeader), bytes + i * perPage, header.length);
+        RC rc = pages[i] < firstNewPage ? overflow.writePage(pages[i], page) : overflow.appendPage(page);
+        if (rc)
+        {
+            free(page);
+            return RBFM_WRITE_FAILED;
+        }
+    }
+    free(page);
+    firstPage = numPages > 0 ? pages[0] : OVERFLOW_NO_PAGE;
+    return SUCCESS;
+}
+
+// Puts a chain of pages at the head of the list of free pages
+RC RecordBasedFileManager::freeOverflowChain(FileHandle &overflow, PageNum firstPage)
+{
+    if (firstPage == OVERFLOW_NO_PAGE)
+        return SUCCESS;
+    char *page = (char *)malloc(overflow.getPageSize());
+    if (page == NULL)
+        return RBFM_MALLOC_FAILED;
+    if (overflow.readPage(0, page))
+    {
+        free(page);
+        return RBFM_READ_FAILED;
+    }
+    OverflowPageHeader freeList;
+    memcpy(&freeList, page, sizeof(OverflowPageHeader));
+
+    // The last page of the chain is linked to the pages already free
+    PageNum pageNum = firstPage;
+    OverflowPageHeader header;
+    RC rc = SUCCESS;
+    while (rc == SUCCESS)
+    {
+        if (overflow.readPage(pageNum, page))
+        {
+            rc = RBFM_READ_FAILED;
+            break;
+        }
+        memcpy(&header, page, sizeof(OverflowPageHeader));
+        if (header.nextPage == OVERFLOW_NO_PAGE)
+        {
+            header.nextPage = freeList.nextPage;
+            memcpy(page, &header, sizeof(OverflowPageHeader));
+            if (overflow.writePage(pageNum, page))
+                rc = RBFM_WRITE_FAILED;
+            break;
+        }
+        pageNum = header.nextPage;
+    }
+
+    if (rc == SUCCESS)
+    {
+        freeList.nextPage = firstPage;
+        if (overflow.readPage(0, page))
+            rc = RBFM_READ_FAILED;
+        else
+        {
+            memcpy(page, &freeList, sizeof(OverflowPageHeader));
+            if (overflow.writePage(0, page))
+                rc = RBFM_WRITE_FAILED;
+        }
+    }
+    free(page);
+    return rc;
+}
+
+RC RecordBasedFileManager::readOverflowValue(FileHandle &fileHandle, const char *field, void *value, uint32_t &length)
+{
+    OverflowPointer pointer;
+    memcpy(&pointer, field, sizeof(OverflowPointer));
+    length = pointer.length;
+    memcpy(value, field + sizeof(OverflowPointer), OVERFLOW_PREFIX_SIZE);
+    FileHandle *overflowFile = getCompanions(fileHandle).overflow;
+    if (overflowFile == NULL)
+        return RBFM_READ_FAILED;
+
+    FileHandle &overflow = *overflowFile;
+    char *page = (char *)malloc(overflow.getPageSize());
+    if (page == NULL)
+        return RBFM_MALLOC_FAILED;
+    uint32_t copied = OVERFLOW_PREFIX_SIZE;
+    PageNum pageNum = pointer.firstPage;
+    while (copied < length && pageNum != OVERFLOW_NO_PAGE)
+    {
+        OverflowPageHeader header;
+        if (overflow.readPage(pageNum, page))
+            break;
+        memcpy(&header, page, sizeof(OverflowPageHeader));
+        if (header.length > length - copied)
+            break;
+        memcpy((char *)value + copied, page + sizeof(OverflowPageHeader), header.length);
+        copied += header.length;
+        pageNum = header.nextPage;
+    }
+    free(page);
+    return copied == length ? SUCCESS : RBFM_READ_FAILED;
+}
+
+RC RecordBasedFileManager::freeOverflowValues(FileHandle &fileHandle, void *page, int32_t offset)
+{
+    FileHandle *overflowFile = getCompanions(fileHandle).overflow;
+    if (overflowFile == NULL)
+        return SUCCESS;
+
+    char *start = (char *)page + offset;
+    RecordLength n;
+    memcpy(&n, start, sizeof(RecordLength));
+    char *nullIndicator = start + sizeof(RecordLength);
+    unsigned headerOffset = sizeof(RecordLength) + getNullIndicatorSize(n);
+    for (unsigned i = 0; i < n; i++)
+    {
+        bool overflowed;
+        getColumnEnd(start + headerOffset, i, overflowed);
+        if (fieldIsNull(nullIndicator, i) || !overflowed)
+            continue;
+        unsigned attrStart = i > 0 ? getColumnEnd(start + headerOffset, i - 1) : headerOffset + n * sizeof(ColumnOffset);
+        OverflowPointer pointer;
+        memcpy(&pointer, start + attrStart, sizeof(OverflowPointer));
+        RC rc = freeOverflowChain(*overflowFile, pointer.firstPage);
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
+bool RecordBasedFileManager::getOverflowPrefix(void *page, unsigned slot, unsigned attrIndex, OverflowPointer &pointer, const char *&prefix)
+{
+    if (getSlotDirectoryHeader(page).layout == PAX_LAYOUT)
+        return false;
+    char *start = (char *)page + getSlotDirectoryRecordEntry(page, slot).offset;
+    RecordLength n;
+    memcpy(&n, start, sizeof(RecordLength));
+    if (attrIndex >= n || fieldIsNull(start + sizeof(RecordLength), attrIndex))
+        return false;
+
+    unsigned headerOffset = sizeof(RecordLength) + getNullIndicatorSize(n);
+    bool overflowed;
+    getColumnEnd(start + headerOffset, attrIndex, overflowed);
+    if (!overflowed)
+        return false;
+    unsigned attrStart = attrIndex > 0 ? getColumnEnd(start + headerOffset, attrIndex - 1) : headerOffset + n * sizeof(ColumnOffset);
+    memcpy(&pointer, start + attrStart, sizeof(OverflowPointer));
+    prefix = start + attrStart + sizeof(OverflowPointer);
+    return true;
+}
+
+VarCharDictionary::VarCharDictionary(FileHandle *file)
+    : file(file), nextPage(1), nextEntry(0)
+{
+}
+
+VarCharDictionary::~VarCharDictionary()
+{
+    PagedFileManager::instance()->closeFile(*file);
+    delete file;
+}
+
+RC VarCharDictionary::createFile(const string &fileName, const vector<string> &attrNames)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    if (pfm->createFile(fileName))
+        return RBFM_CREATE_FAILED;
+
+    // Page 0: the number of encoded attributes, then the length and name of each
+    char page[PAGE_SIZE];
+    memset(page, 0, PAGE_SIZE);
+    uint16_t count = attrNames.size();
+    memcpy(page, &count, sizeof(uint16_t));
+    unsigned offset = sizeof(uint16_t);
+    for (const string &name : attrNames)
+    {
+        uint16_t length = name.size();
+        if (offset + sizeof(uint16_t) + length > PAGE_SIZE)
+            return RBFM_CREATE_FAILED;
+        memcpy(page + offset, &length, sizeof(uint16_t));
+        memcpy(page + offset + sizeof(uint16_t), name.data(), length);
+        offset += sizeof(uint16_t) + length;
+    }
+
+    FileHandle handle;
+    if (pfm->openFile(fileName, handle))
+        return RBFM_OPEN_FAILED;
+    RC rc = handle.appendPage(page) ? RBFM_APPEND_FAILED : SUCCESS;
+    pfm->closeFile(handle);
+    return rc;
+}
+
+RC VarCharDictionary::load()
+{
+    char page[PAGE_SIZE];
+    if (file->readPage(0, page))
+        return RBFM_READ_FAILED;
+    uint16_t count;
+    memcpy(&count, page, sizeof(uint16_t));
+    unsigned offset = sizeof(uint16_t);
+    attrNames.clear();
+    for (unsigned i = 0; i < count; i++)
+    {
+        uint16_t length;
+        memcpy(&length, page + offset, sizeof(uint16_t));
+        attrNames.push_back(string(page + offset + sizeof(uint16_t), length));
+        offset += sizeof(uint16_t) + length;
+    }
+    return readNewValues();
+}
+
+bool VarCharDictionary::isEncoded(const string &attrName) const
+{
+    for (const string &name : attrNames)
+        if (name == attrName)
+            return true;
+    return false;
+}
+
+RC VarCharDictionary::getCode(const string &value, bool add, uint32_t &code)
+{
+    auto found = codes.find(value);
+    if (found == codes.end())
+    {
+        // Another handle may have added it
+        RC rc = readNewValues();
+        if (rc)
+            return rc;
+        found = codes.find(value);
+    }
+    if (found != codes.end())
+    {
+        code = found->second;
+        return SUCCESS;
+    }
+    if (!add)
+    {
+        code = DICTIONARY_NO_CODE;
+        return SUCCESS;
+    }
+
+    // Append the value to the last page, or to a new one if it does not fit
+    char page[PAGE_SIZE];
+    uint16_t count = 0;
+    unsigned offset = sizeof(uint16_t);
+    unsigned numPages = file->getNumberOfPages();
+    bool append = numPages == 1;
+    if (!append)
+    {
+        if (file->readPage(numPages - 1, page))
+            return RBFM_READ_FAILED;
+        memcpy(&count, page, sizeof(uint16_t));
+        for (unsigned i = 0; i < count; i++)
+        {
+            uint16_t length;
+            memcpy(&length, page + offset, sizeof(uint16_t));
+            offset += sizeof(uint16_t) + length;
+        }
+        append = offset + sizeof(uint16_t) + value.size() > PAGE_SIZE;
+    }
+    if (append)
+    {
+        memset(page, 0, PAGE_SIZE);
+        count = 0;
+        offset = sizeof(uint16_t);
+    }
+    if (offset + sizeof(uint16_t) + value.size() > PAGE_SIZE)
+        return RBFM_DICT_FAILED;
+
+    uint16_t length = value.size();
+    memcpy(page + offset, &length, sizeof(uint16_t));
+    memcpy(page + offset + sizeof(uint16_t), value.data(), length);
+    count++;
+    memcpy(page, &count, sizeof(uint16_t));
+    if (append ? file->appendPage(page) : file->writePage(numPages - 1, page))
+        return RBFM_WRITE_FAILED;
+
+    // The new value is the only one not read yet
+    return getCode(value, false, code);
+}
+
+RC VarCharDictionary::getValue(uint32_t code, string &value)
+{
+    if (code >= values.size())
+    {
+        RC rc = readNewValues();
+        if (rc)
+            return rc;
+        if (code >= values.size())
+            return RBFM_DICT_FAILED;
+    }
+    value = values[code];
+    return SUCCESS;
+}
+
+// Reads the values from where the last call stopped, which may be part way through a page
+RC VarCharDictionary::readNewValues()
+{
+    char page[PAGE_SIZE];
+    unsigned numPages = file->getNumberOfPages();
+    for (; nextPage < numPages; nextPage++, nextEntry = 0)
+    {
+        if (file->readPage(nextPage, page))
+            return RBFM_READ_FAILED;
+        uint16_t count;
+        memcpy(&count, page, sizeof(uint16_t));
+        unsigned offset = sizeof(uint16_t);
+        for (unsigned i = 0; i < count; i++)
+        {
+            uint16_t length;
+            memcpy(&length, page + offset, sizeof(uint16_t));
+            if (i >= nextEntry)
+            {
+                codes[string(page + offset + sizeof(uint16_t), length)] = values.size();
+                values.push_back(string(page + offset + sizeof(uint16_t), length));
+            }
+            offset += sizeof(uint16_t) + length;
+        }
+        // The last page may still get values
+        if (nextPage == numPages - 1)
+        {
+            nextEntry = count;
+            break;
+        }
+    }
+    return SUCCESS;
 }
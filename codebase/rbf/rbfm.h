@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <climits>
+#include <unordered_map>
+#include <mutex>
 
 #include "../rbf/pfm.h"
 
@@ -22,6 +24,8 @@
 #define RBFM_SLOT_DN_EXIST 7
 #define RBFM_READ_AFTER_DEL 8
 #define RBFM_NO_SUCH_ATTR 9
+#define RBFM_DICT_FAILED 10
+#define RBFM_RECORD_TOO_LARGE 11
 
 using namespace std;
 
@@ -47,6 +51,16 @@ typedef enum
   DEAD
 } SlotStatus;
 
+// Slot statistics of a record-based file, from RecordBasedFileManager::getFileStats
+typedef struct RecordFileStats
+{
+  unsigned records;          // Live records
+  unsigned forwardedRecords; // Records away from the page of their rid
+  unsigned forwardingSlots;  // MOVED slots, one per hop of each forwarding chain
+  unsigned longestChain;     // Most hops between a rid and its record
+  unsigned deadSlots;        // Slots of deleted records, for new records to reuse
+} RecordFileStats;
+
 typedef unsigned AttrLength;
 
 struct Attribute
@@ -68,12 +82,58 @@ typedef enum
   NO_OP      // no condition
 } CompOp;
 
+// One condition of a scan: the record's value of attribute compared with value. Predicates
+// that share an orGroup are alternatives, one of which has to hold; every group has to hold.
+// A comparison with a NULL never holds, and one with a NULL value matches no record.
+typedef struct ScanPredicate
+{
+  string attribute;
+  CompOp compOp;
+  const void *value;
+  unsigned orGroup;
+} ScanPredicate;
+
+// How the records of a page are stored. Every page of a file has the layout the file was
+// created with.
+//  ROW_LAYOUT: each record is stored whole, the slot directory giving its offset and length.
+//  PAX_LAYOUT: the page is split into one minipage per column, each holding a null bitmap and
+//    the column's values for every slot; fixed-size values are stored in place, varchar values
+//    as {offset, length} into a heap at the end of the page. The slot directory only tells
+//    whether a slot is live, moved or deleted, so RIDs work as for ROW_LAYOUT.
+typedef enum
+{
+  ROW_LAYOUT = 0,
+  PAX_LAYOUT
+} PageLayout;
+
+// How getPageRanges balances the ranges it splits a file into: by their number of pages, or
+// by their number of live records as the zone map counts them
+typedef enum
+{
+  SPLIT_BY_PAGES = 0,
+  SPLIT_BY_RECORDS
+} SplitMode;
+
+// Pages [startPage, endPage) of a file, and an estimate of the live records on them
+typedef struct PageRange
+{
+  PageNum startPage;
+  PageNum endPage;
+  unsigned records;
+} PageRange;
+
+// The endPage of a scan that runs to the end of the file
+#define SCAN_TO_END UINT32_MAX
+
 // Slot directory headers for page organization
 // See chapter 9.6.2 of the cow book or lecture 3 slide 16 for more information
 typedef struct SlotDirectoryHeader
 {
-  uint16_t freeSpaceOffset;
+  uint32_t freeSpaceOffset;     // For PAX_LAYOUT, the start of the varchar heap
   uint16_t recordEntriesNumber;
+  uint16_t layout;              // A PageLayout
+  uint16_t capacity;            // PAX_LAYOUT only: slots the minipages have room for, 0 until the first insert
+  uint16_t pageSizeKB;          // Size of the page, the page size of its file, in KB
 } SlotDirectoryHeader;
 
 // Assignment 2 tip: Make offset negative to represent a forwarding address
@@ -96,6 +156,115 @@ typedef uint16_t ColumnOffset;
 
 typedef uint16_t RecordLength;
 
+// A varchar value of a PAX_LAYOUT page, in the varchar heap. The offset of an empty value is
+// never used, which is as well since on a MAX_PAGE_SIZE page it may not fit.
+typedef struct PaxVarCharEntry
+{
+  uint16_t offset;
+  uint16_t length;
+} PaxVarCharEntry;
+
+// Slot directory entry of a live record of a PAX_LAYOUT page, whose values are all in the minipages
+#define PAX_LIVE_SLOT 1
+
+// Zone maps: every record-based file has a companion file holding, for each page, a summary
+// of each column over the records on that page. A zone map page holds the summaries of
+// pageSize / (columns * sizeof(ZoneMapEntry)) consecutive data pages; it has the page size of
+// the data file. Scans skip the pages
+// whose summary shows that no record can satisfy the scan condition.
+#define ZONE_MAP_EXTENSION ".zm"
+
+#define ZONE_SUMMARIZED 0x1 // The entry describes its page; pages never summarized are always read
+#define ZONE_HAS_VALUES 0x2 // min and max are set, i.e. some record has a value for the column
+
+// Summary of an int or real column over the records of one page. Varchar columns are only
+// given a null count.
+typedef struct ZoneMapEntry
+{
+  union
+  {
+    int32_t intValue;
+    float realValue;
+  } min, max;
+  uint16_t nullCount;
+  uint16_t flags;
+  // Live records on the page, the same in the entry of every column
+  uint16_t recordCount;
+} ZoneMapEntry;
+
+// Overflow pages: a record of a ROW_LAYOUT file that would take more than a quarter of a page
+// has its longest varchar values moved out, longest first, until it does not. Such a value is
+// kept in the record as an OverflowPointer followed by its first OVERFLOW_PREFIX_SIZE bytes, the
+// rest going to a chain of pages of a companion file, and the end offset of its column has
+// OVERFLOW_COLUMN set. Only reads of the column itself follow the chain: scans that do not
+// project it never read overflow pages, nor do conditions on it that the prefix decides.
+// Page 0 of the overflow file heads the list of the pages freed by updates and deletes.
+#define OVERFLOW_EXTENSION ".ovf"
+#define OVERFLOW_COLUMN 0x8000
+#define OVERFLOW_PREFIX_SIZE 32
+#define OVERFLOW_NO_PAGE UINT32_MAX
+
+typedef struct OverflowPointer
+{
+  uint32_t length; // Of the whole value
+  PageNum firstPage;
+} OverflowPointer;
+
+// Starts each page of a chain; in page 0, nextPage is the first free page
+typedef struct OverflowPageHeader
+{
+  PageNum nextPage;
+  uint32_t length; // Bytes of the value on this page
+} OverflowPageHeader;
+
+// Dictionary encoding: varchar attributes named when a file is created are stored as 4 byte
+// codes into a dictionary of the file's distinct values, kept in a companion file. Page 0 of
+// the dictionary file lists the encoded attributes; the following pages hold the values, in
+// code order, as a uint16 count followed by {uint16 length, bytes} entries. Values are only
+// ever appended, so a handle that meets a value or code it does not know just reads the
+// entries added since it last looked.
+#define DICTIONARY_EXTENSION ".dict"
+#define DICTIONARY_NO_CODE UINT32_MAX // Code of no value, for conditions on values not in the dictionary
+
+class VarCharDictionary
+{
+public:
+  // Takes ownership of the opened dictionary file
+  VarCharDictionary(FileHandle *file);
+  ~VarCharDictionary();
+
+  // Reads the encoded attribute names and all the values
+  RC load();
+
+  bool isEncoded(const string &attrName) const;
+
+  // The code of value; with add, a value not in the dictionary yet is added to it, otherwise
+  // its code is DICTIONARY_NO_CODE
+  RC getCode(const string &value, bool add, uint32_t &code);
+  RC getValue(uint32_t code, string &value);
+
+  static RC createFile(const string &fileName, const vector<string> &attrNames);
+
+private:
+  FileHandle *file;
+  vector<string> attrNames;
+  vector<string> values;
+  unordered_map<string, uint32_t> codes;
+  // Where the values not read yet start
+  PageNum nextPage;
+  unsigned nextEntry;
+
+  RC readNewValues();
+};
+
+// The files RBFM keeps alongside an open record-based file, each NULL if the file has none
+typedef struct CompanionFiles
+{
+  FileHandle *zoneMap;
+  VarCharDictionary *dictionary;
+  FileHandle *overflow;
+} CompanionFiles;
+
 /********************************************************************************
 The scan iterator is NOT required to be implemented for the part 1 of the project 
 ********************************************************************************/
@@ -124,6 +293,13 @@ public:
   RC getNextRecord(RID &rid, void *data);
   RC close();
 
+  // Restart the scan on pages [startPage, endPage) only. Scans over disjoint page ranges
+  // of one file, each through its own FileHandle, may run on different threads.
+  RC setPageRange(PageNum startPage, PageNum endPage);
+
+  // Pages read, and pages skipped thanks to the zone map, since the scan started
+  void getScanStats(unsigned &pagesRead, unsigned &pagesSkipped) const;
+
   friend class RecordBasedFileManager;
 
 private:
@@ -133,34 +309,84 @@ private:
   uint32_t currSlot;
 
   uint32_t totalPage;
-  uint16_t totalSlot;
+  // The first selectionSize entries of selection are the slots of the current page that are
+  // live and satisfy the condition, in order; selected is the position of the next one to
+  // return. The buffers only grow, so that pages after the first allocate nothing.
+  vector<uint16_t> selection;
+  unsigned selectionSize;
+  unsigned selected;
+  vector<char> matches;
+  vector<char> columnValues;
+  // The scan stops before this page
+  uint32_t endPage;
 
   void *pageData;
 
-  AttrType type;
-  unsigned attrIndex;
+  // The zone map page last read, for the condition attribute
+  void *zonePage;
+  int64_t zonePageNum;
+  unsigned pagesRead;
+  unsigned pagesSkipped;
+
+  // A ScanPredicate resolved against recordDescriptor
+  typedef struct ScanCondition
+  {
+    unsigned attrIndex;
+    CompOp compOp;
+    const void *value;
+    // With dictionary-encoded attributes, recordDescriptor has a TypeInt attribute in place
+    // of each of them, holding its code. Equality on one compares code with the codes; other
+    // conditions on one compare values.
+    bool byCode;
+    uint32_t code;
+    bool onValues;
+    // Estimated fraction of the records that satisfy the condition, and relative cost of
+    // checking it on a record
+    double selectivity;
+    double cost;
+  } ScanCondition;
 
   FileHandle fileHandle;
+  // Those of the file being scanned, looked up once when the scan starts
+  CompanionFiles companions;
   vector<Attribute> recordDescriptor;
-  string conditionAttribute;
-  CompOp compOp;
-  const void *value;
+  // The groups of conditions, in the order they are checked: a record is returned if one
+  // condition of every group holds
+  vector<vector<ScanCondition>> conditions;
   vector<string> attributeNames;
+  // Position in recordDescriptor of each projected attribute
+  vector<unsigned> projection;
+
+  // Records projected on dictionary-encoded attributes are read into storedData and then
+  // decoded
+  vector<Attribute> projectedAttributes;
+  void *storedData;
 
-  vector<RID> skipList;
+  // Slots of the current page the conditions of an OR group are checked on, and those one of
+  // them held for
+  vector<char> candidates;
+  vector<char> groupMatches;
 
   RC scanInit(FileHandle &fh,
               const vector<Attribute> rd,
-              const string &ca,
-              const CompOp compOp,
-              const void *v,
-              const vector<string> &an);
+              const vector<ScanPredicate> &predicates,
+              const vector<string> &an,
+              PageNum startPage,
+              PageNum endPage);
 
   RC getNextSlot();
   RC getNextPage();
-  RC handleMovedRecord(bool &status, const RID rid, void *data);
-  bool checkScanCondition();
-  RC checkScanCondition(bool &result, const RID rid);
+  void selectSlots();
+  void filterSlots(const ScanCondition &condition, char *match, unsigned n);
+  template <typename T>
+  void filterColumn(const ScanCondition &condition, char *match, unsigned n);
+  void orderConditions();
+  bool canSkipPage(PageNum pageNum);
+  bool readZoneMapPage(PageNum zoneMapPageNum);
+  static const void *getConditionValue(const ScanCondition &condition);
+  bool checkPrefixCondition(const ScanCondition &condition, const OverflowPointer &pointer, const char *prefix, bool &result);
+  static bool compareResult(int cmp, CompOp compOp);
+  bool checkScanCondition(const ScanCondition &condition);
   bool checkScanCondition(int, CompOp, const void *);
   bool checkScanCondition(float, CompOp, const void *);
   bool checkScanCondition(char *, CompOp, const void *);
@@ -171,7 +397,10 @@ class RecordBasedFileManager
 public:
   static RecordBasedFileManager *instance();
 
-  RC createFile(const string &fileName);
+  // The attributes named in dictionaryAttributes, which must be varchars, are dictionary-encoded.
+  // The pages of the file are pageSize bytes; see PagedFileManager::createFile
+  RC createFile(const string &fileName, PageLayout layout = ROW_LAYOUT,
+                const vector<string> &dictionaryAttributes = vector<string>(), unsigned pageSize = PAGE_SIZE);
 
   RC destroyFile(const string &fileName);
 
@@ -179,6 +408,10 @@ public:
 
   RC closeFile(FileHandle &fileHandle);
 
+  // Rewrites the file, its zone map and its dictionary in the compressed mode of the paged file
+  // manager; meant for files that are mostly read from now on
+  RC compressFile(const string &fileName);
+
   //  Format of the data passed into the function is the following:
   //  [n byte-null-indicators for y fields] [actual value for the first field] [actual value for the second field] ...
   //  1) For y fields, there is n-byte-null-indicators in the beginning of each record.
@@ -197,6 +430,11 @@ public:
 
   RC readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data);
 
+  // Read the records of all rids, data[i] receiving the record of rids[i] in the format of readRecord.
+  // Each page is read once however many of the rids are on it, pages are read in order, and
+  // records that were moved are all followed together once the original pages are done.
+  RC readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids, void *data[]);
+
   // This method will be mainly used for debugging/testing.
   // The format is as follows:
   // field1-name: field1-value  field2-name: field2-value ... \n
@@ -209,9 +447,22 @@ IMPORTANT, PLEASE READ: All methods below this comment (other than the construct
 ******************************************************************************************************************************************************************/
   RC deleteRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid);
 
-  // Assume the RID does not change after an update
+  // Assume the RID does not change after an update. A record that no longer fits on its page
+  // moves to another and its slot forwards to it; the slot always forwards straight to the
+  // record, and a moved record that has to move again goes back to its own page if it can.
   RC updateRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid);
 
+  // Moves forwarded records back to their own page wherever it now has room, points any longer
+  // forwarding chain straight at its record, and drops the DEAD slots that end a page's slot
+  // directory. Rids of live records are unchanged; rids of deleted records may afterwards
+  // refer to slots that no longer exist.
+  RC vacuumFile(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor);
+
+  RC getFileStats(FileHandle &fileHandle, RecordFileStats &stats);
+
+  // The overflow file kept with the file open in fileHandle, NULL if it has none
+  FileHandle *getOverflowFile(const FileHandle &fileHandle);
+
   RC readAttribute(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, const string &attributeName, void *data);
   static RC getColumnFromTuple(const void *tuple, const vector<Attribute> recordDescriptor, string attrName, void *&value);
 
@@ -222,10 +473,32 @@ IMPORTANT, PLEASE READ: All methods below this comment (other than the construct
           const CompOp compOp,                  // comparision type such as "<" and "="
           const void *value,                    // used in the comparison
           const vector<string> &attributeNames, // a list of projected attributes
-          RBFM_ScanIterator &rbfm_ScanIterator);
+          RBFM_ScanIterator &rbfm_ScanIterator,
+          PageNum startPage = 0,                // only pages [startPage, endPage) are scanned
+          PageNum endPage = SCAN_TO_END);
+
+  // Scan with any number of predicates, see ScanPredicate. They are checked on the records
+  // where they are stored, cheapest and most selective first.
+  RC scan(FileHandle &fileHandle,
+          const vector<Attribute> &recordDescriptor,
+          const vector<ScanPredicate> &predicates,
+          const vector<string> &attributeNames,
+          RBFM_ScanIterator &rbfm_ScanIterator,
+          PageNum startPage = 0,
+          PageNum endPage = SCAN_TO_END);
+
+  // Splits the pages of the file into at most count ranges, in order and together covering the
+  // file, for scans that each run through their own FileHandle, possibly on different threads.
+  // Pages the zone map has no summary of are assumed to hold as many records as the average
+  // summarized page.
+  RC getPageRanges(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, unsigned count, SplitMode mode,
+                   vector<PageRange> &ranges);
 
   static int getNullIndicatorSize(int fieldCount);
   static bool fieldIsNull(char *nullIndicator, int i);
+  // Largest size of a record in the format passed to insertRecord, each varchar being as long
+  // as the attribute length
+  static unsigned getMaxDataSize(const vector<Attribute> &recordDescriptor);
 
 public:
   friend class RBFM_ScanIterator;
@@ -239,9 +512,17 @@ private:
   static RecordBasedFileManager *_rbf_manager;
   static PagedFileManager *_pf_manager;
 
+  // The companion files of each file opened by openFile, by FileHandle::getFileId, so that
+  // copies of a handle find them too. Files are opened and closed on several threads.
+  unordered_map<const void *, CompanionFiles> companionFiles;
+  mutex companionFilesMutex;
+  CompanionFiles getCompanions(const FileHandle &fileHandle);
+
   // Private helper methods
 
-  void newRecordBasedPage(void *page);
+  void newRecordBasedPage(void *page, PageLayout layout, unsigned pageSize);
+  unsigned getPageSize(void *page);
+  bool recordFitsOnPage(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned recordSize);
 
   SlotDirectoryHeader getSlotDirectoryHeader(void *page);
   void setSlotDirectoryHeader(void *page, SlotDirectoryHeader slotHeader);
@@ -252,17 +533,110 @@ private:
   unsigned getPageFreeSpaceSize(void *page);
   unsigned getRecordSize(const vector<Attribute> &recordDescriptor, const void *data);
 
-  void setRecordAtOffset(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data);
-  void getRecordAtOffset(void *record, int32_t offset, const vector<Attribute> &recordDescriptor, void *data);
+  // The columns set in overflowed hold an OverflowPointer and prefix rather than their value
+  void setRecordAtOffset(void *page, unsigned offset, const vector<Attribute> &recordDescriptor, const void *data,
+                         const vector<bool> &overflowed = vector<bool>());
+  RC getRecordAtOffset(FileHandle &fileHandle, void *record, int32_t offset, const vector<Attribute> &recordDescriptor, void *data);
+  // Like getRecordAtOffset, but only the attributes at the given positions of recordDescriptor, in that order
+  RC getProjectedRecordAtOffset(FileHandle &fileHandle, void *page, int32_t offset, const vector<Attribute> &recordDescriptor, const vector<unsigned> &projection, void *data);
 
   SlotStatus getSlotStatus(SlotDirectoryRecordEntry slot);
+  static RID getForwardingAddress(SlotDirectoryRecordEntry slot);
   unsigned getOpenSlot(void *page);
 
   void markSlotDeleted(void *page, unsigned i);
+  // Marks the slot DEAD on disk and compacts its page
+  RC freeSlot(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid);
+  // Follows the forwarding slot, whose entry is given, to the record: reads the record's page
+  // into recordPage and sets rid to the record's slot. The slots passed on the way are added
+  // to hops.
+  RC findForwardedRecord(FileHandle &fileHandle, SlotDirectoryRecordEntry recordEntry, void *recordPage, RID &rid, vector<RID> &hops);
 
   void reorganizePage(void *page);
 
-  void getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type, void *data);
+  RC getAttributeFromRecord(FileHandle &fileHandle, void *page, unsigned offset, unsigned attrIndex, AttrType type, void *data);
+
+  // Read the live record in a slot, whatever the page layout
+  RC getRecordInSlot(FileHandle &fileHandle, void *page, unsigned slot, const vector<Attribute> &recordDescriptor, void *data);
+  RC getProjectedRecordInSlot(FileHandle &fileHandle, void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const vector<unsigned> &projection, void *data);
+  RC getAttributeInSlot(FileHandle &fileHandle, void *page, unsigned slot, const vector<Attribute> &recordDescriptor, unsigned attrIndex, void *data);
+
+  // PAX_LAYOUT pages
+  static unsigned getPaxCapacity(const vector<Attribute> &recordDescriptor, unsigned pageSize);
+  void setupPaxPage(void *page, const vector<Attribute> &recordDescriptor);
+  char *getPaxMinipage(void *page, unsigned column);
+  unsigned getPaxHeapStart(void *page, unsigned fieldCount);
+  unsigned getPaxVarCharSize(const vector<Attribute> &recordDescriptor, const void *data);
+  void setPaxRecord(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data);
+  // Append the value of a column, in the format of the data passed to insertRecord, to data;
+  // returns the number of bytes written, 0 if the value is NULL
+  unsigned getPaxValue(void *page, unsigned slot, unsigned column, AttrType type, void *data);
+  void reorganizePaxPage(void *page, const vector<Attribute> &recordDescriptor);
+
+  // Records in a given slot, whatever the page layout. The slot is one of the page's or the
+  // next new one, and holds no record.
+  bool recordFitsInSlot(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data);
+  void setRecordInSlot(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data,
+                       const vector<bool> &overflowed);
+  // Writes the record over the one in the slot if the page has room for it; if not, the old
+  // record is dropped, the slot left DEAD and false returned
+  bool rewriteRecordInSlot(void *page, unsigned slot, const vector<Attribute> &recordDescriptor, const void *data,
+                           const vector<bool> &overflowed);
+  // Moves the record that the forwarding slot at rid leads to back into it if its page has
+  // room, and otherwise makes the slot forward to it directly
+  RC collapseForwarding(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid);
+
+  // The public record operations, on records whose dictionary-encoded attributes are codes,
+  // as described by getStoredDescriptor
+  RC storeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid);
+  // storeRecord of a record whose long values are already in overflow pages
+  RC placeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const vector<bool> &overflowed, RID &rid);
+  RC readStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data);
+  RC readStoredRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids, void *data[]);
+  RC updateStoredRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, const RID &rid);
+  RC readStoredAttribute(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, const string &attributeName, void *data);
+
+  // Dictionary encoding
+  static string getDictionaryFileName(const string &fileName);
+  // recordDescriptor with each dictionary-encoded attribute turned into a TypeInt holding its code
+  void getStoredDescriptor(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, vector<Attribute> &storedDescriptor);
+  RC encodeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, void *stored);
+  // stored is the record, or the projection of a record onto recordDescriptor, with its
+  // encoded attributes as codes
+  RC decodeRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *stored, void *data);
+  // Size of a record in the format passed to insertRecord
+  static unsigned getDataSize(const vector<Attribute> &recordDescriptor, const void *data);
+
+  // Overflow pages
+  static string getOverflowFileName(const string &fileName);
+  RC createOverflowFile(const string &fileName, unsigned pageSize);
+  // When the record would take more than a quarter of a page, moves its longest values to
+  // overflow pages; inlined is then malloc'd to hold data with each of them replaced by its
+  // OverflowPointer and prefix, and overflowed tells which they are. Otherwise inlined is NULL.
+  RC storeOverflowValues(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, void *&inlined,
+                         vector<bool> &overflowed);
+  RC writeOverflowChain(FileHandle &overflow, const char *bytes, uint32_t length, PageNum &firstPage);
+  RC freeOverflowChain(FileHandle &overflow, PageNum firstPage);
+  // Reads the value of a column whose OverflowPointer and prefix are at field into value
+  RC readOverflowValue(FileHandle &fileHandle, const char *field, void *value, uint32_t &length);
+  // Frees the overflow pages of the values of the record at offset
+  RC freeOverflowValues(FileHandle &fileHandle, void *page, int32_t offset);
+  // Whether the varchar attribute of the live record in a slot is in overflow pages; if so,
+  // pointer and prefix are set from the record
+  bool getOverflowPrefix(void *page, unsigned slot, unsigned attrIndex, OverflowPointer &pointer, const char *&prefix);
+
+  // Zone map maintenance. Every data page is written through writeDataPage or appendDataPage,
+  // which summarize the page into the zone map.
+  static string getZoneMapFileName(const string &fileName);
+  static unsigned getZoneMapEntriesPerPage(unsigned fieldCount, unsigned pageSize);
+  RC writeDataPage(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *pageData);
+  RC appendDataPage(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, void *pageData);
+  RC updateZoneMap(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, PageNum pageNum, void *pageData);
+  void summarizePage(const vector<Attribute> &recordDescriptor, void *pageData, ZoneMapEntry *entries);
+  void summarizePaxPage(const vector<Attribute> &recordDescriptor, void *pageData, ZoneMapEntry *entries);
+  static void addToZoneMapEntry(ZoneMapEntry &entry, AttrType type, const void *value);
+  // Whether a page with this summary may hold a record whose column satisfies compOp value
+  static bool zoneMayMatch(const ZoneMapEntry &entry, AttrType type, CompOp compOp, const void *value);
 };
 
 #endif
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_13(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Record-Based File
+    // 2. Insert Records
+    // 3. Update Records so that some of them move to another page
+    // 4. Read Records in one batch
+    // 5. Destroy Record-Based File
+    cout << endl << "***** In RBF Test Case 13 *****" << endl;
+
+    RC rc;
+    string fileName = "test13";
+    const int numRecords = 2000;
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    int recordSize = 0;
+    void *record = malloc(100);
+    vector<RID> rids(numRecords);
+
+    // Short names fill up every page
+    for (int i = 0; i < numRecords; i++) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 1, "a", i, (float)i, i * 10, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+
+    // Growing every third record does not fit on the full pages, so those records are moved
+    string longName(30, 'z');
+    for (int i = 0; i < numRecords; i += 3) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 30, longName, i, (float)i, i * 10, record, &recordSize);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+
+    // Ask for the records in a scrambled order, some of them twice
+    vector<RID> wanted;
+    for (int i = 0; i < numRecords; i++)
+        wanted.push_back(rids[(i * 7919) % numRecords]);
+    for (int i = 0; i < numRecords; i += 100)
+        wanted.push_back(rids[i]);
+
+    vector<void *> data(wanted.size());
+    for (unsigned i = 0; i < wanted.size(); i++)
+        data[i] = malloc(100);
+    void *returnedData = malloc(100);
+
+    rc = rbfm->readRecords(fileHandle, recordDescriptor, wanted, data.data());
+    assert(rc == success && "Reading records should not fail.");
+
+    // Every record must be the one readRecord returns for its rid
+    int result = 0;
+    for (unsigned i = 0; i < wanted.size(); i++) {
+        memset(returnedData, 0, 100);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, wanted[i], returnedData);
+        assert(rc == success && "Reading a record should not fail.");
+
+        int nameLength = *(int *)((char *)data[i] + 1);
+        int age = *(int *)((char *)data[i] + 1 + sizeof(int) + nameLength);
+        int index = i < (unsigned)numRecords ? (i * 7919) % numRecords : (i - numRecords) * 100;
+        recordSize = 1 + sizeof(int) + nameLength + 3 * sizeof(int);
+        if (memcmp(returnedData, data[i], recordSize) != 0 || age != index) {
+            cout << "[FAIL] Test Case 13 Failed! Record " << i << " is not correct." << endl << endl;
+            result = -1;
+            break;
+        }
+    }
+
+    // A deleted record cannot be read
+    if (result == 0) {
+        rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[5]);
+        assert(rc == success && "Deleting a record should not fail.");
+        rc = rbfm->readRecords(fileHandle, recordDescriptor, wanted, data.data());
+        if (rc != RBFM_READ_AFTER_DEL) {
+            cout << "[FAIL] Test Case 13 Failed! Reading a deleted record should fail." << endl << endl;
+            result = -1;
+        }
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    for (unsigned i = 0; i < data.size(); i++)
+        free(data[i]);
+    free(returnedData);
+    free(record);
+    free(nullsIndicator);
+
+    if (result == 0)
+        cout << "RBF Test Case 13 Finished! The result will be examined." << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test13");
+
+    RC rcmain = RBFTest_13(rbfm);
+
+    return rcmain;
+}
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Scans the file for "attrName compOp value" and counts the records found. Every record
+// returned must satisfy the condition on Age, the only attribute projected.
+int countMatches(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                 const string &attrName, CompOp compOp, int value, unsigned &pagesRead, unsigned &pagesSkipped)
+{
+    vector<string> attributeNames;
+    attributeNames.push_back("Age");
+
+    RBFM_ScanIterator iter;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, attrName, compOp, &value, attributeNames, iter);
+    assert(rc == success && "Starting a scan should not fail.");
+
+    RID rid;
+    char data[PAGE_SIZE];
+    int count = 0;
+    while (iter.getNextRecord(rid, data) != RBFM_EOF) {
+        int age = *(int *)(data + 1);
+        if (attrName == "Age" && ((compOp == LT_OP && age >= value) || (compOp == GE_OP && age < value)
+                                  || (compOp == EQ_OP && age != value))) {
+            cout << "Age " << age << " does not satisfy the scan condition." << endl;
+            count = -1;
+            break;
+        }
+        count++;
+    }
+    iter.getScanStats(pagesRead, pagesSkipped);
+    iter.close();
+    return count;
+}
+
+int RBFTest_14(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Record-Based File
+    // 2. Insert Records sorted on Age
+    // 3. Scan with conditions the zone map lets the scan skip pages for
+    // 4. Delete and Update Records, then scan again, also after reopening the file
+    // 5. Destroy Record-Based File
+    cout << endl << "***** In RBF Test Case 14 *****" << endl;
+
+    RC rc;
+    string fileName = "test14";
+    const int numRecords = 5000;
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    int recordSize = 0;
+    void *record = malloc(100);
+    vector<RID> rids(numRecords);
+
+    // Age follows the insertion order, Salary does not
+    for (int i = 0; i < numRecords; i++) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Employee", i, (float)i, (i * 7919) % numRecords, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+
+    // A record whose Age is NULL matches no condition on Age
+    RID nullRid;
+    nullsIndicator[0] = 1 << 6;
+    prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Employee", 0, 0.0, 0, record, &recordSize);
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, nullRid);
+    assert(rc == success && "Inserting a record should not fail.");
+    nullsIndicator[0] = 0;
+
+    int result = 0;
+    unsigned pagesRead, pagesSkipped;
+    unsigned totalPages = fileHandle.getNumberOfPages();
+
+    // Selective conditions on the sorted attribute skip most pages
+    if (countMatches(rbfm, fileHandle, recordDescriptor, "Age", LT_OP, 100, pagesRead, pagesSkipped) != 100
+        || pagesSkipped == 0 || pagesRead + pagesSkipped != totalPages) {
+        cout << "[FAIL] Test Case 14 Failed! Age < 100 is not correct." << endl << endl;
+        result = -1;
+    }
+    cout << "Age < 100: " << pagesRead << " pages read, " << pagesSkipped << " skipped" << endl;
+    if (result == 0 && (countMatches(rbfm, fileHandle, recordDescriptor, "Age", GE_OP, 4900, pagesRead, pagesSkipped) != 100
+                        || pagesSkipped == 0)) {
+        cout << "[FAIL] Test Case 14 Failed! Age >= 4900 is not correct." << endl << endl;
+        result = -1;
+    }
+    if (result == 0 && (countMatches(rbfm, fileHandle, recordDescriptor, "Age", EQ_OP, 2500, pagesRead, pagesSkipped) != 1
+                        || pagesRead > 2)) {
+        cout << "[FAIL] Test Case 14 Failed! Age = 2500 is not correct." << endl << endl;
+        result = -1;
+    }
+
+    // The same selectivity on the unsorted attribute reads most pages; the record with a NULL
+    // Age has a Salary of 0
+    if (result == 0 && countMatches(rbfm, fileHandle, recordDescriptor, "Salary", LT_OP, 100, pagesRead, pagesSkipped) != 101) {
+        cout << "[FAIL] Test Case 14 Failed! Salary < 100 is not correct." << endl << endl;
+        result = -1;
+    }
+    cout << "Salary < 100: " << pagesRead << " pages read, " << pagesSkipped << " skipped" << endl;
+
+    // Delete Age < 100 and move Age 3000 to 7: only the updated record is left below 100
+    if (result == 0) {
+        for (int i = 0; i < 100; i++) {
+            rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+            assert(rc == success && "Deleting a record should not fail.");
+        }
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Employee", 7, 7.0, 0, record, &recordSize);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[3000]);
+        assert(rc == success && "Updating a record should not fail.");
+
+        if (countMatches(rbfm, fileHandle, recordDescriptor, "Age", LT_OP, 100, pagesRead, pagesSkipped) != 1) {
+            cout << "[FAIL] Test Case 14 Failed! Age < 100 after the delete and update is not correct." << endl << endl;
+            result = -1;
+        }
+        if (result == 0 && countMatches(rbfm, fileHandle, recordDescriptor, "Age", EQ_OP, 3000, pagesRead, pagesSkipped) != 0) {
+            cout << "[FAIL] Test Case 14 Failed! Age = 3000 after the update is not correct." << endl << endl;
+            result = -1;
+        }
+    }
+
+    // The zone map is kept with the file
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (result == 0 && (countMatches(rbfm, fileHandle, recordDescriptor, "Age", LT_OP, 100, pagesRead, pagesSkipped) != 1
+                        || pagesSkipped == 0)) {
+        cout << "[FAIL] Test Case 14 Failed! Age < 100 after reopening the file is not correct." << endl << endl;
+        result = -1;
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    struct stat sb;
+    if (result == 0 && stat((fileName + ZONE_MAP_EXTENSION).c_str(), &sb) == 0) {
+        cout << "[FAIL] Test Case 14 Failed! The zone map was not destroyed with the file." << endl << endl;
+        result = -1;
+    }
+
+    free(record);
+    free(nullsIndicator);
+
+    if (result == 0)
+        cout << "RBF Test Case 14 Finished! The result will be examined." << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test14");
+
+    RC rcmain = RBFTest_14(rbfm);
+
+    return rcmain;
+}
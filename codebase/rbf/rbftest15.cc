@@ -0,0 +1,205 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+const int numRecords = 3000;
+
+// Record i as of the given version: 0 when inserted, 1 after the update
+void prepareTestRecord(int i, int version, void *record, int *recordSize)
+{
+    unsigned char nullsIndicator = 0;
+    if (i % 7 == 0)
+        nullsIndicator |= 1 << 7;
+    if (i % 11 == 0)
+        nullsIndicator |= 1 << 4;
+    int nameLength = i % 30 + 1;
+    if (version == 1)
+        nameLength = i % 2 == 0 ? 30 : 1;
+    string name(nameLength, 'a' + i % 26);
+    prepareRecord(4, &nullsIndicator, nameLength, name, i, (float)i / 2, i * 10, record, recordSize);
+}
+
+// Checks that every record of the file reads as expected, or is gone if deleted
+int checkRecords(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                 const vector<RID> &rids, const vector<int> &versions)
+{
+    char record[100];
+    char returnedData[100];
+    int recordSize;
+    for (int i = 0; i < numRecords; i++) {
+        RC rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        if (versions[i] < 0) {
+            if (rc != RBFM_READ_AFTER_DEL) {
+                cout << "Record " << i << " was deleted but can still be read." << endl;
+                return -1;
+            }
+            continue;
+        }
+        prepareTestRecord(i, versions[i], record, &recordSize);
+        if (rc != success || memcmp(record, returnedData, recordSize) != 0) {
+            cout << "Record " << i << " is not correct." << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int RBFTest_15(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Record-Based File with the PAX layout
+    // 2. Insert, Read, Update, Delete and Read Records
+    // 3. Read Attributes
+    // 4. Scan with a condition and a projection
+    // 5. Destroy Record-Based File
+    cout << endl << "***** In RBF Test Case 15 *****" << endl;
+
+    RC rc;
+    string fileName = "test15";
+
+    rc = rbfm->createFile(fileName, PAX_LAYOUT);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    char record[100];
+    int recordSize = 0;
+    vector<RID> rids(numRecords);
+    vector<int> versions(numRecords, 0);
+
+    for (int i = 0; i < numRecords; i++) {
+        prepareTestRecord(i, 0, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    int result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+
+    // Half of the names grow to the longest a name can be, so some records have to move
+    if (result == 0) {
+        for (int i = 0; i < numRecords; i += 3) {
+            prepareTestRecord(i, 1, record, &recordSize);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Updating a record should not fail.");
+            versions[i] = 1;
+        }
+        result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+    }
+
+    // Deleted slots and the heap space of their names are reused
+    if (result == 0) {
+        for (int i = 0; i < numRecords; i += 4) {
+            rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+            assert(rc == success && "Deleting a record should not fail.");
+            versions[i] = -1;
+        }
+        result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+        for (int i = 0; i < numRecords; i += 4) {
+            prepareTestRecord(i, 0, record, &recordSize);
+            rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Inserting a record should not fail.");
+            versions[i] = 0;
+        }
+        if (result == 0)
+            result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+    }
+
+    // A single attribute, NULL or not
+    if (result == 0) {
+        char attribute[100];
+        for (int i = 0; i < numRecords && result == 0; i += 10) {
+            rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[i], "Salary", attribute);
+            assert(rc == success && "Reading an attribute should not fail.");
+            bool isNull = attribute[0] & (1 << 7);
+            if (isNull != (i % 11 == 0) || (!isNull && *(int *)(attribute + 1) != i * 10)) {
+                cout << "Salary of record " << i << " is not correct." << endl;
+                result = -1;
+            }
+        }
+    }
+
+    // Age and EmpName of the records with Age >= 1000
+    if (result == 0) {
+        vector<string> attributeNames;
+        attributeNames.push_back("Age");
+        attributeNames.push_back("EmpName");
+        int value = 1000;
+        RBFM_ScanIterator iter;
+        rc = rbfm->scan(fileHandle, recordDescriptor, "Age", GE_OP, &value, attributeNames, iter);
+        assert(rc == success && "Starting a scan should not fail.");
+
+        RID rid;
+        char returnedData[100];
+        vector<bool> seen(numRecords, false);
+        int count = 0;
+        while (iter.getNextRecord(rid, returnedData) != RBFM_EOF) {
+            int i = *(int *)(returnedData + 1);
+            if (i < 1000 || i >= numRecords || seen[i] || versions[i] < 0) {
+                cout << "Scan returned a wrong record." << endl;
+                result = -1;
+                break;
+            }
+            seen[i] = true;
+
+            // EmpName as last written
+            bool isNull = returnedData[0] & (1 << 6);
+            int nameLength = i % 30 + 1;
+            if (versions[i] == 1)
+                nameLength = i % 2 == 0 ? 30 : 1;
+            if (isNull != (i % 7 == 0) || (!isNull && (*(int *)(returnedData + 5) != nameLength
+                                                       || returnedData[9] != 'a' + i % 26))) {
+                cout << "EmpName of record " << i << " is not correct." << endl;
+                result = -1;
+                break;
+            }
+            count++;
+        }
+        iter.close();
+
+        int expected = 0;
+        for (int i = 1000; i < numRecords; i++)
+            if (versions[i] >= 0)
+                expected++;
+        if (result == 0 && count != expected) {
+            cout << "Scan returned " << count << " records instead of " << expected << "." << endl;
+            result = -1;
+        }
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    if (result == 0)
+        cout << "RBF Test Case 15 Finished! The result will be examined." << endl << endl;
+    else
+        cout << "[FAIL] Test Case 15 Failed!" << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test15");
+
+    RC rcmain = RBFTest_15(rbfm);
+
+    return rcmain;
+}
@@ -0,0 +1,293 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+const int numRecords = 3000;
+const int numNames = 8;
+const string names[numNames] = {
+    "Accounting and Finance", "Human Resources", "Research and Development", "Customer Support",
+    "Sales and Marketing", "Legal", "Information Technology", "Facilities Management"
+};
+
+// Record i as of the given version: 0 when inserted, 1 after the update. A name that is
+// not in the dictionary yet is added by the update.
+void prepareTestRecord(int i, int version, void *record, int *recordSize)
+{
+    unsigned char nullsIndicator = 0;
+    if (i % 13 == 0)
+        nullsIndicator |= 1 << 7;
+    string name = version == 0 ? names[i % numNames] : "Updated " + to_string(i % 5);
+    prepareRecord(4, &nullsIndicator, name.size(), name, i, (float)i / 2, i * 10, record, recordSize);
+}
+
+// Checks that every record of the file reads as expected
+int checkRecords(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                 const vector<RID> &rids, const vector<int> &versions)
+{
+    char record[100];
+    char returnedData[100];
+    int recordSize;
+    for (int i = 0; i < numRecords; i++) {
+        RC rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        prepareTestRecord(i, versions[i], record, &recordSize);
+        if (rc != success || memcmp(record, returnedData, recordSize) != 0) {
+            cout << "Record " << i << " is not correct." << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Scans the file for "EmpName compOp name" and counts the records found, checking the
+// EmpName and Age returned against the versions
+int countMatches(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                 CompOp compOp, const string &name, const vector<int> &versions)
+{
+    vector<string> attributeNames;
+    attributeNames.push_back("EmpName");
+    attributeNames.push_back("Age");
+
+    char value[100];
+    int nameLength = name.size();
+    memcpy(value, &nameLength, sizeof(int));
+    memcpy(value + sizeof(int), name.data(), nameLength);
+
+    RBFM_ScanIterator iter;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, "EmpName", compOp, value, attributeNames, iter);
+    assert(rc == success && "Starting a scan should not fail.");
+
+    RID rid;
+    char data[PAGE_SIZE];
+    int count = 0;
+    while (iter.getNextRecord(rid, data) != RBFM_EOF) {
+        int length;
+        memcpy(&length, data + 1, sizeof(int));
+        string returnedName(data + 1 + sizeof(int), length);
+        int age;
+        memcpy(&age, data + 1 + sizeof(int) + length, sizeof(int));
+
+        char record[100];
+        int recordSize;
+        prepareTestRecord(age, versions[age], record, &recordSize);
+        int expectedLength;
+        memcpy(&expectedLength, record + 1, sizeof(int));
+        int cmp = returnedName.compare(name);
+        if (data[0] != 0 || returnedName != string(record + 1 + sizeof(int), expectedLength)
+            || (compOp == EQ_OP && cmp != 0) || (compOp == NE_OP && cmp == 0) || (compOp == LT_OP && cmp >= 0)) {
+            cout << "Scan returned a wrong record for Age " << age << "." << endl;
+            count = -1;
+            break;
+        }
+        count++;
+    }
+    iter.close();
+    return count;
+}
+
+int RBFTest_16(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Record-Based File with a dictionary-encoded attribute
+    // 2. Insert, Read and Update Records, Read Attributes and Records
+    // 3. Scan with conditions on the encoded attribute
+    // 4. Reopen the file, and open it twice
+    // 5. Destroy Record-Based File
+    cout << endl << "***** In RBF Test Case 16 *****" << endl;
+
+    RC rc;
+    string fileName = "test16";
+    string plainFileName = "test16plain";
+
+    vector<string> dictionaryAttributes;
+    dictionaryAttributes.push_back("EmpName");
+    rc = rbfm->createFile(fileName, ROW_LAYOUT, dictionaryAttributes);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = rbfm->createFile(plainFileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    FileHandle plainFileHandle;
+    rc = rbfm->openFile(plainFileName, plainFileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    char record[100];
+    int recordSize = 0;
+    vector<RID> rids(numRecords);
+    vector<int> versions(numRecords, 0);
+
+    RID plainRid;
+    for (int i = 0; i < numRecords; i++) {
+        prepareTestRecord(i, 0, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+        rc = rbfm->insertRecord(plainFileHandle, recordDescriptor, record, plainRid);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    int result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+
+    // Codes take less space than the names they stand for
+    unsigned pages = fileHandle.getNumberOfPages();
+    unsigned plainPages = plainFileHandle.getNumberOfPages();
+    cout << "Encoded file: " << pages << " pages, plain file: " << plainPages << " pages" << endl;
+    if (result == 0 && pages >= plainPages) {
+        cout << "The encoded file is not smaller than the plain one." << endl;
+        result = -1;
+    }
+
+    // Updates add names to the dictionary
+    if (result == 0) {
+        for (int i = 0; i < numRecords; i += 3) {
+            prepareTestRecord(i, 1, record, &recordSize);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Updating a record should not fail.");
+            versions[i] = 1;
+        }
+        result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+    }
+
+    // A single attribute, and a batch of records
+    if (result == 0) {
+        char attribute[100];
+        for (int i = 0; i < numRecords && result == 0; i += 10) {
+            rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[i], "EmpName", attribute);
+            assert(rc == success && "Reading an attribute should not fail.");
+            prepareTestRecord(i, versions[i], record, &recordSize);
+            int length;
+            memcpy(&length, record + 1, sizeof(int));
+            bool isNull = attribute[0] & (1 << 7);
+            if (isNull != (i % 13 == 0) || (!isNull && memcmp(attribute + 1, record + 1, sizeof(int) + length) != 0)) {
+                cout << "EmpName of record " << i << " is not correct." << endl;
+                result = -1;
+            }
+        }
+    }
+    if (result == 0) {
+        vector<RID> batch(rids.begin(), rids.begin() + 100);
+        char *batchData = (char *)malloc(100 * batch.size());
+        vector<void *> buffers;
+        for (unsigned i = 0; i < batch.size(); i++)
+            buffers.push_back(batchData + i * 100);
+        rc = rbfm->readRecords(fileHandle, recordDescriptor, batch, buffers.data());
+        assert(rc == success && "Reading records should not fail.");
+        for (unsigned i = 0; i < batch.size() && result == 0; i++) {
+            prepareTestRecord(i, versions[i], record, &recordSize);
+            if (memcmp(record, batchData + i * 100, recordSize) != 0) {
+                cout << "Record " << i << " read in a batch is not correct." << endl;
+                result = -1;
+            }
+        }
+        free(batchData);
+    }
+
+    // Conditions on the encoded attribute, including a name that is not in the dictionary
+    int expectedEq = 0, expectedNe = 0, expectedLt = 0, expectedUpdated = 0;
+    for (int i = 0; i < numRecords; i++) {
+        if (i % 13 == 0)
+            continue;
+        string name = versions[i] == 0 ? names[i % numNames] : "Updated " + to_string(i % 5);
+        expectedEq += name == "Legal";
+        expectedNe += name != "Legal";
+        expectedLt += name < "Human";
+        expectedUpdated += name == "Updated 3";
+    }
+    if (result == 0 && (countMatches(rbfm, fileHandle, recordDescriptor, EQ_OP, "Legal", versions) != expectedEq
+                        || countMatches(rbfm, fileHandle, recordDescriptor, NE_OP, "Legal", versions) != expectedNe
+                        || countMatches(rbfm, fileHandle, recordDescriptor, LT_OP, "Human", versions) != expectedLt
+                        || countMatches(rbfm, fileHandle, recordDescriptor, EQ_OP, "Nobody", versions) != 0)) {
+        cout << "[FAIL] Test Case 16 Failed! A scan on EmpName is not correct." << endl << endl;
+        result = -1;
+    }
+
+    // A second handle on the file sees the names the first one adds
+    FileHandle secondHandle;
+    rc = rbfm->openFile(fileName, secondHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (result == 0) {
+        prepareTestRecord(3, 1, record, &recordSize);
+        string name = "Added Later";
+        int nameLength = name.size();
+        memcpy(record + 1, &nameLength, sizeof(int));
+        memcpy(record + 1 + sizeof(int), name.data(), nameLength);
+        int age = 3;
+        memcpy(record + 1 + sizeof(int) + nameLength, &age, sizeof(int));
+        float height = 1.5;
+        memcpy(record + 1 + 2 * sizeof(int) + nameLength, &height, sizeof(float));
+        int salary = 30;
+        memcpy(record + 1 + 2 * sizeof(int) + sizeof(float) + nameLength, &salary, sizeof(int));
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[3]);
+        assert(rc == success && "Updating a record should not fail.");
+
+        char returnedData[100];
+        rc = rbfm->readRecord(secondHandle, recordDescriptor, rids[3], returnedData);
+        if (rc != success || memcmp(returnedData + 1, record + 1, sizeof(int) + nameLength) != 0) {
+            cout << "[FAIL] Test Case 16 Failed! The second handle does not see the new name." << endl << endl;
+            result = -1;
+        }
+        prepareTestRecord(3, versions[3], record, &recordSize);
+        rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[3]);
+        assert(rc == success && "Updating a record should not fail.");
+    }
+    rc = rbfm->closeFile(secondHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // The dictionary is kept with the file
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (result == 0)
+        result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+    if (result == 0 && countMatches(rbfm, fileHandle, recordDescriptor, EQ_OP, "Updated 3", versions) != expectedUpdated) {
+        cout << "[FAIL] Test Case 16 Failed! A scan after reopening the file is not correct." << endl << endl;
+        result = -1;
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->closeFile(plainFileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    rc = rbfm->destroyFile(plainFileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    struct stat sb;
+    if (result == 0 && stat((fileName + DICTIONARY_EXTENSION).c_str(), &sb) == 0) {
+        cout << "[FAIL] Test Case 16 Failed! The dictionary was not destroyed with the file." << endl << endl;
+        result = -1;
+    }
+
+    if (result == 0)
+        cout << "RBF Test Case 16 Finished! The result will be examined." << endl << endl;
+    else
+        cout << "[FAIL] Test Case 16 Failed!" << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test16");
+    remove("test16plain");
+
+    RC rcmain = RBFTest_16(rbfm);
+
+    return rcmain;
+}
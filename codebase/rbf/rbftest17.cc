@@ -0,0 +1,228 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Page i as of the given version. Even pages of version 0 compress well; odd pages, and every
+// page of version 1, are pseudo-random bytes that do not.
+void preparePage(int i, int version, char *page)
+{
+    unsigned state = i * 2654435761u + version + 1;
+    for (int j = 0; j < PAGE_SIZE; j++) {
+        if (version == 0 && i % 2 == 0) {
+            page[j] = (j / 64 + i) % 26 + 'a';
+        } else {
+            state = state * 1103515245 + 12345;
+            page[j] = state >> 16;
+        }
+    }
+}
+
+int checkPages(FileHandle &fileHandle, const vector<int> &versions)
+{
+    char page[PAGE_SIZE];
+    char expected[PAGE_SIZE];
+    if (fileHandle.getNumberOfPages() != versions.size()) {
+        cout << "The file has " << fileHandle.getNumberOfPages() << " pages instead of " << versions.size() << "." << endl;
+        return -1;
+    }
+    for (unsigned i = 0; i < versions.size(); i++) {
+        preparePage(i, versions[i], expected);
+        if (fileHandle.readPage(i, page) != success || memcmp(page, expected, PAGE_SIZE) != 0) {
+            cout << "Page " << i << " is not correct." << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+long getFileSize(const string &fileName)
+{
+    struct stat sb;
+    return stat(fileName.c_str(), &sb) == 0 ? sb.st_size : -1;
+}
+
+int RBFTest_17(PagedFileManager *pfm, RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create a compressed Paged File
+    // 2. Append, Write and Read Pages, over more than one map block
+    // 3. Compress a Record-Based File, then Read, Scan, Insert and Update Records in it
+    // 4. Destroy the files
+    cout << endl << "***** In RBF Test Case 17 *****" << endl;
+
+    RC rc;
+    string fileName = "test17";
+    const int numPages = PFM_MAP_ENTRIES + 44;
+
+    rc = pfm->createFile(fileName, true);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (!fileHandle.isCompressed()) {
+        cout << "[FAIL] Test Case 17 Failed! The file is not compressed." << endl << endl;
+        return -1;
+    }
+
+    char page[PAGE_SIZE];
+    vector<int> versions(numPages, 0);
+    for (int i = 0; i < numPages; i++) {
+        preparePage(i, 0, page);
+        rc = fileHandle.appendPage(page);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    int result = checkPages(fileHandle, versions);
+    if (result == 0 && fileHandle.readPage(numPages, page) == success) {
+        cout << "A page past the end of the file can be read." << endl;
+        result = -1;
+    }
+
+    // Pages that no longer compress move to new extents
+    long size = getFileSize(fileName);
+    cout << "Compressed file: " << size << " bytes for " << numPages * PAGE_SIZE << " bytes of pages" << endl;
+    if (result == 0 && size >= (long)numPages * PAGE_SIZE) {
+        cout << "The compressed file is not smaller than its pages." << endl;
+        result = -1;
+    }
+    if (result == 0) {
+        for (int i = 0; i < numPages; i += 5) {
+            versions[i] = 1;
+            preparePage(i, 1, page);
+            rc = fileHandle.writePage(i, page);
+            assert(rc == success && "Writing a page should not fail.");
+        }
+        result = checkPages(fileHandle, versions);
+    }
+
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (result == 0)
+        result = checkPages(fileHandle, versions);
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    // A record-based file compressed after it was loaded is used as before
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    const int numRecords = 2000;
+    vector<RID> rids(numRecords);
+    char record[100];
+    char returnedData[100];
+    int recordSize;
+    unsigned char nullsIndicator = 0;
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    for (int i = 0; i < numRecords; i++) {
+        prepareRecord(recordDescriptor.size(), &nullsIndicator, 8, "Employee", i, (float)i, i * 10, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    long plainSize = getFileSize(fileName);
+    rc = rbfm->compressFile(fileName);
+    assert(rc == success && "Compressing the file should not fail.");
+    size = getFileSize(fileName);
+    cout << "Record-based file: " << plainSize << " bytes, " << size << " bytes compressed" << endl;
+    if (result == 0 && size >= plainSize) {
+        cout << "[FAIL] Test Case 17 Failed! Compressing the file did not make it smaller." << endl << endl;
+        result = -1;
+    }
+
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (result == 0 && !fileHandle.isCompressed()) {
+        cout << "[FAIL] Test Case 17 Failed! The file is not compressed." << endl << endl;
+        result = -1;
+    }
+    for (int i = 0; i < numRecords && result == 0; i++) {
+        prepareRecord(recordDescriptor.size(), &nullsIndicator, 8, "Employee", i, (float)i, i * 10, record, &recordSize);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        if (rc != success || memcmp(record, returnedData, recordSize) != 0) {
+            cout << "[FAIL] Test Case 17 Failed! Record " << i << " is not correct after compressing the file." << endl << endl;
+            result = -1;
+        }
+    }
+
+    // Updates and inserts, then a scan that relies on the compressed zone map
+    if (result == 0) {
+        string longName(30, 'x');
+        for (int i = 0; i < numRecords; i += 7) {
+            prepareRecord(recordDescriptor.size(), &nullsIndicator, longName.size(), longName, i, (float)i, i * 10, record, &recordSize);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Updating a record should not fail.");
+        }
+        RID rid;
+        prepareRecord(recordDescriptor.size(), &nullsIndicator, 8, "Employee", numRecords, (float)numRecords, 0, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+
+        vector<string> attributeNames;
+        attributeNames.push_back("Age");
+        attributeNames.push_back("EmpName");
+        int value = numRecords - 100;
+        RBFM_ScanIterator iter;
+        rc = rbfm->scan(fileHandle, recordDescriptor, "Age", GE_OP, &value, attributeNames, iter);
+        assert(rc == success && "Starting a scan should not fail.");
+        int count = 0;
+        while (iter.getNextRecord(rid, returnedData) != RBFM_EOF) {
+            int age = *(int *)(returnedData + 1);
+            int nameLength = *(int *)(returnedData + 5);
+            if (age < value || nameLength != (age % 7 == 0 && age < numRecords ? 30 : 8)) {
+                cout << "Scan returned a wrong record." << endl;
+                result = -1;
+                break;
+            }
+            count++;
+        }
+        unsigned pagesRead, pagesSkipped;
+        iter.getScanStats(pagesRead, pagesSkipped);
+        iter.close();
+        if (result == 0 && (count != 101 || pagesSkipped == 0)) {
+            cout << "[FAIL] Test Case 17 Failed! The scan returned " << count << " records." << endl << endl;
+            result = -1;
+        }
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    if (result == 0)
+        cout << "RBF Test Case 17 Finished! The result will be examined." << endl << endl;
+    else
+        cout << "[FAIL] Test Case 17 Failed!" << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the paged file manager and the record-based file manager
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test17");
+
+    RC rcmain = RBFTest_17(pfm, rbfm);
+
+    return rcmain;
+}
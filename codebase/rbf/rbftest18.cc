@@ -0,0 +1,222 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+const int numRecords = 6000;
+
+// Record i as of the given version: 0 when inserted, 1 after the update
+void prepareTestRecord(int i, int version, void *record, int *recordSize)
+{
+    unsigned char nullsIndicator = 0;
+    if (i % 7 == 0)
+        nullsIndicator |= 1 << 7;
+    int nameLength = version == 0 ? i % 10 + 1 : 30;
+    string name(nameLength, 'a' + i % 26);
+    prepareRecord(4, &nullsIndicator, nameLength, name, i, (float)i / 2, i * 10, record, recordSize);
+}
+
+// Checks that every record of the file reads as expected, or is gone if deleted
+int checkRecords(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                 const vector<RID> &rids, const vector<int> &versions)
+{
+    char record[100];
+    char returnedData[100];
+    int recordSize;
+    for (int i = 0; i < numRecords; i++) {
+        RC rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        if (versions[i] < 0) {
+            if (rc != RBFM_READ_AFTER_DEL) {
+                cout << "Record " << i << " was deleted but can still be read." << endl;
+                return -1;
+            }
+            continue;
+        }
+        prepareTestRecord(i, versions[i], record, &recordSize);
+        if (rc != success || memcmp(record, returnedData, recordSize) != 0) {
+            cout << "Record " << i << " is not correct." << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Inserts, updates, deletes and scans records in a file of the given page size and layout
+int testPageSize(RecordBasedFileManager *rbfm, unsigned pageSize, PageLayout layout, bool compress)
+{
+    cout << "Page size " << pageSize << (layout == PAX_LAYOUT ? ", PAX layout" : ", row layout")
+         << (compress ? ", compressed" : "") << endl;
+
+    RC rc;
+    string fileName = "test18";
+    rc = rbfm->createFile(fileName, layout, vector<string>(), pageSize);
+    assert(rc == success && "Creating the file should not fail.");
+    if (compress) {
+        rc = rbfm->compressFile(fileName);
+        assert(rc == success && "Compressing the file should not fail.");
+    }
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (fileHandle.getPageSize() != pageSize) {
+        cout << "The file has pages of " << fileHandle.getPageSize() << " bytes." << endl;
+        rbfm->closeFile(fileHandle);
+        rbfm->destroyFile(fileName);
+        return -1;
+    }
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    char record[100];
+    int recordSize = 0;
+    vector<RID> rids(numRecords);
+    vector<int> versions(numRecords, 0);
+    for (int i = 0; i < numRecords; i++) {
+        prepareTestRecord(i, 0, record, &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    int result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+    cout << numRecords << " records on " << fileHandle.getNumberOfPages() << " pages" << endl;
+
+    // Some records have to move when their names grow
+    if (result == 0) {
+        for (int i = 0; i < numRecords; i += 3) {
+            prepareTestRecord(i, 1, record, &recordSize);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Updating a record should not fail.");
+            versions[i] = 1;
+        }
+        for (int i = 0; i < numRecords; i += 4) {
+            rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+            assert(rc == success && "Deleting a record should not fail.");
+            versions[i] = -1;
+        }
+        result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+    }
+
+    // The zone map skips pages on Age, which follows the insertion order
+    if (result == 0) {
+        vector<string> attributeNames;
+        attributeNames.push_back("Age");
+        int value = numRecords - 500;
+        RBFM_ScanIterator iter;
+        rc = rbfm->scan(fileHandle, recordDescriptor, "Age", GE_OP, &value, attributeNames, iter);
+        assert(rc == success && "Starting a scan should not fail.");
+        RID rid;
+        char returnedData[100];
+        int count = 0;
+        while (iter.getNextRecord(rid, returnedData) != RBFM_EOF) {
+            int age = *(int *)(returnedData + 1);
+            if (age < value || versions[age] < 0) {
+                cout << "Scan returned a wrong record." << endl;
+                result = -1;
+                break;
+            }
+            count++;
+        }
+        unsigned pagesRead, pagesSkipped;
+        iter.getScanStats(pagesRead, pagesSkipped);
+        iter.close();
+
+        int expected = 0;
+        for (int i = value; i < numRecords; i++)
+            if (versions[i] >= 0)
+                expected++;
+        if (result == 0 && (count != expected || pagesSkipped == 0)) {
+            cout << "Scan returned " << count << " records instead of " << expected << ", skipping "
+                 << pagesSkipped << " pages." << endl;
+            result = -1;
+        }
+    }
+
+    // The page size is kept with the file
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (result == 0)
+        result = checkRecords(rbfm, fileHandle, recordDescriptor, rids, versions);
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    return result;
+}
+
+int RBFTest_18(PagedFileManager *pfm, RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Paged Files with invalid page sizes
+    // 2. Create Record-Based Files with larger pages, in both layouts and compressed
+    // 3. Insert, Read, Update, Delete and Scan Records
+    // 4. Destroy Record-Based File
+    // 5. Open a file of the format without a header page
+    cout << endl << "***** In RBF Test Case 18 *****" << endl;
+
+    int result = 0;
+    unsigned badPageSizes[] = {MIN_PAGE_SIZE / 2, MIN_PAGE_SIZE + 1024, MAX_PAGE_SIZE * 2};
+    for (unsigned pageSize : badPageSizes) {
+        if (pfm->createFile("test18", false, pageSize) != PFM_BAD_PAGE_SIZE) {
+            cout << "[FAIL] Test Case 18 Failed! A file with pages of " << pageSize << " bytes was created." << endl << endl;
+            pfm->destroyFile("test18");
+            result = -1;
+        }
+    }
+
+    // A file of PAGE_SIZE pages without the header page, as files were before pages had a size
+    // of their own, is refused rather than read in the current page layout
+    if (result == 0) {
+        FILE *oldFile = fopen("test18", "wb");
+        char page[PAGE_SIZE] = {0};
+        fwrite(page, 1, PAGE_SIZE, oldFile);
+        fclose(oldFile);
+        FileHandle fileHandle;
+        if (pfm->openFile("test18", fileHandle) != PFM_OLD_FORMAT) {
+            cout << "[FAIL] Test Case 18 Failed! A file without a header page was opened." << endl << endl;
+            pfm->closeFile(fileHandle);
+            result = -1;
+        }
+        pfm->destroyFile("test18");
+    }
+
+    if (result == 0)
+        result = testPageSize(rbfm, 16384, ROW_LAYOUT, false);
+    if (result == 0)
+        result = testPageSize(rbfm, MAX_PAGE_SIZE, ROW_LAYOUT, false);
+    if (result == 0)
+        result = testPageSize(rbfm, MAX_PAGE_SIZE, PAX_LAYOUT, false);
+    if (result == 0)
+        result = testPageSize(rbfm, MAX_PAGE_SIZE, ROW_LAYOUT, true);
+
+    if (result == 0)
+        cout << "RBF Test Case 18 Finished! The result will be examined." << endl << endl;
+    else
+        cout << "[FAIL] Test Case 18 Failed!" << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the paged file manager and the record-based file manager
+    PagedFileManager *pfm = PagedFileManager::instance();
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test18");
+
+    RC rcmain = RBFTest_18(pfm, rbfm);
+
+    return rcmain;
+}
@@ -0,0 +1,291 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+const int numRecords = 300;
+const int maxBodyLength = 20000;
+
+void createDocumentDescriptor(vector<Attribute> &recordDescriptor)
+{
+    Attribute attr;
+    attr.name = "Id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "Title";
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)50;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "Body";
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)maxBodyLength;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "Score";
+    attr.type = TypeReal;
+    attr.length = (AttrLength)4;
+    recordDescriptor.push_back(attr);
+}
+
+// The body of document i as of the given version; most are too long to stay in the record
+string getBody(int i, int version)
+{
+    static const int lengths[] = {10, 300, 1500, 4000, 9000, maxBodyLength};
+    int length = lengths[(i + version) % 6];
+    string body(length, ' ');
+    for (int j = 0; j < length; j++)
+        body[j] = 'a' + (i * 7 + j / 97 + version) % 26;
+    return body;
+}
+
+// Record i as of the given version, in the format of insertRecord
+int prepareDocument(int i, int version, char *record)
+{
+    char nullsIndicator = 0;
+    string title = "Document " + to_string(i);
+    string body = getBody(i, version);
+    int length, offset = 1;
+    memcpy(record, &nullsIndicator, 1);
+    memcpy(record + offset, &i, sizeof(int));
+    offset += sizeof(int);
+    length = title.size();
+    memcpy(record + offset, &length, sizeof(int));
+    memcpy(record + offset + sizeof(int), title.data(), length);
+    offset += sizeof(int) + length;
+    length = body.size();
+    memcpy(record + offset, &length, sizeof(int));
+    memcpy(record + offset + sizeof(int), body.data(), length);
+    offset += sizeof(int) + length;
+    float score = i / 2.0;
+    memcpy(record + offset, &score, sizeof(float));
+    return offset + sizeof(float);
+}
+
+int checkDocuments(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                   const vector<RID> &rids, const vector<int> &versions)
+{
+    char *record = (char *)malloc(maxBodyLength + 100);
+    char *returnedData = (char *)malloc(maxBodyLength + 100);
+    int result = 0;
+    for (int i = 0; i < numRecords && result == 0; i++) {
+        RC rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        if (versions[i] < 0) {
+            if (rc != RBFM_READ_AFTER_DEL) {
+                cout << "Document " << i << " was deleted but can still be read." << endl;
+                result = -1;
+            }
+            continue;
+        }
+        int recordSize = prepareDocument(i, versions[i], record);
+        if (rc != success || memcmp(record, returnedData, recordSize) != 0) {
+            cout << "Document " << i << " is not correct." << endl;
+            result = -1;
+            continue;
+        }
+
+        // The body on its own
+        string body = getBody(i, versions[i]);
+        rc = rbfm->readAttribute(fileHandle, recordDescriptor, rids[i], "Body", returnedData);
+        if (rc != success || returnedData[0] != 0 || *(int *)(returnedData + 1) != (int)body.size()
+            || memcmp(returnedData + 1 + sizeof(int), body.data(), body.size()) != 0) {
+            cout << "The body of document " << i << " is not correct." << endl;
+            result = -1;
+        }
+    }
+    free(record);
+    free(returnedData);
+    return result;
+}
+
+int RBFTest_19(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Record-Based File
+    // 2. Insert, Read and Read Attribute of Records with values larger than a page
+    // 3. Scan with and without the large attribute
+    // 4. Update and Delete Records, reusing the freed overflow pages
+    // 5. Destroy Record-Based File
+    cout << endl << "***** In RBF Test Case 19 *****" << endl;
+
+    RC rc;
+    string fileName = "test19";
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (rbfm->getOverflowFile(fileHandle) == NULL) {
+        cout << "[FAIL] Test Case 19 Failed! The file has no overflow file." << endl << endl;
+        return -1;
+    }
+
+    vector<Attribute> recordDescriptor;
+    createDocumentDescriptor(recordDescriptor);
+
+    char *record = (char *)malloc(maxBodyLength + 100);
+    char *returnedData = (char *)malloc(maxBodyLength + 100);
+    vector<RID> rids(numRecords);
+    vector<int> versions(numRecords, 0);
+    for (int i = 0; i < numRecords; i++) {
+        prepareDocument(i, 0, record);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    int result = checkDocuments(rbfm, fileHandle, recordDescriptor, rids, versions);
+    unsigned overflowPages = rbfm->getOverflowFile(fileHandle)->getNumberOfPages();
+    cout << numRecords << " documents on " << fileHandle.getNumberOfPages() << " pages and " << overflowPages
+         << " overflow pages" << endl;
+
+    // A scan that does not project the body reads no overflow pages
+    unsigned readPageCount, writePageCount, appendPageCount;
+    unsigned overflowReads;
+    if (result == 0) {
+        rbfm->getOverflowFile(fileHandle)->collectCounterValues(overflowReads, writePageCount, appendPageCount);
+        vector<string> attributeNames;
+        attributeNames.push_back("Id");
+        attributeNames.push_back("Title");
+        float score = 100;
+        RBFM_ScanIterator iter;
+        rc = rbfm->scan(fileHandle, recordDescriptor, "Score", GE_OP, &score, attributeNames, iter);
+        assert(rc == success && "Starting a scan should not fail.");
+        RID rid;
+        int count = 0;
+        while (iter.getNextRecord(rid, returnedData) != RBFM_EOF) {
+            int id = *(int *)(returnedData + 1);
+            string title = "Document " + to_string(id);
+            if (id < 200 || *(int *)(returnedData + 5) != (int)title.size()
+                || memcmp(returnedData + 9, title.data(), title.size()) != 0) {
+                cout << "The scan returned a wrong record." << endl;
+                result = -1;
+                break;
+            }
+            count++;
+        }
+        iter.close();
+        rbfm->getOverflowFile(fileHandle)->collectCounterValues(readPageCount, writePageCount, appendPageCount);
+        if (result == 0 && (count != numRecords - 200 || readPageCount != overflowReads)) {
+            cout << "The scan returned " << count << " records and read " << readPageCount - overflowReads
+                 << " overflow pages." << endl;
+            result = -1;
+        }
+    }
+
+    // A condition on the body that its prefix decides reads no overflow pages either, and one
+    // that it does not gets the whole value
+    if (result == 0) {
+        string body = getBody(7, 0);
+        int length = body.size();
+        memcpy(record, &length, sizeof(int));
+        memcpy(record + sizeof(int), body.data(), length);
+        vector<string> attributeNames;
+        attributeNames.push_back("Id");
+
+        rbfm->getOverflowFile(fileHandle)->collectCounterValues(overflowReads, writePageCount, appendPageCount);
+        RBFM_ScanIterator iter;
+        rc = rbfm->scan(fileHandle, recordDescriptor, "Body", EQ_OP, record, attributeNames, iter);
+        assert(rc == success && "Starting a scan should not fail.");
+        RID rid;
+        int count = 0;
+        while (iter.getNextRecord(rid, returnedData) != RBFM_EOF) {
+            int id = *(int *)(returnedData + 1);
+            if (getBody(id, 0) != body) {
+                cout << "The scan returned a wrong record." << endl;
+                result = -1;
+            }
+            count++;
+        }
+        iter.close();
+        rbfm->getOverflowFile(fileHandle)->collectCounterValues(readPageCount, writePageCount, appendPageCount);
+        cout << "Equality on the body: " << count << " records, " << readPageCount - overflowReads << " overflow pages read" << endl;
+        if (result == 0 && (count == 0 || readPageCount - overflowReads >= overflowPages / 4)) {
+            cout << "The prefix of the values was not used." << endl;
+            result = -1;
+        }
+    }
+
+    // Bodies move in and out of overflow pages, and the pages freed are used again
+    if (result == 0) {
+        for (int i = 0; i < numRecords; i += 2) {
+            prepareDocument(i, 1, record);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Updating a record should not fail.");
+            versions[i] = 1;
+        }
+        for (int i = 0; i < numRecords; i += 5) {
+            rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+            assert(rc == success && "Deleting a record should not fail.");
+            versions[i] = -1;
+        }
+        result = checkDocuments(rbfm, fileHandle, recordDescriptor, rids, versions);
+    }
+    if (result == 0) {
+        for (int i = 0; i < numRecords; i += 5) {
+            prepareDocument(i, 0, record);
+            rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Inserting a record should not fail.");
+            versions[i] = 0;
+        }
+        result = checkDocuments(rbfm, fileHandle, recordDescriptor, rids, versions);
+        cout << "After the updates: " << rbfm->getOverflowFile(fileHandle)->getNumberOfPages() << " overflow pages" << endl;
+        if (result == 0 && rbfm->getOverflowFile(fileHandle)->getNumberOfPages() > overflowPages * 5 / 4) {
+            cout << "The freed overflow pages were not used again." << endl;
+            result = -1;
+        }
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    // Records of a PAX_LAYOUT file have to fit on a page
+    if (result == 0) {
+        rc = rbfm->createFile(fileName, PAX_LAYOUT);
+        assert(rc == success && "Creating the file should not fail.");
+        rc = rbfm->openFile(fileName, fileHandle);
+        assert(rc == success && "Opening the file should not fail.");
+        prepareDocument(5, 0, record);
+        RID rid;
+        if (rbfm->insertRecord(fileHandle, recordDescriptor, record, rid) != RBFM_RECORD_TOO_LARGE) {
+            cout << "A record larger than a page was inserted into a PAX_LAYOUT file." << endl;
+            result = -1;
+        }
+        rc = rbfm->closeFile(fileHandle);
+        assert(rc == success && "Closing the file should not fail.");
+        rc = rbfm->destroyFile(fileName);
+        assert(rc == success && "Destroying the file should not fail.");
+    }
+
+    free(record);
+    free(returnedData);
+    if (result == 0)
+        cout << "RBF Test Case 19 Finished! The result will be examined." << endl << endl;
+    else
+        cout << "[FAIL] Test Case 19 Failed!" << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test19");
+
+    RC rcmain = RBFTest_19(rbfm);
+
+    return rcmain;
+}
@@ -0,0 +1,239 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+const int numRecords = 1000;
+const int maxTextLength = 1000;
+
+void createNoteDescriptor(vector<Attribute> &recordDescriptor, int textLength)
+{
+    Attribute attr;
+    attr.name = "Id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    recordDescriptor.push_back(attr);
+
+    attr.name = "Text";
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)textLength;
+    recordDescriptor.push_back(attr);
+}
+
+// Record i with a text of the given length, in the format of insertRecord
+int prepareNote(int i, int textLength, char *record)
+{
+    int offset = 1;
+    record[0] = 0;
+    memcpy(record + offset, &i, sizeof(int));
+    offset += sizeof(int);
+    memcpy(record + offset, &textLength, sizeof(int));
+    offset += sizeof(int);
+    memset(record + offset, 'a' + i % 26, textLength);
+    return offset + textLength;
+}
+
+// Checks that every record reads as expected, or is gone if deleted unless its slot may have
+// been reused, and that a scan returns each live record once
+int checkNotes(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+               const vector<RID> &rids, const vector<int> &lengths, bool slotsReused = false)
+{
+    char record[maxTextLength + 100];
+    char returnedData[maxTextLength + 100];
+    int live = 0;
+    for (int i = 0; i < numRecords; i++) {
+        RC rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        if (lengths[i] < 0) {
+            if (!slotsReused && rc != RBFM_READ_AFTER_DEL && rc != RBFM_SLOT_DN_EXIST) {
+                cout << "Record " << i << " was deleted but can still be read." << endl;
+                return -1;
+            }
+            continue;
+        }
+        int recordSize = prepareNote(i, lengths[i], record);
+        if (rc != success || memcmp(record, returnedData, recordSize) != 0) {
+            cout << "Record " << i << " is not correct." << endl;
+            return -1;
+        }
+        live++;
+    }
+
+    vector<string> attributeNames;
+    attributeNames.push_back("Id");
+    RBFM_ScanIterator iter;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, "", NO_OP, NULL, attributeNames, iter);
+    assert(rc == success && "Starting a scan should not fail.");
+    vector<int> seen(numRecords, 0);
+    RID rid;
+    int count = 0;
+    while (iter.getNextRecord(rid, returnedData) != RBFM_EOF) {
+        int id = *(int *)(returnedData + 1);
+        if (id < 0 || id >= numRecords || lengths[id] < 0 || seen[id]++) {
+            cout << "The scan returned a wrong record." << endl;
+            iter.close();
+            return -1;
+        }
+        count++;
+    }
+    iter.close();
+    if (count != live) {
+        cout << "The scan returned " << count << " records instead of " << live << "." << endl;
+        return -1;
+    }
+    return 0;
+}
+
+int checkStats(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const string &when, RecordFileStats &stats)
+{
+    RC rc = rbfm->getFileStats(fileHandle, stats);
+    assert(rc == success && "Getting the file statistics should not fail.");
+    cout << when << ": " << stats.records << " records, " << stats.forwardedRecords << " forwarded, longest chain "
+         << stats.longestChain << ", " << stats.deadSlots << " dead slots" << endl;
+    if (stats.longestChain > 1 || stats.forwardingSlots != stats.forwardedRecords) {
+        cout << "A record is more than one hop away from its rid." << endl;
+        return -1;
+    }
+    return 0;
+}
+
+// The texts may be textLength long. PAX_LAYOUT pages have room for half that length per
+// record, so there the texts must get closer to it before records move.
+int testLayout(RecordBasedFileManager *rbfm, PageLayout layout, int textLength)
+{
+    cout << (layout == PAX_LAYOUT ? "PAX layout" : "Row layout") << endl;
+
+    RC rc;
+    string fileName = "test20";
+    rc = rbfm->createFile(fileName, layout);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createNoteDescriptor(recordDescriptor, textLength);
+
+    char record[maxTextLength + 100];
+    vector<RID> rids(numRecords);
+    vector<int> lengths(numRecords, 50);
+    for (int i = 0; i < numRecords; i++) {
+        prepareNote(i, lengths[i], record);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+
+    // Records that grow leave their full pages, and grow again where they went
+    int result = 0;
+    RecordFileStats stats;
+    int growths[] = {textLength * 3 / 5, textLength * 9 / 10};
+    for (int length : growths) {
+        for (int i = 0; i < numRecords; i += 4) {
+            lengths[i] = length;
+            prepareNote(i, lengths[i], record);
+            rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Updating a record should not fail.");
+        }
+        if (result == 0)
+            result = checkNotes(rbfm, fileHandle, recordDescriptor, rids, lengths);
+        if (result == 0)
+            result = checkStats(rbfm, fileHandle, "Texts of " + to_string(length), stats);
+    }
+    if (result == 0 && stats.forwardedRecords == 0) {
+        cout << "No record was moved." << endl;
+        result = -1;
+    }
+
+    // Once the moved records shrink and their neighbours go, their own pages have room again
+    if (result == 0) {
+        for (int i = 0; i < numRecords; i++) {
+            if (i % 4 == 0) {
+                lengths[i] = 20;
+                prepareNote(i, lengths[i], record);
+                rc = rbfm->updateRecord(fileHandle, recordDescriptor, record, rids[i]);
+                assert(rc == success && "Updating a record should not fail.");
+            } else if (i % 2 == 1 || i > numRecords * 3 / 4) {
+                rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rids[i]);
+                assert(rc == success && "Deleting a record should not fail.");
+                lengths[i] = -1;
+            }
+        }
+        result = checkNotes(rbfm, fileHandle, recordDescriptor, rids, lengths);
+    }
+    RecordFileStats before;
+    if (result == 0)
+        result = checkStats(rbfm, fileHandle, "Before the vacuum", before);
+
+    if (result == 0) {
+        rc = rbfm->vacuumFile(fileHandle, recordDescriptor);
+        assert(rc == success && "Vacuuming the file should not fail.");
+        result = checkNotes(rbfm, fileHandle, recordDescriptor, rids, lengths);
+    }
+    if (result == 0)
+        result = checkStats(rbfm, fileHandle, "After the vacuum", stats);
+    if (result == 0 && (stats.forwardedRecords != 0 || stats.records != before.records || stats.deadSlots >= before.deadSlots)) {
+        cout << "The vacuum left records forwarded or dead slots behind." << endl;
+        result = -1;
+    }
+
+    // The file stays usable, and the slots freed are used again
+    if (result == 0) {
+        for (int i = 0; i < numRecords; i += 2) {
+            if (lengths[i] >= 0)
+                continue;
+            lengths[i] = 70;
+            prepareNote(i, lengths[i], record);
+            rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rids[i]);
+            assert(rc == success && "Inserting a record should not fail.");
+        }
+        result = checkNotes(rbfm, fileHandle, recordDescriptor, rids, lengths, true);
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    return result;
+}
+
+int RBFTest_20(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Record-Based File
+    // 2. Update Records that move more than once
+    // 3. File statistics
+    // 4. Vacuum the file
+    // 5. Destroy Record-Based File
+    cout << endl << "***** In RBF Test Case 20 *****" << endl;
+
+    int result = testLayout(rbfm, ROW_LAYOUT, maxTextLength);
+    if (result == 0)
+        result = testLayout(rbfm, PAX_LAYOUT, 100);
+
+    if (result == 0)
+        cout << "RBF Test Case 20 Finished! The result will be examined." << endl << endl;
+    else
+        cout << "[FAIL] Test Case 20 Failed!" << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test20");
+
+    RC rcmain = RBFTest_20(rbfm);
+
+    return rcmain;
+}
@@ -0,0 +1,207 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <functional>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+const int numRecords = 3000;
+
+// The fields of record i; its Age is NULL when ageIsNull
+string getName(int i) { return "Emp" + to_string(i % 50); }
+bool ageIsNull(int i) { return i % 13 == 0; }
+int getAge(int i) { return i % 97; }
+float getHeight(int i) { return (i * 7) % 1000 / 10.0; }
+
+typedef struct PredicateTest
+{
+    string description;
+    vector<ScanPredicate> predicates;
+    function<bool(int)> expected;
+} PredicateTest;
+
+// Scans with the predicates and checks that exactly the records expected are returned
+int checkScan(RecordBasedFileManager *rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+              const PredicateTest &test, unsigned &pagesSkipped)
+{
+    vector<string> attributeNames;
+    attributeNames.push_back("Salary");
+    RBFM_ScanIterator iter;
+    RC rc = rbfm->scan(fileHandle, recordDescriptor, test.predicates, attributeNames, iter);
+    assert(rc == success && "Starting a scan should not fail.");
+
+    vector<int> seen(numRecords, 0);
+    char returnedData[100];
+    RID rid;
+    int count = 0;
+    int result = 0;
+    while (iter.getNextRecord(rid, returnedData) != RBFM_EOF)
+    {
+        int i = *(int *)(returnedData + 1);
+        if (i < 0 || i >= numRecords || !test.expected(i) || seen[i]++)
+        {
+            cout << test.description << ": the scan returned record " << i << " wrongly." << endl;
+            result = -1;
+            break;
+        }
+        count++;
+    }
+    unsigned pagesRead;
+    iter.getScanStats(pagesRead, pagesSkipped);
+    iter.close();
+
+    int expected = 0;
+    for (int i = 0; i < numRecords; i++)
+        expected += test.expected(i);
+    cout << test.description << ": " << count << " records, " << pagesRead << " pages read, " << pagesSkipped
+         << " skipped" << endl;
+    if (result == 0 && count != expected)
+    {
+        cout << test.description << ": the scan returned " << count << " records instead of " << expected << "." << endl;
+        result = -1;
+    }
+    return result;
+}
+
+int testLayout(RecordBasedFileManager *rbfm, PageLayout layout, const vector<string> &encoded)
+{
+    cout << (layout == PAX_LAYOUT ? "PAX layout" : "Row layout") << (encoded.empty() ? "" : ", names encoded") << endl;
+
+    RC rc;
+    string fileName = "test21";
+    rc = rbfm->createFile(fileName, layout, encoded);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+
+    // The Salary of each record is its number
+    char record[100];
+    int recordSize;
+    RID rid;
+    for (int i = 0; i < numRecords; i++)
+    {
+        unsigned char nullsIndicator = ageIsNull(i) ? 0x40 : 0;
+        string name = getName(i);
+        prepareRecord(recordDescriptor.size(), &nullsIndicator, name.size(), name, getAge(i), getHeight(i), i, record,
+                      &recordSize);
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+
+    int age20 = 20, age40 = 40, age10 = 10, age50 = 50, age5 = 5, age1000 = 1000;
+    float height30 = 30, height5 = 5;
+    int salary100 = 100, salary500 = 500, salary1000 = 1000, salary2500 = 2500;
+    char emp7[20], emp3[20];
+    int length = 4;
+    memcpy(emp7, &length, sizeof(int));
+    memcpy(emp7 + sizeof(int), "Emp7", length);
+    memcpy(emp3, &length, sizeof(int));
+    memcpy(emp3 + sizeof(int), "Emp3", length);
+
+    vector<PredicateTest> tests;
+    tests.push_back({"Age >= 20 AND Age < 40 AND Height > 30",
+                     {{"Age", GE_OP, &age20, 0}, {"Age", LT_OP, &age40, 1}, {"Height", GT_OP, &height30, 2}},
+                     [](int i) { return !ageIsNull(i) && getAge(i) >= 20 && getAge(i) < 40 && getHeight(i) > 30; }});
+    tests.push_back({"(Age < 10 OR EmpName = Emp7) AND Salary >= 1000",
+                     {{"Age", LT_OP, &age10, 0}, {"EmpName", EQ_OP, emp7, 0}, {"Salary", GE_OP, &salary1000, 1}},
+                     [](int i) { return ((!ageIsNull(i) && getAge(i) < 10) || getName(i) == "Emp7") && i >= 1000; }});
+    tests.push_back({"EmpName > Emp3 AND (Height <= 5 OR Salary < 100 OR Age = 50)",
+                     {{"EmpName", GT_OP, emp3, 4}, {"Height", LE_OP, &height5, 7}, {"Salary", LT_OP, &salary100, 7},
+                      {"Age", EQ_OP, &age50, 7}},
+                     [](int i) {
+                         return getName(i) > "Emp3"
+                                && (getHeight(i) <= 5 || i < 100 || (!ageIsNull(i) && getAge(i) == 50));
+                     }});
+    tests.push_back({"Age = 1000 AND EmpName <> Emp3",
+                     {{"EmpName", NE_OP, emp3, 0}, {"Age", EQ_OP, &age1000, 1}},
+                     [](int i) { return false; }});
+    tests.push_back({"(Age < 5 OR no condition) AND Salary < 100",
+                     {{"Age", LT_OP, &age5, 0}, {"Age", NO_OP, NULL, 0}, {"Salary", LT_OP, &salary100, 1}},
+                     [](int i) { return i < 100; }});
+    tests.push_back({"Salary >= 500 AND Salary < NULL",
+                     {{"Salary", GE_OP, &salary500, 0}, {"Salary", LT_OP, NULL, 1}},
+                     [](int i) { return false; }});
+    tests.push_back({"Salary < 500 OR Salary >= 2500",
+                     {{"Salary", LT_OP, &salary500, 0}, {"Salary", GE_OP, &salary2500, 0}},
+                     [](int i) { return i < 500 || i >= 2500; }});
+
+    int result = 0;
+    vector<unsigned> skipped(tests.size());
+    for (unsigned t = 0; t < tests.size() && result == 0; t++)
+        result = checkScan(rbfm, fileHandle, recordDescriptor, tests[t], skipped[t]);
+
+    // The zone map on Salary rules out the pages in between
+    if (result == 0 && skipped[6] == 0)
+    {
+        cout << "The zone map was not used with an OR group." << endl;
+        result = -1;
+    }
+
+    if (result == 0)
+    {
+        vector<ScanPredicate> predicates = {{"Age", GE_OP, &age20, 0}, {"Weight", LT_OP, &age40, 1}};
+        vector<string> attributeNames;
+        RBFM_ScanIterator iter;
+        if (rbfm->scan(fileHandle, recordDescriptor, predicates, attributeNames, iter) != RBFM_NO_SUCH_ATTR)
+        {
+            cout << "A scan with a condition on an attribute that does not exist did not fail." << endl;
+            result = -1;
+        }
+        iter.close();
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    return result;
+}
+
+int RBFTest_21(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Record-Based File
+    // 2. Insert Records
+    // 3. Scan with several predicates, in AND and OR groups
+    // 4. Destroy Record-Based File
+    cout << endl << "***** In RBF Test Case 21 *****" << endl;
+
+    vector<string> encoded;
+    int result = testLayout(rbfm, ROW_LAYOUT, encoded);
+    if (result == 0)
+        result = testLayout(rbfm, PAX_LAYOUT, encoded);
+    encoded.push_back("EmpName");
+    if (result == 0)
+        result = testLayout(rbfm, ROW_LAYOUT, encoded);
+
+    if (result == 0)
+        cout << "RBF Test Case 21 Finished! The result will be examined." << endl << endl;
+    else
+        cout << "[FAIL] Test Case 21 Failed!" << endl << endl;
+    return result;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    remove("test21");
+
+    RC rcmain = RBFTest_21(rbfm);
+
+    return rcmain;
+}
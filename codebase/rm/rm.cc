@@ -87,13 +87,14 @@ RC RelationManager::deleteCatalog()
     return SUCCESS;
 }
 
-RC RelationManager::createTable(const string &tableName, const vector<Attribute> &attrs)
+RC RelationManager::createTable(const string &tableName, const vector<Attribute> &attrs, PageLayout layout,
+                                 const vector<string> &dictionaryAttributes, unsigned pageSize)
 {
     RC rc;
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
 
     // Create the rbfm file to store the table
-    if ((rc = rbfm->createFile(getFileName(tableName))))
+    if ((rc = rbfm->createFile(getFileName(tableName), layout, dictionaryAttributes, pageSize)))
         return rc;
 
     // Get the table's ID
@@ -115,6 +116,53 @@ RC RelationManager::createTable(const string &tableName, const vector<Attribute>
     return SUCCESS;
 }
 
+RC RelationManager::compressTable(const string &tableName)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    PagedFileManager *pfm = PagedFileManager::instance();
+
+    // The system tables are updated by every DDL statement
+    bool isSystem;
+    RC rc = isSystemTable(isSystem, tableName);
+    if (rc)
+        return rc;
+    if (isSystem)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    vector<string> indexes;
+    rc = getIndexes(tableName, indexes);
+    if (rc)
+        return rc;
+    rc = rbfm->compressFile(getFileName(tableName));
+    if (rc)
+        return rc;
+    for (const string &attrName : indexes)
+    {
+        rc = pfm->compressFile(getIndexFileName(tableName, attrName));
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
+RC RelationManager::vacuumTable(const string &tableName)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    vector<Attribute> attrs;
+    RC rc = getAttributes(tableName, attrs);
+    if (rc)
+        return rc;
+
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    if (rc)
+        return rc;
+    rc = rbfm->vacuumFile(fileHandle, attrs);
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
 RC RelationManager::deleteTable(const string &tableName)
 {
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
@@ -182,15 +230,16 @@ RC RelationManager::deleteTable(const string &tableName)
         return rc;
     rbfm->closeFile(fileHandle);
 
+    rbfm_si.close();
     rc = rbfm->openFile(getFileName(INDEXES_TABLE_NAME), fileHandle);
     if (rc)
         return rc;
-    rbfm->closeFile(fileHandle);
-    rbfm_si.close();
 
-    value = malloc(TABLES_COL_TABLE_NAME_SIZE);
-    void *columnIndexFileName = malloc(INDEXES_COL_FILE_NAME_SIZE);
-    toAPI(tableName, value);
+    // The value compared against is a bare varchar, with no null indicator
+    value = malloc(VARCHAR_LENGTH_SIZE + tableName.length());
+    void *columnIndexFileName = malloc(1 + VARCHAR_LENGTH_SIZE + INDEXES_COL_FILE_NAME_SIZE);
+    *(int32_t *)value = tableName.length();
+    memcpy((char *)value + VARCHAR_LENGTH_SIZE, tableName.c_str(), tableName.length());
 
     projection.clear();
     projection.push_back(INDEXES_COL_FILE_NAME);
@@ -203,13 +252,13 @@ RC RelationManager::deleteTable(const string &tableName)
     {
         string _columnIndexFileName;
         fromAPI(_columnIndexFileName, columnIndexFileName);
-        rc = rbfm->destroyFile(_columnIndexFileName);
+        rc = IndexManager::instance()->destroyFile(_columnIndexFileName);
         if (rc)
             return rc;
         rc = rbfm->deleteRecord(fileHandle, indexDescriptor, rid);
         if (rc)
             return rc;
-        memset(columnIndexFileName, 0, INDEXES_COL_COLUMN_NAME_SIZE);
+        memset(columnIndexFileName, 0, 1 + VARCHAR_LENGTH_SIZE + INDEXES_COL_FILE_NAME_SIZE);
     }
     free(columnIndexFileName);
     free(value);
@@ -324,6 +373,12 @@ RC RelationManager::getAttributes(const string &tableName, vector<Attribute> &at
     return SUCCESS;
 }
 RC RelationManager::getIndexes(const string &tableName, vector<string> &indexes)
+{
+    vector<vector<string>> includedAttributes;
+    return getIndexes(tableName, indexes, includedAttributes);
+}
+
+RC RelationManager::getIndexes(const string &tableName, vector<string> &indexes, vector<vector<string>> &includedAttributes)
 {
     RC rc = SUCCESS;
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
@@ -339,6 +394,7 @@ RC RelationManager::getIndexes(const string &tableName, vector<string> &indexes)
     void *indexColumnName = malloc(PAGE_SIZE);
     //toAPI(tableName, value);
     projection.push_back(INDEXES_COL_COLUMN_NAME);
+    projection.push_back(INDEXES_COL_INCLUDED);
     rc = rbfm->openFile(getFileName(INDEXES_TABLE_NAME), filehandle);
     if (rc)
     {
@@ -358,6 +414,13 @@ RC RelationManager::getIndexes(const string &tableName, vector<string> &indexes)
         string tmp;
         fromAPI(tmp, indexColumnName);
         indexes.push_back(tmp);
+
+        // The included attributes follow the name
+        char *field = (char *)indexColumnName + 1 + VARCHAR_LENGTH_SIZE + tmp.length();
+        int32_t includedLength;
+        memcpy(&includedLength, field, VARCHAR_LENGTH_SIZE);
+        string included(field + VARCHAR_LENGTH_SIZE, includedLength);
+        includedAttributes.push_back(splitIndexName(included));
         memset(indexColumnName, 0, INDEXES_COL_COLUMN_NAME_SIZE);
     }
     free(indexColumnName);
@@ -385,10 +448,11 @@ RC RelationManager::insertTuple(const string &tableName, const void *data, RID &
     // Get recordDescriptor
     vector<Attribute> recordDescriptor;
     vector<string> columnsWithIndexes;
+    vector<vector<string>> includedAttributes;
     rc = getAttributes(tableName, recordDescriptor);
     if (rc)
         return rc;
-    rc = getIndexes(tableName, columnsWithIndexes);
+    rc = getIndexes(tableName, columnsWithIndexes, includedAttributes);
     if (rc)
         return rc;
 
@@ -401,31 +465,39 @@ RC RelationManager::insertTuple(const string &tableName, const void *data, RID &
     // Let rbfm do all the work
     rc = rbfm->insertRecord(fileHandle, recordDescriptor, data, rid);
     rbfm->closeFile(fileHandle);
+    if (rc)
+        return rc;
 
     // Insert corresponding record into the index
     IndexManager *im = IndexManager::instance();
     IXFileHandle ixFileHandle;
 
-    // Iterate over attributes in recordDescriptor
-    void *value; // This is malloc'd in getColumnFromTuple()
-    for (Attribute attr : recordDescriptor)
+    // Iterate over the indexes of the table
+    void *value; // This is malloc'd in prepareIndexKey()
+    Attribute attr;
+    void *included = malloc(max((unsigned)PAGE_SIZE, RecordBasedFileManager::getMaxDataSize(recordDescriptor)));
+    unsigned includedSize;
+    for (unsigned i = 0; i < columnsWithIndexes.size(); i++)
     {
-        if (std::find(columnsWithIndexes.begin(), columnsWithIndexes.end(), attr.name) != columnsWithIndexes.end())
-        {
-            rc = im->openFile(getIndexFileName(tableName, attr.name), ixFileHandle);
-            if (rc)
-                return rc;
-            rc = RecordBasedFileManager::getColumnFromTuple(data, recordDescriptor, attr.name, value);
-            if (rc)
-                return rc;
-            rc = im->insertEntry(ixFileHandle, attr, value, rid);
-            if (rc)
-                return rc;
-            free(value);
-            im->closeFile(ixFileHandle);
-        }
+        rc = prepareIndexKey(recordDescriptor, data, columnsWithIndexes[i], attr, value);
+        if (rc == RBFM_READ_FAILED) // NULLs are not indexed
+            continue;
+        if (rc)
+            return rc;
+        rc = im->openFile(getIndexFileName(tableName, columnsWithIndexes[i]), ixFileHandle);
+        if (rc)
+            return rc;
+        rc = projectTuple(recordDescriptor, data, includedAttributes[i], included, includedSize);
+        if (rc)
+            return rc;
+        rc = im->insertEntry(ixFileHandle, attr, value, rid, included, includedSize);
+        if (rc)
+            return rc;
+        free(value);
+        im->closeFile(ixFileHandle);
     }
-    return rc;
+    free(included);
+    return SUCCESS;
 }
 
 RC RelationManager::deleteTuple(const string &tableName, const RID &rid)
@@ -452,7 +524,8 @@ RC RelationManager::deleteTuple(const string &tableName, const RID &rid)
     rc = rbfm->openFile(getFileName(tableName), fileHandle);
     if (rc)
         return rc;
-    void *data = malloc(PAGE_SIZE);
+    // Long values are kept in overflow pages, so a tuple may be larger than a page
+    void *data = malloc(max((unsigned)PAGE_SIZE, RecordBasedFileManager::getMaxDataSize(recordDescriptor)));
     rc = rbfm->readRecord(fileHandle, recordDescriptor, rid, data);
     if (rc)
         return rc;
@@ -463,24 +536,24 @@ RC RelationManager::deleteTuple(const string &tableName, const RID &rid)
     if (rc)
         return rc;
     IndexManager *im = IndexManager::instance();
-    // Iterate over attributes in recordDescriptor
-    void *value; // This is malloc'd in getColumnFromTuple()
-    for (Attribute attr : recordDescriptor)
+    // Iterate over the indexes of the table
+    void *value; // This is malloc'd in prepareIndexKey()
+    Attribute attr;
+    for (const string &indexName : columnsWithIndexes)
     {
-        if (std::find(columnsWithIndexes.begin(), columnsWithIndexes.end(), attr.name) != columnsWithIndexes.end())
-        {
-            rc = im->openFile(getIndexFileName(tableName, attr.name), ixFileHandle);
-            if (rc)
-                return rc;
-            rc = RecordBasedFileManager::getColumnFromTuple(data, recordDescriptor, attr.name, value);
-            if (rc)
-                return rc;
-            rc = im->deleteEntry(ixFileHandle, attr, value, rid);
-            if (rc)
-                return rc;
-            free(value);
-            im->closeFile(ixFileHandle);
-        }
+        rc = prepareIndexKey(recordDescriptor, data, indexName, attr, value);
+        if (rc == RBFM_READ_FAILED) // NULLs are not indexed
+            continue;
+        if (rc)
+            return rc;
+        rc = im->openFile(getIndexFileName(tableName, indexName), ixFileHandle);
+        if (rc)
+            return rc;
+        rc = im->deleteEntry(ixFileHandle, attr, value, rid);
+        if (rc)
+            return rc;
+        free(value);
+        im->closeFile(ixFileHandle);
     }
     free(data);
     // Let rbfm do all the work
@@ -516,41 +589,52 @@ RC RelationManager::updateTuple(const string &tableName, const void *data, const
     rc = rbfm->openFile(getFileName(tableName), fileHandle);
     if (rc)
         return rc;
-    void *currentData = malloc(PAGE_SIZE);
+    void *currentData = malloc(max((unsigned)PAGE_SIZE, RecordBasedFileManager::getMaxDataSize(recordDescriptor)));
     rc = rbfm->readRecord(fileHandle, recordDescriptor, rid, currentData);
     if (rc)
         return rc;
 
     IXFileHandle ixFileHandle;
     vector<string> columnsWithIndexes;
-    rc = getIndexes(tableName, columnsWithIndexes);
+    vector<vector<string>> includedAttributes;
+    rc = getIndexes(tableName, columnsWithIndexes, includedAttributes);
     if (rc)
         return rc;
     IndexManager *im = IndexManager::instance();
-    // Iterate over attributes in recordDescriptor
-    void *value; // This is malloc'd in getColumnFromTuple()
-    for (Attribute attr : recordDescriptor)
+    // Iterate over the indexes of the table
+    void *value; // This is malloc'd in prepareIndexKey()
+    Attribute attr;
+    void *included = malloc(max((unsigned)PAGE_SIZE, RecordBasedFileManager::getMaxDataSize(recordDescriptor)));
+    unsigned includedSize;
+    for (unsigned i = 0; i < columnsWithIndexes.size(); i++)
     {
-        if (std::find(columnsWithIndexes.begin(), columnsWithIndexes.end(), attr.name) != columnsWithIndexes.end())
+        rc = im->openFile(getIndexFileName(tableName, columnsWithIndexes[i]), ixFileHandle);
+        if (rc)
+            return rc;
+        rc = prepareIndexKey(recordDescriptor, currentData, columnsWithIndexes[i], attr, value);
+        if (rc == SUCCESS)
         {
-            rc = im->openFile(getIndexFileName(tableName, attr.name), ixFileHandle);
-            if (rc)
-                return rc;
-            rc = RecordBasedFileManager::getColumnFromTuple(currentData, recordDescriptor, attr.name, value);
-            if (rc)
-                return rc;
-            rc = im->deleteEntry(ixFileHandle, attr, value, rid);
+            im->deleteEntry(ixFileHandle, attr, value, rid);
             free(value);
-            rc = RecordBasedFileManager::getColumnFromTuple(data, recordDescriptor, attr.name, value);
-            if (rc)
-                return rc;
-            rc = im->insertEntry(ixFileHandle, attr, value, rid);
+        }
+        else if (rc != RBFM_READ_FAILED) // NULLs are not indexed
+            return rc;
+        rc = prepareIndexKey(recordDescriptor, data, columnsWithIndexes[i], attr, value);
+        if (rc == SUCCESS)
+        {
+            // The included values may have changed even if the key did not
+            rc = projectTuple(recordDescriptor, data, includedAttributes[i], included, includedSize);
+            if (rc == SUCCESS)
+                rc = im->insertEntry(ixFileHandle, attr, value, rid, included, includedSize);
             free(value);
             if (rc)
                 return rc;
-            im->closeFile(ixFileHandle);
         }
+        else if (rc != RBFM_READ_FAILED)
+            return rc;
+        im->closeFile(ixFileHandle);
     }
+    free(included);
     free(currentData);
 
     // Let rbfm do all the work
@@ -718,6 +802,11 @@ vector<Attribute> RelationManager::createIndexDescriptor()
     attr.length = (AttrLength)INDEXES_COL_FILE_NAME_SIZE;
     id.push_back(attr);
 
+    attr.name = INDEXES_COL_INCLUDED;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)INDEXES_COL_INCLUDED_SIZE;
+    id.push_back(attr);
+
     return id;
 }
 
@@ -789,15 +878,17 @@ void RelationManager::prepareColumnsRecordData(int32_t id, int32_t pos, Attribut
     offset += INT_SIZE;
 }
 
-// Prepares the Index table entry for the given name and attribute
-void RelationManager::prepareIndexesRecordData(const string &tableName, const string &attrName, void *data)
+// Prepares the Index table entry for the given name, attribute and included attributes
+void RelationManager::prepareIndexesRecordData(const string &tableName, const string &attrName, const string &included,
+                                               void *data)
 {
     unsigned offset = 0;
 
     int32_t name_len = tableName.length();
     int32_t attr_len = attrName.length();
-    string table_file_name = getFileName(tableName);
-    int32_t file_name_len = table_file_name.length();
+    string index_file_name = getIndexFileName(tableName, attrName);
+    int32_t file_name_len = index_file_name.length();
+    int32_t included_len = included.length();
 
     // All fields non-null
     char null = 0;
@@ -817,9 +908,129 @@ void RelationManager::prepareIndexesRecordData(const string &tableName, const st
     // Copy in varchar file name
     memcpy((char *)data + offset, &file_name_len, VARCHAR_LENGTH_SIZE);
     offset += VARCHAR_LENGTH_SIZE;
-    memcpy((char *)data + offset, table_file_name.c_str(), file_name_len);
+    memcpy((char *)data + offset, index_file_name.c_str(), file_name_len);
     offset += file_name_len;
+    // Copy in varchar included attribute names
+    memcpy((char *)data + offset, &included_len, VARCHAR_LENGTH_SIZE);
+    offset += VARCHAR_LENGTH_SIZE;
+    memcpy((char *)data + offset, included.c_str(), included_len);
+    offset += included_len;
 }
+
+RC RelationManager::projectTuple(const vector<Attribute> &recordDescriptor, const void *tuple,
+                                 const vector<string> &included, void *data, unsigned &size)
+{
+    size = 0;
+    if (included.empty())
+        return SUCCESS;
+
+    int nullIndicatorSize = RecordBasedFileManager::getNullIndicatorSize(included.size());
+    memset(data, 0, nullIndicatorSize);
+    size = nullIndicatorSize;
+    for (unsigned i = 0; i < included.size(); i++)
+    {
+        void *value = nullptr; // This is malloc'd in getColumnFromTuple()
+        RC rc = RecordBasedFileManager::getColumnFromTuple(tuple, recordDescriptor, included[i], value);
+        if (rc == RBFM_READ_FAILED) // NULL value in column
+        {
+            ((char *)data)[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - i % CHAR_BIT);
+            continue;
+        }
+        if (rc)
+            return rc;
+        auto attr = std::find_if(recordDescriptor.begin(), recordDescriptor.end(),
+                                 [&](const Attribute &a) { return a.name == included[i]; });
+        unsigned length = INT_SIZE;
+        if (attr->type == TypeVarChar)
+        {
+            int32_t varcharLength;
+            memcpy(&varcharLength, value, VARCHAR_LENGTH_SIZE);
+            length = VARCHAR_LENGTH_SIZE + varcharLength;
+        }
+        memcpy((char *)data + size, value, length);
+        size += length;
+        free(value);
+    }
+    return SUCCESS;
+}
+
+RC RelationManager::getIndexAttribute(const vector<Attribute> &recordDescriptor, const string &indexName,
+                                      Attribute &indexAttr, vector<Attribute> &keyAttrs)
+{
+    keyAttrs.clear();
+    for (const string &name : splitIndexName(indexName))
+    {
+        auto attr = std::find_if(recordDescriptor.begin(), recordDescriptor.end(),
+                                 [&](const Attribute &a) { return a.name == name; });
+        if (attr == recordDescriptor.end())
+            return RM_ATTR_DOES_NOT_EXIST;
+        keyAttrs.push_back(*attr);
+    }
+    if (keyAttrs.empty())
+        return RM_ATTR_DOES_NOT_EXIST;
+    if (keyAttrs.size() == 1)
+    {
+        indexAttr = keyAttrs[0];
+        return SUCCESS;
+    }
+    indexAttr.name = indexName;
+    indexAttr.type = TypeVarChar;
+    indexAttr.length = IndexManager::getCompositeKeyLength(keyAttrs);
+    return SUCCESS;
+}
+
+RC RelationManager::prepareIndexKey(const vector<Attribute> &recordDescriptor, const void *tuple, const string &indexName,
+                                    Attribute &indexAttr, void *&key)
+{
+    vector<Attribute> keyAttrs;
+    RC rc = getIndexAttribute(recordDescriptor, indexName, indexAttr, keyAttrs);
+    if (rc)
+        return rc;
+    if (keyAttrs.size() == 1)
+        return RecordBasedFileManager::getColumnFromTuple(tuple, recordDescriptor, indexName, key);
+
+    // The values of the key attributes, encoded
+    unsigned size;
+    void *values = malloc(max((unsigned)PAGE_SIZE, RecordBasedFileManager::getMaxDataSize(recordDescriptor)));
+    rc = projectTuple(recordDescriptor, tuple, splitIndexName(indexName), values, size);
+    if (rc)
+    {
+        free(values);
+        return rc;
+    }
+    key = malloc(VARCHAR_LENGTH_SIZE + indexAttr.length);
+    IndexManager::encodeCompositeKey(keyAttrs, keyAttrs.size(), values, key);
+    free(values);
+    return SUCCESS;
+}
+
+string RelationManager::getIndexName(const vector<string> &attributeNames)
+{
+    string indexName;
+    for (const string &name : attributeNames)
+    {
+        if (!indexName.empty())
+            indexName += INDEXES_ATTR_SEPARATOR;
+        indexName += name;
+    }
+    return indexName;
+}
+
+vector<string> RelationManager::splitIndexName(const string &indexName)
+{
+    vector<string> attributeNames;
+    size_t start = 0;
+    while (start < indexName.length())
+    {
+        size_t end = indexName.find(INDEXES_ATTR_SEPARATOR, start);
+        if (end == string::npos)
+            end = indexName.length();
+        attributeNames.push_back(indexName.substr(start, end - start));
+        start = end + 1;
+    }
+    return attributeNames;
+}
+
 // Insert the given columns into the Columns table
 RC RelationManager::insertColumns(int32_t id, const vector<Attribute> &recordDescriptor)
 {
@@ -867,7 +1078,7 @@ RC RelationManager::insertTable(int32_t id, int32_t system, const string &tableN
     return rc;
 }
 
-RC RelationManager::insertIndex(const string &tableName, const string &attrName)
+RC RelationManager::insertIndex(const string &tableName, const string &attrName, const string &included)
 {
     FileHandle fileHandle;
     RID rid;
@@ -879,7 +1090,7 @@ RC RelationManager::insertIndex(const string &tableName, const string &attrName)
         return rc;
 
     void *indexData = malloc(INDEXES_RECORD_DATA_SIZE);
-    prepareIndexesRecordData(tableName, attrName, indexData);
+    prepareIndexesRecordData(tableName, attrName, included, indexData);
     rc = rbfm->insertRecord(fileHandle, indexDescriptor, indexData, rid);
 
     rbfm->closeFile(fileHandle);
@@ -1095,7 +1306,9 @@ RC RelationManager::scan(const string &tableName,
                          const CompOp compOp,
                          const void *value,
                          const vector<string> &attributeNames,
-                         RM_ScanIterator &rm_ScanIterator)
+                         RM_ScanIterator &rm_ScanIterator,
+                         PageNum startPage,
+                         PageNum endPage)
 {
     // Open the file for the given tableName
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
@@ -1111,19 +1324,87 @@ RC RelationManager::scan(const string &tableName,
 
     // Use the underlying rbfm_scaniterator to do all the work
     rc = rbfm->scan(rm_ScanIterator.fileHandle, recordDescriptor, conditionAttribute,
-                    compOp, value, attributeNames, rm_ScanIterator.rbfm_iter);
+                    compOp, value, attributeNames, rm_ScanIterator.rbfm_iter, startPage, endPage);
     if (rc)
         return rc;
     return SUCCESS;
 }
 
+RC RelationManager::scan(const string &tableName,
+                         const vector<ScanPredicate> &predicates,
+                         const vector<string> &attributeNames,
+                         RM_ScanIterator &rm_ScanIterator,
+                         PageNum startPage,
+                         PageNum endPage)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc = rbfm->openFile(getFileName(tableName), rm_ScanIterator.fileHandle);
+    if (rc)
+        return rc;
+
+    vector<Attribute> recordDescriptor;
+    rc = getAttributes(tableName, recordDescriptor);
+    if (rc)
+        return rc;
+
+    return rbfm->scan(rm_ScanIterator.fileHandle, recordDescriptor, predicates, attributeNames,
+                      rm_ScanIterator.rbfm_iter, startPage, endPage);
+}
+
 // Let rbfm do all the work
 RC RM_ScanIterator::getNextTuple(RID &rid, void *data)
 {
     return rbfm_iter.getNextRecord(rid, data);
 }
 
-RC RelationManager::createIndex(const string &tableName, const string &attributeName)
+RC RM_ScanIterator::setPageRange(PageNum startPage, PageNum endPage)
+{
+    return rbfm_iter.setPageRange(startPage, endPage);
+}
+
+void RM_ScanIterator::getScanStats(unsigned &pagesRead, unsigned &pagesSkipped) const
+{
+    rbfm_iter.getScanStats(pagesRead, pagesSkipped);
+}
+
+RC RelationManager::getNumberOfPages(const string &tableName, unsigned &pageCount)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    FileHandle fileHandle;
+    RC rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    if (rc)
+        return rc;
+
+    pageCount = fileHandle.getNumberOfPages();
+    rbfm->closeFile(fileHandle);
+    return SUCCESS;
+}
+
+RC RelationManager::getPageRanges(const string &tableName, unsigned count, SplitMode mode, vector<PageRange> &ranges)
+{
+    vector<Attribute> recordDescriptor;
+    RC rc = getAttributes(tableName, recordDescriptor);
+    if (rc)
+        return rc;
+
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    FileHandle fileHandle;
+    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    if (rc)
+        return rc;
+    rc = rbfm->getPageRanges(fileHandle, recordDescriptor, count, mode, ranges);
+    rbfm->closeFile(fileHandle);
+    return rc;
+}
+
+RC RelationManager::createIndex(const string &tableName, const string &attributeName,
+                                const vector<string> &includedAttributes, IndexKind kind)
+{
+    return createIndex(tableName, vector<string>(1, attributeName), includedAttributes, kind);
+}
+
+RC RelationManager::createIndex(const string &tableName, const vector<string> &attributeNames,
+                                const vector<string> &includedAttributes, IndexKind kind)
 {
     RC rc;
 
@@ -1133,36 +1414,53 @@ RC RelationManager::createIndex(const string &tableName, const string &attribute
     if (rc != SUCCESS)
         return rc;
 
-    // Ensure index on attribute is attribute of table.
+    // Ensure index on attributes is on attributes of table.
     vector<Attribute> tableAttrs;
     rc = getAttributes(tableName, tableAttrs);
     if (rc != SUCCESS)
         return rc;
 
-    int attrIndex = -1;
-    for (auto it = tableAttrs.begin(); it != tableAttrs.end(); it++)
+    string attributeName = getIndexName(attributeNames);
+    Attribute indexAttr;
+    vector<Attribute> keyAttrs;
+    rc = getIndexAttribute(tableAttrs, attributeName, indexAttr, keyAttrs);
+    if (rc != SUCCESS || keyAttrs.size() != attributeNames.size())
+        return RM_ATTR_DOES_NOT_EXIST;
+    if (attributeName.length() > INDEXES_COL_COLUMN_NAME_SIZE)
+        return RM_KEY_TOO_LONG;
+
+    // The included attributes must be attributes of the table too, and leave room for several
+    // entries in a leaf.
+    vector<Attribute> includedAttrs;
+    for (const string &name : includedAttributes)
     {
-        auto index = std::distance(tableAttrs.begin(), it);
-        Attribute attr = *it;
-        if (attr.name.compare(attributeName) == 0)
-        {
-            attrIndex = index;
-            break;
-        }
+        auto attr = std::find_if(tableAttrs.begin(), tableAttrs.end(), [&](const Attribute &a) { return a.name == name; });
+        if (attr == tableAttrs.end() || name.find(INDEXES_ATTR_SEPARATOR) != string::npos)
+            return RM_ATTR_DOES_NOT_EXIST;
+        includedAttrs.push_back(*attr);
     }
+    string included = getIndexName(includedAttributes);
+    if (included.length() > INDEXES_COL_INCLUDED_SIZE)
+        return RM_INCLUDED_TOO_LONG;
 
-    bool hasTargetAttr = attrIndex >= 0;
-    if (!hasTargetAttr)
-        return RM_ATTR_DOES_NOT_EXIST;
-
-    // Create index file.
+    // Create index file, with the page size of the table's file.
+    FileHandle fileHandle;
+    rc = RecordBasedFileManager::instance()->openFile(getFileName(tableName), fileHandle);
+    if (rc != SUCCESS)
+        return rc;
+    unsigned pageSize = fileHandle.getPageSize();
+    RecordBasedFileManager::instance()->closeFile(fileHandle);
+    if (!includedAttrs.empty() && RecordBasedFileManager::getMaxDataSize(includedAttrs) > pageSize / 4)
+        return RM_INCLUDED_TOO_LONG;
+    if (keyAttrs.size() > 1 && (unsigned)indexAttr.length > pageSize / 4)
+        return RM_KEY_TOO_LONG;
     IndexManager *ixm = IndexManager::instance();
-    rc = ixm->createFile(getIndexFileName(tableName, attributeName));
+    rc = ixm->createFile(getIndexFileName(tableName, attributeName), kind, pageSize);
     if (rc != SUCCESS) // This also fails when index file already exists.
         return rc;
 
     // Insert into index catalog.
-    rc = insertIndex(tableName, attributeName);
+    rc = insertIndex(tableName, attributeName, included);
     if (rc != SUCCESS)
     {
         ixm->destroyFile(getIndexFileName(tableName, attributeName)); // Try to cleanup index file from before.
@@ -1171,7 +1469,7 @@ RC RelationManager::createIndex(const string &tableName, const string &attribute
 
     // For each tuple in the table:
     //     For each index on the table:
-    //         get new key by projecting only the attribute of the index
+    //         get new key by projecting only the attributes of the index
     //         insert <key, rid> into index.
 
     RM_ScanIterator rmsi;
@@ -1198,14 +1496,16 @@ RC RelationManager::createIndex(const string &tableName, const string &attribute
     }
 
     RID rid;
-    void *data = calloc(PAGE_SIZE, sizeof(uint32_t));
+    void *data = calloc(max((unsigned)PAGE_SIZE, RecordBasedFileManager::getMaxDataSize(tableAttrs)), sizeof(uint32_t));
     //void *value = calloc(PAGE_SIZE, sizeof(uint32_t));
+    void *includedData = malloc(max((unsigned)PAGE_SIZE, RecordBasedFileManager::getMaxDataSize(tableAttrs)));
+    unsigned includedSize;
 
     // For each tuple in the table, insert into our index.
     while ((rc = rmsi.getNextTuple(rid, data)) == SUCCESS)
     {
-        void *value = nullptr; // This is alloc'd in getColumnFromTuple.
-        rc = RecordBasedFileManager::getColumnFromTuple(data, tableAttrs, tableAttrs[attrIndex].name, value);
+        void *value = nullptr; // This is alloc'd in prepareIndexKey.
+        rc = prepareIndexKey(tableAttrs, data, attributeName, indexAttr, value);
         if (rc)
         {
             if (rc == RBFM_READ_FAILED) // NULL value in column.
@@ -1217,23 +1517,28 @@ RC RelationManager::createIndex(const string &tableName, const string &attribute
             else
             {
                 free(data);
+                free(includedData);
                 if (value != nullptr)
                     free(value);
                 rmsi.close();
                 return rc; // Some other error means something broke.
             }
         }
-        rc = ixm->insertEntry(ixFileHandle, tableAttrs[attrIndex], value, rid);
+        rc = projectTuple(tableAttrs, data, includedAttributes, includedData, includedSize);
+        if (rc == SUCCESS)
+            rc = ixm->insertEntry(ixFileHandle, indexAttr, value, rid, includedData, includedSize);
         free(value);
         if (rc)
         {
             free(data);
+            free(includedData);
             rmsi.close();
             return rc;
         }
     }
     ixm->closeFile(ixFileHandle);
     free(data);
+    free(includedData);
     rmsi.close();
     return SUCCESS;
 }
@@ -1248,21 +1553,14 @@ RC RelationManager::destroyIndex(const string &tableName, const string &attribut
     if (rc != SUCCESS)
         return rc;
 
-    // Ensure index on attribute is attribute of table.
+    // Ensure index on attributes is on attributes of table.
     vector<Attribute> tableAttrs;
     rc = getAttributes(tableName, tableAttrs);
     if (rc != SUCCESS)
         return rc;
-    bool hasTargetAttr = false;
-    for (auto attr : tableAttrs)
-    {
-        if (attr.name.compare(attributeName) == 0)
-        {
-            hasTargetAttr = true;
-            break;
-        }
-    }
-    if (!hasTargetAttr)
+    Attribute indexAttr;
+    vector<Attribute> keyAttrs;
+    if (getIndexAttribute(tableAttrs, attributeName, indexAttr, keyAttrs) != SUCCESS)
         return RM_ATTR_DOES_NOT_EXIST;
 
     // Destroy index file.
@@ -1327,13 +1625,40 @@ RC RelationManager::destroyIndex(const string &tableName, const string &attribut
     return SUCCESS;
 }
 
+RC RelationManager::destroyIndex(const string &tableName, const vector<string> &attributeNames)
+{
+    return destroyIndex(tableName, getIndexName(attributeNames));
+}
+
+RC RelationManager::createIndexFilter(const string &tableName, const string &attributeName)
+{
+    vector<Attribute> tableAttrs;
+    RC rc = getAttributes(tableName, tableAttrs);
+    if (rc != SUCCESS)
+        return rc;
+    Attribute indexAttr;
+    vector<Attribute> keyAttrs;
+    if (getIndexAttribute(tableAttrs, attributeName, indexAttr, keyAttrs) != SUCCESS)
+        return RM_ATTR_DOES_NOT_EXIST;
+
+    IndexManager *ixm = IndexManager::instance();
+    IXFileHandle ixFileHandle;
+    rc = ixm->openFile(getIndexFileName(tableName, attributeName), ixFileHandle);
+    if (rc != SUCCESS)
+        return rc;
+    rc = ixm->createFilter(ixFileHandle, indexAttr);
+    ixm->closeFile(ixFileHandle);
+    return rc;
+}
+
 RC RelationManager::indexScan(const string &tableName,
                               const string &attributeName,
                               const void *lowKey,
                               const void *highKey,
                               bool lowKeyInclusive,
                               bool highKeyInclusive,
-                              RM_IndexScanIterator &rm_IndexScanIterator)
+                              RM_IndexScanIterator &rm_IndexScanIterator,
+                              bool descending)
 {
     RC rc;
 
@@ -1343,23 +1668,14 @@ RC RelationManager::indexScan(const string &tableName,
     if (rc != SUCCESS)
         return rc;
 
-    // Ensure index on attribute is attribute of table.
+    // Ensure index on attributes is on attributes of table.
     Attribute targetAttr; // Get the matching attribute.
     vector<Attribute> tableAttrs;
     rc = getAttributes(tableName, tableAttrs);
     if (rc != SUCCESS)
         return rc;
-    bool hasTargetAttr = false;
-    for (auto attr : tableAttrs)
-    {
-        if (attr.name.compare(attributeName) == 0)
-        {
-            hasTargetAttr = true;
-            targetAttr = attr;
-            break;
-        }
-    }
-    if (!hasTargetAttr)
+    vector<Attribute> keyAttrs;
+    if (getIndexAttribute(tableAttrs, attributeName, targetAttr, keyAttrs) != SUCCESS)
         return RM_ATTR_DOES_NOT_EXIST;
 
     IndexManager *ixm = IndexManager::instance();
@@ -1375,7 +1691,8 @@ RC RelationManager::indexScan(const string &tableName,
         highKey,
         lowKeyInclusive,
         highKeyInclusive,
-        rm_IndexScanIterator.indexScanIterator);
+        rm_IndexScanIterator.indexScanIterator,
+        descending);
     if (rc != SUCCESS)
         return rc;
 
@@ -1384,6 +1701,81 @@ RC RelationManager::indexScan(const string &tableName,
     return SUCCESS;
 }
 
+RC RelationManager::indexScan(const string &tableName,
+                              const vector<string> &attributeNames,
+                              const void *lowKey,
+                              unsigned lowKeyLength,
+                              const void *highKey,
+                              unsigned highKeyLength,
+                              bool lowKeyInclusive,
+                              bool highKeyInclusive,
+                              RM_IndexScanIterator &rm_IndexScanIterator,
+                              bool descending)
+{
+    vector<Attribute> tableAttrs;
+    RC rc = getAttributes(tableName, tableAttrs);
+    if (rc != SUCCESS)
+        return rc;
+    string indexName = getIndexName(attributeNames);
+    Attribute indexAttr;
+    vector<Attribute> keyAttrs;
+    if (getIndexAttribute(tableAttrs, indexName, indexAttr, keyAttrs) != SUCCESS || keyAttrs.size() != attributeNames.size()
+        || lowKeyLength > keyAttrs.size() || highKeyLength > keyAttrs.size())
+        return RM_ATTR_DOES_NOT_EXIST;
+
+    // The scan compares entries with its bounds until it ends, so it keeps its own copies
+    rm_IndexScanIterator.lowKey = NULL;
+    rm_IndexScanIterator.highKey = NULL;
+    if (keyAttrs.size() == 1)
+    {
+        // A bound on one attribute is just its value, and bounds on none leave the scan open
+        const void *low = lowKey == NULL || lowKeyLength == 0 ? NULL : (char *)lowKey + 1;
+        const void *high = highKey == NULL || highKeyLength == 0 ? NULL : (char *)highKey + 1;
+        if ((low != NULL && *(char *)lowKey) || (high != NULL && *(char *)highKey)) // NULLs are not indexed
+            return RM_NULL_COLUMN;
+        // A varchar bound may be longer than any value of the attribute
+        if (low != NULL)
+        {
+            size_t size = indexAttr.type == TypeVarChar ? VARCHAR_LENGTH_SIZE + *(int32_t *)low : INT_SIZE;
+            rm_IndexScanIterator.lowKey = malloc(size);
+            memcpy(rm_IndexScanIterator.lowKey, low, size);
+        }
+        if (high != NULL)
+        {
+            size_t size = indexAttr.type == TypeVarChar ? VARCHAR_LENGTH_SIZE + *(int32_t *)high : INT_SIZE;
+            rm_IndexScanIterator.highKey = malloc(size);
+            memcpy(rm_IndexScanIterator.highKey, high, size);
+        }
+    }
+    else
+    {
+        // A prefix bound is past its prefix where it must take in the keys that start with it
+        if (lowKey != NULL && lowKeyLength > 0)
+        {
+            rm_IndexScanIterator.lowKey = malloc(VARCHAR_LENGTH_SIZE + indexAttr.length);
+            IndexManager::encodeCompositeKey(keyAttrs, lowKeyLength, lowKey, rm_IndexScanIterator.lowKey, !lowKeyInclusive);
+        }
+        if (highKey != NULL && highKeyLength > 0)
+        {
+            rm_IndexScanIterator.highKey = malloc(VARCHAR_LENGTH_SIZE + indexAttr.length);
+            IndexManager::encodeCompositeKey(keyAttrs, highKeyLength, highKey, rm_IndexScanIterator.highKey, highKeyInclusive);
+        }
+        if (lowKeyLength < keyAttrs.size())
+            lowKeyInclusive = true;
+        if (highKeyLength < keyAttrs.size())
+            highKeyInclusive = false;
+    }
+    rc = indexScan(tableName, indexName, rm_IndexScanIterator.lowKey, rm_IndexScanIterator.highKey, lowKeyInclusive,
+                   highKeyInclusive, rm_IndexScanIterator, descending);
+    if (rc != SUCCESS)
+    {
+        free(rm_IndexScanIterator.lowKey);
+        free(rm_IndexScanIterator.highKey);
+        rm_IndexScanIterator.lowKey = rm_IndexScanIterator.highKey = NULL;
+    }
+    return rc;
+}
+
 RC RM_IndexScanIterator::getNextEntry(RID &rid, void *key)
 {
     if (closed)
@@ -1391,6 +1783,13 @@ RC RM_IndexScanIterator::getNextEntry(RID &rid, void *key)
     return indexScanIterator.getNextEntry(rid, key);
 }
 
+RC RM_IndexScanIterator::getNextEntry(RID &rid, void *key, void *included, unsigned &includedSize)
+{
+    if (closed)
+        return -1;
+    return indexScanIterator.getNextEntry(rid, key, included, includedSize);
+}
+
 RC RM_IndexScanIterator::close()
 {
     if (closed)
@@ -1398,6 +1797,10 @@ RC RM_IndexScanIterator::close()
 
     RC rc;
 
+    free(lowKey);
+    free(highKey);
+    lowKey = highKey = nullptr;
+
     rc = indexScanIterator.close();
     if (rc != SUCCESS)
         return rc;
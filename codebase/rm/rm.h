@@ -50,18 +50,26 @@ using namespace std;
 #define INDEXES_COL_TABLE_NAME "table-name"
 #define INDEXES_COL_COLUMN_NAME "attr-name"
 #define INDEXES_COL_FILE_NAME "file-name"
+#define INDEXES_COL_INCLUDED "included-attrs"
 #define INDEXES_COL_TABLE_NAME_SIZE 50
 #define INDEXES_COL_COLUMN_NAME_SIZE 50
 #define INDEXES_COL_FILE_NAME_SIZE 50
+#define INDEXES_COL_INCLUDED_SIZE 200
 
-// 1 null byte, 3 integer fields and 3 varchars
-#define INDEXES_RECORD_DATA_SIZE 1 + 3 * INT_SIZE + INDEXES_COL_TABLE_NAME_SIZE + INDEXES_COL_COLUMN_NAME_SIZE + INDEXES_COL_FILE_NAME_SIZE
+// The attributes of a composite index are kept in attr-name, and those an index includes in
+// included-attrs, separated by commas
+#define INDEXES_ATTR_SEPARATOR ','
+
+// 1 null byte, 4 integer fields and 4 varchars
+#define INDEXES_RECORD_DATA_SIZE 1 + 4 * INT_SIZE + INDEXES_COL_TABLE_NAME_SIZE + INDEXES_COL_COLUMN_NAME_SIZE + INDEXES_COL_FILE_NAME_SIZE + INDEXES_COL_INCLUDED_SIZE
 
 #define RM_EOF (-1) // end of a scan operator
 
 #define RM_CANNOT_MOD_SYS_TBL 1
 #define RM_NULL_COLUMN 2
 #define RM_ATTR_DOES_NOT_EXIST 3
+#define RM_INCLUDED_TOO_LONG 4
+#define RM_KEY_TOO_LONG 5
 
 typedef struct IndexedAttr
 {
@@ -80,6 +88,12 @@ public:
   RC getNextTuple(RID &rid, void *data);
   RC close();
 
+  // Restart the scan on pages [startPage, endPage) of the table only
+  RC setPageRange(PageNum startPage, PageNum endPage);
+
+  // Pages read, and pages the zone map let the scan skip
+  void getScanStats(unsigned &pagesRead, unsigned &pagesSkipped) const;
+
   friend class RelationManager;
 
 private:
@@ -95,11 +109,17 @@ public:
   IX_ScanIterator indexScanIterator;
   bool closed;
 
+  void *lowKey = nullptr;    // The bounds of a scan of a composite index, encoded
+  void *highKey = nullptr;
+
   RM_IndexScanIterator(){};  // Constructor
   ~RM_IndexScanIterator(){}; // Destructor
 
   // "key" follows the same format as in IndexManager::insertEntry()
   RC getNextEntry(RID &rid, void *key); // Get next matching entry
+  // Also gets the values of the attributes the index includes, as a tuple of just them in
+  // the order of RelationManager::getIndexes(); includedSize is 0 if the index includes none
+  RC getNextEntry(RID &rid, void *key, void *included, unsigned &includedSize);
   RC close();                           // Terminate index scan
 };
 
@@ -115,12 +135,27 @@ public:
 
   RC deleteCatalog();
 
-  RC createTable(const string &tableName, const vector<Attribute> &attrs);
+  // The layout decides how the table's pages store its tuples; see PageLayout. The varchar
+  // attributes named in dictionaryAttributes are dictionary-encoded; see VarCharDictionary.
+  // The table's file, and the files of its indexes, have pages of pageSize bytes
+  RC createTable(const string &tableName, const vector<Attribute> &attrs, PageLayout layout = ROW_LAYOUT,
+                 const vector<string> &dictionaryAttributes = vector<string>(), unsigned pageSize = PAGE_SIZE);
 
   RC deleteTable(const string &tableName);
 
+  // Rewrites the table and its indexes as compressed files, for tables that are rarely updated
+  // but still scanned. They stay fully usable, updates just cost more.
+  RC compressTable(const string &tableName);
+
+  // Moves the table's forwarded tuples back to their own page where there is room and drops
+  // trailing deleted slots; see RecordBasedFileManager::vacuumFile. Rids of tuples, and so
+  // the indexes, are unchanged.
+  RC vacuumTable(const string &tableName);
+
   RC getAttributes(const string &tableName, vector<Attribute> &attrs);
   RC getIndexes(const string &tableName, vector<string> &indexes);
+  // Also gets the attributes each index includes, see createIndex
+  RC getIndexes(const string &tableName, vector<string> &indexes, vector<vector<string>> &includedAttributes);
 
   RC insertTuple(const string &tableName, const void *data, RID &rid);
 
@@ -136,6 +171,13 @@ public:
 
   RC readAttribute(const string &tableName, const RID &rid, const string &attributeName, void *data);
 
+  // Number of pages in the table's file, for splitting a scan into page ranges
+  RC getNumberOfPages(const string &tableName, unsigned &pageCount);
+
+  // Splits the table's pages into at most count ranges to scan in parallel, see
+  // RecordBasedFileManager::getPageRanges
+  RC getPageRanges(const string &tableName, unsigned count, SplitMode mode, vector<PageRange> &ranges);
+
   // Scan returns an iterator to allow the caller to go through the results one by one.
   // Do not store entire results in the scan iterator.
   RC scan(const string &tableName,
@@ -143,20 +185,66 @@ public:
           const CompOp compOp,                  // comparison type such as "<" and "="
           const void *value,                    // used in the comparison
           const vector<string> &attributeNames, // a list of projected attributes
-          RM_ScanIterator &rm_ScanIterator);
+          RM_ScanIterator &rm_ScanIterator,
+          PageNum startPage = 0,                // only pages [startPage, endPage) are scanned
+          PageNum endPage = SCAN_TO_END);
 
-  RC createIndex(const string &tableName, const string &attributeName);
+  // Scan with any number of predicates, see ScanPredicate
+  RC scan(const string &tableName,
+          const vector<ScanPredicate> &predicates,
+          const vector<string> &attributeNames,
+          RM_ScanIterator &rm_ScanIterator,
+          PageNum startPage = 0,
+          PageNum endPage = SCAN_TO_END);
+
+  // The index on attributeName keeps the values of includedAttributes with each entry too, so
+  // that a query needing only those and the key can be answered from the index alone. An
+  // LSM_INDEX takes changes faster than a B+ tree, for tables written more than read.
+  RC createIndex(const string &tableName, const string &attributeName,
+                 const vector<string> &includedAttributes = vector<string>(), IndexKind kind = BTREE_INDEX);
+  // A composite index, ordered by the attributes one after another; see getIndexName
+  RC createIndex(const string &tableName, const vector<string> &attributeNames,
+                 const vector<string> &includedAttributes = vector<string>(), IndexKind kind = BTREE_INDEX);
 
   RC destroyIndex(const string &tableName, const string &attributeName);
+  RC destroyIndex(const string &tableName, const vector<string> &attributeNames);
+  // Gives the index a Bloom filter of its keys, so that an equality scan for a key it does not
+  // have reads no page of it; built again if the index already has one
+  RC createIndexFilter(const string &tableName, const string &attributeName);
 
-  // indexScan returns an iterator to allow the caller to go through qualified entries in index
+  // indexScan returns an iterator to allow the caller to go through qualified entries in index,
+  // or with descending from the high key down
   RC indexScan(const string &tableName,
                const string &attributeName,
                const void *lowKey,
                const void *highKey,
                bool lowKeyInclusive,
                bool highKeyInclusive,
-               RM_IndexScanIterator &rm_IndexScanIterator);
+               RM_IndexScanIterator &rm_IndexScanIterator,
+               bool descending = false);
+
+  // Scan of a composite index. lowKey and highKey are tuples, in the format of insertTuple, of
+  // the first lowKeyLength and highKeyLength of its attributes; a bound on fewer attributes
+  // than the index has bounds every key that starts with its values, so that a scan can
+  // match on a prefix of the key and take a range of the next attribute.
+  RC indexScan(const string &tableName,
+               const vector<string> &attributeNames,
+               const void *lowKey,
+               unsigned lowKeyLength,
+               const void *highKey,
+               unsigned highKeyLength,
+               bool lowKeyInclusive,
+               bool highKeyInclusive,
+               RM_IndexScanIterator &rm_IndexScanIterator,
+               bool descending = false);
+
+  // The name of the index on the attributes, as getIndexes gives it
+  static string getIndexName(const vector<string> &attributeNames);
+  static vector<string> splitIndexName(const string &indexName);
+  // Gets the attribute the index on indexName is keyed on: the table's attribute, or the
+  // varchar of the encoded values of a composite index
+  RC getIndexAttribute(const vector<Attribute> &recordDescriptor, const string &indexName, Attribute &indexAttr,
+                       vector<Attribute> &keyAttrs);
 
   // Convert tableName to index file name (append extension).
   static string getIndexFileName(const char *tableName, const char *attributeName);
@@ -185,14 +273,22 @@ private:
   // Prepare an entry for the Table/Column/Index table
   void prepareTablesRecordData(int32_t id, bool system, const string &tableName, void *data);
   void prepareColumnsRecordData(int32_t id, int32_t pos, Attribute attr, void *data);
-  void prepareIndexesRecordData(const string &tableName, const string &attrName, void *data);
+  void prepareIndexesRecordData(const string &tableName, const string &attrName, const string &included, void *data);
+  // Prepares the values of the named attributes of tuple as a tuple of just them, or sets size
+  // to 0 if there are none
+  RC projectTuple(const vector<Attribute> &recordDescriptor, const void *tuple, const vector<string> &attributeNames,
+                  void *data, unsigned &size);
+  // Prepares the key of tuple in the index on indexName. key is malloc'd; it is not set, and
+  // RBFM_READ_FAILED returned, if the key of an index on a single attribute is NULL
+  RC prepareIndexKey(const vector<Attribute> &recordDescriptor, const void *tuple, const string &indexName,
+                     Attribute &indexAttr, void *&key);
 
   // Given a table ID and recordDescriptor, creates entries in Column table
   RC insertColumns(int32_t id, const vector<Attribute> &recordDescriptor);
   // Given table ID, system flag, and table name, creates entry in Table table
   RC insertTable(int32_t id, int32_t system, const string &tableName);
   // Given a table ID and attribute name, creates entry in Index table
-  RC insertIndex(const string &tableName, const string &attrName);
+  RC insertIndex(const string &tableName, const string &attrName, const string &included);
 
   // Get next table ID for creating table
   RC getNextTableID(int32_t &table_id);
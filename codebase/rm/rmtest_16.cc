@@ -0,0 +1,203 @@
+#include <thread>
+
+#include "rm_test_util.h"
+
+const int numTuples = 20000;
+const unsigned numRanges = 4;
+
+// Scans the range with its own iterator, and so its own FileHandle, counting the tuples seen
+void scanRange(const string &tableName, PageRange range, vector<int> *seen, int *count, RC *rc)
+{
+    vector<string> attributes;
+    attributes.push_back("Age");
+    RM_ScanIterator rmsi;
+    *rc = rm->scan(tableName, "", NO_OP, NULL, attributes, rmsi, range.startPage, range.endPage);
+    if (*rc)
+        return;
+    char returnedData[100];
+    RID rid;
+    *count = 0;
+    while (rmsi.getNextTuple(rid, returnedData) != RM_EOF)
+    {
+        int age = *(int *)(returnedData + 1);
+        if (age >= 0 && age < numTuples)
+            (*seen)[age]++;
+        (*count)++;
+    }
+    rmsi.close();
+}
+
+// Checks that the ranges cover the table in order, and returns the most tuples one range has
+int checkRanges(const string &tableName, const vector<PageRange> &ranges, unsigned numPages, const vector<bool> &live,
+                int &largest)
+{
+    PageNum next = 0;
+    for (const PageRange &range : ranges)
+    {
+        if (range.startPage != next || range.endPage <= range.startPage)
+        {
+            cout << "The ranges do not cover the table in order." << endl;
+            return -1;
+        }
+        next = range.endPage;
+    }
+    if (ranges.size() != numRanges || next != numPages)
+    {
+        cout << "The ranges do not cover the table in order." << endl;
+        return -1;
+    }
+
+    // Every range on its own thread, each tuple seen by exactly one of them
+    vector<vector<int>> seen(ranges.size(), vector<int>(numTuples, 0));
+    vector<int> counts(ranges.size(), 0);
+    vector<RC> rcs(ranges.size(), success);
+    vector<thread> threads;
+    for (unsigned i = 0; i < ranges.size(); i++)
+        threads.push_back(thread(scanRange, tableName, ranges[i], &seen[i], &counts[i], &rcs[i]));
+    for (thread &t : threads)
+        t.join();
+
+    largest = 0;
+    for (unsigned i = 0; i < ranges.size(); i++)
+    {
+        assert(rcs[i] == success && "RelationManager::scan() should not fail.");
+        cout << "  pages [" << ranges[i].startPage << ", " << ranges[i].endPage << "): " << counts[i] << " tuples, "
+             << ranges[i].records << " estimated" << endl;
+        if ((unsigned)counts[i] != ranges[i].records)
+        {
+            cout << "The estimate of a range is not its number of tuples." << endl;
+            return -1;
+        }
+        largest = max(largest, counts[i]);
+    }
+    for (int age = 0; age < numTuples; age++)
+    {
+        int times = 0;
+        for (unsigned i = 0; i < ranges.size(); i++)
+            times += seen[i][age];
+        if (times != (live[age] ? 1 : 0))
+        {
+            cout << "Tuple " << age << " was seen " << times << " times." << endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+RC TEST_RM_16(const string &tableName)
+{
+    // Functions Tested
+    // 1. Insert and delete tuples
+    // 2. Split the table into page ranges by pages and by records
+    // 3. Scan the ranges in parallel
+    cout << endl << "***** In RM Test Case 16 *****" << endl;
+
+    rm->deleteTable(tableName);
+    RC rc = createTable(tableName);
+    assert(rc == success && "Creating the table should not fail.");
+
+    vector<Attribute> attrs;
+    rc = rm->getAttributes(tableName, attrs);
+    assert(rc == success && "RelationManager::getAttributes() should not fail.");
+    int nullAttributesIndicatorActualSize = getActualByteForNullsIndicator(attrs.size());
+    unsigned char *nullsIndicator = (unsigned char *)malloc(nullAttributesIndicatorActualSize);
+    memset(nullsIndicator, 0, nullAttributesIndicatorActualSize);
+
+    // The Age of each tuple is its number
+    void *tuple = malloc(200);
+    int tupleSize;
+    vector<RID> rids(numTuples);
+    for (int i = 0; i < numTuples; i++)
+    {
+        string name = "Employee" + to_string(i % 1000);
+        prepareTuple(attrs.size(), nullsIndicator, name.size(), name, i, i / 3.0, i % 5000, tuple, &tupleSize);
+        rc = rm->insertTuple(tableName, tuple, rids[i]);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    }
+
+    // Leave the first half of the table nearly empty
+    vector<bool> live(numTuples, true);
+    for (int i = 0; i < numTuples / 2; i++)
+    {
+        if (i % 10 == 0)
+            continue;
+        rc = rm->deleteTuple(tableName, rids[i]);
+        assert(rc == success && "RelationManager::deleteTuple() should not fail.");
+        live[i] = false;
+    }
+
+    unsigned numPages;
+    rc = rm->getNumberOfPages(tableName, numPages);
+    assert(rc == success && "RelationManager::getNumberOfPages() should not fail.");
+    int liveTuples = numTuples / 2 + numTuples / 20;
+    cout << liveTuples << " tuples on " << numPages << " pages" << endl;
+
+    int result = 0;
+    int largestByPages = 0, largestByRecords = 0;
+    vector<PageRange> ranges;
+    rc = rm->getPageRanges(tableName, numRanges, SPLIT_BY_PAGES, ranges);
+    assert(rc == success && "RelationManager::getPageRanges() should not fail.");
+    cout << "Split by pages" << endl;
+    result = checkRanges(tableName, ranges, numPages, live, largestByPages);
+    for (unsigned i = 0; i < ranges.size() && result == 0; i++)
+    {
+        unsigned pages = ranges[i].endPage - ranges[i].startPage;
+        if (pages < numPages / numRanges || pages > numPages / numRanges + 1)
+        {
+            cout << "The ranges do not have as many pages each." << endl;
+            result = -1;
+        }
+    }
+
+    if (result == 0)
+    {
+        rc = rm->getPageRanges(tableName, numRanges, SPLIT_BY_RECORDS, ranges);
+        assert(rc == success && "RelationManager::getPageRanges() should not fail.");
+        cout << "Split by records" << endl;
+        result = checkRanges(tableName, ranges, numPages, live, largestByRecords);
+    }
+    if (result == 0 && (largestByRecords >= largestByPages || largestByRecords > liveTuples / (int)numRanges * 5 / 4))
+    {
+        cout << "The ranges split by records are not balanced." << endl;
+        result = -1;
+    }
+
+    // More ranges than pages give one page each, and a range past the end is empty
+    if (result == 0)
+    {
+        rc = rm->getPageRanges(tableName, numPages + 10, SPLIT_BY_RECORDS, ranges);
+        assert(rc == success && "RelationManager::getPageRanges() should not fail.");
+        if (ranges.size() != numPages || ranges.back().endPage != numPages)
+        {
+            cout << "There are more ranges than pages." << endl;
+            result = -1;
+        }
+        PageRange past = {numPages, numPages + 5, 0};
+        vector<int> seen(numTuples, 0);
+        int count = -1;
+        scanRange(tableName, past, &seen, &count, &rc);
+        assert(rc == success && "RelationManager::scan() should not fail.");
+        if (result == 0 && count != 0)
+        {
+            cout << "A scan past the end of the table returned tuples." << endl;
+            result = -1;
+        }
+    }
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+    free(tuple);
+    free(nullsIndicator);
+
+    if (result == 0)
+        cout << "***** RM Test Case 16 Finished. The result will be examined. *****" << endl;
+    else
+        cout << "***** [FAIL] RM Test Case 16 Failed *****" << endl;
+    return result;
+}
+
+int main()
+{
+    RC rcmain = TEST_RM_16("tbl_ranges");
+    return rcmain;
+}